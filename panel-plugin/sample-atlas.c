@@ -0,0 +1,272 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <pango/pangocairo.h>
+
+#include "sample-atlas.h"
+
+/* U+FFFC OBJECT REPLACEMENT CHARACTER, as long in UTF-8 as the placeholders */
+#define ATLAS_OBJECT_CHAR "\xef\xbf\xbc"
+
+struct _SampleAtlas
+{
+    cairo_surface_t *surfaces[ICON_COUNT];
+
+    /* what the surfaces were built for */
+    gboolean         valid;
+    gint             scale;
+    gchar           *font;
+    GdkRGBA          color;
+    GtkIconTheme    *theme;
+
+    /* icon box in pango units, relative to the baseline */
+    PangoRectangle   rect;
+};
+
+SampleAtlas *
+sample_atlas_new (void)
+{
+    return g_slice_new0(SampleAtlas);
+}
+
+void
+sample_atlas_free (SampleAtlas *atlas)
+{
+    if (!atlas)
+        return;
+    
+    for (gint id = 0; id < ICON_COUNT; id++)
+        g_clear_pointer(&atlas->surfaces[id], cairo_surface_destroy);
+    g_free(atlas->font);
+    g_slice_free(SampleAtlas, atlas);
+}
+
+/* Symbolic icons are recolored to the text color when loaded */
+static cairo_surface_t *
+sample_atlas_load_icon (GtkIconTheme  *theme,
+                        const gchar   *name,
+                        gint           size,
+                        gint           scale,
+                        const GdkRGBA *color)
+{
+    GtkIconInfo     *info;
+    GdkPixbuf       *pixbuf;
+    cairo_surface_t *surface;
+    
+    if (!name)
+        return NULL;
+    
+    info = gtk_icon_theme_lookup_icon_for_scale(theme, name, size, scale, GTK_ICON_LOOKUP_FORCE_SIZE);
+    if (!info)
+        return NULL;
+    
+    pixbuf = gtk_icon_info_load_symbolic(info, color, NULL, NULL, NULL, NULL, NULL);
+    g_object_unref(info);
+    if (!pixbuf)
+        return NULL;
+    
+    surface = gdk_cairo_surface_create_from_pixbuf(pixbuf, scale, NULL);
+    g_object_unref(pixbuf);
+    
+    return surface;
+}
+
+/* The one place an emoji font is still looked up: its ink box is scaled
+ * into the icon square */
+static cairo_surface_t *
+sample_atlas_render_emoji (const gchar *emoji,
+                           gint         size,
+                           gint         scale)
+{
+    cairo_surface_t      *surface;
+    cairo_t              *cr;
+    PangoLayout          *layout;
+    PangoFontDescription *desc;
+    PangoRectangle        ink;
+    
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size * scale, size * scale);
+    cairo_surface_set_device_scale(surface, scale, scale);
+    cr = cairo_create(surface);
+    
+    layout = pango_cairo_create_layout(cr);
+    desc = pango_font_description_new();
+    pango_font_description_set_absolute_size(desc, size * PANGO_SCALE);
+    pango_layout_set_font_description(layout, desc);
+    pango_font_description_free(desc);
+    pango_layout_set_text(layout, emoji, -1);
+    pango_layout_get_pixel_extents(layout, &ink, NULL);
+    
+    if (ink.width > 0 && ink.height > 0) {
+        gdouble factor = MIN((gdouble)size / ink.width, (gdouble)size / ink.height);
+        
+        cairo_translate(cr, size / 2.0, size / 2.0);
+        cairo_scale(cr, factor, factor);
+        cairo_translate(cr, -(ink.x + ink.width / 2.0), -(ink.y + ink.height / 2.0));
+        pango_cairo_show_layout(cr, layout);
+    }
+    
+    g_object_unref(layout);
+    cairo_destroy(cr);
+    
+    return surface;
+}
+
+/* Rebuild the surfaces if the widget's scale, font, text color or icon
+ * theme changed since the last build; TRUE when it did, which means the
+ * layouts built with the old icon size have to be rebuilt too */
+gboolean
+sample_atlas_update (SampleAtlas *atlas,
+                     GtkWidget   *widget)
+{
+    GtkStyleContext  *style = gtk_widget_get_style_context(widget);
+    PangoContext     *context = gtk_widget_get_pango_context(widget);
+    GtkIconTheme     *theme = gtk_icon_theme_get_for_screen(gtk_widget_get_screen(widget));
+    gint              scale = gtk_widget_get_scale_factor(widget);
+    gchar            *font = pango_font_description_to_string(pango_context_get_font_description(context));
+    PangoFontMetrics *metrics;
+    GdkRGBA           color;
+    gint              ascent, descent, size;
+    
+    gtk_style_context_get_color(style, gtk_style_context_get_state(style), &color);
+    
+    if (atlas->valid
+        && atlas->scale == scale
+        && atlas->theme == theme
+        && gdk_rgba_equal(&atlas->color, &color)
+        && g_strcmp0(atlas->font, font) == 0) {
+        g_free(font);
+        return FALSE;
+    }
+    
+    g_free(atlas->font);
+    atlas->font = font;
+    atlas->scale = scale;
+    atlas->theme = theme;
+    atlas->color = color;
+    atlas->valid = TRUE;
+    
+    /* icons are as tall as the font's ascent, centered on its line box */
+    metrics = pango_context_get_metrics(context, NULL, NULL);
+    ascent = pango_font_metrics_get_ascent(metrics);
+    descent = pango_font_metrics_get_descent(metrics);
+    pango_font_metrics_unref(metrics);
+    
+    size = MAX(PANGO_PIXELS(ascent), 8);
+    atlas->rect.x = 0;
+    atlas->rect.width = size * PANGO_SCALE;
+    atlas->rect.height = size * PANGO_SCALE;
+    atlas->rect.y = PANGO_UNITS_ROUND(-ascent + (ascent + descent - atlas->rect.height) / 2);
+    
+    for (gint id = ICON_NONE + 1; id < ICON_COUNT; id++) {
+        g_clear_pointer(&atlas->surfaces[id], cairo_surface_destroy);
+        atlas->surfaces[id] = sample_atlas_load_icon(theme, sample_icon_get_name(id), size, scale, &color);
+        if (!atlas->surfaces[id])
+            atlas->surfaces[id] = sample_atlas_render_emoji(sample_icon_get_emoji(id), size, scale);
+    }
+    
+    return TRUE;
+}
+
+/* The icon theme's contents changed, rebuild on the next update */
+void
+sample_atlas_invalidate (SampleAtlas *atlas)
+{
+    atlas->valid = FALSE;
+}
+
+static void
+sample_atlas_render_shape (cairo_t        *cr,
+                           PangoAttrShape *attr,
+                           gboolean        do_path,
+                           gpointer        data)
+{
+    SampleAtlas     *atlas = data;
+    IconId           id = GPOINTER_TO_INT(attr->data);
+    cairo_surface_t *surface;
+    gdouble          x, y;
+    
+    if (do_path || id <= ICON_NONE || id >= ICON_COUNT)
+        return;
+    
+    surface = atlas->surfaces[id];
+    if (!surface)
+        return;
+    
+    /* the current point is on the baseline */
+    cairo_get_current_point(cr, &x, &y);
+    cairo_save(cr);
+    cairo_set_source_surface(cr, surface, x, y + (gdouble)attr->logical_rect.y / PANGO_SCALE);
+    cairo_paint(cr);
+    cairo_restore(cr);
+}
+
+/* Layouts created on @context draw their icon shapes from the atlas */
+void
+sample_atlas_attach (SampleAtlas  *atlas,
+                     PangoContext *context)
+{
+    pango_cairo_context_set_shape_renderer(context, sample_atlas_render_shape, atlas, NULL);
+}
+
+/* Set block markup on @layout with every icon placeholder turned into a
+ * shape of the atlas icon size, and tabular digits so a value keeps its
+ * width as long as it keeps its number of digits */
+gboolean
+sample_atlas_set_markup (SampleAtlas *atlas,
+                         PangoLayout *layout,
+                         const gchar *markup)
+{
+    PangoAttrList *attrs;
+    gchar         *text;
+    
+    if (!pango_parse_markup(markup, -1, 0, &attrs, &text, NULL, NULL))
+        return FALSE;
+    
+    for (gchar *p = text; *p; p = g_utf8_next_char(p)) {
+        IconId          id = sample_icon_from_char(g_utf8_get_char(p));
+        PangoAttribute *shape;
+        
+        if (id == ICON_NONE)
+            continue;
+        
+        /* same length in UTF-8, so the parsed attribute offsets hold */
+        memcpy(p, ATLAS_OBJECT_CHAR, strlen(ATLAS_OBJECT_CHAR));
+        shape = pango_attr_shape_new_with_data(&atlas->rect, &atlas->rect, GINT_TO_POINTER(id), NULL, NULL);
+        shape->start_index = p - text;
+        shape->end_index = shape->start_index + strlen(ATLAS_OBJECT_CHAR);
+        pango_attr_list_insert(attrs, shape);
+    }
+    
+    pango_attr_list_insert_before(attrs, pango_attr_font_features_new("tnum=1"));
+    
+    pango_layout_set_text(layout, text, -1);
+    pango_layout_set_attributes(layout, attrs);
+    
+    pango_attr_list_unref(attrs);
+    g_free(text);
+    
+    return TRUE;
+}
@@ -0,0 +1,52 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_ATLAS_H__
+#define __SAMPLE_ATLAS_H__
+
+#include <gtk/gtk.h>
+
+#include "sample-icons.h"
+
+G_BEGIN_DECLS
+
+/* Block icons rasterized once per icon size, scale, font and theme. Layouts
+ * get the icons as shape attributes, drawn from these surfaces, so no emoji
+ * font has to be looked up or shaped when a block changes. */
+typedef struct _SampleAtlas SampleAtlas;
+
+SampleAtlas *sample_atlas_new        (void);
+
+void         sample_atlas_free       (SampleAtlas *atlas);
+
+gboolean     sample_atlas_update     (SampleAtlas *atlas,
+                                      GtkWidget   *widget);
+
+void         sample_atlas_invalidate (SampleAtlas *atlas);
+
+void         sample_atlas_attach     (SampleAtlas  *atlas,
+                                      PangoContext *context);
+
+gboolean     sample_atlas_set_markup (SampleAtlas *atlas,
+                                      PangoLayout *layout,
+                                      const gchar *markup);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_ATLAS_H__ */
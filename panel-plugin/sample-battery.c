@@ -0,0 +1,318 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <fcntl.h>
+
+#include "sample-battery.h"
+#include "sample-clock.h"
+#include "sample-source.h"
+
+/* time constant of the smoothed rate, a few samples at the usual cadence */
+#define BATTERY_RATE_TAU 120.0    /* s */
+
+typedef enum {
+    BATTERY_CAPACITY,
+    BATTERY_STATUS,
+    BATTERY_NOW,          /* energy_now or charge_now */
+    BATTERY_RATE,         /* power_now or current_now */
+    BATTERY_FULL,         /* energy_full or charge_full */
+    BATTERY_VOLTAGE,      /* voltage_now, to show a charge rate in watts */
+    BATTERY_DESIGN,       /* energy_full_design or charge_full_design, at start */
+    BATTERY_N_FILES
+} BatteryFile;
+
+struct _BatteryStat
+{
+    gint     dir_fd;
+    gint     fds[BATTERY_N_FILES];
+    gboolean charge_units;
+
+    gint     capacity;
+    gchar    status[32];
+    gboolean charging;
+    gboolean discharging;
+
+    gint64   level;
+    gint64   full;
+    gint64   full_design;     /* read once, 0 when unknown */
+    gint64   voltage;
+    gdouble  rate;            /* smoothed, 0 while unknown */
+    gint64   sampled_at;      /* monotonic */
+
+    /* where the level last changed, for batteries without a rate */
+    gint64   last_level;
+    gint64   last_level_at;
+};
+
+static gint
+battery_stat_open (BatteryStat *stat, const gchar *name)
+{
+    return sample_source_openat(stat->dir_fd, name, O_RDONLY | O_CLOEXEC);
+}
+
+static gboolean
+battery_stat_read (BatteryStat *stat, BatteryFile file, gchar *buffer, gsize size)
+{
+    gssize n;
+    
+    if (stat->fds[file] < 0)
+        return FALSE;
+    
+    n = sample_source_pread(stat->fds[file], buffer, size - 1);
+    if (n <= 0)
+        return FALSE;
+    
+    buffer[n] = '\0';
+    g_strchomp(buffer);
+    
+    return TRUE;
+}
+
+static gboolean
+battery_stat_read_value (BatteryStat *stat, BatteryFile file, gint64 *value)
+{
+    gchar buffer[32];
+    gchar *end;
+    
+    if (!battery_stat_read(stat, file, buffer, sizeof(buffer)))
+        return FALSE;
+    
+    *value = g_ascii_strtoll(buffer, &end, 10);
+    
+    return end != buffer;
+}
+
+/* The design capacity does not change, so it is not kept open */
+static gint64
+battery_stat_read_design (BatteryStat *stat)
+{
+    gint64 value = 0;
+    
+    stat->fds[BATTERY_DESIGN] = battery_stat_open(stat, stat->charge_units ? "charge_full_design"
+                                                                            : "energy_full_design");
+    if (!battery_stat_read_value(stat, BATTERY_DESIGN, &value))
+        value = 0;
+    if (stat->fds[BATTERY_DESIGN] >= 0) {
+        sample_source_close(stat->fds[BATTERY_DESIGN]);
+        stat->fds[BATTERY_DESIGN] = -1;
+    }
+    
+    return MAX(value, 0);
+}
+
+BatteryStat *
+battery_stat_new (const gchar *path)
+{
+    BatteryStat *stat;
+    gint dir_fd;
+    
+    dir_fd = sample_source_open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0)
+        return NULL;
+    
+    stat = g_new0(BatteryStat, 1);
+    stat->dir_fd = dir_fd;
+    for (gint i = 0; i < BATTERY_N_FILES; i++)
+        stat->fds[i] = -1;
+    
+    stat->fds[BATTERY_CAPACITY] = battery_stat_open(stat, "capacity");
+    if (stat->fds[BATTERY_CAPACITY] < 0) {
+        battery_stat_free(stat);
+        return NULL;
+    }
+    stat->fds[BATTERY_STATUS] = battery_stat_open(stat, "status");
+    
+    stat->fds[BATTERY_NOW] = battery_stat_open(stat, "energy_now");
+    if (stat->fds[BATTERY_NOW] >= 0) {
+        stat->fds[BATTERY_RATE] = battery_stat_open(stat, "power_now");
+        stat->fds[BATTERY_FULL] = battery_stat_open(stat, "energy_full");
+    } else {
+        stat->charge_units = TRUE;
+        stat->fds[BATTERY_NOW] = battery_stat_open(stat, "charge_now");
+        stat->fds[BATTERY_RATE] = battery_stat_open(stat, "current_now");
+        stat->fds[BATTERY_FULL] = battery_stat_open(stat, "charge_full");
+        stat->fds[BATTERY_VOLTAGE] = battery_stat_open(stat, "voltage_now");
+    }
+    stat->full_design = battery_stat_read_design(stat);
+    
+    return stat;
+}
+
+void
+battery_stat_free (BatteryStat *stat)
+{
+    if (!stat)
+        return;
+    
+    for (gint i = 0; i < BATTERY_N_FILES; i++) {
+        if (stat->fds[i] >= 0)
+            sample_source_close(stat->fds[i]);
+    }
+    sample_source_close(stat->dir_fd);
+    g_free(stat);
+}
+
+/* Feed one rate reading into the average, per level unit and hour */
+static void
+battery_stat_add_rate (BatteryStat *stat, gdouble rate, gint64 now)
+{
+    gdouble dt;
+    
+    if (stat->rate <= 0.0 || stat->sampled_at == 0) {
+        stat->rate = rate;
+        return;
+    }
+    
+    /* weights by the time since the last sample, so a stretched cadence
+     * on battery keeps the same time constant */
+    dt = (now - stat->sampled_at) / (gdouble) G_USEC_PER_SEC;
+    stat->rate += dt / (BATTERY_RATE_TAU + dt) * (rate - stat->rate);
+}
+
+/* FALSE once the battery is gone, the stat is of no use then */
+gboolean
+battery_stat_sample (BatteryStat *stat)
+{
+    gint64 now = sample_clock_get_monotonic();
+    gint64 capacity, level, rate;
+    gboolean charging, discharging;
+    gdouble reading = 0.0;
+    
+    if (!battery_stat_read_value(stat, BATTERY_CAPACITY, &capacity))
+        return FALSE;
+    stat->capacity = CLAMP(capacity, 0, 100);
+    
+    if (!battery_stat_read(stat, BATTERY_STATUS, stat->status, sizeof(stat->status)))
+        stat->status[0] = '\0';
+    
+    /* the rate of one direction says nothing about the other */
+    charging = strcmp(stat->status, "Charging") == 0;
+    discharging = strcmp(stat->status, "Discharging") == 0;
+    if (charging != stat->charging || discharging != stat->discharging) {
+        stat->rate = 0.0;
+        stat->last_level_at = 0;
+    }
+    stat->charging = charging;
+    stat->discharging = discharging;
+    
+    if (!battery_stat_read_value(stat, BATTERY_FULL, &stat->full))
+        stat->full = 0;
+    if (!battery_stat_read_value(stat, BATTERY_VOLTAGE, &stat->voltage))
+        stat->voltage = 0;
+    
+    if (battery_stat_read_value(stat, BATTERY_NOW, &level)) {
+        /* some firmware reports no rate, derive it from the level then */
+        if (stat->last_level_at == 0) {
+            stat->last_level = level;
+            stat->last_level_at = now;
+        } else if (level != stat->last_level) {
+            gdouble hours = (now - stat->last_level_at) / (3600.0 * G_USEC_PER_SEC);
+            
+            if (hours > 0.0)
+                reading = ABS(level - stat->last_level) / hours;
+            stat->last_level = level;
+            stat->last_level_at = now;
+        }
+        stat->level = level;
+    } else {
+        stat->level = -1;
+    }
+    
+    /* signed on some drivers */
+    if (battery_stat_read_value(stat, BATTERY_RATE, &rate) && rate != 0)
+        reading = ABS(rate);
+    
+    if ((charging || discharging) && reading > 0.0)
+        battery_stat_add_rate(stat, reading, now);
+    stat->sampled_at = now;
+    
+    return TRUE;
+}
+
+gint
+battery_stat_get_capacity (BatteryStat *stat)
+{
+    return stat->capacity;
+}
+
+const gchar *
+battery_stat_get_status (BatteryStat *stat)
+{
+    return stat->status;
+}
+
+gboolean
+battery_stat_is_charging (BatteryStat *stat)
+{
+    return stat->charging;
+}
+
+/* The capacity when full now and as designed, in µWh or µAh as the
+ * battery reports them, 0 when unknown */
+gint64
+battery_stat_get_full (BatteryStat *stat)
+{
+    return stat->full;
+}
+
+gint64
+battery_stat_get_full_design (BatteryStat *stat)
+{
+    return stat->full_design;
+}
+
+/* Smoothed draw or charge rate in watts, 0 when unknown */
+gdouble
+battery_stat_get_power (BatteryStat *stat)
+{
+    if (stat->rate <= 0.0)
+        return 0.0;
+    
+    /* µW, or µA times µV */
+    if (!stat->charge_units)
+        return stat->rate / 1e6;
+    return stat->voltage > 0 ? stat->rate * stat->voltage / 1e12 : 0.0;
+}
+
+/* Time to empty while discharging or to full while charging, 0 when
+ * unknown */
+gint64
+battery_stat_get_seconds_left (BatteryStat *stat)
+{
+    gdouble hours;
+    
+    if (stat->rate <= 0.0 || stat->level < 0)
+        return 0;
+    
+    if (stat->discharging)
+        hours = stat->level / stat->rate;
+    else if (stat->charging && stat->full > stat->level)
+        hours = (stat->full - stat->level) / stat->rate;
+    else
+        return 0;
+    
+    return (gint64) (hours * 3600.0);
+}
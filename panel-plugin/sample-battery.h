@@ -0,0 +1,55 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_BATTERY_H__
+#define __SAMPLE_BATTERY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Sampler over one power_supply battery directory. The directory and the
+ * attributes it needs stay open and every sample is a handful of preads.
+ * Batteries report either energy (µWh, µW) or charge (µAh, µA); the rate
+ * is smoothed in whichever unit the battery uses. */
+typedef struct _BatteryStat BatteryStat;
+
+BatteryStat *battery_stat_new              (const gchar *path);
+
+void         battery_stat_free             (BatteryStat *stat);
+
+gboolean     battery_stat_sample           (BatteryStat *stat);
+
+gint         battery_stat_get_capacity     (BatteryStat *stat);
+
+const gchar *battery_stat_get_status       (BatteryStat *stat);
+
+gboolean     battery_stat_is_charging      (BatteryStat *stat);
+
+gdouble      battery_stat_get_power        (BatteryStat *stat);
+
+gint64       battery_stat_get_full         (BatteryStat *stat);
+
+gint64       battery_stat_get_full_design  (BatteryStat *stat);
+
+gint64       battery_stat_get_seconds_left (BatteryStat *stat);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_BATTERY_H__ */
@@ -0,0 +1,471 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "sample-blocks.h"
+#include "sample-export.h"
+#include "sample-trace.h"
+
+static const gchar *block_names[BLOCK_COUNT] = {
+    [BLOCK_WEATHER]       = "weather",
+    [BLOCK_EXCHANGE_RATE] = "exchange",
+    [BLOCK_NETWORK]       = "network",
+    [BLOCK_BATTERY]       = "battery",
+    [BLOCK_CPU]           = "cpu",
+    [BLOCK_MEMORY]        = "memory",
+    [BLOCK_DATE]          = "date",
+};
+
+void
+block_store_init (BlockStore       *store,
+                  BlockStoreNotify  notify,
+                  gpointer          notify_data)
+{
+    memset(store->blocks, 0, sizeof(store->blocks));
+    pthread_mutex_init(&store->mutex, NULL);
+    store->notify = notify;
+    store->notify_data = notify_data;
+    store->export = NULL;
+    store->history = NULL;
+}
+
+void
+block_store_clear (BlockStore *store)
+{
+    pthread_mutex_destroy(&store->mutex);
+}
+
+/* Publish the blocks through @export from now on, NULL to stop */
+void
+block_store_set_export (BlockStore   *store,
+                        SampleExport *export)
+{
+    pthread_mutex_lock(&store->mutex);
+    store->export = export;
+    for (gint i = 0; export && i < BLOCK_COUNT; i++) {
+        if (store->blocks[i].serial > 0)
+            sample_export_write(export, i, &store->blocks[i]);
+    }
+    pthread_mutex_unlock(&store->mutex);
+}
+
+/* Record the values behind the blocks in @history; set before the
+ * workers start and cleared after they stopped */
+void
+block_store_set_history (BlockStore    *store,
+                         SampleHistory *history)
+{
+    store->history = history;
+}
+
+#define BLOCK_MARKUP_MAX_DEPTH 8
+
+static gboolean
+markup_name_char (gchar c)
+{
+    return g_ascii_isalnum(c) || c == '_' || c == '-' || c == ':';
+}
+
+/* One of the XML predefined entities or a character reference, without
+ * the & and ; */
+static gboolean
+markup_entity_valid (const gchar *name, gsize len)
+{
+    static const gchar *predefined[] = { "amp", "lt", "gt", "quot", "apos" };
+    
+    if (len >= 2 && name[0] == '#') {
+        gboolean hex = name[1] == 'x';
+        gsize digits = 1 + hex;
+        
+        if (digits == len)
+            return FALSE;
+        for (gsize i = digits; i < len; i++) {
+            if (hex ? !g_ascii_isxdigit(name[i]) : !g_ascii_isdigit(name[i]))
+                return FALSE;
+        }
+        return TRUE;
+    }
+    
+    for (guint i = 0; i < G_N_ELEMENTS(predefined); i++) {
+        if (strlen(predefined[i]) == len && memcmp(name, predefined[i], len) == 0)
+            return TRUE;
+    }
+    
+    return FALSE;
+}
+
+/* Text or an attribute value: no tags, every & starts an entity */
+static gboolean
+markup_text_valid (const gchar *p, const gchar *end)
+{
+    while ((p = memchr(p, '&', end - p))) {
+        const gchar *semicolon = memchr(p, ';', end - p);
+        
+        if (!semicolon || !markup_entity_valid(p + 1, semicolon - p - 1))
+            return FALSE;
+        p = semicolon + 1;
+    }
+    
+    return TRUE;
+}
+
+/* The core does not link Pango, so markup is only checked for being
+ * well-formed; Pango specific attributes are checked where it is drawn.
+ * Every tick of every provider passes here, so it is checked in place
+ * rather than through a GMarkupParseContext. */
+gboolean
+block_markup_valid (const gchar *text, gsize len)
+{
+    const gchar *open[BLOCK_MARKUP_MAX_DEPTH];
+    gsize open_len[BLOCK_MARKUP_MAX_DEPTH];
+    gint depth = 0;
+    const gchar *p = text;
+    const gchar *end = text + len;
+    
+    if (!g_utf8_validate(text, len, NULL))
+        return FALSE;
+    
+    while (p < end) {
+        const gchar *name, *q;
+        gboolean closing;
+        gsize name_len;
+        
+        if (*p != '<') {
+            q = memchr(p, '<', end - p);
+            if (!q)
+                q = end;
+            if (!markup_text_valid(p, q))
+                return FALSE;
+            p = q;
+            continue;
+        }
+        
+        closing = p + 1 < end && p[1] == '/';
+        name = q = p + 1 + closing;
+        while (q < end && markup_name_char(*q))
+            q++;
+        name_len = q - name;
+        if (name_len == 0)
+            return FALSE;
+        
+        if (closing) {
+            while (q < end && g_ascii_isspace(*q))
+                q++;
+            if (q == end || *q != '>' || depth == 0
+                || open_len[depth - 1] != name_len || memcmp(open[depth - 1], name, name_len) != 0)
+                return FALSE;
+            depth--;
+            p = q + 1;
+            continue;
+        }
+        
+        /* name='value' pairs up to the end of the tag */
+        for (;;) {
+            const gchar *attribute, *value_end;
+            
+            while (q < end && g_ascii_isspace(*q))
+                q++;
+            if (q == end)
+                return FALSE;
+            if (*q == '>' || (*q == '/' && q + 1 < end && q[1] == '>'))
+                break;
+            
+            attribute = q;
+            while (q < end && markup_name_char(*q))
+                q++;
+            if (q == attribute)
+                return FALSE;
+            while (q < end && g_ascii_isspace(*q))
+                q++;
+            if (q == end || *q != '=')
+                return FALSE;
+            q++;
+            while (q < end && g_ascii_isspace(*q))
+                q++;
+            if (q == end || (*q != '\'' && *q != '"'))
+                return FALSE;
+            
+            value_end = memchr(q + 1, *q, end - q - 1);
+            if (!value_end || memchr(q + 1, '<', value_end - q - 1)
+                || !markup_text_valid(q + 1, value_end))
+                return FALSE;
+            q = value_end + 1;
+        }
+        
+        if (*q == '/') {
+            /* empty element */
+            p = q + 2;
+            continue;
+        }
+        
+        if (depth == BLOCK_MARKUP_MAX_DEPTH)
+            return FALSE;
+        open[depth] = name;
+        open_len[depth] = name_len;
+        depth++;
+        p = q + 1;
+    }
+    
+    return depth == 0;
+}
+
+/* Length of the longest prefix of @text that fits a block and does not
+ * end inside a UTF-8 character, a tag or an entity */
+static gsize
+block_text_fit (const gchar *text, gsize len)
+{
+    gsize cut;
+    
+    if (len < MAX_BLOCK_SIZE)
+        return len;
+    
+    cut = MAX_BLOCK_SIZE - 1;
+    while (cut > 0 && ((guchar)text[cut] & 0xc0) == 0x80)
+        cut--;
+    for (gsize i = cut; i > 0; i--) {
+        if (text[i - 1] == '>' || text[i - 1] == ';')
+            break;
+        if (text[i - 1] == '<' || text[i - 1] == '&') {
+            cut = i - 1;
+            break;
+        }
+    }
+    
+    return cut;
+}
+
+gsize
+block_markup_escape (const gchar *text,
+                     gsize        len,
+                     gchar       *buffer,
+                     gsize        size)
+{
+    const gchar *p = text;
+    const gchar *end = text + len;
+    gsize n = 0;
+    
+    g_return_val_if_fail(size > 0, 0);
+    
+    while (p < end) {
+        gunichar c = g_utf8_get_char_validated(p, end - p);
+        gchar reference[16];
+        const gchar *piece;
+        gsize piece_len, skip;
+        
+        if (c == (gunichar) -1 || c == (gunichar) -2) {
+            piece = "\xef\xbf\xbd";    /* U+FFFD */
+            piece_len = 3;
+            skip = 1;
+        } else {
+            skip = g_utf8_next_char(p) - p;
+            switch (c) {
+                case '&':  piece = "&amp;";  break;
+                case '<':  piece = "&lt;";   break;
+                case '>':  piece = "&gt;";   break;
+                case '\'': piece = "&apos;"; break;
+                case '"':  piece = "&quot;"; break;
+                default:
+                    /* the control characters g_markup_escape_text() escapes */
+                    if ((c >= 0x1 && c <= 0x8) || c == 0xb || c == 0xc || (c >= 0xe && c <= 0x1f)
+                        || (c >= 0x7f && c <= 0x84) || (c >= 0x86 && c <= 0x9f)) {
+                        g_snprintf(reference, sizeof(reference), "&#x%x;", c);
+                        piece = reference;
+                    } else {
+                        piece = NULL;
+                    }
+            }
+            piece_len = piece ? strlen(piece) : skip;
+            if (!piece)
+                piece = p;
+        }
+        
+        if (n + piece_len >= size)
+            break;
+        memcpy(buffer + n, piece, piece_len);
+        n += piece_len;
+        p += skip;
+    }
+    buffer[n] = '\0';
+    
+    return n;
+}
+
+/* Update a block together with the raw values it was formatted from.
+ * The text is copied straight into the block, nothing is allocated. */
+void
+block_store_update (BlockStore        *store,
+                    BlockId            block_id,
+                    const gchar       *text,
+                    const BlockSample *raw)
+{
+    block_store_update_cached(store, block_id, text, raw, 0, FALSE);
+}
+
+/* The same for blocks shown from a cache, with the age of the entry */
+void
+block_store_update_cached (BlockStore        *store,
+                           BlockId            block_id,
+                           const gchar       *text,
+                           const BlockSample *raw,
+                           gint64             fetched_at,
+                           gboolean           outdated)
+{
+    gchar escaped[MAX_BLOCK_SIZE];
+    gboolean invalid, changed = TRUE;
+    gsize len;
+    
+    if (!store || block_id >= BLOCK_COUNT || !text)
+        return;
+    
+    /* Validate markup as it will be stored; cutting off the end can still
+     * leave elements open, which then shows escaped */
+    len = block_text_fit(text, strlen(text));
+    invalid = !block_markup_valid(text, len);
+    if (invalid) {
+        /* a provider producing broken markup does so every tick, so this
+         * does not allocate either */
+        len = block_markup_escape(text, len, escaped, sizeof(escaped));
+        text = escaped;
+    }
+    
+    SAMPLE_TRACE2(block__update, block_id, len);
+    
+    pthread_mutex_lock(&store->mutex);
+    SAMPLE_TRACE1(store__lock, block_id);
+    
+    if (invalid)
+        changed = store->blocks[block_id].len != (int) len
+                  || memcmp(store->blocks[block_id].data, text, len) != 0;
+    store->blocks[block_id].len = len;
+    memcpy(store->blocks[block_id].data, text, len);
+    store->blocks[block_id].data[len] = '\0';
+    store->blocks[block_id].serial++;
+    store->blocks[block_id].fetched_at = fetched_at;
+    store->blocks[block_id].outdated = outdated;
+    if (raw)
+        store->blocks[block_id].raw = *raw;
+    sample_export_write(store->export, block_id, &store->blocks[block_id]);
+    
+    SAMPLE_TRACE1(store__unlock, block_id);
+    pthread_mutex_unlock(&store->mutex);
+    
+    /* once, not on every tick showing the same text */
+    if (invalid && changed)
+        g_warning("Invalid markup in block %d, shown escaped: %s", block_id, text);
+    
+    if (store->notify)
+        store->notify(store->notify_data);
+}
+
+/* Empty a block whose worker was stopped, whatever it showed is stale */
+void
+block_store_reset (BlockStore *store,
+                   BlockId     block_id)
+{
+    pthread_mutex_lock(&store->mutex);
+    SAMPLE_TRACE1(store__lock, block_id);
+    store->blocks[block_id].len = 0;
+    store->blocks[block_id].data[0] = '\0';
+    store->blocks[block_id].serial++;
+    store->blocks[block_id].fetched_at = 0;
+    store->blocks[block_id].outdated = FALSE;
+    sample_export_write(store->export, block_id, &store->blocks[block_id]);
+    SAMPLE_TRACE1(store__unlock, block_id);
+    pthread_mutex_unlock(&store->mutex);
+    
+    if (store->notify)
+        store->notify(store->notify_data);
+}
+
+/* Whether the settings show a block at all */
+gboolean
+block_enabled (const SampleConfig *config, BlockId block_id)
+{
+    switch (block_id) {
+        case BLOCK_WEATHER:
+            return config->show_weather;
+        case BLOCK_EXCHANGE_RATE:
+            return config->show_exchange;
+        case BLOCK_NETWORK:
+            return config->show_network;
+        case BLOCK_BATTERY:
+            return config->show_battery;
+        case BLOCK_CPU:
+            return config->show_cpu;
+        case BLOCK_MEMORY:
+            return config->show_memory;
+        case BLOCK_DATE:
+            return config->show_date;
+        default:
+            return FALSE;
+    }
+}
+
+static gboolean
+block_notify_dispatch (GSource     *source,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+    /* disarm first, updates during the callback dispatch it again */
+    g_source_set_ready_time(source, -1);
+    
+    if (callback)
+        callback(user_data);
+    
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs block_notify_funcs = {
+    NULL, NULL, block_notify_dispatch, NULL, NULL, NULL
+};
+
+/* A main loop source that runs its callback once after any number of
+ * block_notify_source_wake() calls from any thread. Unlike an idle per
+ * update it is created once, so a busy store queues nothing. The
+ * callback's return value is ignored. */
+GSource *
+block_notify_source_new (void)
+{
+    GSource *source = g_source_new(&block_notify_funcs, sizeof(GSource));
+    
+    g_source_set_name(source, "block-store-notify");
+    
+    return source;
+}
+
+/* A BlockStoreNotify, pass the source as its data */
+void
+block_notify_source_wake (gpointer source)
+{
+    g_source_set_ready_time(source, 0);
+}
+
+const gchar *
+block_get_name (BlockId block_id)
+{
+    g_return_val_if_fail(block_id < BLOCK_COUNT, NULL);
+    
+    return block_names[block_id];
+}
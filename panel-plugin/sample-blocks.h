@@ -0,0 +1,210 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_BLOCKS_H__
+#define __SAMPLE_BLOCKS_H__
+
+#include <glib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "sample-config.h"
+#include "sample-net.h"
+#include "sample-procs.h"
+
+G_BEGIN_DECLS
+
+#define MAX_BLOCK_SIZE 256
+
+/* Block identifiers for different status components */
+typedef enum {
+    BLOCK_WEATHER = 0,
+    BLOCK_EXCHANGE_RATE,
+    BLOCK_NETWORK,
+    BLOCK_BATTERY,
+    BLOCK_CPU,
+    BLOCK_MEMORY,
+    BLOCK_DATE,
+    BLOCK_COUNT
+} BlockId;
+
+/* Raw values behind the blocks, kept so the tooltips can be built on demand */
+typedef struct {
+    time_t   time;
+} DateSample;
+
+typedef struct {
+    gulong   total_kb;
+    gulong   free_kb;
+    gulong   available_kb;
+    gulong   buffers_kb;
+    gulong   cached_kb;
+    gulong   reclaimable_kb;
+    gulong   shmem_kb;
+    gulong   swap_total_kb;
+    gulong   swap_free_kb;
+    gint     n_top;         /* only while the tooltip is shown */
+    ProcUsage top[PROC_TOP_MAX];
+} MemorySample;
+
+#define WEATHER_MAX_LOCATIONS 6
+
+typedef struct {
+    gchar    name[32];      /* empty for an unnamed location */
+    gdouble  temperature;
+    gdouble  windspeed;
+    gdouble  winddirection;
+    gint     weathercode;
+    gboolean is_day;
+} WeatherReading;
+
+typedef struct {
+    gint           n_readings;
+    WeatherReading readings[WEATHER_MAX_LOCATIONS];
+    gint64         fetched_at;  /* when the forecast was fetched */
+} WeatherSample;
+
+typedef struct {
+    gboolean has_try;
+    gboolean has_rub;
+    gdouble  try_rate;
+    gdouble  rub_rate;
+    gint64   timestamp;
+    gchar    source[24];    /* the rate source that answered */
+} ExchangeSample;
+
+typedef struct {
+    gint     capacity;
+    gchar    status[32];
+    gboolean charging;
+    gdouble  power;         /* smoothed W, 0 when unknown */
+    gint64   seconds_left;  /* to empty or full, 0 when unknown */
+    gint64   full;          /* µWh or µAh, 0 when unknown */
+    gint64   full_design;   /* in the same unit, 0 when unknown */
+} BatterySample;
+
+typedef struct {
+    gfloat   total;
+    gint     n_cores;
+    gint     n_busy_cores;  /* cores above 90% */
+    gint     busiest_core;
+    gfloat   busiest;
+} CpuSample;
+
+#define NET_SAMPLE_MAX_INTERFACES 8
+
+typedef struct {
+    gint         n_interfaces;
+    NetInterface interfaces[NET_SAMPLE_MAX_INTERFACES];
+} NetSample;
+
+typedef union {
+    DateSample     date;
+    MemorySample   memory;
+    WeatherSample  weather;
+    ExchangeSample exchange;
+    BatterySample  battery;
+    CpuSample      cpu;
+    NetSample      net;
+} BlockSample;
+
+/* Structure to hold individual block data */
+typedef struct {
+    int         len;
+    char        data[MAX_BLOCK_SIZE];
+    guint       serial;     /* bumped on every update */
+    BlockSample raw;
+    gint64      fetched_at; /* real time in µs the shown data was fetched, 0 for local blocks */
+    gboolean    outdated;   /* fetched longer ago than it is good for */
+} BlockData;
+
+/* Called by the writing thread after every change of a block */
+typedef void (*BlockStoreNotify) (gpointer user_data);
+
+/* see sample-export.h */
+typedef struct _SampleExport SampleExport;
+
+/* see sample-history.h */
+typedef struct _SampleHistory SampleHistory;
+
+/* The current text of every block. Workers write it, the front end reads
+ * it; both hold the mutex while touching the blocks. Changes are copied
+ * into the export, if any, under the same lock. Providers record the
+ * numbers behind their blocks in the history, if any, which has its own
+ * lock. */
+typedef struct {
+    BlockData        blocks[BLOCK_COUNT];
+    pthread_mutex_t  mutex;
+    BlockStoreNotify notify;
+    gpointer         notify_data;
+    SampleExport    *export;
+    SampleHistory   *history;
+} BlockStore;
+
+void         block_store_init   (BlockStore       *store,
+                                 BlockStoreNotify  notify,
+                                 gpointer          notify_data);
+
+void         block_store_clear  (BlockStore       *store);
+
+void         block_store_set_export (BlockStore   *store,
+                                     SampleExport *export);
+
+void         block_store_set_history (BlockStore    *store,
+                                      SampleHistory *history);
+
+void         block_store_update (BlockStore        *store,
+                                 BlockId            block_id,
+                                 const gchar       *text,
+                                 const BlockSample *raw);
+
+void         block_store_update_cached (BlockStore        *store,
+                                        BlockId            block_id,
+                                        const gchar       *text,
+                                        const BlockSample *raw,
+                                        gint64             fetched_at,
+                                        gboolean           outdated);
+
+void         block_store_reset  (BlockStore       *store,
+                                 BlockId           block_id);
+
+gboolean     block_markup_valid (const gchar      *text,
+                                 gsize             len);
+
+/* Escapes @len bytes of @text into @buffer as markup showing the text as
+ * is; invalid UTF-8 shows as U+FFFD. What does not fit in @size bytes is
+ * left out, never part of a character or an entity. Returns the length
+ * written, does not allocate. */
+gsize        block_markup_escape (const gchar *text,
+                                  gsize        len,
+                                  gchar       *buffer,
+                                  gsize        size);
+
+GSource     *block_notify_source_new  (void);
+
+void         block_notify_source_wake (gpointer source);
+
+gboolean     block_enabled      (const SampleConfig *config,
+                                 BlockId             block_id);
+
+const gchar *block_get_name     (BlockId block_id);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_BLOCKS_H__ */
@@ -0,0 +1,451 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "sample-bus.h"
+
+/* Changes a single sender may make, per second and in one go */
+#define BUS_CLIENT_RATE  2.0
+#define BUS_CLIENT_BURST 5.0
+
+/* The same for all senders together, against many short lived ones
+ * such as a loop around gdbus call */
+#define BUS_TOTAL_RATE   10.0
+#define BUS_TOTAL_BURST  10.0
+
+static const gchar introspection_xml[] =
+    "<node>"
+    "  <interface name='" SAMPLE_BUS_INTERFACE "'>"
+    "    <method name='Set'>"
+    "      <arg type='s' name='name' direction='in'/>"
+    "      <arg type='s' name='markup' direction='in'/>"
+    "    </method>"
+    "    <method name='Remove'>"
+    "      <arg type='s' name='name' direction='in'/>"
+    "    </method>"
+    "    <method name='List'>"
+    "      <arg type='as' name='names' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+typedef struct {
+    gdouble  tokens;
+    gint64   refilled;      /* monotonic µs */
+} BusBucket;
+
+typedef struct {
+    SampleBus *bus;
+    gchar     *sender;
+    BusBucket  bucket;
+    guint      flush_id;    /* waiting for the budget */
+} BusClient;
+
+typedef struct {
+    SampleBusBlock shown;
+    gboolean       used;
+    gboolean       pending;         /* a change waits for its sender's budget */
+    gboolean       pending_remove;
+    gchar          pending_text[MAX_BLOCK_SIZE];
+    BusClient     *pending_client;
+} BusSlot;
+
+struct _SampleBus {
+    guint              owner_id;
+    guint              registration_id;
+    GDBusConnection   *connection;
+    GDBusNodeInfo     *introspection;
+    SampleBusValidate  validate;
+    BlockStoreNotify   notify;
+    gpointer           notify_data;
+    BusSlot            slots[SAMPLE_BUS_MAX_BLOCKS];
+    GHashTable        *clients;     /* sender -> BusClient */
+    BusBucket          total;
+    guint              serial;
+};
+
+static void bus_client_schedule (SampleBus *bus, BusClient *client);
+
+static void
+bus_bucket_refill (BusBucket *bucket, gdouble rate, gdouble burst, gint64 now)
+{
+    bucket->tokens = MIN(burst, bucket->tokens + (now - bucket->refilled) * rate / G_USEC_PER_SEC);
+    bucket->refilled = now;
+}
+
+/* Seconds until the bucket holds a whole change */
+static gdouble
+bus_bucket_wait (const BusBucket *bucket, gdouble rate)
+{
+    return bucket->tokens >= 1.0 ? 0.0 : (1.0 - bucket->tokens) / rate;
+}
+
+static void
+bus_client_free (gpointer data)
+{
+    BusClient *client = data;
+    
+    if (client->flush_id)
+        g_source_remove(client->flush_id);
+    g_free(client->sender);
+    g_free(client);
+}
+
+static BusClient *
+bus_client_get (SampleBus *bus, const gchar *sender)
+{
+    BusClient *client = g_hash_table_lookup(bus->clients, sender);
+    
+    if (!client) {
+        client = g_new0(BusClient, 1);
+        client->bus = bus;
+        client->sender = g_strdup(sender);
+        client->bucket.tokens = BUS_CLIENT_BURST;
+        client->bucket.refilled = g_get_monotonic_time();
+        g_hash_table_insert(bus->clients, client->sender, client);
+    }
+    
+    return client;
+}
+
+/* Senders with their whole budget back and nothing waiting are
+ * indistinguishable from new ones */
+static gboolean
+bus_client_idle (gpointer key, gpointer value, gpointer user_data)
+{
+    BusClient *client = value;
+    
+    bus_bucket_refill(&client->bucket, BUS_CLIENT_RATE, BUS_CLIENT_BURST, *(gint64 *) user_data);
+    
+    return client->flush_id == 0 && client->bucket.tokens >= BUS_CLIENT_BURST;
+}
+
+/* Apply everything @client has waiting, the front end redraws once */
+static void
+bus_client_flush (SampleBus *bus, BusClient *client)
+{
+    gboolean changed = FALSE;
+    
+    for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+        BusSlot *slot = &bus->slots[i];
+        
+        if (!slot->pending || slot->pending_client != client)
+            continue;
+        
+        if (slot->pending_remove) {
+            memset(slot, 0, sizeof(*slot));
+        } else {
+            g_strlcpy(slot->shown.text, slot->pending_text, sizeof(slot->shown.text));
+            slot->shown.serial = ++bus->serial;
+            slot->pending = FALSE;
+            slot->pending_client = NULL;
+        }
+        changed = TRUE;
+    }
+    
+    if (changed && bus->notify)
+        bus->notify(bus->notify_data);
+}
+
+static gboolean
+bus_client_flush_due (gpointer data)
+{
+    BusClient *client = data;
+    
+    client->flush_id = 0;
+    bus_client_schedule(client->bus, client);
+    
+    return G_SOURCE_REMOVE;
+}
+
+/* Apply the changes of @client now if the budgets allow, or once they do */
+static void
+bus_client_schedule (SampleBus *bus, BusClient *client)
+{
+    gint64 now = g_get_monotonic_time();
+    gboolean waiting = FALSE;
+    gdouble wait;
+    
+    for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++)
+        waiting |= bus->slots[i].pending && bus->slots[i].pending_client == client;
+    if (!waiting || client->flush_id)
+        return;
+    
+    bus_bucket_refill(&client->bucket, BUS_CLIENT_RATE, BUS_CLIENT_BURST, now);
+    bus_bucket_refill(&bus->total, BUS_TOTAL_RATE, BUS_TOTAL_BURST, now);
+    wait = MAX(bus_bucket_wait(&client->bucket, BUS_CLIENT_RATE),
+               bus_bucket_wait(&bus->total, BUS_TOTAL_RATE));
+    
+    if (wait > 0.0) {
+        client->flush_id = g_timeout_add((guint) (wait * 1000.0) + 1, bus_client_flush_due, client);
+        return;
+    }
+    
+    client->bucket.tokens -= 1.0;
+    bus->total.tokens -= 1.0;
+    bus_client_flush(bus, client);
+}
+
+static BusSlot *
+bus_find_slot (SampleBus *bus, const gchar *name)
+{
+    for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+        if (bus->slots[i].used && strcmp(bus->slots[i].shown.name, name) == 0)
+            return &bus->slots[i];
+    }
+    
+    return NULL;
+}
+
+static gboolean
+bus_name_valid (const gchar *name, GError **error)
+{
+    gsize len = strlen(name);
+    
+    for (gsize i = 0; i < len; i++) {
+        if (!g_ascii_islower(name[i]) && !g_ascii_isdigit(name[i]) && name[i] != '-' && name[i] != '_')
+            len = 0;
+    }
+    if (len == 0 || len >= SAMPLE_BUS_NAME_MAX) {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Block names are 1 to %d of a-z, 0-9, - and _", SAMPLE_BUS_NAME_MAX - 1);
+        return FALSE;
+    }
+    
+    for (gint id = 0; id < BLOCK_COUNT; id++) {
+        if (strcmp(name, block_get_name(id)) == 0) {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "\"%s\" is a built-in block", name);
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+/* The only check the markup gets, the front ends draw it as is */
+static gboolean
+bus_markup_valid (SampleBus *bus, const gchar *markup, GError **error)
+{
+    GError *front_end_error = NULL;
+    gsize len = strlen(markup);
+    
+    if (len == 0 || len >= MAX_BLOCK_SIZE) {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Markup must be 1 to %d bytes", MAX_BLOCK_SIZE - 1);
+        return FALSE;
+    }
+    if (!block_markup_valid(markup, len)) {
+        g_set_error_literal(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                            "Markup is not well-formed");
+        return FALSE;
+    }
+    if (bus->validate && !bus->validate(markup, &front_end_error)) {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                    "Invalid markup: %s", front_end_error->message);
+        g_error_free(front_end_error);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+static gboolean
+bus_set (SampleBus *bus, BusClient *client, const gchar *name, const gchar *markup, GError **error)
+{
+    BusSlot *slot;
+    
+    if (!bus_name_valid(name, error) || !bus_markup_valid(bus, markup, error))
+        return FALSE;
+    
+    slot = bus_find_slot(bus, name);
+    for (gint i = 0; !slot && i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+        if (!bus->slots[i].used) {
+            slot = &bus->slots[i];
+            slot->used = TRUE;
+            g_strlcpy(slot->shown.name, name, sizeof(slot->shown.name));
+        }
+    }
+    if (!slot) {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_LIMITS_EXCEEDED,
+                    "No room for another block, there are at most %d", SAMPLE_BUS_MAX_BLOCKS);
+        return FALSE;
+    }
+    
+    /* repeating what is shown costs nothing */
+    if (!slot->pending && strcmp(slot->shown.text, markup) == 0)
+        return TRUE;
+    
+    slot->pending = TRUE;
+    slot->pending_remove = FALSE;
+    slot->pending_client = client;
+    g_strlcpy(slot->pending_text, markup, sizeof(slot->pending_text));
+    bus_client_schedule(bus, client);
+    
+    return TRUE;
+}
+
+static gboolean
+bus_remove (SampleBus *bus, BusClient *client, const gchar *name, GError **error)
+{
+    BusSlot *slot = bus_find_slot(bus, name);
+    
+    if (!slot || (slot->pending && slot->pending_remove)) {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "No block \"%s\"", name);
+        return FALSE;
+    }
+    
+    slot->pending = TRUE;
+    slot->pending_remove = TRUE;
+    slot->pending_client = client;
+    bus_client_schedule(bus, client);
+    
+    return TRUE;
+}
+
+static void
+bus_method_call (GDBusConnection       *connection,
+                 const gchar           *sender,
+                 const gchar           *object_path,
+                 const gchar           *interface_name,
+                 const gchar           *method_name,
+                 GVariant              *parameters,
+                 GDBusMethodInvocation *invocation,
+                 gpointer               user_data)
+{
+    SampleBus *bus = user_data;
+    GError *error = NULL;
+    const gchar *name, *markup;
+    gint64 now = g_get_monotonic_time();
+    
+    g_hash_table_foreach_remove(bus->clients, bus_client_idle, &now);
+    
+    if (g_strcmp0(method_name, "Set") == 0) {
+        g_variant_get(parameters, "(&s&s)", &name, &markup);
+        if (!bus_set(bus, bus_client_get(bus, sender), name, markup, &error)) {
+            g_dbus_method_invocation_take_error(invocation, error);
+            return;
+        }
+        g_dbus_method_invocation_return_value(invocation, NULL);
+    } else if (g_strcmp0(method_name, "Remove") == 0) {
+        g_variant_get(parameters, "(&s)", &name);
+        if (!bus_remove(bus, bus_client_get(bus, sender), name, &error)) {
+            g_dbus_method_invocation_take_error(invocation, error);
+            return;
+        }
+        g_dbus_method_invocation_return_value(invocation, NULL);
+    } else if (g_strcmp0(method_name, "List") == 0) {
+        GVariantBuilder names;
+        
+        g_variant_builder_init(&names, G_VARIANT_TYPE("as"));
+        for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+            if (bus->slots[i].used && !(bus->slots[i].pending && bus->slots[i].pending_remove))
+                g_variant_builder_add(&names, "s", bus->slots[i].shown.name);
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(as)", &names));
+    }
+}
+
+static const GDBusInterfaceVTable bus_vtable = {
+    bus_method_call, NULL, NULL, { NULL }
+};
+
+static void
+bus_acquired (GDBusConnection *connection, const gchar *name, gpointer user_data)
+{
+    SampleBus *bus = user_data;
+    GError *error = NULL;
+    
+    bus->connection = g_object_ref(connection);
+    bus->registration_id = g_dbus_connection_register_object(connection, SAMPLE_BUS_PATH,
+                                                             bus->introspection->interfaces[0],
+                                                             &bus_vtable, bus, NULL, &error);
+    if (bus->registration_id == 0) {
+        g_warning("Custom blocks are unavailable: %s", error->message);
+        g_error_free(error);
+    }
+}
+
+static void
+bus_name_lost (GDBusConnection *connection, const gchar *name, gpointer user_data)
+{
+    /* without a session bus, or another instance has the name; the
+     * bus daemon hands it over once that one is gone */
+    if (connection)
+        g_message("%s is taken, custom blocks go to its owner", name);
+    else
+        g_debug("No session bus, custom blocks are unavailable");
+}
+
+/* Offer the interface under @name on the session bus, as given by
+ * $DBUS_SESSION_BUS_ADDRESS. @validate, if any, runs on every markup
+ * that arrives; @notify runs after every applied change. */
+SampleBus *
+sample_bus_new (const gchar       *name,
+                SampleBusValidate  validate,
+                BlockStoreNotify   notify,
+                gpointer           notify_data)
+{
+    SampleBus *bus = g_new0(SampleBus, 1);
+    
+    bus->validate = validate;
+    bus->notify = notify;
+    bus->notify_data = notify_data;
+    bus->clients = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, bus_client_free);
+    bus->total.tokens = BUS_TOTAL_BURST;
+    bus->total.refilled = g_get_monotonic_time();
+    bus->introspection = g_dbus_node_info_new_for_xml(introspection_xml, NULL);
+    bus->owner_id = g_bus_own_name(G_BUS_TYPE_SESSION, name, G_BUS_NAME_OWNER_FLAGS_NONE,
+                                   bus_acquired, NULL, bus_name_lost, bus, NULL);
+    
+    return bus;
+}
+
+void
+sample_bus_free (SampleBus *bus)
+{
+    if (!bus)
+        return;
+    
+    g_bus_unown_name(bus->owner_id);
+    if (bus->registration_id)
+        g_dbus_connection_unregister_object(bus->connection, bus->registration_id);
+    g_clear_object(&bus->connection);
+    g_hash_table_destroy(bus->clients);
+    g_dbus_node_info_unref(bus->introspection);
+    g_free(bus);
+}
+
+const SampleBusBlock *
+sample_bus_get_block (SampleBus *bus,
+                      gint       index)
+{
+    g_return_val_if_fail(index >= 0 && index < SAMPLE_BUS_MAX_BLOCKS, NULL);
+    
+    if (!bus || !bus->slots[index].used || bus->slots[index].shown.serial == 0)
+        return NULL;
+    
+    return &bus->slots[index].shown;
+}
@@ -0,0 +1,72 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_BUS_H__
+#define __SAMPLE_BUS_H__
+
+#include <gio/gio.h>
+
+#include "sample-blocks.h"
+
+G_BEGIN_DECLS
+
+/* Custom blocks pushed over the session bus by other programs, e.g.
+ *
+ *   gdbus call --session --dest org.xfce.SamplePlugin \
+ *       --object-path /org/xfce/SamplePlugin \
+ *       --method org.xfce.SamplePlugin.Blocks.Set deploy '<b>green</b>'
+ *
+ * Set (name, markup) creates or replaces a block, Remove (name) drops it
+ * and List () returns the names. Markup is checked when it arrives and
+ * rejected with InvalidArgs, so the front ends draw it unchecked. Every
+ * sender has a small budget of changes per second; changes beyond it are
+ * held, only the latest per block, and applied together once the budget
+ * allows. All of it runs in the main context the bus was created in. */
+#define SAMPLE_BUS_NAME        "org.xfce.SamplePlugin"
+#define SAMPLE_BUS_PATH        "/org/xfce/SamplePlugin"
+#define SAMPLE_BUS_INTERFACE   "org.xfce.SamplePlugin.Blocks"
+
+#define SAMPLE_BUS_MAX_BLOCKS  8
+#define SAMPLE_BUS_NAME_MAX    16
+
+typedef struct {
+    gchar    name[SAMPLE_BUS_NAME_MAX];
+    gchar    text[MAX_BLOCK_SIZE];  /* empty until the first change is applied */
+    guint    serial;                /* changes with every applied change */
+} SampleBusBlock;
+
+/* Extra markup checks of a front end, on top of block_markup_valid() */
+typedef gboolean (*SampleBusValidate) (const gchar *markup, GError **error);
+
+typedef struct _SampleBus SampleBus;
+
+SampleBus            *sample_bus_new       (const gchar       *name,
+                                            SampleBusValidate  validate,
+                                            BlockStoreNotify   notify,
+                                            gpointer           notify_data);
+
+void                  sample_bus_free      (SampleBus         *bus);
+
+/* The block in slot @index, NULL if the slot is unused */
+const SampleBusBlock *sample_bus_get_block (SampleBus         *bus,
+                                            gint               index);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_BUS_H__ */
@@ -0,0 +1,154 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "sample-cache.h"
+#include "sample-clock.h"
+
+/* Settings changes leave entries of old keys behind, the oldest go first */
+#define SAMPLE_CACHE_MAX_ENTRIES 8
+
+typedef struct {
+    gint64 fetched_at;
+    gchar  value[];
+} CacheEntry;
+
+struct _SampleCache
+{
+    GMutex            lock;
+    GHashTable       *entries;     /* key -> CacheEntry */
+    gsize             value_size;
+    gint64            soft_ttl;    /* µs */
+    gint64            ttl;
+    SampleCacheStats  stats;
+};
+
+SampleCache *
+sample_cache_new (gsize value_size, gint soft_ttl, gint ttl)
+{
+    SampleCache *cache = g_slice_new0(SampleCache);
+    
+    g_mutex_init(&cache->lock);
+    cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    cache->value_size = value_size;
+    cache->soft_ttl = (gint64) soft_ttl * G_USEC_PER_SEC;
+    cache->ttl = (gint64) MAX(ttl, soft_ttl) * G_USEC_PER_SEC;
+    
+    return cache;
+}
+
+void
+sample_cache_free (SampleCache *cache)
+{
+    if (!cache)
+        return;
+    
+    g_hash_table_unref(cache->entries);
+    g_mutex_clear(&cache->lock);
+    g_slice_free(SampleCache, cache);
+}
+
+SampleCacheState
+sample_cache_get (SampleCache *cache,
+                  const gchar *key,
+                  gpointer     value,
+                  gint64      *fetched_at)
+{
+    CacheEntry *entry;
+    gint64 age;
+    
+    g_mutex_lock(&cache->lock);
+    entry = g_hash_table_lookup(cache->entries, key);
+    if (!entry) {
+        cache->stats.misses++;
+        g_mutex_unlock(&cache->lock);
+        return SAMPLE_CACHE_MISS;
+    }
+    
+    cache->stats.hits++;
+    memcpy(value, entry->value, cache->value_size);
+    *fetched_at = entry->fetched_at;
+    g_mutex_unlock(&cache->lock);
+    
+    age = sample_clock_get_real() - *fetched_at;
+    if (age >= cache->ttl)
+        return SAMPLE_CACHE_EXPIRED;
+    if (age >= cache->soft_ttl)
+        return SAMPLE_CACHE_REVALIDATE;
+    
+    return SAMPLE_CACHE_FRESH;
+}
+
+static void
+sample_cache_evict_oldest (SampleCache *cache)
+{
+    GHashTableIter iter;
+    gpointer key, entry;
+    const gchar *oldest_key = NULL;
+    gint64 oldest = G_MAXINT64;
+    
+    g_hash_table_iter_init(&iter, cache->entries);
+    while (g_hash_table_iter_next(&iter, &key, &entry)) {
+        if (((CacheEntry *) entry)->fetched_at < oldest) {
+            oldest = ((CacheEntry *) entry)->fetched_at;
+            oldest_key = key;
+        }
+    }
+    if (oldest_key)
+        g_hash_table_remove(cache->entries, oldest_key);
+}
+
+void
+sample_cache_put (SampleCache   *cache,
+                  const gchar   *key,
+                  gconstpointer  value)
+{
+    CacheEntry *entry;
+    
+    g_mutex_lock(&cache->lock);
+    entry = g_hash_table_lookup(cache->entries, key);
+    if (entry) {
+        cache->stats.revalidations++;
+    } else {
+        if (g_hash_table_size(cache->entries) >= SAMPLE_CACHE_MAX_ENTRIES)
+            sample_cache_evict_oldest(cache);
+        entry = g_malloc(sizeof(CacheEntry) + cache->value_size);
+        g_hash_table_insert(cache->entries, g_strdup(key), entry);
+    }
+    
+    memcpy(entry->value, value, cache->value_size);
+    entry->fetched_at = sample_clock_get_real();
+    g_mutex_unlock(&cache->lock);
+}
+
+void
+sample_cache_take_stats (SampleCache      *cache,
+                         SampleCacheStats *stats)
+{
+    g_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    memset(&cache->stats, 0, sizeof(cache->stats));
+    g_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,70 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_CACHE_H__
+#define __SAMPLE_CACHE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Fetched values of a remote provider by request key, e.g. the
+ * locations or the API key. Entries are served at any age: past the soft
+ * TTL the provider fetches again in the background, past the TTL the
+ * value is still shown but marked as out of date. Values are fixed size
+ * and copied in and out, so reads do not allocate. Thread safe. */
+typedef struct _SampleCache SampleCache;
+
+typedef enum {
+    SAMPLE_CACHE_MISS,         /* nothing cached for the key */
+    SAMPLE_CACHE_FRESH,        /* younger than the soft TTL */
+    SAMPLE_CACHE_REVALIDATE,   /* past the soft TTL, fetch again */
+    SAMPLE_CACHE_EXPIRED       /* past the TTL, out of date */
+} SampleCacheState;
+
+typedef struct {
+    guint hits;
+    guint misses;
+    guint revalidations;       /* entries replaced by a newer fetch */
+} SampleCacheStats;
+
+/* TTLs in seconds */
+SampleCache      *sample_cache_new         (gsize             value_size,
+                                            gint              soft_ttl,
+                                            gint              ttl);
+
+void              sample_cache_free        (SampleCache      *cache);
+
+/* Copies the value out; @fetched_at is real time in µs */
+SampleCacheState  sample_cache_get         (SampleCache      *cache,
+                                            const gchar      *key,
+                                            gpointer          value,
+                                            gint64           *fetched_at);
+
+void              sample_cache_put         (SampleCache      *cache,
+                                            const gchar      *key,
+                                            gconstpointer     value);
+
+/* The counters since the last call */
+void              sample_cache_take_stats  (SampleCache      *cache,
+                                            SampleCacheStats *stats);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_CACHE_H__ */
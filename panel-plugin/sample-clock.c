@@ -0,0 +1,255 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "sample-clock.h"
+
+/* threads woken per round of a step, the rest follow in the next round */
+#define CLOCK_WAKE_BATCH 32
+
+/* A thread sleeping on the virtual clock, on its own stack */
+typedef struct {
+    GList     link;       /* in clock_sleepers */
+    GCond    *cond;
+    GMutex   *mutex;
+    gint64    deadline;
+    gboolean  woken;      /* by the clock */
+} ClockSleeper;
+
+static gdouble  clock_scale = 1.0;
+static gint64   clock_epoch_monotonic;     /* system and scaled time agree here */
+static gint64   clock_epoch_real;
+
+/* the virtual clock; the lock guards everything below */
+static gboolean clock_virtual;
+static GMutex   clock_lock;
+static GCond    clock_changed;
+static gint64   clock_now;                 /* virtual monotonic time */
+static GQueue   clock_sleepers = G_QUEUE_INIT;
+static guint    clock_busy;                /* woken by the clock, not asleep again */
+static GPrivate clock_owes_sleep;          /* set in threads counted in clock_busy */
+
+void
+sample_clock_set_scale (gdouble scale)
+{
+    g_return_if_fail(scale > 0.0);
+    g_return_if_fail(!clock_virtual);
+    
+    clock_epoch_monotonic = g_get_monotonic_time();
+    clock_epoch_real = g_get_real_time();
+    clock_scale = scale;
+}
+
+gdouble
+sample_clock_get_scale (void)
+{
+    return clock_scale;
+}
+
+gboolean
+sample_clock_is_virtual (void)
+{
+    return clock_virtual;
+}
+
+static gint64
+sample_clock_elapsed (void)
+{
+    gint64 now;
+    
+    if (!clock_virtual)
+        return (gint64) ((g_get_monotonic_time() - clock_epoch_monotonic) * clock_scale);
+    
+    g_mutex_lock(&clock_lock);
+    now = clock_now;
+    g_mutex_unlock(&clock_lock);
+    
+    return now - clock_epoch_monotonic;
+}
+
+gint64
+sample_clock_get_monotonic (void)
+{
+    if (clock_scale == 1.0 && !clock_virtual)
+        return g_get_monotonic_time();
+    
+    return clock_epoch_monotonic + sample_clock_elapsed();
+}
+
+gint64
+sample_clock_get_real (void)
+{
+    if (clock_scale == 1.0 && !clock_virtual)
+        return g_get_real_time();
+    
+    return clock_epoch_real + sample_clock_elapsed();
+}
+
+time_t
+sample_clock_time (void)
+{
+    if (clock_scale == 1.0 && !clock_virtual)
+        return time(NULL);
+    
+    return (time_t) (sample_clock_get_real() / G_USEC_PER_SEC);
+}
+
+/* Called with the lock held: the calling thread was woken by the clock
+ * and is done with that tick */
+static void
+clock_sleep_owed (void)
+{
+    if (!g_private_get(&clock_owes_sleep))
+        return;
+    
+    g_private_set(&clock_owes_sleep, NULL);
+    clock_busy--;
+    g_cond_broadcast(&clock_changed);
+}
+
+gboolean
+sample_clock_wait_until (GCond  *cond,
+                         GMutex *mutex,
+                         gint64  deadline)
+{
+    ClockSleeper sleeper = { .cond = cond, .mutex = mutex, .deadline = deadline };
+    
+    if (!clock_virtual) {
+        /* a deadline on the scaled clock as a system monotonic time */
+        if (clock_scale != 1.0)
+            deadline = clock_epoch_monotonic + (gint64) ((deadline - clock_epoch_monotonic) / clock_scale);
+        return g_cond_wait_until(cond, mutex, deadline);
+    }
+    
+    g_mutex_lock(&clock_lock);
+    clock_sleep_owed();
+    if (deadline <= clock_now) {
+        g_mutex_unlock(&clock_lock);
+        return FALSE;
+    }
+    sleeper.link.data = &sleeper;
+    g_queue_push_tail_link(&clock_sleepers, &sleeper.link);
+    g_cond_broadcast(&clock_changed);
+    g_mutex_unlock(&clock_lock);
+    
+    /* the clock signals with @mutex held, so no wakeup is lost between
+     * registering and waiting */
+    g_cond_wait(cond, mutex);
+    
+    g_mutex_lock(&clock_lock);
+    g_queue_unlink(&clock_sleepers, &sleeper.link);
+    if (sleeper.woken)
+        g_private_set(&clock_owes_sleep, GINT_TO_POINTER(TRUE));
+    g_mutex_unlock(&clock_lock);
+    
+    return !sleeper.woken;
+}
+
+void
+sample_clock_set_virtual (gint64 real_start)
+{
+    g_return_if_fail(clock_scale == 1.0);
+    
+    /* monotonic times keep looking like system ones, 0 stays "never" */
+    clock_epoch_monotonic = g_get_monotonic_time();
+    clock_epoch_real = real_start;
+    clock_now = clock_epoch_monotonic;
+    clock_virtual = TRUE;
+}
+
+void
+sample_clock_settle (guint n_sleepers)
+{
+    g_return_if_fail(clock_virtual);
+    
+    g_mutex_lock(&clock_lock);
+    while (clock_busy > 0 || clock_sleepers.length < n_sleepers)
+        g_cond_wait(&clock_changed, &clock_lock);
+    g_mutex_unlock(&clock_lock);
+}
+
+/* Does not allocate, a harness may count the allocations of the workers
+ * around it */
+void
+sample_clock_advance (gint64 usec)
+{
+    gint64 target;
+    
+    g_return_if_fail(clock_virtual);
+    g_return_if_fail(usec >= 0);
+    
+    g_mutex_lock(&clock_lock);
+    target = clock_now + usec;
+    for (;;) {
+        GCond *conds[CLOCK_WAKE_BATCH];
+        GMutex *mutexes[CLOCK_WAKE_BATCH];
+        gint64 next = target;
+        guint n = 0;
+        
+        /* on to the earliest deadline within the step */
+        for (GList *l = clock_sleepers.head; l; l = l->next) {
+            ClockSleeper *sleeper = l->data;
+            
+            if (!sleeper->woken)
+                next = MIN(next, sleeper->deadline);
+        }
+        clock_now = MAX(clock_now, next);
+        
+        for (GList *l = clock_sleepers.head; l && n < CLOCK_WAKE_BATCH; l = l->next) {
+            ClockSleeper *sleeper = l->data;
+            
+            if (!sleeper->woken && sleeper->deadline <= clock_now) {
+                sleeper->woken = TRUE;
+                clock_busy++;
+                conds[n] = sleeper->cond;
+                mutexes[n] = sleeper->mutex;
+                n++;
+            }
+        }
+        if (n == 0 && clock_now >= target)
+            break;
+        g_mutex_unlock(&clock_lock);
+        
+        for (guint i = 0; i < n; i++) {
+            g_mutex_lock(mutexes[i]);
+            g_cond_signal(conds[i]);
+            g_mutex_unlock(mutexes[i]);
+        }
+        
+        /* the woken run their tick before time moves on */
+        g_mutex_lock(&clock_lock);
+        while (clock_busy > 0)
+            g_cond_wait(&clock_changed, &clock_lock);
+    }
+    g_mutex_unlock(&clock_lock);
+}
+
+void
+sample_clock_release (void)
+{
+    if (!clock_virtual)
+        return;
+    
+    g_mutex_lock(&clock_lock);
+    clock_sleep_owed();
+    g_mutex_unlock(&clock_lock);
+}
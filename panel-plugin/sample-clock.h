@@ -0,0 +1,72 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_CLOCK_H__
+#define __SAMPLE_CLOCK_H__
+
+#include <glib.h>
+#include <time.h>
+
+G_BEGIN_DECLS
+
+/* Time as the providers and the scheduler see it. Normally these are the
+ * system clocks; a soak run speeds them up so that weeks of refresh
+ * cycles pass in hours. Both clocks start out at the system time when the
+ * scale is set and then advance @scale times faster. The scale is set
+ * once, before any worker runs. All times are in microseconds. */
+void     sample_clock_set_scale     (gdouble scale);
+
+gdouble  sample_clock_get_scale     (void);
+
+gint64   sample_clock_get_monotonic (void);
+
+gint64   sample_clock_get_real      (void);
+
+time_t   sample_clock_time          (void);
+
+/* Like g_cond_wait_until() with a deadline on the sample clock. Workers
+ * sleep through this so that a virtual clock can wake them. */
+gboolean sample_clock_wait_until    (GCond  *cond,
+                                     GMutex *mutex,
+                                     gint64  deadline);
+
+/* A virtual clock for test harnesses: time stands still at @real_start,
+ * real time in µs, until it is stepped. Set once, before any worker runs,
+ * instead of a scale. */
+void     sample_clock_set_virtual   (gint64 real_start);
+
+/* Whether the clock above was set */
+gboolean sample_clock_is_virtual    (void);
+
+/* Waits until @n_sleepers threads sleep in sample_clock_wait_until(),
+ * e.g. all workers after they started */
+void     sample_clock_settle        (guint  n_sleepers);
+
+/* Steps the virtual clock by @usec. Every deadline passed on the way is
+ * honoured in order: its sleepers are woken and the step only goes on
+ * once they are asleep again, so a step of a day runs every tick of the
+ * day in turn. A sleeper woken by the clock that ends its thread instead
+ * must call sample_clock_release(). */
+void     sample_clock_advance       (gint64 usec);
+
+void     sample_clock_release       (void);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_CLOCK_H__ */
@@ -0,0 +1,601 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-unix.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sample-commands.h"
+
+#define COMMANDS_DEFAULT_INTERVAL 60
+#define COMMANDS_DEFAULT_TIMEOUT  10
+
+/* interval commands running at the same time, the rest wait their turn */
+#define COMMANDS_MAX_RUNNING      4
+
+/* seconds before a persistent command that exited, or one that could not
+ * be started, is tried again */
+#define COMMANDS_RESTART_DELAY    10
+
+/* ms between looks at a command that closed its output but still runs */
+#define COMMANDS_REAP_INTERVAL    100
+
+/* output kept of a single line, the rest of it is dropped */
+#define COMMANDS_LINE_MAX         4096
+
+#define COMMAND_INTERVAL_ONCE     0
+#define COMMAND_INTERVAL_PERSIST  (-1)
+
+typedef struct {
+    gchar    *name;
+    gchar    *command;
+    gint      interval;     /* seconds, or one of the COMMAND_INTERVAL_ values */
+    gint      timeout;      /* seconds */
+    gboolean  markup;       /* the output is Pango markup */
+    gint      refresh;      /* atomic, set by sample_commands_refresh() */
+
+    /* only touched by the thread */
+    gboolean  running;      /* until both the process and its output are gone */
+    gboolean  killed;       /* ran past its timeout */
+    pid_t     pid;          /* 0 once reaped */
+    pid_t     pgid;
+    gint      fd;           /* read end of its stdout, -1 once closed */
+    gint64    started;      /* monotonic µs */
+    gint64    next_run;     /* monotonic µs, G_MAXINT64 for never */
+    GString  *line;         /* the line being read */
+    gboolean  got_line;     /* an interval command printed its first line */
+} Command;
+
+/* What the front ends see, under the lock */
+typedef struct {
+    gchar     text[MAX_BLOCK_SIZE];
+    guint     serial;       /* 0 until the first output */
+} CommandBlock;
+
+struct _SampleCommands {
+    GThread          *thread;
+    gint              wake[2];    /* a byte on it wakes the thread */
+    gint              stopping;   /* atomic */
+    gint              n_commands;
+    Command           commands[SAMPLE_COMMANDS_MAX];
+    
+    GMutex            lock;
+    CommandBlock      blocks[SAMPLE_COMMANDS_MAX];
+    guint             serial;
+    BlockStoreNotify  notify;
+    gpointer          notify_data;
+};
+
+/* Plain text as markup, cut at a whole character to fit a block */
+static void
+commands_escape (GString *escaped, const gchar *text)
+{
+    for (const gchar *p = text; *p; p = g_utf8_next_char(p)) {
+        const gchar *next = g_utf8_next_char(p);
+        const gchar *entity = NULL;
+        gsize len;
+        
+        switch (*p) {
+            case '&':  entity = "&amp;"; break;
+            case '<':  entity = "&lt;"; break;
+            case '>':  entity = "&gt;"; break;
+            case '\'': entity = "&#39;"; break;
+            case '"':  entity = "&quot;"; break;
+        }
+        
+        len = entity ? strlen(entity) : (gsize) (next - p);
+        if (escaped->len + len >= MAX_BLOCK_SIZE)
+            break;
+        g_string_append_len(escaped, entity ? entity : p, len);
+    }
+}
+
+/* Show @output in the block of command @index, the front end is only
+ * woken if that changes anything */
+static void
+commands_publish (SampleCommands *commands, gint index, const gchar *output, gsize len)
+{
+    Command *command = &commands->commands[index];
+    CommandBlock *block = &commands->blocks[index];
+    gchar *valid = g_utf8_make_valid(output, len);
+    GString *text = g_string_sized_new(MAX_BLOCK_SIZE);
+    gboolean changed;
+    
+    /* trailing blanks are common and make the block look off */
+    g_strchomp(valid);
+    len = strlen(valid);
+    if (command->markup && len < MAX_BLOCK_SIZE && block_markup_valid(valid, len)) {
+        g_string_append_len(text, valid, len);
+    } else {
+        if (command->markup)
+            g_warning("Invalid markup from command block %s: %s", command->name, valid);
+        commands_escape(text, valid);
+    }
+    
+    g_mutex_lock(&commands->lock);
+    changed = block->serial == 0 || strcmp(block->text, text->str) != 0;
+    if (changed) {
+        g_strlcpy(block->text, text->str, sizeof(block->text));
+        block->serial = ++commands->serial;
+    }
+    g_mutex_unlock(&commands->lock);
+    
+    g_string_free(text, TRUE);
+    g_free(valid);
+    
+    if (changed && commands->notify)
+        commands->notify(commands->notify_data);
+}
+
+/* posix_spawn() rather than fork(): nothing of the panel is copied, and
+ * the process group is set before the command runs */
+static gboolean
+command_spawn (Command *command, gint64 now)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
+    sigset_t signals;
+    gchar *argv[] = { "/bin/sh", "-c", command->command, NULL };
+    gchar **envp;
+    GError *error = NULL;
+    gint fds[2];
+    pid_t pid;
+    gint result;
+    
+    if (!g_unix_open_pipe(fds, FD_CLOEXEC, &error)) {
+        g_warning("Unable to start command block %s: %s", command->name, error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+    g_unix_set_fd_nonblocking(fds[0], TRUE, NULL);
+    
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    
+    /* a group of its own takes whatever it starts down with it; signals
+     * the front end ignores or blocks are back to normal for the command */
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK
+                                          | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigaddset(&signals, SIGPIPE);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGCHLD);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    
+    envp = g_environ_setenv(g_get_environ(), "BLOCK_NAME", command->name, TRUE);
+    result = posix_spawn(&pid, argv[0], &actions, &attributes, argv, envp);
+    
+    g_strfreev(envp);
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    
+    if (result != 0) {
+        g_warning("Unable to start command block %s: %s", command->name, g_strerror(result));
+        close(fds[0]);
+        return FALSE;
+    }
+    
+    command->running = TRUE;
+    command->killed = FALSE;
+    command->pid = command->pgid = pid;
+    command->fd = fds[0];
+    command->started = now;
+    command->got_line = FALSE;
+    g_string_truncate(command->line, 0);
+    
+    return TRUE;
+}
+
+static void
+command_reap (Command *command)
+{
+    pid_t result;
+    gint status;
+    
+    if (command->pid == 0)
+        return;
+    
+    do
+        result = waitpid(command->pid, &status, WNOHANG);
+    while (result < 0 && errno == EINTR);
+    
+    if (result == command->pid || (result < 0 && errno == ECHILD))
+        command->pid = 0;
+}
+
+static void
+command_kill (Command *command)
+{
+    kill(-command->pgid, SIGKILL);
+    if (command->fd >= 0) {
+        close(command->fd);
+        command->fd = -1;
+    }
+    command_reap(command);
+}
+
+/* Split what was read into lines; a persistent command shows each one,
+ * an interval command only its first */
+static void
+commands_consume (SampleCommands *commands, gint index, const gchar *data, gsize len)
+{
+    Command *command = &commands->commands[index];
+    const gchar *p = data;
+    const gchar *end = data + len;
+    
+    while (p < end) {
+        const gchar *newline = memchr(p, '\n', end - p);
+        gsize line_len = (newline ? newline : end) - p;
+        
+        if (!command->got_line && command->line->len < COMMANDS_LINE_MAX)
+            g_string_append_len(command->line, p, MIN(line_len, COMMANDS_LINE_MAX - command->line->len));
+        if (!newline)
+            break;
+        
+        if (command->interval == COMMAND_INTERVAL_PERSIST) {
+            commands_publish(commands, index, command->line->str, command->line->len);
+            g_string_truncate(command->line, 0);
+        } else {
+            command->got_line = TRUE;
+        }
+        p = newline + 1;
+    }
+}
+
+/* Everything there is without blocking */
+static void
+commands_read (SampleCommands *commands, gint index)
+{
+    Command *command = &commands->commands[index];
+    gchar buffer[4096];
+    gssize n;
+    
+    while ((n = read(command->fd, buffer, sizeof(buffer))) > 0)
+        commands_consume(commands, index, buffer, n);
+    
+    if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        close(command->fd);
+        command->fd = -1;
+    }
+}
+
+/* The process and its output are gone */
+static void
+commands_finish (SampleCommands *commands, gint index, gint64 now)
+{
+    Command *command = &commands->commands[index];
+    
+    command->running = FALSE;
+    
+    if (command->interval == COMMAND_INTERVAL_PERSIST) {
+        g_debug("Command block %s exited, starting it again in %d s",
+                command->name, COMMANDS_RESTART_DELAY);
+        command->next_run = now + COMMANDS_RESTART_DELAY * G_USEC_PER_SEC;
+        return;
+    }
+    
+    if (!command->killed || command->got_line)
+        commands_publish(commands, index, command->line->str, command->line->len);
+    
+    if (command->interval == COMMAND_INTERVAL_ONCE)
+        command->next_run = G_MAXINT64;
+    else
+        command->next_run = MAX(now, command->started + (gint64) command->interval * G_USEC_PER_SEC);
+}
+
+/* One poll() over the output of every running command, woken by output,
+ * the next timeout or start and the wake pipe */
+static gpointer
+commands_thread (gpointer data)
+{
+    SampleCommands *commands = data;
+    struct pollfd fds[SAMPLE_COMMANDS_MAX + 1];
+    gint owners[SAMPLE_COMMANDS_MAX + 1];
+    
+    while (!g_atomic_int_get(&commands->stopping)) {
+        gint64 now = g_get_monotonic_time();
+        gint64 deadline = G_MAXINT64;
+        gint n_running = 0;
+        gint n_fds = 1;
+        gchar drain[64];
+        
+        /* take down what ran too long, finish what is done */
+        for (gint i = 0; i < commands->n_commands; i++) {
+            Command *command = &commands->commands[i];
+            
+            if (!command->running)
+                continue;
+            
+            command_reap(command);
+            if (command->interval != COMMAND_INTERVAL_PERSIST && !command->killed
+                && now >= command->started + (gint64) command->timeout * G_USEC_PER_SEC) {
+                g_message("Command block %s ran longer than %d s and was killed",
+                          command->name, command->timeout);
+                command->killed = TRUE;
+                command_kill(command);
+            }
+            
+            if (command->pid == 0 && command->fd < 0)
+                commands_finish(commands, i, now);
+            else if (command->interval != COMMAND_INTERVAL_PERSIST)
+                n_running++;
+        }
+        
+        /* start what is due, as far as the cap allows */
+        for (gint i = 0; i < commands->n_commands; i++) {
+            Command *command = &commands->commands[i];
+            gboolean persist = command->interval == COMMAND_INTERVAL_PERSIST;
+            
+            if (g_atomic_int_compare_and_exchange(&command->refresh, 1, 0) && !persist && !command->running)
+                command->next_run = now;
+            if (command->running || now < command->next_run || (!persist && n_running >= COMMANDS_MAX_RUNNING))
+                continue;
+            
+            if (!command_spawn(command, now))
+                command->next_run = now + COMMANDS_RESTART_DELAY * G_USEC_PER_SEC;
+            else if (!persist)
+                n_running++;
+        }
+        
+        fds[0].fd = commands->wake[0];
+        fds[0].events = POLLIN;
+        for (gint i = 0; i < commands->n_commands; i++) {
+            Command *command = &commands->commands[i];
+            gboolean persist = command->interval == COMMAND_INTERVAL_PERSIST;
+            
+            if (!command->running) {
+                /* the waiting ones start when a running one is done */
+                if (persist || n_running < COMMANDS_MAX_RUNNING)
+                    deadline = MIN(deadline, command->next_run);
+                continue;
+            }
+            
+            if (command->fd >= 0) {
+                fds[n_fds].fd = command->fd;
+                fds[n_fds].events = POLLIN;
+                owners[n_fds++] = i;
+            } else {
+                deadline = MIN(deadline, now + COMMANDS_REAP_INTERVAL * 1000);
+            }
+            if (!persist && !command->killed)
+                deadline = MIN(deadline, command->started + (gint64) command->timeout * G_USEC_PER_SEC);
+        }
+        
+        if (poll(fds, n_fds, deadline == G_MAXINT64 ? -1
+                             : (gint) CLAMP((deadline - now + 999) / 1000, 0, G_MAXINT)) < 0) {
+            if (errno == EINTR)
+                continue;
+            g_warning("Command blocks stopped: %s", g_strerror(errno));
+            break;
+        }
+        
+        if (fds[0].revents)
+            while (read(commands->wake[0], drain, sizeof(drain)) > 0);
+        for (gint i = 1; i < n_fds; i++) {
+            if (fds[i].revents)
+                commands_read(commands, owners[i]);
+        }
+    }
+    
+    /* nothing outlives the front end */
+    for (gint i = 0; i < commands->n_commands; i++) {
+        Command *command = &commands->commands[i];
+        
+        if (!command->running)
+            continue;
+        command_kill(command);
+        if (command->pid != 0)
+            waitpid(command->pid, NULL, 0);
+    }
+    
+    return NULL;
+}
+
+static gint
+commands_parse_seconds (GKeyFile *file, const gchar *group, const gchar *key,
+                        gint fallback, GError **error)
+{
+    gchar *value = g_key_file_get_string(file, group, key, NULL);
+    guint64 seconds = fallback;
+    
+    if (value && g_strcmp0(key, "interval") == 0 && g_strcmp0(value, "once") == 0)
+        seconds = COMMAND_INTERVAL_ONCE;
+    else if (value && g_strcmp0(key, "interval") == 0 && g_strcmp0(value, "persist") == 0)
+        seconds = (guint64) COMMAND_INTERVAL_PERSIST;
+    else if (value && !g_ascii_string_to_unsigned(value, 10, 1, G_MAXINT / G_USEC_PER_SEC, &seconds, NULL)) {
+        g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                    "[%s] %s must be a number of seconds%s", group, key,
+                    g_strcmp0(key, "interval") == 0 ? ", once or persist" : "");
+        g_free(value);
+        return -2;
+    }
+    g_free(value);
+    
+    return (gint) seconds;
+}
+
+/* Read the commands from @path, a leading ~/ is the home directory.
+ * They start right away, in a thread of their own; @notify runs in it
+ * whenever a block changes. */
+SampleCommands *
+sample_commands_new (const gchar       *path,
+                     BlockStoreNotify   notify,
+                     gpointer           notify_data,
+                     GError           **error)
+{
+    SampleCommands *commands;
+    GKeyFile *file = g_key_file_new();
+    gchar *expanded = g_str_has_prefix(path, "~/") ? g_build_filename(g_get_home_dir(), path + 2, NULL)
+                                                   : g_strdup(path);
+    GError *local_error = NULL;
+    gchar **groups;
+    gsize n_groups;
+    
+    if (!g_key_file_load_from_file(file, expanded, G_KEY_FILE_NONE, error)) {
+        g_prefix_error(error, "%s: ", expanded);
+        g_key_file_free(file);
+        g_free(expanded);
+        return NULL;
+    }
+    
+    commands = g_new0(SampleCommands, 1);
+    commands->notify = notify;
+    commands->notify_data = notify_data;
+    g_mutex_init(&commands->lock);
+    
+    groups = g_key_file_get_groups(file, &n_groups);
+    if (n_groups > SAMPLE_COMMANDS_MAX)
+        g_warning("%s: only the first %d command blocks are run", expanded, SAMPLE_COMMANDS_MAX);
+    
+    for (gsize i = 0; i < MIN(n_groups, SAMPLE_COMMANDS_MAX); i++) {
+        Command *command = &commands->commands[i];
+        gchar *markup;
+        
+        command->fd = -1;
+        command->line = g_string_new(NULL);
+        command->name = g_strdup(groups[i]);
+        commands->n_commands++;
+        
+        command->command = g_key_file_get_string(file, groups[i], "command", &local_error);
+        if (!command->command)
+            break;
+        command->interval = commands_parse_seconds(file, groups[i], "interval", COMMANDS_DEFAULT_INTERVAL,
+                                                   &local_error);
+        if (command->interval < COMMAND_INTERVAL_PERSIST)
+            break;
+        command->timeout = commands_parse_seconds(file, groups[i], "timeout", COMMANDS_DEFAULT_TIMEOUT,
+                                                  &local_error);
+        if (command->timeout < COMMAND_INTERVAL_PERSIST)
+            break;
+        
+        markup = g_key_file_get_string(file, groups[i], "markup", NULL);
+        command->markup = g_strcmp0(markup, "pango") == 0;
+        g_free(markup);
+    }
+    
+    if (local_error)
+        g_prefix_error(&local_error, "%s: ", expanded);
+    g_strfreev(groups);
+    g_key_file_free(file);
+    g_free(expanded);
+    
+    if (local_error || !g_unix_open_pipe(commands->wake, FD_CLOEXEC, &local_error)) {
+        g_propagate_error(error, local_error);
+        commands->wake[0] = commands->wake[1] = -1;
+        sample_commands_free(commands);
+        return NULL;
+    }
+    g_unix_set_fd_nonblocking(commands->wake[0], TRUE, NULL);
+    g_unix_set_fd_nonblocking(commands->wake[1], TRUE, NULL);
+    
+    commands->thread = g_thread_new("commands", commands_thread, commands);
+    
+    return commands;
+}
+
+void
+sample_commands_free (SampleCommands *commands)
+{
+    if (!commands)
+        return;
+    
+    if (commands->thread) {
+        g_atomic_int_set(&commands->stopping, 1);
+        if (write(commands->wake[1], "", 1) < 0)
+            g_warning("Unable to stop the command blocks: %s", g_strerror(errno));
+        g_thread_join(commands->thread);
+    }
+    if (commands->wake[0] >= 0) {
+        close(commands->wake[0]);
+        close(commands->wake[1]);
+    }
+    
+    for (gint i = 0; i < commands->n_commands; i++) {
+        g_free(commands->commands[i].name);
+        g_free(commands->commands[i].command);
+        g_string_free(commands->commands[i].line, TRUE);
+    }
+    g_mutex_clear(&commands->lock);
+    g_free(commands);
+}
+
+const gchar *
+sample_commands_get_name (SampleCommands *commands,
+                          gint            index)
+{
+    if (!commands || index < 0 || index >= commands->n_commands)
+        return NULL;
+    
+    return commands->commands[index].name;
+}
+
+gboolean
+sample_commands_read (SampleCommands *commands,
+                      gint            index,
+                      guint          *serial,
+                      gchar          *text)
+{
+    CommandBlock *block;
+    gboolean shown;
+    
+    if (!commands || index < 0 || index >= commands->n_commands)
+        return FALSE;
+    
+    block = &commands->blocks[index];
+    g_mutex_lock(&commands->lock);
+    shown = block->serial != 0 && block->text[0] != '\0';
+    if (shown && block->serial != *serial) {
+        memcpy(text, block->text, MAX_BLOCK_SIZE);
+        *serial = block->serial;
+    }
+    g_mutex_unlock(&commands->lock);
+    
+    return shown;
+}
+
+void
+sample_commands_refresh (SampleCommands *commands,
+                         gint            index)
+{
+    if (!commands || index < 0 || index >= commands->n_commands)
+        return;
+    
+    g_atomic_int_set(&commands->commands[index].refresh, 1);
+    if (write(commands->wake[1], "", 1) < 0 && errno != EAGAIN)
+        g_warning("Unable to wake the command blocks: %s", g_strerror(errno));
+}
@@ -0,0 +1,75 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_COMMANDS_H__
+#define __SAMPLE_COMMANDS_H__
+
+#include <glib.h>
+
+#include "sample-blocks.h"
+
+G_BEGIN_DECLS
+
+/* Blocks filled by shell commands, set up in a key file much like
+ * i3blocks:
+ *
+ *   [vpn]
+ *   command=nmcli -t -f NAME,TYPE connection show --active | grep -c vpn
+ *   interval=10       ; seconds, "once" or "persist", 60 by default
+ *   timeout=5         ; seconds, 10 by default
+ *   markup=pango      ; the output is plain text otherwise
+ *
+ * A command runs with /bin/sh in a process group of its own, stdin from
+ * /dev/null and $BLOCK_NAME set. The block shows the first line it
+ * prints. One running past its timeout is killed together with the rest
+ * of its group and the block keeps the previous line. A "persist"
+ * command keeps running and every line it prints replaces the block; it
+ * is started again some seconds after it exits. A single thread
+ * waits on the output of all commands, and at most a few interval
+ * commands run at the same time, however many are due. */
+#define SAMPLE_COMMANDS_MAX 24
+
+typedef struct _SampleCommands SampleCommands;
+
+SampleCommands *sample_commands_new      (const gchar       *path,
+                                          BlockStoreNotify   notify,
+                                          gpointer           notify_data,
+                                          GError           **error);
+
+void            sample_commands_free     (SampleCommands    *commands);
+
+/* The section name of command @index, NULL past the last one */
+const gchar    *sample_commands_get_name (SampleCommands    *commands,
+                                          gint               index);
+
+/* Whether block @index has anything to show. Its markup is copied into
+ * @text, MAX_BLOCK_SIZE bytes, only if it changed since @serial, which
+ * is updated then. */
+gboolean        sample_commands_read     (SampleCommands    *commands,
+                                          gint               index,
+                                          guint             *serial,
+                                          gchar             *text);
+
+/* Run an interval command now rather than when it is due */
+void            sample_commands_refresh  (SampleCommands    *commands,
+                                          gint               index);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_COMMANDS_H__ */
@@ -0,0 +1,73 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "sample-config.h"
+
+static void
+sample_config_clear (gpointer data)
+{
+    SampleConfig *config = data;
+    
+    g_free(config->weather_location);
+    g_free(config->weather_url);
+    g_free(config->exchange_api_key);
+    g_free(config->exchange_sources);
+    g_free(config->network_exclude);
+    g_free(config->commands_file);
+}
+
+SampleConfig *
+sample_config_new (void)
+{
+    return g_atomic_rc_box_new0(SampleConfig);
+}
+
+/* Unpublished copy for the caller to edit */
+SampleConfig *
+sample_config_copy (const SampleConfig *config)
+{
+    SampleConfig *copy = g_atomic_rc_box_dup(sizeof(SampleConfig), config);
+    
+    copy->weather_location = g_strdup(config->weather_location);
+    copy->weather_url = g_strdup(config->weather_url);
+    copy->exchange_api_key = g_strdup(config->exchange_api_key);
+    copy->exchange_sources = g_strdup(config->exchange_sources);
+    copy->network_exclude = g_strdup(config->network_exclude);
+    copy->commands_file = g_strdup(config->commands_file);
+    copy->serial = 0;
+    
+    return copy;
+}
+
+SampleConfig *
+sample_config_ref (SampleConfig *config)
+{
+    return g_atomic_rc_box_acquire(config);
+}
+
+void
+sample_config_unref (SampleConfig *config)
+{
+    if (config)
+        g_atomic_rc_box_release_full(config, sample_config_clear);
+}
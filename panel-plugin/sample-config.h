@@ -0,0 +1,61 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_CONFIG_H__
+#define __SAMPLE_CONFIG_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Plugin settings as one reference counted snapshot. A published snapshot is
+ * never modified: the dialog edits a copy and publishes that as a whole, so
+ * worker threads can keep reading the one they hold without locking. */
+typedef struct {
+    gchar    *weather_location;    /* [name=]latitude,longitude, ';' separated */
+    gchar    *weather_url;         /* forecast service, NULL for WEATHER_DEFAULT_URL */
+    gchar    *exchange_api_key;    /* OpenExchangeRates API key */
+    gchar    *exchange_sources;    /* rate sources, ';' separated, NULL for the defaults */
+    gchar    *network_exclude;     /* interface patterns left out, ';' separated */
+    gchar    *commands_file;       /* command blocks, see sample-commands.h; NULL for none */
+    gint      exchange_budget;     /* exchange rate requests per month, 0 for no limit */
+    gint      update_interval;     /* Base update interval in seconds */
+    gboolean  show_weather;
+    gboolean  show_exchange;
+    gboolean  show_network;
+    gboolean  show_battery;
+    gboolean  show_memory;
+    gboolean  show_cpu;
+    gboolean  show_cpu_graph;      /* per-core mini bar graph */
+    gboolean  show_date;
+
+    gint      serial;              /* assigned when the snapshot is published */
+} SampleConfig;
+
+SampleConfig *sample_config_new   (void);
+
+SampleConfig *sample_config_copy  (const SampleConfig *config);
+
+SampleConfig *sample_config_ref   (SampleConfig *config);
+
+void          sample_config_unref (SampleConfig *config);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_CONFIG_H__ */
@@ -0,0 +1,265 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <fcntl.h>
+
+#include "sample-cpu.h"
+#include "sample-source.h"
+
+/* initial read buffer, grown once if the file does not fit */
+#define CPU_STAT_BUFFER_SIZE   8192
+/* initial counter slots, aggregate line included */
+#define CPU_STAT_INITIAL_SLOTS 64
+/* user nice system idle iowait irq softirq steal; guest time is part of user */
+#define CPU_STAT_N_FIELDS      8
+
+struct _CpuStat
+{
+    gint     fd;
+    gchar   *buffer;
+    gsize    buffer_size;
+
+    gint     n_slots;       /* slots seen in the last pass */
+    gint     capacity;      /* allocated slots */
+    guint64 *busy;
+    guint64 *total;
+    guint64 *prev_busy;
+    guint64 *prev_total;
+    gfloat  *usage;
+
+    gboolean primed;
+};
+
+static void
+cpu_stat_reserve (CpuStat *stat, gint n_slots)
+{
+    gint old_capacity = stat->capacity;
+    gint capacity = MAX(old_capacity, CPU_STAT_INITIAL_SLOTS);
+    gint extra;
+
+    while (capacity < n_slots)
+        capacity *= 2;
+    if (capacity == old_capacity)
+        return;
+
+    extra = capacity - old_capacity;
+    stat->busy = g_renew(guint64, stat->busy, capacity);
+    stat->total = g_renew(guint64, stat->total, capacity);
+    stat->prev_busy = g_renew(guint64, stat->prev_busy, capacity);
+    stat->prev_total = g_renew(guint64, stat->prev_total, capacity);
+    stat->usage = g_renew(gfloat, stat->usage, capacity);
+
+    memset(stat->busy + old_capacity, 0, extra * sizeof(guint64));
+    memset(stat->total + old_capacity, 0, extra * sizeof(guint64));
+    memset(stat->prev_busy + old_capacity, 0, extra * sizeof(guint64));
+    memset(stat->prev_total + old_capacity, 0, extra * sizeof(guint64));
+    memset(stat->usage + old_capacity, 0, extra * sizeof(gfloat));
+
+    stat->capacity = capacity;
+}
+
+static gssize
+cpu_stat_read (CpuStat *stat)
+{
+    gssize n;
+
+    for (;;) {
+        n = sample_source_pread(stat->fd, stat->buffer, stat->buffer_size - 1);
+        if (n < 0)
+            return -1;
+        if ((gsize)n < stat->buffer_size - 1)
+            break;
+
+        /* the file did not fit, this only happens on the first passes */
+        stat->buffer_size *= 2;
+        stat->buffer = g_realloc(stat->buffer, stat->buffer_size);
+    }
+
+    stat->buffer[n] = '\0';
+    return n;
+}
+
+static inline const gchar *
+parse_u64 (const gchar *p, guint64 *value)
+{
+    guint64 v = 0;
+
+    while (*p == ' ')
+        p++;
+    while (*p >= '0' && *p <= '9')
+        v = v * 10 + (guint64)(*p++ - '0');
+
+    *value = v;
+    return p;
+}
+
+/* Single pass over the cpu lines, which always come first in /proc/stat */
+static gboolean
+cpu_stat_parse (CpuStat *stat)
+{
+    const gchar *p = stat->buffer;
+    gint         n_slots = 0;
+
+    while (p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+        guint64 fields[CPU_STAT_N_FIELDS];
+        guint64 total = 0;
+        gint    slot = 0;
+
+        p += 3;
+        if (*p != ' ') {
+            guint64 index;
+            p = parse_u64(p, &index);
+            slot = (gint)index + 1;
+        }
+
+        for (gint i = 0; i < CPU_STAT_N_FIELDS; i++) {
+            p = parse_u64(p, &fields[i]);
+            total += fields[i];
+        }
+
+        if (G_UNLIKELY(slot >= stat->capacity))
+            cpu_stat_reserve(stat, slot + 1);
+
+        /* offline cores leave gaps, forget their counters */
+        for (gint i = n_slots; i < slot; i++) {
+            stat->busy[i] = 0;
+            stat->total[i] = 0;
+        }
+
+        stat->total[slot] = total;
+        stat->busy[slot] = total - fields[3] - fields[4];
+        n_slots = MAX(n_slots, slot + 1);
+
+        /* skip the guest columns */
+        p = strchr(p, '\n');
+        if (!p)
+            break;
+        p++;
+    }
+
+    /* and so do the highest ones when they went away */
+    for (gint i = n_slots; i < stat->n_slots; i++) {
+        stat->prev_busy[i] = 0;
+        stat->prev_total[i] = 0;
+    }
+
+    stat->n_slots = n_slots;
+    return n_slots > 0;
+}
+
+/* Kept branch-free over plain arrays so the compiler can vectorize it.
+ * A slot whose previous sample is zero has no delta yet: a core that was
+ * just plugged in, or one that went missing from the last pass. Counters
+ * going backwards are treated the same way rather than as a huge delta. */
+static void
+cpu_usage_kernel (const guint64 *restrict busy,
+                  const guint64 *restrict total,
+                  guint64       *restrict prev_busy,
+                  guint64       *restrict prev_total,
+                  gfloat        *restrict usage,
+                  gint                    n)
+{
+    for (gint i = 0; i < n; i++) {
+        guint64 d_busy = busy[i] - prev_busy[i];
+        guint64 d_total = total[i] - prev_total[i];
+        gboolean valid = prev_total[i] != 0 && total[i] > prev_total[i]
+                         && busy[i] >= prev_busy[i] && d_busy <= d_total;
+
+        usage[i] = valid ? (gfloat)d_busy / (gfloat)d_total : 0.0f;
+        prev_busy[i] = busy[i];
+        prev_total[i] = total[i];
+    }
+}
+
+CpuStat *
+cpu_stat_new (const gchar *path)
+{
+    CpuStat *stat;
+    gint     fd;
+
+    fd = sample_source_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    stat = g_new0(CpuStat, 1);
+    stat->fd = fd;
+    stat->buffer_size = CPU_STAT_BUFFER_SIZE;
+    stat->buffer = g_malloc(stat->buffer_size);
+    cpu_stat_reserve(stat, CPU_STAT_INITIAL_SLOTS);
+
+    return stat;
+}
+
+void
+cpu_stat_free (CpuStat *stat)
+{
+    if (!stat)
+        return;
+
+    sample_source_close(stat->fd);
+    g_free(stat->buffer);
+    g_free(stat->busy);
+    g_free(stat->total);
+    g_free(stat->prev_busy);
+    g_free(stat->prev_total);
+    g_free(stat->usage);
+    g_free(stat);
+}
+
+/* Take a sample; returns TRUE once there is a previous one to compare with */
+gboolean
+cpu_stat_sample (CpuStat *stat)
+{
+    gboolean primed;
+
+    if (cpu_stat_read(stat) < 0 || !cpu_stat_parse(stat))
+        return FALSE;
+
+    cpu_usage_kernel(stat->busy, stat->total, stat->prev_busy, stat->prev_total,
+                     stat->usage, stat->n_slots);
+
+    primed = stat->primed;
+    stat->primed = TRUE;
+    return primed;
+}
+
+gint
+cpu_stat_get_n_cores (CpuStat *stat)
+{
+    return MAX(stat->n_slots - 1, 0);
+}
+
+gfloat
+cpu_stat_get_total (CpuStat *stat)
+{
+    return stat->usage[0];
+}
+
+const gfloat *
+cpu_stat_get_cores (CpuStat *stat)
+{
+    return stat->usage + 1;
+}
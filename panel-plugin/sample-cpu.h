@@ -0,0 +1,46 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_CPU_H__
+#define __SAMPLE_CPU_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Delta sampler over /proc/stat. The file stays open and every sample is
+ * parsed in one pass into preallocated counter arrays, index 0 holding the
+ * aggregate "cpu" line and index n + 1 the line of "cpuN". */
+typedef struct _CpuStat CpuStat;
+
+CpuStat      *cpu_stat_new         (const gchar *path);
+
+void          cpu_stat_free        (CpuStat *stat);
+
+gboolean      cpu_stat_sample      (CpuStat *stat);
+
+gint          cpu_stat_get_n_cores (CpuStat *stat);
+
+gfloat        cpu_stat_get_total   (CpuStat *stat);
+
+const gfloat *cpu_stat_get_cores   (CpuStat *stat);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_CPU_H__ */
@@ -32,6 +32,9 @@
 
 #include "sample.h"
 #include "sample-dialogs.h"
+#ifdef ENABLE_EXCHANGE
+#include "sample-rates.h"
+#endif
 
 /* the website url */
 #define PLUGIN_WEBSITE "https://docs.xfce.org/panel-plugins/xfce4-sample-plugin"
@@ -59,26 +62,73 @@ sample_configure_response (GtkWidget    *dialog,
   else
     {
       /* Get widget pointers */
+#ifdef ENABLE_WEATHER
       GtkWidget *weather_location_entry = g_object_get_data(G_OBJECT(dialog), "weather_location_entry");
+#endif
+#ifdef ENABLE_EXCHANGE
       GtkWidget *exchange_api_key_entry = g_object_get_data(G_OBJECT(dialog), "exchange_api_key_entry");
+      GtkWidget *exchange_sources_entry = g_object_get_data(G_OBJECT(dialog), "exchange_sources_entry");
+      GtkWidget *exchange_budget_spin = g_object_get_data(G_OBJECT(dialog), "exchange_budget_spin");
+#endif
+      GtkWidget *network_exclude_entry = g_object_get_data(G_OBJECT(dialog), "network_exclude_entry");
+      GtkWidget *commands_file_entry = g_object_get_data(G_OBJECT(dialog), "commands_file_entry");
+#ifdef ENABLE_WEATHER
       GtkWidget *show_weather_check = g_object_get_data(G_OBJECT(dialog), "show_weather_check");
+#endif
+#ifdef ENABLE_EXCHANGE
       GtkWidget *show_exchange_check = g_object_get_data(G_OBJECT(dialog), "show_exchange_check");
+#endif
+      GtkWidget *show_network_check = g_object_get_data(G_OBJECT(dialog), "show_network_check");
+#ifdef ENABLE_BATTERY
       GtkWidget *show_battery_check = g_object_get_data(G_OBJECT(dialog), "show_battery_check");
+#endif
       GtkWidget *show_memory_check = g_object_get_data(G_OBJECT(dialog), "show_memory_check");
+      GtkWidget *show_cpu_check = g_object_get_data(G_OBJECT(dialog), "show_cpu_check");
+      GtkWidget *show_cpu_graph_check = g_object_get_data(G_OBJECT(dialog), "show_cpu_graph_check");
       GtkWidget *show_date_check = g_object_get_data(G_OBJECT(dialog), "show_date_check");
 
-      /* Update settings */
-      g_free(sample->weather_location);
-      sample->weather_location = g_strdup(gtk_entry_get_text(GTK_ENTRY(weather_location_entry)));
+      /* Build the new settings on a copy; workers keep reading the old
+       * snapshot until they pick up this one */
+      SampleConfig *config = sample_config_copy(sample_scheduler_get_config(sample->scheduler));
+
+      /* settings of blocks that are not built in are kept as they are */
+#ifdef ENABLE_WEATHER
+      g_free(config->weather_location);
+      config->weather_location = g_strdup(gtk_entry_get_text(GTK_ENTRY(weather_location_entry)));
+      
+#endif
+#ifdef ENABLE_EXCHANGE
+      g_free(config->exchange_api_key);
+      config->exchange_api_key = g_strdup(gtk_entry_get_text(GTK_ENTRY(exchange_api_key_entry)));
+      
+      g_free(config->exchange_sources);
+      config->exchange_sources = g_strdup(gtk_entry_get_text(GTK_ENTRY(exchange_sources_entry)));
+      
+      config->exchange_budget = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(exchange_budget_spin));
+      
+#endif
+      g_free(config->network_exclude);
+      config->network_exclude = g_strdup(gtk_entry_get_text(GTK_ENTRY(network_exclude_entry)));
       
-      g_free(sample->exchange_api_key);
-      sample->exchange_api_key = g_strdup(gtk_entry_get_text(GTK_ENTRY(exchange_api_key_entry)));
+      g_free(config->commands_file);
+      config->commands_file = g_strdup(gtk_entry_get_text(GTK_ENTRY(commands_file_entry)));
       
-      sample->show_weather = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_weather_check));
-      sample->show_exchange = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_exchange_check));
-      sample->show_battery = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_battery_check));
-      sample->show_memory = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_memory_check));
-      sample->show_date = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_date_check));
+#ifdef ENABLE_WEATHER
+      config->show_weather = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_weather_check));
+#endif
+#ifdef ENABLE_EXCHANGE
+      config->show_exchange = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_exchange_check));
+#endif
+      config->show_network = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_network_check));
+#ifdef ENABLE_BATTERY
+      config->show_battery = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_battery_check));
+#endif
+      config->show_memory = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_memory_check));
+      config->show_cpu = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_cpu_check));
+      config->show_cpu_graph = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_cpu_graph_check));
+      config->show_date = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(show_date_check));
+
+      sample_apply_config (sample, config);
 
       /* remove the dialog data from the plugin */
       g_object_set_data (G_OBJECT (sample->plugin), "dialog", NULL);
@@ -103,13 +153,27 @@ sample_configure (XfcePanelPlugin *plugin,
   GtkWidget *dialog;
   GtkWidget *grid;
   GtkWidget *label;
+#ifdef ENABLE_WEATHER
   GtkWidget *weather_location_entry;
-  GtkWidget *exchange_api_key_entry;
   GtkWidget *show_weather_check;
+#endif
+#ifdef ENABLE_EXCHANGE
+  GtkWidget *exchange_api_key_entry;
+  GtkWidget *exchange_sources_entry;
+  GtkWidget *exchange_budget_spin;
   GtkWidget *show_exchange_check;
+#endif
+  GtkWidget *network_exclude_entry;
+  GtkWidget *commands_file_entry;
+  GtkWidget *show_network_check;
+#ifdef ENABLE_BATTERY
   GtkWidget *show_battery_check;
+#endif
   GtkWidget *show_memory_check;
+  GtkWidget *show_cpu_check;
+  GtkWidget *show_cpu_graph_check;
   GtkWidget *show_date_check;
+  const SampleConfig *config = sample_scheduler_get_config (sample->scheduler);
   int row = 0;
 
   /* block the plugin menu */
@@ -138,33 +202,102 @@ sample_configure (XfcePanelPlugin *plugin,
   gtk_widget_set_margin_top(grid, 12);
   gtk_widget_set_margin_bottom(grid, 12);
 
+#ifdef ENABLE_WEATHER
   /* Weather location setting */
-  label = gtk_label_new(_("Weather Location (lat,long):"));
+  label = gtk_label_new(_("Weather Locations:"));
   gtk_label_set_xalign(GTK_LABEL(label), 0.0);
   gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
   
   weather_location_entry = gtk_entry_new();
-  if (sample->weather_location) {
-    gtk_entry_set_text(GTK_ENTRY(weather_location_entry), sample->weather_location);
+  if (config->weather_location) {
+    gtk_entry_set_text(GTK_ENTRY(weather_location_entry), config->weather_location);
   }
-  gtk_entry_set_placeholder_text(GTK_ENTRY(weather_location_entry), "e.g., 37.7749,-122.4194");
+  gtk_entry_set_placeholder_text(GTK_ENTRY(weather_location_entry), "e.g., Home=37.7749,-122.4194;Office=52.52,13.40");
+  gtk_widget_set_tooltip_text(weather_location_entry,
+                              _("One or more [name=]latitude,longitude entries separated by ';', "
+                                "fetched together in a single request"));
   gtk_grid_attach(GTK_GRID(grid), weather_location_entry, 1, row, 1, 1);
   row++;
+#endif
 
+#ifdef ENABLE_EXCHANGE
   /* Exchange API key setting */
   label = gtk_label_new(_("Exchange API Key:"));
   gtk_label_set_xalign(GTK_LABEL(label), 0.0);
   gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
   
   exchange_api_key_entry = gtk_entry_new();
-  if (sample->exchange_api_key) {
-    gtk_entry_set_text(GTK_ENTRY(exchange_api_key_entry), sample->exchange_api_key);
+  if (config->exchange_api_key) {
+    gtk_entry_set_text(GTK_ENTRY(exchange_api_key_entry), config->exchange_api_key);
   }
   gtk_entry_set_placeholder_text(GTK_ENTRY(exchange_api_key_entry), "OpenExchangeRates API key");
   gtk_entry_set_visibility(GTK_ENTRY(exchange_api_key_entry), FALSE); /* Hide for security */
   gtk_grid_attach(GTK_GRID(grid), exchange_api_key_entry, 1, row, 1, 1);
   row++;
 
+  /* Exchange rate sources */
+  label = gtk_label_new(_("Exchange Sources:"));
+  gtk_label_set_xalign(GTK_LABEL(label), 0.0);
+  gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+
+  exchange_sources_entry = gtk_entry_new();
+  if (config->exchange_sources) {
+    gtk_entry_set_text(GTK_ENTRY(exchange_sources_entry), config->exchange_sources);
+  }
+  gtk_entry_set_placeholder_text(GTK_ENTRY(exchange_sources_entry), RATE_DEFAULT_SOURCES);
+  gtk_widget_set_tooltip_text(exchange_sources_entry,
+                              _("Rate sources separated by ';', built-in names or name=URL entries "
+                                "answering like openexchangerates.org. Whichever has been quickest "
+                                "is asked first, the next one when it is slow to answer"));
+  gtk_grid_attach(GTK_GRID(grid), exchange_sources_entry, 1, row, 1, 1);
+  row++;
+
+  /* Exchange rate requests per month */
+  label = gtk_label_new(_("Exchange Requests:"));
+  gtk_label_set_xalign(GTK_LABEL(label), 0.0);
+  gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+
+  exchange_budget_spin = gtk_spin_button_new_with_range(0, 1000000, 100);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(exchange_budget_spin), config->exchange_budget);
+  gtk_widget_set_tooltip_text(exchange_budget_spin,
+                              _("Requests per month the exchange rates may take, spread over working "
+                                "hours first and left out while the markets are closed; 0 for no limit. "
+                                "With an openexchangerates.org key its reported quota counts too"));
+  gtk_grid_attach(GTK_GRID(grid), exchange_budget_spin, 1, row, 1, 1);
+  row++;
+#endif
+
+  /* Ignored network interfaces */
+  label = gtk_label_new(_("Ignored Interfaces:"));
+  gtk_label_set_xalign(GTK_LABEL(label), 0.0);
+  gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+
+  network_exclude_entry = gtk_entry_new();
+  if (config->network_exclude) {
+    gtk_entry_set_text(GTK_ENTRY(network_exclude_entry), config->network_exclude);
+  }
+  gtk_entry_set_placeholder_text(GTK_ENTRY(network_exclude_entry), "e.g., lo;docker*;veth*");
+  gtk_widget_set_tooltip_text(network_exclude_entry, _("Interface name patterns separated by ';', wildcards allowed"));
+  gtk_grid_attach(GTK_GRID(grid), network_exclude_entry, 1, row, 1, 1);
+  row++;
+
+  /* Command blocks */
+  label = gtk_label_new(_("Command Blocks:"));
+  gtk_label_set_xalign(GTK_LABEL(label), 0.0);
+  gtk_grid_attach(GTK_GRID(grid), label, 0, row, 1, 1);
+
+  commands_file_entry = gtk_entry_new();
+  if (config->commands_file) {
+    gtk_entry_set_text(GTK_ENTRY(commands_file_entry), config->commands_file);
+  }
+  gtk_entry_set_placeholder_text(GTK_ENTRY(commands_file_entry), "e.g., ~/.config/xfce4-sample-plugin/commands");
+  gtk_widget_set_tooltip_text(commands_file_entry,
+                              _("A file with one [name] section per block, each with a command and "
+                                "optionally its interval, timeout and markup=pango. It is read again "
+                                "whenever these settings are closed"));
+  gtk_grid_attach(GTK_GRID(grid), commands_file_entry, 1, row, 1, 1);
+  row++;
+
   /* Separator */
   gtk_grid_attach(GTK_GRID(grid), gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), 0, row, 2, 1);
   row++;
@@ -176,28 +309,50 @@ sample_configure (XfcePanelPlugin *plugin,
   gtk_grid_attach(GTK_GRID(grid), label, 0, row, 2, 1);
   row++;
 
+#ifdef ENABLE_WEATHER
   show_weather_check = gtk_check_button_new_with_label(_("Show Weather"));
-  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_weather_check), sample->show_weather);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_weather_check), config->show_weather);
   gtk_grid_attach(GTK_GRID(grid), show_weather_check, 0, row, 2, 1);
   row++;
+#endif
 
+#ifdef ENABLE_EXCHANGE
   show_exchange_check = gtk_check_button_new_with_label(_("Show Exchange Rates"));
-  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_exchange_check), sample->show_exchange);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_exchange_check), config->show_exchange);
   gtk_grid_attach(GTK_GRID(grid), show_exchange_check, 0, row, 2, 1);
   row++;
+#endif
+
+  show_network_check = gtk_check_button_new_with_label(_("Show Network Throughput"));
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_network_check), config->show_network);
+  gtk_grid_attach(GTK_GRID(grid), show_network_check, 0, row, 2, 1);
+  row++;
 
+#ifdef ENABLE_BATTERY
   show_battery_check = gtk_check_button_new_with_label(_("Show Battery"));
-  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_battery_check), sample->show_battery);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_battery_check), config->show_battery);
   gtk_grid_attach(GTK_GRID(grid), show_battery_check, 0, row, 2, 1);
   row++;
+#endif
+
+  show_cpu_check = gtk_check_button_new_with_label(_("Show CPU Usage"));
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_cpu_check), config->show_cpu);
+  gtk_grid_attach(GTK_GRID(grid), show_cpu_check, 0, row, 2, 1);
+  row++;
+
+  show_cpu_graph_check = gtk_check_button_new_with_label(_("Show per-core CPU graph"));
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_cpu_graph_check), config->show_cpu_graph);
+  gtk_widget_set_margin_start(show_cpu_graph_check, 18);
+  gtk_grid_attach(GTK_GRID(grid), show_cpu_graph_check, 0, row, 2, 1);
+  row++;
 
   show_memory_check = gtk_check_button_new_with_label(_("Show Memory Usage"));
-  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_memory_check), sample->show_memory);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_memory_check), config->show_memory);
   gtk_grid_attach(GTK_GRID(grid), show_memory_check, 0, row, 2, 1);
   row++;
 
   show_date_check = gtk_check_button_new_with_label(_("Show Date/Time"));
-  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_date_check), sample->show_date);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(show_date_check), config->show_date);
   gtk_grid_attach(GTK_GRID(grid), show_date_check, 0, row, 2, 1);
   row++;
 
@@ -206,12 +361,25 @@ sample_configure (XfcePanelPlugin *plugin,
   gtk_widget_show_all(grid);
 
   /* Store widget pointers for response handler */
+#ifdef ENABLE_WEATHER
   g_object_set_data(G_OBJECT(dialog), "weather_location_entry", weather_location_entry);
-  g_object_set_data(G_OBJECT(dialog), "exchange_api_key_entry", exchange_api_key_entry);
   g_object_set_data(G_OBJECT(dialog), "show_weather_check", show_weather_check);
+#endif
+#ifdef ENABLE_EXCHANGE
+  g_object_set_data(G_OBJECT(dialog), "exchange_api_key_entry", exchange_api_key_entry);
+  g_object_set_data(G_OBJECT(dialog), "exchange_sources_entry", exchange_sources_entry);
+  g_object_set_data(G_OBJECT(dialog), "exchange_budget_spin", exchange_budget_spin);
   g_object_set_data(G_OBJECT(dialog), "show_exchange_check", show_exchange_check);
+#endif
+  g_object_set_data(G_OBJECT(dialog), "network_exclude_entry", network_exclude_entry);
+  g_object_set_data(G_OBJECT(dialog), "commands_file_entry", commands_file_entry);
+  g_object_set_data(G_OBJECT(dialog), "show_network_check", show_network_check);
+#ifdef ENABLE_BATTERY
   g_object_set_data(G_OBJECT(dialog), "show_battery_check", show_battery_check);
+#endif
   g_object_set_data(G_OBJECT(dialog), "show_memory_check", show_memory_check);
+  g_object_set_data(G_OBJECT(dialog), "show_cpu_check", show_cpu_check);
+  g_object_set_data(G_OBJECT(dialog), "show_cpu_graph_check", show_cpu_graph_check);
   g_object_set_data(G_OBJECT(dialog), "show_date_check", show_date_check);
 
   /* link the dialog to the plugin, so we can destroy it when the plugin
@@ -0,0 +1,332 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sample-clock.h"
+#include "sample-export.h"
+
+/* blocks start on their own cache lines, so writing one does not slow
+ * down readers of its neighbours */
+#define EXPORT_ALIGN        64
+#define EXPORT_BLOCK_OFFSET EXPORT_ALIGN
+#define EXPORT_BLOCK_STRIDE ((sizeof(SampleExportBlock) + EXPORT_ALIGN - 1) & ~(gsize) (EXPORT_ALIGN - 1))
+#define EXPORT_SIZE         (EXPORT_BLOCK_OFFSET + BLOCK_COUNT * EXPORT_BLOCK_STRIDE)
+
+/* a writer stopped halfway leaves a block odd for good */
+#define EXPORT_READ_SPINS   10000
+
+G_STATIC_ASSERT(sizeof(SampleExportHeader) <= EXPORT_BLOCK_OFFSET);
+
+struct _SampleExport
+{
+    gchar              *path;
+    SampleExportHeader *header;
+};
+
+struct _SampleExportReader
+{
+    gchar              *path;
+    SampleExportHeader *header;
+    gsize               size;
+    guint64             retries;
+};
+
+static SampleExportBlock *
+export_block (SampleExportHeader *header, guint block_id)
+{
+    return (SampleExportBlock *) ((gchar *) header + header->block_offset
+                                  + (gsize) block_id * header->block_stride);
+}
+
+gchar *
+sample_export_default_path (const gchar *name)
+{
+    gchar *file = g_strconcat(name, ".blocks", NULL);
+    gchar *path = g_build_filename(g_get_user_runtime_dir(), "xfce4-sample-plugin", file, NULL);
+    
+    g_free(file);
+    
+    return path;
+}
+
+/* Readers of a file left behind by a writer that did not exit cleanly
+ * would keep reading it after it is replaced */
+static void
+export_close_stale (const gchar *path)
+{
+    SampleExportHeader header;
+    guint32 closed = 1;
+    gint fd = open(path, O_RDWR | O_CLOEXEC);
+    
+    if (fd < 0)
+        return;
+    
+    if (pread(fd, &header, sizeof(header), 0) == sizeof(header)
+        && memcmp(header.magic, SAMPLE_EXPORT_MAGIC, SAMPLE_EXPORT_MAGIC_LEN) == 0
+        && pwrite(fd, &closed, sizeof(closed), offsetof(SampleExportHeader, closed)) != sizeof(closed))
+        g_debug("Unable to mark %s closed, its readers stay on it: %s", path, g_strerror(errno));
+    close(fd);
+}
+
+SampleExport *
+sample_export_new (const gchar *path, GError **error)
+{
+    SampleExport *export;
+    SampleExportHeader *header;
+    gchar *dir = g_path_get_dirname(path);
+    gchar *tmp = g_strconcat(path, ".new", NULL);
+    gpointer map = MAP_FAILED;
+    gint fd = -1;
+    
+    /* build the file aside, readers only ever see a complete one */
+    if (g_mkdir_with_parents(dir, 0700) < 0
+        || (fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)) < 0
+        || ftruncate(fd, EXPORT_SIZE) < 0
+        || (map = mmap(NULL, EXPORT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        gint saved_errno = errno;
+        
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Unable to create %s: %s", tmp, g_strerror(saved_errno));
+        if (fd >= 0) {
+            close(fd);
+            g_unlink(tmp);
+        }
+        g_free(dir);
+        g_free(tmp);
+        return NULL;
+    }
+    close(fd);
+    
+    header = map;
+    memcpy(header->magic, SAMPLE_EXPORT_MAGIC, SAMPLE_EXPORT_MAGIC_LEN);
+    header->version = SAMPLE_EXPORT_VERSION;
+    header->header_size = sizeof(SampleExportHeader);
+    header->block_offset = EXPORT_BLOCK_OFFSET;
+    header->block_stride = EXPORT_BLOCK_STRIDE;
+    header->n_blocks = BLOCK_COUNT;
+    header->raw_size = sizeof(BlockSample);
+    header->pid = getpid();
+    for (guint i = 0; i < BLOCK_COUNT; i++)
+        g_strlcpy(export_block(header, i)->name, block_get_name(i), sizeof(export_block(header, i)->name));
+    
+    export_close_stale(path);
+    if (g_rename(tmp, path) < 0) {
+        gint saved_errno = errno;
+        
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Unable to create %s: %s", path, g_strerror(saved_errno));
+        munmap(map, EXPORT_SIZE);
+        g_unlink(tmp);
+        g_free(dir);
+        g_free(tmp);
+        return NULL;
+    }
+    g_free(dir);
+    g_free(tmp);
+    
+    export = g_new0(SampleExport, 1);
+    export->path = g_strdup(path);
+    export->header = header;
+    
+    return export;
+}
+
+void
+sample_export_free (SampleExport *export)
+{
+    if (!export)
+        return;
+    
+    __atomic_store_n(&export->header->closed, 1, __ATOMIC_RELEASE);
+    munmap(export->header, EXPORT_SIZE);
+    g_unlink(export->path);
+    g_free(export->path);
+    g_free(export);
+}
+
+/* The writing half of a seqlock: make the count odd before touching the
+ * block and even again after */
+void
+sample_export_write (SampleExport    *export,
+                     BlockId          block_id,
+                     const BlockData *block)
+{
+    SampleExportBlock *out;
+    guint32 sequence;
+    
+    if (!export || block_id >= BLOCK_COUNT)
+        return;
+    
+    out = export_block(export->header, block_id);
+    sequence = out->sequence;
+    __atomic_store_n(&out->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    out->len = block->len;
+    memcpy(out->text, block->data, block->len + 1);
+    out->updated = sample_clock_get_real();
+    out->fetched_at = block->fetched_at;
+    out->outdated = block->outdated;
+    out->serial = block->serial;
+    out->raw = block->raw;
+    
+    __atomic_store_n(&out->sequence, sequence + 2, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&export->header->generation, 1, __ATOMIC_RELEASE);
+}
+
+static gboolean
+export_reader_map (SampleExportReader *reader, GError **error)
+{
+    SampleExportHeader *header;
+    struct stat st;
+    gpointer map;
+    gint fd = open(reader->path, O_RDONLY | O_CLOEXEC);
+    
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        gint saved_errno = errno;
+        
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Unable to open %s: %s", reader->path, g_strerror(saved_errno));
+        if (fd >= 0)
+            close(fd);
+        return FALSE;
+    }
+    
+    map = (gsize) st.st_size >= sizeof(SampleExportHeader)
+          ? mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    
+    header = map;
+    if (map == MAP_FAILED
+        || memcmp(header->magic, SAMPLE_EXPORT_MAGIC, SAMPLE_EXPORT_MAGIC_LEN) != 0
+        || header->version != SAMPLE_EXPORT_VERSION
+        || header->raw_size != sizeof(BlockSample)
+        || header->block_stride < sizeof(SampleExportBlock)
+        || header->block_offset < header->header_size
+        || header->block_offset + (gsize) header->n_blocks * header->block_stride > (gsize) st.st_size) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                    "%s is not a block export of this version", reader->path);
+        if (map != MAP_FAILED)
+            munmap(map, st.st_size);
+        return FALSE;
+    }
+    
+    reader->header = header;
+    reader->size = st.st_size;
+    
+    return TRUE;
+}
+
+static void
+export_reader_unmap (SampleExportReader *reader)
+{
+    if (reader->header)
+        munmap(reader->header, reader->size);
+    reader->header = NULL;
+}
+
+SampleExportReader *
+sample_export_reader_open (const gchar *path, GError **error)
+{
+    SampleExportReader *reader = g_new0(SampleExportReader, 1);
+    
+    reader->path = g_strdup(path);
+    if (!export_reader_map(reader, error)) {
+        sample_export_reader_close(reader);
+        return NULL;
+    }
+    
+    return reader;
+}
+
+void
+sample_export_reader_close (SampleExportReader *reader)
+{
+    if (!reader)
+        return;
+    
+    export_reader_unmap(reader);
+    g_free(reader->path);
+    g_free(reader);
+}
+
+/* The reading half: copy the block, then check the count did not move */
+gboolean
+sample_export_reader_read (SampleExportReader *reader,
+                           BlockId             block_id,
+                           SampleExportBlock  *block)
+{
+    SampleExportBlock *in;
+    guint32 sequence;
+    
+    if (!reader->header || __atomic_load_n(&reader->header->closed, __ATOMIC_ACQUIRE)) {
+        export_reader_unmap(reader);
+        if (!export_reader_map(reader, NULL))
+            return FALSE;
+    }
+    if (block_id >= reader->header->n_blocks)
+        return FALSE;
+    
+    in = export_block(reader->header, block_id);
+    for (guint spins = 0; ; spins++) {
+        if (spins == EXPORT_READ_SPINS)
+            return FALSE;
+        
+        sequence = __atomic_load_n(&in->sequence, __ATOMIC_ACQUIRE);
+        if (!(sequence & 1)) {
+            memcpy(block, in, sizeof(*block));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&in->sequence, __ATOMIC_RELAXED) == sequence)
+                break;
+        }
+        reader->retries++;
+    }
+    
+    block->len = MIN(block->len, MAX_BLOCK_SIZE - 1);
+    block->text[block->len] = '\0';
+    block->name[sizeof(block->name) - 1] = '\0';
+    
+    return sequence != 0;
+}
+
+guint32
+sample_export_reader_get_generation (SampleExportReader *reader)
+{
+    return reader->header ? __atomic_load_n(&reader->header->generation, __ATOMIC_ACQUIRE) : 0;
+}
+
+guint64
+sample_export_reader_get_retries (SampleExportReader *reader)
+{
+    return reader->retries;
+}
@@ -0,0 +1,101 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_EXPORT_H__
+#define __SAMPLE_EXPORT_H__
+
+#include <glib.h>
+
+#include "sample-blocks.h"
+
+G_BEGIN_DECLS
+
+/* The current blocks published in a memory mapped file for other
+ * programs, by default under $XDG_RUNTIME_DIR/xfce4-sample-plugin. The
+ * file is a SampleExportHeader followed by one SampleExportBlock per
+ * block at block_offset + id * block_stride. Every block has its own
+ * sequence count, odd while the block is written, so a reader copies a
+ * block and retries if the count was odd or moved meanwhile; the header
+ * generation moves with every write. Readers never take a lock and make
+ * no system calls after mapping the file. A file is never resized: the
+ * writer creates a new one, renames it into place and marks the old one
+ * closed. Layout changes bump the version. */
+#define SAMPLE_EXPORT_MAGIC     "XSSBLOCK"
+#define SAMPLE_EXPORT_MAGIC_LEN 8
+#define SAMPLE_EXPORT_VERSION   1
+
+typedef struct {
+    gchar       magic[SAMPLE_EXPORT_MAGIC_LEN];
+    guint32     version;
+    guint32     header_size;
+    guint32     block_offset;
+    guint32     block_stride;
+    guint32     n_blocks;
+    guint32     raw_size;       /* sizeof(BlockSample) */
+    guint32     generation;     /* bumped by every block write */
+    guint32     closed;         /* the writer is gone, reopen the path */
+    gint64      pid;            /* of the writer */
+} SampleExportHeader;
+
+typedef struct {
+    guint32     sequence;       /* odd while the block is written */
+    guint32     len;
+    gint64      updated;        /* real time in µs of the last write */
+    gint64      fetched_at;     /* as in BlockData */
+    guint32     outdated;
+    guint32     serial;
+    gchar       name[16];
+    gchar       text[MAX_BLOCK_SIZE];
+    BlockSample raw;
+} SampleExportBlock;
+
+typedef struct _SampleExport SampleExport;
+typedef struct _SampleExportReader SampleExportReader;
+
+gchar              *sample_export_default_path  (const gchar         *name);
+
+/* Writing side; writes of one export must not run concurrently */
+SampleExport       *sample_export_new           (const gchar         *path,
+                                                 GError             **error);
+
+void                sample_export_free          (SampleExport        *export);
+
+void                sample_export_write         (SampleExport        *export,
+                                                 BlockId              block_id,
+                                                 const BlockData     *block);
+
+/* Reading side. A read returns FALSE for a block never written. Once
+ * the writer is gone, reads reopen the path and fail until it is back. */
+SampleExportReader *sample_export_reader_open   (const gchar         *path,
+                                                 GError             **error);
+
+void                sample_export_reader_close  (SampleExportReader  *reader);
+
+gboolean            sample_export_reader_read   (SampleExportReader  *reader,
+                                                 BlockId              block_id,
+                                                 SampleExportBlock   *block);
+
+guint32             sample_export_reader_get_generation (SampleExportReader *reader);
+
+/* Copies retried because a write was in progress, since the open */
+guint64             sample_export_reader_get_retries    (SampleExportReader *reader);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_EXPORT_H__ */
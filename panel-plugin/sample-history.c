@@ -0,0 +1,575 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sample-clock.h"
+#include "sample-history.h"
+
+#define HISTORY_HEADER_SIZE sizeof(SampleHistoryHeader)
+#define HISTORY_POINT_SIZE  sizeof(SampleHistoryPoint)
+
+static const struct {
+    const gchar *suffix;
+    gint64       bucket;    /* seconds */
+    gint64       keep;      /* seconds, 0 for ever */
+} history_levels[SAMPLE_HISTORY_N_LEVELS] = {
+    [SAMPLE_HISTORY_MINUTE] = { "minute", 60,    2 * 86400 },
+    [SAMPLE_HISTORY_HOUR]   = { "hour",   3600,  90 * 86400 },
+    [SAMPLE_HISTORY_DAY]    = { "day",    86400, 0 },
+};
+
+typedef struct {
+    gchar              *path;
+    gint                fd;         /* opened for appending, -1 if unusable */
+    gsize               size;       /* of the file */
+    const guint8       *map;        /* read only, of map_size bytes */
+    gsize               map_size;
+    gint64              end;        /* end of the last closed bucket, 0 for none */
+    GArray             *pending;    /* closed points not written yet */
+    SampleHistoryPoint  open;       /* bucket being filled, count 0 for none */
+} HistoryFile;
+
+typedef struct {
+    HistoryFile files[SAMPLE_HISTORY_N_LEVELS];
+} HistorySeries;
+
+/* A file rewritten to its retention outside the lock */
+typedef struct {
+    HistoryFile        *file;
+    SampleHistoryLevel  level;
+    gint                fd;         /* a duplicate, the file's own may be closed meanwhile */
+    gsize               size;       /* written when it was taken */
+    gint64              from;       /* first bucket kept */
+    gboolean            written;    /* the new file replaced the old one */
+} HistoryCompaction;
+
+struct _SampleHistory {
+    gchar      *dir;
+    GMutex      lock;
+    GHashTable *series;         /* name -> HistorySeries */
+    gint64      flushed_at;     /* sample clock, monotonic */
+    gboolean    compacting;     /* no flush until the compacted files are in */
+};
+
+static void
+history_point_merge (SampleHistoryPoint *into, const SampleHistoryPoint *point)
+{
+    gdouble count = (gdouble) into->count + point->count;
+    
+    into->mean = (into->mean * (gdouble) into->count + point->mean * (gdouble) point->count) / count;
+    into->min = MIN(into->min, point->min);
+    into->max = MAX(into->max, point->max);
+    into->count += point->count;
+}
+
+static gsize
+history_file_n_points (const HistoryFile *file)
+{
+    return file->size > HISTORY_HEADER_SIZE ? (file->size - HISTORY_HEADER_SIZE) / HISTORY_POINT_SIZE : 0;
+}
+
+/* Maps what was written so far; the mapping only changes after a flush */
+static const SampleHistoryPoint *
+history_file_points (HistoryFile *file)
+{
+    if (file->map && file->map_size != file->size) {
+        munmap((gpointer) file->map, file->map_size);
+        file->map = NULL;
+    }
+    if (!file->map && file->fd >= 0 && history_file_n_points(file) > 0) {
+        gpointer map = mmap(NULL, file->size, PROT_READ, MAP_SHARED, file->fd, 0);
+        
+        if (map == MAP_FAILED)
+            return NULL;
+        file->map = map;
+        file->map_size = file->size;
+    }
+    
+    return file->map ? (const SampleHistoryPoint *) (file->map + HISTORY_HEADER_SIZE) : NULL;
+}
+
+/* Index of the first of @n_points at or after @time */
+static gsize
+history_points_search (const SampleHistoryPoint *points, gsize n_points, gint64 time)
+{
+    gsize low = 0, high = n_points;
+    
+    while (low < high) {
+        gsize middle = low + (high - low) / 2;
+        
+        if (points[middle].time < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    
+    return low;
+}
+
+/* Index of the first written point at or after @time */
+static gsize
+history_file_search (HistoryFile *file, gint64 time)
+{
+    const SampleHistoryPoint *points = history_file_points(file);
+    
+    return points ? history_points_search(points, history_file_n_points(file), time) : 0;
+}
+
+static void
+history_file_close (HistoryFile *file)
+{
+    if (file->map)
+        munmap((gpointer) file->map, file->map_size);
+    file->map = NULL;
+    if (file->fd >= 0)
+        close(file->fd);
+    file->fd = -1;
+}
+
+/* Open or create the file, a damaged one starts over */
+static void
+history_file_open (HistoryFile *file, SampleHistoryLevel level)
+{
+    SampleHistoryHeader header = { SAMPLE_HISTORY_MAGIC, SAMPLE_HISTORY_VERSION, HISTORY_HEADER_SIZE,
+                                   HISTORY_POINT_SIZE, history_levels[level].bucket };
+    SampleHistoryHeader found;
+    SampleHistoryPoint last;
+    struct stat st;
+    
+    file->fd = open(file->path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (file->fd < 0 || fstat(file->fd, &st) < 0) {
+        g_warning("Unable to open %s: %s", file->path, g_strerror(errno));
+        history_file_close(file);
+        return;
+    }
+    file->size = st.st_size;
+    
+    if (file->size > 0
+        && (file->size < HISTORY_HEADER_SIZE
+            || pread(file->fd, &found, sizeof(found), 0) != sizeof(found)
+            || memcmp(&found, &header, sizeof(header)) != 0)) {
+        g_warning("%s is not a history file of this version, starting over", file->path);
+        file->size = 0;
+    }
+    
+    /* a point cut short by a crash */
+    if (file->size > 0)
+        file->size -= (file->size - HISTORY_HEADER_SIZE) % HISTORY_POINT_SIZE;
+    
+    if ((file->size != (gsize) st.st_size && ftruncate(file->fd, file->size) < 0)
+        || (file->size == 0 && write(file->fd, &header, sizeof(header)) != sizeof(header))) {
+        g_warning("Unable to write %s: %s", file->path, g_strerror(errno));
+        history_file_close(file);
+        return;
+    }
+    file->size = MAX(file->size, HISTORY_HEADER_SIZE);
+    
+    if (history_file_n_points(file) > 0
+        && pread(file->fd, &last, sizeof(last), file->size - HISTORY_POINT_SIZE) == sizeof(last))
+        file->end = last.time + history_levels[level].bucket;
+}
+
+/* Add a value or a closed point of the level below; a bucket it closes
+ * is rolled up into the level above */
+static void
+history_level_add (HistorySeries *series, SampleHistoryLevel level, const SampleHistoryPoint *point)
+{
+    HistoryFile *file = &series->files[level];
+    gint64 bucket = point->time - point->time % history_levels[level].bucket;
+    
+    if (bucket < file->end || (file->open.count > 0 && bucket < file->open.time))
+        return;
+    
+    if (file->open.count > 0 && bucket > file->open.time) {
+        SampleHistoryPoint closed = file->open;
+        
+        g_array_append_val(file->pending, closed);
+        file->end = closed.time + history_levels[level].bucket;
+        file->open.count = 0;
+        if (level + 1 < SAMPLE_HISTORY_N_LEVELS)
+            history_level_add(series, level + 1, &closed);
+    }
+    
+    if (file->open.count == 0) {
+        file->open = *point;
+        file->open.time = bucket;
+    } else {
+        history_point_merge(&file->open, point);
+    }
+}
+
+static void
+history_series_free (gpointer data)
+{
+    HistorySeries *series = data;
+    
+    for (gint level = 0; level < SAMPLE_HISTORY_N_LEVELS; level++) {
+        history_file_close(&series->files[level]);
+        g_array_unref(series->files[level].pending);
+        g_free(series->files[level].path);
+    }
+    g_free(series);
+}
+
+static HistorySeries *
+history_series_get (SampleHistory *history, const gchar *name)
+{
+    HistorySeries *series = g_hash_table_lookup(history->series, name);
+    
+    if (series)
+        return series;
+    
+    series = g_new0(HistorySeries, 1);
+    for (gint level = 0; level < SAMPLE_HISTORY_N_LEVELS; level++) {
+        HistoryFile *file = &series->files[level];
+        gchar *filename = g_strconcat(name, ".", history_levels[level].suffix, NULL);
+        
+        file->path = g_build_filename(history->dir, filename, NULL);
+        file->pending = g_array_new(FALSE, FALSE, HISTORY_POINT_SIZE);
+        history_file_open(file, level);
+        g_free(filename);
+    }
+    
+    /* the buckets that were still open when the history was last freed
+     * are rebuilt from the level below, the coarsest first so that the
+     * points rolled up on the way come in order */
+    for (gint level = SAMPLE_HISTORY_N_LEVELS - 1; level > 0; level--) {
+        HistoryFile *below = &series->files[level - 1];
+        const SampleHistoryPoint *points = history_file_points(below);
+        gsize n = history_file_n_points(below);
+        
+        for (gsize i = points ? history_file_search(below, series->files[level].end) : n; i < n; i++)
+            history_level_add(series, level, &points[i]);
+    }
+    
+    g_hash_table_insert(history->series, g_strdup(name), series);
+    
+    return series;
+}
+
+/* Keep the points from @compaction->from on, written to a new file that
+ * replaces the old one. Runs without the lock: the file is read through
+ * a mapping of its own and nothing is appended to it meanwhile. */
+static void
+history_compaction_write (HistoryCompaction *compaction)
+{
+    const gchar *path = compaction->file->path;
+    gsize n = (compaction->size - HISTORY_HEADER_SIZE) / HISTORY_POINT_SIZE;
+    const SampleHistoryPoint *points;
+    gchar *tmp = g_strconcat(path, ".new", NULL);
+    gpointer map;
+    gsize first;
+    gint fd;
+    
+    map = mmap(NULL, compaction->size, PROT_READ, MAP_SHARED, compaction->fd, 0);
+    if (map == MAP_FAILED) {
+        g_warning("Unable to compact %s: %s", path, g_strerror(errno));
+        g_free(tmp);
+        return;
+    }
+    points = (const SampleHistoryPoint *) ((const guint8 *) map + HISTORY_HEADER_SIZE);
+    first = history_points_search(points, n, compaction->from);
+    
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0
+        || write(fd, map, HISTORY_HEADER_SIZE) != HISTORY_HEADER_SIZE
+        || write(fd, points + first, (n - first) * HISTORY_POINT_SIZE) != (gssize) ((n - first) * HISTORY_POINT_SIZE)
+        || fsync(fd) < 0 || g_rename(tmp, path) < 0) {
+        g_warning("Unable to compact %s: %s", path, g_strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        g_unlink(tmp);
+    } else {
+        close(fd);
+        compaction->written = TRUE;
+        g_debug("Compacted %s from %" G_GSIZE_FORMAT " to %" G_GSIZE_FORMAT " points", path, n, n - first);
+    }
+    munmap(map, compaction->size);
+    g_free(tmp);
+}
+
+/* Writes the files taken by history_flush() and swaps them in */
+static void
+history_compact (SampleHistory *history, GArray *compactions)
+{
+    if (!compactions)
+        return;
+    
+    for (guint i = 0; i < compactions->len; i++)
+        history_compaction_write(&g_array_index(compactions, HistoryCompaction, i));
+    
+    g_mutex_lock(&history->lock);
+    for (guint i = 0; i < compactions->len; i++) {
+        HistoryCompaction *compaction = &g_array_index(compactions, HistoryCompaction, i);
+        
+        if (compaction->written) {
+            history_file_close(compaction->file);
+            history_file_open(compaction->file, compaction->level);
+        }
+        close(compaction->fd);
+    }
+    history->compacting = FALSE;
+    g_mutex_unlock(&history->lock);
+    
+    g_array_unref(compactions);
+}
+
+/* Appends what is pending; TRUE if the file holds twice its retention */
+static gboolean
+history_file_flush (HistoryFile *file, SampleHistoryLevel level)
+{
+    gsize len = file->pending->len * HISTORY_POINT_SIZE;
+    const gchar *data = file->pending->data;
+    gsize written = 0;
+    
+    while (file->fd >= 0 && written < len) {
+        gssize n = write(file->fd, data + written, len - written);
+        
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            /* what is left would only pile up */
+            g_warning("Unable to write %s: %s", file->path, g_strerror(errno));
+            break;
+        }
+        written += n;
+    }
+    file->size += written - written % HISTORY_POINT_SIZE;
+    g_array_set_size(file->pending, 0);
+    
+    if (history_levels[level].keep > 0) {
+        const SampleHistoryPoint *points = history_file_points(file);
+        
+        return points && points[0].time < file->end - 2 * history_levels[level].keep;
+    }
+    
+    return FALSE;
+}
+
+/* Writes what is pending, with the lock held. Files due for compaction
+ * are returned, to be passed to history_compact() once the lock is
+ * released; until then nothing else is flushed. */
+static GArray *
+history_flush (SampleHistory *history)
+{
+    GArray *compactions = NULL;
+    GHashTableIter iter;
+    gpointer series;
+    
+    g_hash_table_iter_init(&iter, history->series);
+    while (g_hash_table_iter_next(&iter, NULL, &series)) {
+        for (gint level = 0; level < SAMPLE_HISTORY_N_LEVELS; level++) {
+            HistoryFile *file = &((HistorySeries *) series)->files[level];
+            HistoryCompaction compaction;
+            
+            if (file->pending->len == 0 || !history_file_flush(file, level))
+                continue;
+            
+            compaction.file = file;
+            compaction.level = level;
+            compaction.size = file->size;
+            compaction.from = file->end - history_levels[level].keep;
+            compaction.written = FALSE;
+            compaction.fd = fcntl(file->fd, F_DUPFD_CLOEXEC, 0);
+            if (compaction.fd < 0) {
+                g_warning("Unable to compact %s: %s", file->path, g_strerror(errno));
+                continue;
+            }
+            if (!compactions)
+                compactions = g_array_new(FALSE, FALSE, sizeof(HistoryCompaction));
+            g_array_append_val(compactions, compaction);
+        }
+    }
+    history->flushed_at = sample_clock_get_monotonic();
+    history->compacting = compactions != NULL;
+    
+    return compactions;
+}
+
+/* Keep the history in @dir, created if needed */
+SampleHistory *
+sample_history_new (const gchar *dir, GError **error)
+{
+    SampleHistory *history;
+    
+    if (g_mkdir_with_parents(dir, 0700) < 0) {
+        gint saved_errno = errno;
+        
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Unable to create %s: %s", dir, g_strerror(saved_errno));
+        return NULL;
+    }
+    
+    history = g_new0(SampleHistory, 1);
+    history->dir = g_strdup(dir);
+    history->series = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, history_series_free);
+    history->flushed_at = sample_clock_get_monotonic();
+    g_mutex_init(&history->lock);
+    
+    return history;
+}
+
+void
+sample_history_free (SampleHistory *history)
+{
+    if (!history)
+        return;
+    
+    history_compact(history, history_flush(history));
+    g_hash_table_destroy(history->series);
+    g_mutex_clear(&history->lock);
+    g_free(history->dir);
+    g_free(history);
+}
+
+void
+sample_history_add (SampleHistory *history,
+                    const gchar   *series,
+                    gint64         time,
+                    gdouble        value)
+{
+    SampleHistoryPoint point = { time, value, value, value, 1 };
+    GArray *compactions = NULL;
+    
+    if (!history || time < 0)
+        return;
+    
+    g_mutex_lock(&history->lock);
+    history_level_add(history_series_get(history, series), SAMPLE_HISTORY_MINUTE, &point);
+    if (!history->compacting
+        && sample_clock_get_monotonic() - history->flushed_at >= SAMPLE_HISTORY_FLUSH_INTERVAL * G_USEC_PER_SEC)
+        compactions = history_flush(history);
+    g_mutex_unlock(&history->lock);
+    
+    /* the GUI thread reads summaries for tooltips, it must not wait for
+     * the rewrite and fsync */
+    history_compact(history, compactions);
+}
+
+/* Points of one level in the range, written ones first, then the
+ * pending ones and the open bucket; copied to @points if given, up to
+ * @max_points, and merged into @summary if given */
+static gint
+history_file_range (HistoryFile *file, gint64 from, gint64 to,
+                    SampleHistoryPoint *points, gint max_points, SampleHistoryPoint *summary)
+{
+    const SampleHistoryPoint *written = history_file_points(file);
+    gsize first = history_file_search(file, from);
+    gsize last = history_file_search(file, to);
+    gint n = 0;
+    
+    for (guint i = 0; i < file->pending->len + 1 + (last - first); i++) {
+        const SampleHistoryPoint *point;
+        
+        if (i < last - first)
+            point = &written[first + i];
+        else if (i - (last - first) < file->pending->len)
+            point = &g_array_index(file->pending, SampleHistoryPoint, i - (last - first));
+        else
+            point = &file->open;
+        
+        if (point->count == 0 || point->time < from || point->time >= to)
+            continue;
+        if (points && n < max_points)
+            points[n] = *point;
+        if (summary && summary->count == 0)
+            *summary = *point;
+        else if (summary)
+            history_point_merge(summary, point);
+        n++;
+    }
+    
+    return n;
+}
+
+static SampleHistoryLevel
+history_pick_level (HistorySeries *series, gint64 from, gint64 to, gint max_points)
+{
+    for (gint level = 0; level < SAMPLE_HISTORY_N_LEVELS - 1; level++) {
+        HistoryFile *file = &series->files[level];
+        gint64 end = file->open.count > 0 ? file->open.time + history_levels[level].bucket : file->end;
+        
+        if (from < end - history_levels[level].keep)
+            continue;
+        if (history_file_range(file, from, to, NULL, 0, NULL) <= max_points)
+            return level;
+    }
+    
+    return SAMPLE_HISTORY_N_LEVELS - 1;
+}
+
+gint
+sample_history_query (SampleHistory      *history,
+                      const gchar        *series,
+                      gint64              from,
+                      gint64              to,
+                      SampleHistoryPoint *points,
+                      gint                max_points)
+{
+    HistorySeries *found;
+    gint n;
+    
+    if (!history)
+        return 0;
+    
+    g_mutex_lock(&history->lock);
+    found = history_series_get(history, series);
+    n = history_file_range(&found->files[history_pick_level(found, from, to, max_points)],
+                           from, to, points, max_points, NULL);
+    g_mutex_unlock(&history->lock);
+    
+    return MIN(n, max_points);
+}
+
+gboolean
+sample_history_summary (SampleHistory      *history,
+                        const gchar        *series,
+                        gint64              from,
+                        gint64              to,
+                        SampleHistoryPoint *summary)
+{
+    HistorySeries *found;
+    
+    summary->count = 0;
+    if (!history)
+        return FALSE;
+    
+    /* every point of the finest level that still has the range is fine,
+     * they are only added up */
+    g_mutex_lock(&history->lock);
+    found = history_series_get(history, series);
+    history_file_range(&found->files[history_pick_level(found, from, to, G_MAXINT)],
+                       from, to, NULL, 0, summary);
+    g_mutex_unlock(&history->lock);
+    
+    return summary->count > 0;
+}
@@ -0,0 +1,109 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_HISTORY_H__
+#define __SAMPLE_HISTORY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Past values of a few numbers behind the blocks, e.g. the exchange
+ * rates, for charts and tooltips. Every series is kept at three
+ * resolutions, in one append-only file each below the history directory:
+ * <series>.minute, .hour and .day. A file is a SampleHistoryHeader
+ * followed by fixed size points in time order, so a range is found by
+ * binary search in a read-only mapping of the file. Values added within
+ * a minute are merged into one point, closed minutes are rolled up into
+ * the hour and hours into the day. Points are written in batches, at
+ * most every SAMPLE_HISTORY_FLUSH_INTERVAL and when the history is
+ * freed, so points of the last minutes are lost on a crash. The minute
+ * and hour files are compacted to their retention once they hold twice
+ * as much, into a new file written outside the lock, so queries only
+ * wait for the swap; days are kept for good. Times are Unix seconds,
+ * buckets are aligned in UTC. Thread safe. */
+#define SAMPLE_HISTORY_MAGIC          "XSSHIST"
+#define SAMPLE_HISTORY_MAGIC_LEN      8
+#define SAMPLE_HISTORY_VERSION        1
+
+#define SAMPLE_HISTORY_FLUSH_INTERVAL (5 * 60)
+
+/* the series the providers record */
+#define SAMPLE_HISTORY_TRY            "try"
+#define SAMPLE_HISTORY_RUB            "rub"
+#define SAMPLE_HISTORY_TEMPERATURE    "temperature"
+#define SAMPLE_HISTORY_MEMORY         "memory"
+
+typedef enum {
+    SAMPLE_HISTORY_MINUTE,        /* kept for 2 days */
+    SAMPLE_HISTORY_HOUR,          /* kept for 90 days */
+    SAMPLE_HISTORY_DAY,           /* kept */
+    SAMPLE_HISTORY_N_LEVELS
+} SampleHistoryLevel;
+
+typedef struct {
+    gchar       magic[SAMPLE_HISTORY_MAGIC_LEN];
+    guint32     version;
+    guint32     header_size;
+    guint32     point_size;
+    guint32     bucket;         /* seconds per point */
+} SampleHistoryHeader;
+
+typedef struct {
+    gint64      time;           /* start of the bucket */
+    gfloat      mean;
+    gfloat      min;
+    gfloat      max;
+    guint32     count;          /* values merged into the point */
+} SampleHistoryPoint;
+
+typedef struct _SampleHistory SampleHistory;
+
+SampleHistory *sample_history_new     (const gchar        *dir,
+                                       GError            **error);
+
+/* Writes what is pending */
+void           sample_history_free    (SampleHistory      *history);
+
+/* Values older than the last one of the series are dropped */
+void           sample_history_add     (SampleHistory      *history,
+                                       const gchar        *series,
+                                       gint64              time,
+                                       gdouble             value);
+
+/* Points from @from to before @to at the finest level that still holds
+ * @from and gives at most @max_points, the coarsest otherwise; returns
+ * how many were copied to @points */
+gint           sample_history_query   (SampleHistory      *history,
+                                       const gchar        *series,
+                                       gint64              from,
+                                       gint64              to,
+                                       SampleHistoryPoint *points,
+                                       gint                max_points);
+
+/* All points of such a range merged into one, FALSE if there are none */
+gboolean       sample_history_summary (SampleHistory      *history,
+                                       const gchar        *series,
+                                       gint64              from,
+                                       gint64              to,
+                                       SampleHistoryPoint *summary);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_HISTORY_H__ */
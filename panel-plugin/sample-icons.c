@@ -0,0 +1,79 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "sample-icons.h"
+
+/* the UTF-8 encodings in the header only cover the first 64 ids */
+G_STATIC_ASSERT(ICON_COUNT <= 64);
+
+static const struct {
+    const gchar *name;     /* themed symbolic icon, NULL to always use the emoji */
+    const gchar *emoji;
+} icons[ICON_COUNT] = {
+    [ICON_NONE]            = { NULL,                                "" },
+    [ICON_CALENDAR]        = { "x-office-calendar-symbolic",        "📅" },
+    [ICON_DAY]             = { "weather-clear-symbolic",            "☀️" },
+    [ICON_NIGHT]           = { "weather-clear-night-symbolic",      "🌙" },
+    [ICON_MEMORY]          = { "media-flash-symbolic",              "🗄️" },
+    [ICON_CPU]             = { "computer-symbolic",                 "🖥️" },
+    [ICON_NETWORK]         = { "network-transmit-receive-symbolic", "🌐" },
+    [ICON_BATTERY_EMPTY]   = { "battery-empty-symbolic",            "🔋" },
+    [ICON_BATTERY_CAUTION] = { "battery-caution-symbolic",          "🔋" },
+    [ICON_BATTERY_LOW]     = { "battery-low-symbolic",              "🔋" },
+    [ICON_BATTERY_GOOD]    = { "battery-good-symbolic",             "🔋" },
+    [ICON_BATTERY_FULL]    = { "battery-full-symbolic",             "🔋" },
+    [ICON_CHARGING]        = { "ac-adapter-symbolic",               "⚡" },
+    /* no themed counterparts for the temperature bands */
+    [ICON_TEMP_FREEZING]   = { NULL,                                "❄️" },
+    [ICON_TEMP_COLD]       = { NULL,                                "🥶" },
+    [ICON_TEMP_COOL]       = { NULL,                                "🌿" },
+    [ICON_TEMP_MILD]       = { NULL,                                "😊" },
+    [ICON_TEMP_WARM]       = { NULL,                                "🌡️" },
+    [ICON_TEMP_HOT]        = { NULL,                                "🔥" },
+};
+
+const gchar *
+sample_icon_get_name (IconId id)
+{
+    g_return_val_if_fail(id < ICON_COUNT, NULL);
+    
+    return icons[id].name;
+}
+
+const gchar *
+sample_icon_get_emoji (IconId id)
+{
+    g_return_val_if_fail(id < ICON_COUNT, "");
+    
+    return icons[id].emoji;
+}
+
+/* ICON_NONE for anything that is not an icon placeholder */
+IconId
+sample_icon_from_char (gunichar c)
+{
+    if (c <= ICON_CHAR_BASE || c >= ICON_CHAR_BASE + ICON_COUNT)
+        return ICON_NONE;
+    
+    return c - ICON_CHAR_BASE;
+}
@@ -0,0 +1,83 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_ICONS_H__
+#define __SAMPLE_ICONS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Icons shown in the blocks */
+typedef enum {
+    ICON_NONE = 0,
+    ICON_CALENDAR,
+    ICON_DAY,
+    ICON_NIGHT,
+    ICON_MEMORY,
+    ICON_CPU,
+    ICON_NETWORK,
+    ICON_BATTERY_EMPTY,
+    ICON_BATTERY_CAUTION,
+    ICON_BATTERY_LOW,
+    ICON_BATTERY_GOOD,
+    ICON_BATTERY_FULL,
+    ICON_CHARGING,
+    ICON_TEMP_FREEZING,
+    ICON_TEMP_COLD,
+    ICON_TEMP_COOL,
+    ICON_TEMP_MILD,
+    ICON_TEMP_WARM,
+    ICON_TEMP_HOT,
+    ICON_COUNT
+} IconId;
+
+/* Block markup references an icon with the private use character
+ * U+E000 + id, so the markup stays plain UTF-8 and whoever renders it
+ * decides how the icon is drawn. These are its UTF-8 encodings. */
+#define ICON_CHAR_BASE              0xE000
+
+#define ICON_CALENDAR_STR           "\xee\x80\x81"
+#define ICON_DAY_STR                "\xee\x80\x82"
+#define ICON_NIGHT_STR              "\xee\x80\x83"
+#define ICON_MEMORY_STR             "\xee\x80\x84"
+#define ICON_CPU_STR                "\xee\x80\x85"
+#define ICON_NETWORK_STR            "\xee\x80\x86"
+#define ICON_BATTERY_EMPTY_STR      "\xee\x80\x87"
+#define ICON_BATTERY_CAUTION_STR    "\xee\x80\x88"
+#define ICON_BATTERY_LOW_STR        "\xee\x80\x89"
+#define ICON_BATTERY_GOOD_STR       "\xee\x80\x8a"
+#define ICON_BATTERY_FULL_STR       "\xee\x80\x8b"
+#define ICON_CHARGING_STR           "\xee\x80\x8c"
+#define ICON_TEMP_FREEZING_STR      "\xee\x80\x8d"
+#define ICON_TEMP_COLD_STR          "\xee\x80\x8e"
+#define ICON_TEMP_COOL_STR          "\xee\x80\x8f"
+#define ICON_TEMP_MILD_STR          "\xee\x80\x90"
+#define ICON_TEMP_WARM_STR          "\xee\x80\x91"
+#define ICON_TEMP_HOT_STR           "\xee\x80\x92"
+
+const gchar *sample_icon_get_name  (IconId id);
+
+const gchar *sample_icon_get_emoji (IconId id);
+
+IconId       sample_icon_from_char (gunichar c);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_ICONS_H__ */
@@ -0,0 +1,373 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "sample-net.h"
+#include "sample-clock.h"
+
+/* enough for a few links of a dump per datagram */
+#define NET_BUFFER_SIZE     32768
+/* weight of the newest rate in the moving average */
+#define NET_RATE_SMOOTHING  0.3
+
+typedef struct {
+    NetInterface  pub;
+    guint64       prev_rx;
+    guint64       prev_tx;
+    gint64        prev_time;
+    gboolean      has_counters;
+    gboolean      primed;
+    gboolean      has_rate;
+    gboolean      seen;
+} NetEntry;
+
+typedef struct {
+    struct nlmsghdr  nlh;
+    struct ifinfomsg ifi;
+} NetRequest;
+
+struct _NetStat
+{
+    gint           fd;
+    guint32        port_id;
+    guint32        seq;
+    gboolean       resync;
+    GPatternSpec **exclude;
+    NetEntry       entries[NET_MAX_INTERFACES];
+    guint          n_entries;
+    NetRequest     requests[NET_MAX_INTERFACES];
+    gpointer       buffer;
+};
+
+static gboolean
+net_stat_excluded (NetStat *stat, const gchar *name)
+{
+    for (GPatternSpec **spec = stat->exclude; spec && *spec; spec++) {
+        if (g_pattern_match_string(*spec, name))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static NetEntry *
+net_stat_find (NetStat *stat, gint index)
+{
+    for (guint i = 0; i < stat->n_entries; i++) {
+        if (stat->entries[i].pub.index == index)
+            return &stat->entries[i];
+    }
+    return NULL;
+}
+
+static void
+net_stat_remove (NetStat *stat, NetEntry *entry)
+{
+    guint i = entry - stat->entries;
+
+    /* keep the order stable, it is the display order */
+    memmove(entry, entry + 1, (stat->n_entries - i - 1) * sizeof(NetEntry));
+    stat->n_entries--;
+}
+
+static void
+net_stat_handle_link (NetStat *stat, struct nlmsghdr *nlh)
+{
+    struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+    struct rtattr    *rta;
+    gint              len = IFLA_PAYLOAD(nlh);
+    const gchar      *name = NULL;
+    gconstpointer     stats = NULL;
+    NetEntry         *entry = net_stat_find(stat, ifi->ifi_index);
+
+    if (nlh->nlmsg_type == RTM_DELLINK) {
+        if (entry)
+            net_stat_remove(stat, entry);
+        return;
+    }
+
+    for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type == IFLA_IFNAME)
+            name = RTA_DATA(rta);
+        else if (rta->rta_type == IFLA_STATS64 && RTA_PAYLOAD(rta) >= sizeof(struct rtnl_link_stats64))
+            stats = RTA_DATA(rta);
+    }
+
+    if (!name)
+        return;
+
+    if (!entry) {
+        if (net_stat_excluded(stat, name) || stat->n_entries == NET_MAX_INTERFACES)
+            return;
+        entry = &stat->entries[stat->n_entries++];
+        memset(entry, 0, sizeof(*entry));
+        entry->pub.index = ifi->ifi_index;
+    }
+
+    g_strlcpy(entry->pub.name, name, sizeof(entry->pub.name));
+    entry->pub.up = (ifi->ifi_flags & IFF_UP) && (ifi->ifi_flags & IFF_RUNNING);
+    entry->seen = TRUE;
+
+    if (stats) {
+        struct rtnl_link_stats64 link_stats;
+
+        /* attribute data is only 4-byte aligned */
+        memcpy(&link_stats, stats, sizeof(link_stats));
+        entry->pub.rx_bytes = link_stats.rx_bytes;
+        entry->pub.tx_bytes = link_stats.tx_bytes;
+        entry->has_counters = TRUE;
+    }
+}
+
+/* Read and dispatch messages. Blocks until `expected` replies to `seq`
+ * (or the end of a dump) arrived, then drains whatever events are queued. */
+static gboolean
+net_stat_process (NetStat *stat, guint32 seq, guint expected, gboolean dump)
+{
+    guint replies = 0;
+
+    for (;;) {
+        gboolean         waiting = dump || replies < expected;
+        struct nlmsghdr *nlh;
+        gssize           n;
+
+        n = recv(stat->fd, stat->buffer, NET_BUFFER_SIZE, waiting ? 0 : MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ENOBUFS) {
+                /* events were dropped, the table needs a fresh dump */
+                stat->resync = TRUE;
+                continue;
+            }
+            /* EAGAIN is the end of the queue, or the receive timeout */
+            return !waiting && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        for (nlh = stat->buffer; NLMSG_OK(nlh, n); nlh = NLMSG_NEXT(nlh, n)) {
+            gboolean reply = seq != 0 && nlh->nlmsg_seq == seq && nlh->nlmsg_pid == stat->port_id;
+
+            switch (nlh->nlmsg_type) {
+                case NLMSG_DONE:
+                    if (reply)
+                        dump = FALSE;
+                    break;
+                case NLMSG_ERROR:
+                    /* a link that vanished meanwhile, its RTM_DELLINK follows */
+                    if (reply)
+                        replies++;
+                    break;
+                case RTM_NEWLINK:
+                case RTM_DELLINK:
+                    net_stat_handle_link(stat, nlh);
+                    if (reply && !dump)
+                        replies++;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+static gboolean
+net_stat_send (NetStat *stat, gconstpointer data, gsize size)
+{
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+
+    return sendto(stat->fd, data, size, 0, (struct sockaddr *)&kernel, sizeof(kernel)) == (gssize)size;
+}
+
+/* Rebuild the table from a full dump, at start and after lost events */
+static gboolean
+net_stat_dump (NetStat *stat)
+{
+    NetRequest request;
+
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.nlh.nlmsg_type = RTM_GETLINK;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nlh.nlmsg_seq = ++stat->seq;
+    request.ifi.ifi_family = AF_UNSPEC;
+
+    for (guint i = 0; i < stat->n_entries; i++)
+        stat->entries[i].seen = FALSE;
+
+    if (!net_stat_send(stat, &request, request.nlh.nlmsg_len)
+        || !net_stat_process(stat, request.nlh.nlmsg_seq, 0, TRUE))
+        return FALSE;
+
+    for (guint i = stat->n_entries; i > 0; i--) {
+        if (!stat->entries[i - 1].seen)
+            net_stat_remove(stat, &stat->entries[i - 1]);
+    }
+
+    stat->resync = FALSE;
+    return TRUE;
+}
+
+NetStat *
+net_stat_new (const gchar *exclude_patterns)
+{
+    NetStat            *stat;
+    struct sockaddr_nl  addr = { .nl_family = AF_NETLINK, .nl_groups = RTMGRP_LINK };
+    socklen_t           addr_len = sizeof(addr);
+    struct timeval      timeout = { .tv_sec = 1 };
+    gchar             **patterns;
+    guint               n_specs = 0;
+    gint                fd;
+
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0)
+        return NULL;
+
+    /* a lost reply must not hang the thread */
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || getsockname(fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    stat = g_new0(NetStat, 1);
+    stat->fd = fd;
+    stat->port_id = addr.nl_pid;
+    stat->buffer = g_malloc(NET_BUFFER_SIZE);
+
+    patterns = g_strsplit_set(exclude_patterns ? exclude_patterns : "", ";, ", -1);
+    stat->exclude = g_new0(GPatternSpec *, g_strv_length(patterns) + 1);
+    for (gchar **p = patterns; *p; p++) {
+        if (**p != '\0')
+            stat->exclude[n_specs++] = g_pattern_spec_new(*p);
+    }
+    g_strfreev(patterns);
+
+    if (!net_stat_dump(stat)) {
+        net_stat_free(stat);
+        return NULL;
+    }
+
+    return stat;
+}
+
+void
+net_stat_free (NetStat *stat)
+{
+    if (!stat)
+        return;
+
+    close(stat->fd);
+    for (GPatternSpec **spec = stat->exclude; *spec; spec++)
+        g_pattern_spec_free(*spec);
+    g_free(stat->exclude);
+    g_free(stat->buffer);
+    g_free(stat);
+}
+
+gboolean
+net_stat_sample (NetStat *stat)
+{
+    guint32 seq = ++stat->seq;
+    guint   n = 0;
+    gint64  now;
+
+    /* apply the add/remove events queued since the last sample */
+    if (!net_stat_process(stat, 0, 0, FALSE))
+        return FALSE;
+    if (stat->resync && !net_stat_dump(stat))
+        return FALSE;
+
+    /* one datagram carrying a non-dump RTM_GETLINK per tracked link */
+    for (guint i = 0; i < stat->n_entries; i++) {
+        NetRequest *request = &stat->requests[n++];
+
+        memset(request, 0, sizeof(*request));
+        request->nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+        request->nlh.nlmsg_type = RTM_GETLINK;
+        request->nlh.nlmsg_flags = NLM_F_REQUEST;
+        request->nlh.nlmsg_seq = seq;
+        request->ifi.ifi_family = AF_UNSPEC;
+        request->ifi.ifi_index = stat->entries[i].pub.index;
+    }
+
+    if (n > 0 && (!net_stat_send(stat, stat->requests, n * sizeof(NetRequest))
+                  || !net_stat_process(stat, seq, n, FALSE)))
+        return FALSE;
+
+    now = sample_clock_get_monotonic();
+    for (guint i = 0; i < stat->n_entries; i++) {
+        NetEntry *entry = &stat->entries[i];
+
+        if (!entry->has_counters)
+            continue;
+
+        if (entry->primed && now > entry->prev_time) {
+            gdouble dt = (now - entry->prev_time) / (gdouble)G_USEC_PER_SEC;
+            /* counters restart when a link is recreated */
+            gdouble rx = entry->pub.rx_bytes >= entry->prev_rx ? (entry->pub.rx_bytes - entry->prev_rx) / dt : 0.0;
+            gdouble tx = entry->pub.tx_bytes >= entry->prev_tx ? (entry->pub.tx_bytes - entry->prev_tx) / dt : 0.0;
+
+            if (entry->has_rate) {
+                entry->pub.rx_rate += NET_RATE_SMOOTHING * (rx - entry->pub.rx_rate);
+                entry->pub.tx_rate += NET_RATE_SMOOTHING * (tx - entry->pub.tx_rate);
+            } else {
+                entry->pub.rx_rate = rx;
+                entry->pub.tx_rate = tx;
+                entry->has_rate = TRUE;
+            }
+        }
+
+        entry->prev_rx = entry->pub.rx_bytes;
+        entry->prev_tx = entry->pub.tx_bytes;
+        entry->prev_time = now;
+        entry->primed = TRUE;
+    }
+
+    return TRUE;
+}
+
+guint
+net_stat_get_n_interfaces (NetStat *stat)
+{
+    return stat->n_entries;
+}
+
+const NetInterface *
+net_stat_get_interface (NetStat *stat, guint i)
+{
+    g_return_val_if_fail(i < stat->n_entries, NULL);
+
+    return &stat->entries[i].pub;
+}
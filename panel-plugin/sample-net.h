@@ -0,0 +1,61 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_NET_H__
+#define __SAMPLE_NET_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define NET_MAX_INTERFACES 16
+#define NET_NAME_SIZE      16
+
+/* Default interfaces left out of the network block */
+#define NET_DEFAULT_EXCLUDE "lo;docker*;veth*;br-*;virbr*;vnet*"
+
+typedef struct {
+    gchar    name[NET_NAME_SIZE];
+    gint     index;
+    gboolean up;
+    guint64  rx_bytes;
+    guint64  tx_bytes;
+    gdouble  rx_rate;       /* smoothed bytes per second */
+    gdouble  tx_rate;
+} NetInterface;
+
+/* Link statistics over one persistent rtnetlink socket. The interface
+ * table is filled by a dump once and then follows RTM_NEWLINK/RTM_DELLINK
+ * events; every sample asks for IFLA_STATS64 of the tracked links only. */
+typedef struct _NetStat NetStat;
+
+NetStat            *net_stat_new              (const gchar *exclude_patterns);
+
+void                net_stat_free             (NetStat *stat);
+
+gboolean            net_stat_sample           (NetStat *stat);
+
+guint               net_stat_get_n_interfaces (NetStat *stat);
+
+const NetInterface *net_stat_get_interface    (NetStat *stat,
+                                               guint    i);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_NET_H__ */
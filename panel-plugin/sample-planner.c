@@ -0,0 +1,325 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <time.h>
+
+#include "sample-planner.h"
+
+#define PLANNER_SEGMENT 3600
+
+struct _SamplePlanner {
+    guint   budget;         /* requests per month, 0 for none */
+    gint    limit;          /* requests per period, -1 for none */
+    gint    remaining;      /* this period, -1 for no limit */
+    gint    min_interval;
+    gint64  period_start;
+    gint64  period_end;
+};
+
+static gint64
+planner_add_months (gint64 time, gint months)
+{
+    GDateTime *dt = g_date_time_new_from_unix_utc(time);
+    GDateTime *added = g_date_time_add_months(dt, months);
+    gint64 result = g_date_time_to_unix(added);
+    
+    g_date_time_unref(added);
+    g_date_time_unref(dt);
+    
+    return result;
+}
+
+static gint64
+planner_month_start (gint64 time)
+{
+    GDateTime *dt = g_date_time_new_from_unix_utc(time);
+    GDateTime *start = g_date_time_new_utc(g_date_time_get_year(dt), g_date_time_get_month(dt), 1, 0, 0, 0);
+    gint64 result = g_date_time_to_unix(start);
+    
+    g_date_time_unref(start);
+    g_date_time_unref(dt);
+    
+    return result;
+}
+
+gboolean
+sample_planner_market_open (gint64 time)
+{
+    /* 1970-01-01 was a Thursday */
+    gint weekday = (time / 86400 + 4) % 7;
+    gint hour = time % 86400 / 3600;
+    
+    return !((weekday == 5 && hour >= 21) || weekday == 6 || (weekday == 0 && hour < 21));
+}
+
+/* Weight of the hour that @time is in, which ends at @end */
+static gint
+planner_segment (gint64 time, gint64 *end)
+{
+    time_t local = time;
+    struct tm tm;
+    
+    *end = time - time % PLANNER_SEGMENT + PLANNER_SEGMENT;
+    if (!sample_planner_market_open(time))
+        return 0;
+    if (!localtime_r(&local, &tm))
+        return 1;
+    
+    return tm.tm_wday >= 1 && tm.tm_wday <= 5
+           && tm.tm_hour >= SAMPLE_PLANNER_WORK_START && tm.tm_hour < SAMPLE_PLANNER_WORK_END
+           ? SAMPLE_PLANNER_WORK_WEIGHT : 1;
+}
+
+/* Weighted seconds from @from to @to */
+static gdouble
+planner_weight (gint64 from, gint64 to)
+{
+    gdouble sum = 0.0;
+    gint64 end;
+    
+    for (gint64 t = from; t < to; t = end) {
+        gint weight = planner_segment(t, &end);
+        
+        sum += (gdouble) weight * (MIN(end, to) - t);
+    }
+    
+    return sum;
+}
+
+gint64
+sample_planner_open_seconds (gint64 from, gint64 to)
+{
+    gint64 sum = 0, end;
+    
+    for (gint64 t = from; t < to; t = end) {
+        end = t - t % PLANNER_SEGMENT + PLANNER_SEGMENT;
+        if (sample_planner_market_open(t))
+            sum += MIN(end, to) - t;
+    }
+    
+    return sum;
+}
+
+static gint64
+planner_next_open (gint64 time)
+{
+    while (!sample_planner_market_open(time))
+        time = time - time % PLANNER_SEGMENT + PLANNER_SEGMENT;
+    
+    return time;
+}
+
+/* Start the next period once the current one is over, with a full budget */
+static void
+planner_sync (SamplePlanner *planner, gint64 now)
+{
+    while (now >= planner->period_end) {
+        planner->period_start = planner->period_end;
+        planner->period_end = planner_add_months(planner->period_start, 1);
+        planner->remaining = planner->limit;
+    }
+}
+
+SamplePlanner *
+sample_planner_new (guint budget, gint min_interval, gint64 now)
+{
+    SamplePlanner *planner = g_new0(SamplePlanner, 1);
+    
+    planner->budget = budget;
+    planner->limit = budget > 0 ? (gint) MIN(budget, G_MAXINT) : -1;
+    planner->min_interval = MAX(min_interval, 1);
+    planner->period_start = planner_month_start(now);
+    planner->period_end = planner_add_months(planner->period_start, 1);
+    planner->remaining = planner->limit;
+    
+    /* assume the budget was spent as planned so far */
+    if (planner->limit > 0) {
+        gdouble total = planner_weight(planner->period_start, planner->period_end);
+        gdouble past = planner_weight(planner->period_start, now);
+        
+        if (total > 0.0)
+            planner->remaining -= (gint) (planner->limit * (past / total) + 0.999);
+        planner->remaining = MAX(planner->remaining, 0);
+    }
+    
+    return planner;
+}
+
+void
+sample_planner_free (SamplePlanner *planner)
+{
+    g_free(planner);
+}
+
+void
+sample_planner_set_usage (SamplePlanner *planner, gint64 now, const SamplePlannerUsage *usage)
+{
+    gint quota = usage->quota > 0 ? usage->quota : -1;
+    gint remaining = quota > 0 && usage->remaining >= 0 ? usage->remaining : -1;
+    
+    if (planner->budget > 0) {
+        gint budget = (gint) MIN(planner->budget, G_MAXINT);
+        gint left = usage->used >= 0 ? MAX(budget - usage->used, 0) : planner->remaining;
+        
+        quota = quota > 0 ? MIN(quota, budget) : budget;
+        remaining = remaining >= 0 ? MIN(remaining, left) : left;
+    }
+    
+    /* the period ends after the rest of today and the days remaining */
+    if (usage->days_remaining >= 0) {
+        planner->period_end = now - now % 86400 + ((gint64) usage->days_remaining + 1) * 86400;
+        planner->period_start = planner_add_months(planner->period_end, -1);
+    }
+    planner->limit = quota;
+    planner->remaining = remaining;
+    planner->min_interval = MAX(planner->min_interval, usage->update_interval);
+    
+    g_debug("Exchange rates: %d of %d requests left until %" G_GINT64_FORMAT,
+            planner->remaining, planner->limit, planner->period_end);
+}
+
+gboolean
+sample_planner_may_fetch (SamplePlanner *planner, gint64 now)
+{
+    planner_sync(planner, now);
+    
+    return planner->remaining != 0;
+}
+
+void
+sample_planner_count (SamplePlanner *planner, gint64 now)
+{
+    planner_sync(planner, now);
+    if (planner->remaining > 0)
+        planner->remaining--;
+}
+
+/* Fetches from @n segments at one per @share weighted seconds, but at
+ * most one per minimum interval */
+static gdouble
+planner_count_fetches (const gint *weights, const gint64 *seconds, gint n, gint min_interval, gdouble share)
+{
+    gdouble fetches = 0.0;
+    
+    for (gint i = 0; i < n; i++)
+        fetches += MIN(weights[i] * seconds[i] / share, (gdouble) seconds[i] / min_interval);
+    
+    return fetches;
+}
+
+/* Weighted seconds per request that spend what is left by the end of the
+ * period. Where the weight would ask for fetches closer than the minimum
+ * interval the rest of the budget goes to the other hours. */
+static gdouble
+planner_share (SamplePlanner *planner, gint64 now)
+{
+    gint n = 0, size = (planner->period_end - now) / PLANNER_SEGMENT + 2;
+    gint *weights = g_new(gint, size);
+    gint64 *seconds = g_new(gint64, size);
+    gdouble low = planner->min_interval, high = 0.0;
+    gint64 end;
+    
+    for (gint64 t = now; t < planner->period_end && n < size; t = end, n++) {
+        weights[n] = planner_segment(t, &end);
+        seconds[n] = MIN(end, planner->period_end) - t;
+        high += (gdouble) weights[n] * seconds[n];
+    }
+    high /= planner->remaining;
+    
+    /* all open hours at the shortest interval still fit */
+    if (high <= low || planner_count_fetches(weights, seconds, n, planner->min_interval, low) <= planner->remaining) {
+        high = MIN(high, low);
+    } else {
+        for (gint i = 0; i < 32; i++) {
+            gdouble middle = (low + high) / 2.0;
+            
+            if (planner_count_fetches(weights, seconds, n, planner->min_interval, middle) > planner->remaining)
+                low = middle;
+            else
+                high = middle;
+        }
+    }
+    g_free(weights);
+    g_free(seconds);
+    
+    return high;
+}
+
+gint64
+sample_planner_next (SamplePlanner *planner, gint64 now, gint64 last)
+{
+    gint64 next = last + planner->min_interval;
+    
+    planner_sync(planner, now);
+    if (planner->remaining == 0)
+        return planner->period_end;
+    
+    /* walk that share of weight from the last fetch on, with the weight
+     * capped where it would come sooner than the minimum interval */
+    if (planner->remaining > 0) {
+        gdouble share = planner_share(planner, now);
+        gdouble cap = share / planner->min_interval;
+        gint64 t = last, end;
+        
+        if (share <= 0.0)
+            return planner->period_end;
+        
+        while (t < planner->period_end) {
+            gdouble weight = MIN(planner_segment(t, &end), cap);
+            
+            if (weight * (end - t) >= share) {
+                t += (gint64) (share / weight);
+                break;
+            }
+            share -= weight * (end - t);
+            t = end;
+        }
+        next = MAX(next, MIN(t, planner->period_end));
+    }
+    
+    return planner_next_open(MAX(next, now));
+}
+
+/* Clicks pull the planned fetch forward, but no more than halfway, so
+ * that they cannot eat up a small budget early in the period */
+gboolean
+sample_planner_may_refresh (SamplePlanner *planner, gint64 now, gint64 last)
+{
+    gint64 next = sample_planner_next(planner, now, last);
+    
+    return planner->remaining != 0 && sample_planner_market_open(now) && now - last >= (next - last) / 2;
+}
+
+gint
+sample_planner_get_remaining (SamplePlanner *planner, gint64 now)
+{
+    planner_sync(planner, now);
+    
+    return planner->remaining;
+}
+
+gint64
+sample_planner_get_period_end (SamplePlanner *planner)
+{
+    return planner->period_end;
+}
@@ -0,0 +1,98 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_PLANNER_H__
+#define __SAMPLE_PLANNER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* When to fetch the exchange rates so that a monthly request budget
+ * lasts. The requests left are spread over the rest of the billing
+ * period by weight: nothing while the FX market is closed (Friday 21:00
+ * to Sunday 21:00 UTC, the rates do not move), SAMPLE_PLANNER_WORK_WEIGHT
+ * during local working hours (Monday to Friday, 8:00 to 18:00) and 1
+ * otherwise, so working hours get the most fetches. Fetches are never
+ * planned closer than the minimum interval, and none are allowed once the
+ * budget is spent. Without usage data of the API the period is the UTC
+ * calendar month, and the share of the budget for the part already past
+ * counts as spent. Times are Unix seconds; the planner reads no clock, so
+ * it can be driven through a simulated month. Not thread safe. */
+#define SAMPLE_PLANNER_WORK_WEIGHT  3
+#define SAMPLE_PLANNER_WORK_START   8
+#define SAMPLE_PLANNER_WORK_END     18
+
+/* Usage of the API key as reported by the service, -1 where unknown */
+typedef struct {
+    gint    used;               /* requests this period */
+    gint    quota;              /* requests per period, -1 for unlimited too */
+    gint    remaining;
+    gint    days_remaining;     /* whole days after today */
+    gint    update_interval;    /* seconds between rate updates of the plan */
+} SamplePlannerUsage;
+
+typedef struct _SamplePlanner SamplePlanner;
+
+/* @budget is in requests per month, 0 for no limit */
+SamplePlanner *sample_planner_new            (guint                     budget,
+                                              gint                      min_interval,
+                                              gint64                    now);
+
+void           sample_planner_free           (SamplePlanner            *planner);
+
+/* Take the period and what is left of it from the service; the budget
+ * still applies if it is lower */
+void           sample_planner_set_usage      (SamplePlanner            *planner,
+                                              gint64                    now,
+                                              const SamplePlannerUsage *usage);
+
+/* Whether a fetch now stays within the budget */
+gboolean       sample_planner_may_fetch      (SamplePlanner            *planner,
+                                              gint64                    now);
+
+/* Whether a click may fetch ahead of the plan after the fetch at @last */
+gboolean       sample_planner_may_refresh    (SamplePlanner            *planner,
+                                              gint64                    now,
+                                              gint64                    last);
+
+/* Count a request made at @now */
+void           sample_planner_count          (SamplePlanner            *planner,
+                                              gint64                    now);
+
+/* When to fetch after the fetch at @last, @now if overdue */
+gint64         sample_planner_next           (SamplePlanner            *planner,
+                                              gint64                    now,
+                                              gint64                    last);
+
+/* Requests left this period, -1 for no limit */
+gint           sample_planner_get_remaining  (SamplePlanner            *planner,
+                                              gint64                    now);
+
+gint64         sample_planner_get_period_end (SamplePlanner            *planner);
+
+gboolean       sample_planner_market_open    (gint64                    time);
+
+/* Seconds of open market from @from to @to */
+gint64         sample_planner_open_seconds   (gint64                    from,
+                                              gint64                    to);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_PLANNER_H__ */
@@ -0,0 +1,184 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef ENABLE_BATTERY
+#include <fcntl.h>
+#include <glib-unix.h>
+#include <libudev.h>
+#endif
+
+#include "sample-power.h"
+#include "sample-source.h"
+
+struct _SamplePower
+{
+#ifdef ENABLE_BATTERY
+    struct udev         *udev;
+    struct udev_monitor *monitor;
+    guint                monitor_source;
+#endif
+    gboolean             on_battery;
+    SamplePowerNotify    notify;
+    gpointer             notify_data;
+};
+
+#ifdef ENABLE_BATTERY
+/* Only runs at startup and on power_supply events, never per tick */
+static gboolean
+sample_power_probe (SamplePower *power)
+{
+    struct udev_enumerate *enumerate = udev_enumerate_new(power->udev);
+    struct udev_list_entry *entry;
+    gboolean has_mains = FALSE;
+    gboolean online = FALSE;
+    
+    udev_enumerate_add_match_subsystem(enumerate, "power_supply");
+    udev_enumerate_add_match_sysattr(enumerate, "type", "Mains");
+    udev_enumerate_scan_devices(enumerate);
+    
+    udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(enumerate)) {
+        struct udev_device *device =
+            udev_device_new_from_syspath(power->udev, udev_list_entry_get_name(entry));
+        
+        if (!device)
+            continue;
+        
+        has_mains = TRUE;
+        if (g_strcmp0(udev_device_get_sysattr_value(device, "online"), "1") == 0)
+            online = TRUE;
+        udev_device_unref(device);
+    }
+    udev_enumerate_unref(enumerate);
+    
+    return has_mains && !online;
+}
+
+/* A copied tree has no udev database to enumerate, so the adapters are
+ * looked up under the names drivers commonly give them. Replayed traces
+ * do not carry them and count as on AC. */
+static gboolean
+sample_power_probe_source (void)
+{
+    static const gchar *adapters[] = { "AC", "AC0", "ACAD", "ADP0", "ADP1" };
+    gboolean has_mains = FALSE;
+    gboolean online = FALSE;
+    
+    for (guint i = 0; i < G_N_ELEMENTS(adapters); i++) {
+        gchar path[64], buffer[4];
+        gint fd;
+        
+        g_snprintf(path, sizeof(path), "/sys/class/power_supply/%s/online", adapters[i]);
+        fd = sample_source_open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        
+        has_mains = TRUE;
+        if (sample_source_pread(fd, buffer, sizeof(buffer)) > 0 && buffer[0] == '1')
+            online = TRUE;
+        sample_source_close(fd);
+    }
+    
+    return has_mains && !online;
+}
+
+static gboolean
+sample_power_event (gint fd, GIOCondition condition, gpointer data)
+{
+    SamplePower *power = data;
+    struct udev_device *device;
+    gboolean on_battery;
+    
+    /* the event only says something changed, the adapters say what */
+    while ((device = udev_monitor_receive_device(power->monitor)))
+        udev_device_unref(device);
+    
+    on_battery = sample_power_probe(power);
+    if (on_battery != power->on_battery) {
+        power->on_battery = on_battery;
+        g_debug("Running on %s power", on_battery ? "battery" : "AC");
+        if (power->notify)
+            power->notify(on_battery, power->notify_data);
+    }
+    
+    return G_SOURCE_CONTINUE;
+}
+#endif /* ENABLE_BATTERY */
+
+SamplePower *
+sample_power_new (SamplePowerNotify notify,
+                  gpointer          user_data)
+{
+    SamplePower *power = g_slice_new0(SamplePower);
+    
+    power->notify = notify;
+    power->notify_data = user_data;
+    
+    /* without udev the machine is taken to be on AC; a copied tree or a
+     * trace is read once, it does not change while it is used */
+#ifdef ENABLE_BATTERY
+    if (!sample_source_is_live()) {
+        power->on_battery = sample_power_probe_source();
+        return power;
+    }
+    
+    power->udev = udev_new();
+    if (!power->udev)
+        return power;
+    
+    power->on_battery = sample_power_probe(power);
+    
+    power->monitor = udev_monitor_new_from_netlink(power->udev, "udev");
+    if (power->monitor) {
+        udev_monitor_filter_add_match_subsystem_devtype(power->monitor, "power_supply", NULL);
+        udev_monitor_enable_receiving(power->monitor);
+        power->monitor_source = g_unix_fd_add(udev_monitor_get_fd(power->monitor), G_IO_IN,
+                                              sample_power_event, power);
+    }
+#endif
+    
+    return power;
+}
+
+void
+sample_power_free (SamplePower *power)
+{
+    if (!power)
+        return;
+    
+#ifdef ENABLE_BATTERY
+    if (power->monitor_source != 0)
+        g_source_remove(power->monitor_source);
+    if (power->monitor)
+        udev_monitor_unref(power->monitor);
+    if (power->udev)
+        udev_unref(power->udev);
+#endif
+    
+    g_slice_free(SamplePower, power);
+}
+
+gboolean
+sample_power_on_battery (SamplePower *power)
+{
+    return power->on_battery;
+}
@@ -0,0 +1,46 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_POWER_H__
+#define __SAMPLE_POWER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Whether the machine runs on battery, from the power_supply class. It
+ * counts as on battery when it has a mains adapter and none is online,
+ * so desktops never are. Changes arrive as udev events on the thread
+ * default main context; under a copied /sys it is read from there once.
+ * Built without the battery block, the machine is always on AC. */
+typedef struct _SamplePower SamplePower;
+
+typedef void (*SamplePowerNotify) (gboolean on_battery,
+                                   gpointer user_data);
+
+SamplePower *sample_power_new        (SamplePowerNotify notify,
+                                      gpointer          user_data);
+
+void         sample_power_free       (SamplePower *power);
+
+gboolean     sample_power_on_battery (SamplePower *power);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_POWER_H__ */
@@ -0,0 +1,372 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "sample-procs.h"
+#include "sample-source.h"
+
+#define PROC_DIRENT_BUFFER_SIZE (32 * 1024)
+#define PROC_STATM_BUFFER_SIZE  128
+#define PROC_ROLLUP_BUFFER_SIZE 1024
+
+/* statm descriptors kept open, at most a quarter of the descriptor limit */
+#define PROC_MAX_RETAINED_FDS   512
+
+#define PROC_FD_NONE   (-1)     /* opened for each scan */
+#define PROC_FD_KERNEL (-2)     /* a kernel thread, never has memory */
+
+/* What getdents64 fills in, glibc has no declaration before 2.30 */
+struct proc_dirent64 {
+    guint64        d_ino;
+    gint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+};
+
+typedef struct {
+    gint     pid;
+    gint     statm_fd;
+    guint    generation;    /* of the last scan that listed it */
+    gchar    name[PROC_NAME_SIZE];
+    gulong   rss_kb;
+} ProcEntry;
+
+struct _ProcStat
+{
+    gint        proc_fd;
+    gchar      *dirents;
+    GHashTable *entries;           /* pid -> ProcEntry */
+    guint       generation;
+    guint       n_procs;
+    guint       n_retained;
+    guint       max_retained;
+    gulong      page_kb;
+
+    /* the biggest processes of a scan, a min-heap on rss_kb */
+    ProcEntry  *heap[PROC_TOP_MAX];
+    gint        n_heap;
+};
+
+ProcStat *
+proc_stat_new (const gchar *path)
+{
+    ProcStat *stat;
+    struct rlimit limit;
+    gint proc_fd;
+    
+    /* the listing is not part of a trace */
+    if (sample_source_is_traced())
+        return NULL;
+    
+    proc_fd = sample_source_open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0)
+        return NULL;
+    
+    stat = g_new0(ProcStat, 1);
+    stat->proc_fd = proc_fd;
+    stat->dirents = g_malloc(PROC_DIRENT_BUFFER_SIZE);
+    stat->entries = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    stat->page_kb = MAX(sysconf(_SC_PAGESIZE) / 1024, 1);
+    stat->max_retained = PROC_MAX_RETAINED_FDS;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+        stat->max_retained = MIN(stat->max_retained, limit.rlim_cur / 4);
+    
+    return stat;
+}
+
+static void
+proc_entry_release (ProcStat *stat, ProcEntry *entry)
+{
+    if (entry->statm_fd >= 0) {
+        sample_source_close(entry->statm_fd);
+        stat->n_retained--;
+    }
+    entry->statm_fd = PROC_FD_NONE;
+}
+
+static gboolean
+proc_entry_release_all (gpointer key, gpointer value, gpointer data)
+{
+    proc_entry_release(data, value);
+    
+    return TRUE;
+}
+
+void
+proc_stat_free (ProcStat *stat)
+{
+    if (!stat)
+        return;
+    
+    g_hash_table_foreach_remove(stat->entries, proc_entry_release_all, stat);
+    g_hash_table_unref(stat->entries);
+    sample_source_close(stat->proc_fd);
+    g_free(stat->dirents);
+    g_free(stat);
+}
+
+/* Reads a small file of a process, the descriptor is not kept */
+static gssize
+proc_read_file (ProcStat *stat, gint pid, const gchar *name, gchar *buffer, gsize size)
+{
+    gchar path[32];
+    gssize n;
+    gint fd;
+    
+    g_snprintf(path, sizeof(path), "%d/%s", pid, name);
+    fd = sample_source_openat(stat->proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    
+    n = sample_source_pread(fd, buffer, size - 1);
+    sample_source_close(fd);
+    
+    if (n >= 0)
+        buffer[n] = '\0';
+    
+    return n;
+}
+
+/* FALSE once the process is gone */
+static gboolean
+proc_entry_read (ProcStat *stat, ProcEntry *entry)
+{
+    gchar buffer[PROC_STATM_BUFFER_SIZE];
+    gchar path[32];
+    gulong size, resident;
+    gssize n;
+    gint fd;
+    
+    if (entry->statm_fd == PROC_FD_KERNEL)
+        return TRUE;
+    
+    fd = entry->statm_fd;
+    if (fd < 0) {
+        g_snprintf(path, sizeof(path), "%d/statm", entry->pid);
+        fd = sample_source_openat(stat->proc_fd, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return FALSE;
+    }
+    
+    n = sample_source_pread(fd, buffer, sizeof(buffer) - 1);
+    
+    /* a kept descriptor reads nothing once its process exited */
+    if (n <= 0) {
+        if (fd != entry->statm_fd)
+            sample_source_close(fd);
+        return FALSE;
+    }
+    buffer[n] = '\0';
+    
+    if (sscanf(buffer, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    entry->rss_kb = resident * stat->page_kb;
+    
+    if (fd != entry->statm_fd) {
+        if (size == 0) {
+            entry->statm_fd = PROC_FD_KERNEL;
+            sample_source_close(fd);
+        } else if (stat->n_retained < stat->max_retained) {
+            entry->statm_fd = fd;
+            stat->n_retained++;
+        } else {
+            sample_source_close(fd);
+        }
+    }
+    
+    return TRUE;
+}
+
+static void
+proc_heap_sift_down (ProcEntry **heap, gint n, gint i)
+{
+    for (;;) {
+        gint smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        ProcEntry *swap;
+        
+        if (left < n && heap[left]->rss_kb < heap[smallest]->rss_kb)
+            smallest = left;
+        if (right < n && heap[right]->rss_kb < heap[smallest]->rss_kb)
+            smallest = right;
+        if (smallest == i)
+            return;
+        
+        swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+/* Keeps the @n_top biggest entries seen so far */
+static void
+proc_heap_offer (ProcStat *stat, ProcEntry *entry, gint n_top)
+{
+    if (entry->rss_kb == 0)
+        return;
+    
+    if (stat->n_heap < n_top) {
+        gint i = stat->n_heap++;
+        
+        stat->heap[i] = entry;
+        while (i > 0 && stat->heap[(i - 1) / 2]->rss_kb > stat->heap[i]->rss_kb) {
+            ProcEntry *swap = stat->heap[i];
+            
+            stat->heap[i] = stat->heap[(i - 1) / 2];
+            stat->heap[(i - 1) / 2] = swap;
+            i = (i - 1) / 2;
+        }
+    } else if (entry->rss_kb > stat->heap[0]->rss_kb) {
+        stat->heap[0] = entry;
+        proc_heap_sift_down(stat->heap, stat->n_heap, 0);
+    }
+}
+
+static void
+proc_stat_visit (ProcStat *stat, gint pid, gint n_top)
+{
+    ProcEntry *entry = g_hash_table_lookup(stat->entries, GINT_TO_POINTER(pid));
+    
+    /* a failed read of a kept descriptor may be a reused pid */
+    if (entry && !proc_entry_read(stat, entry)) {
+        proc_entry_release(stat, entry);
+        g_hash_table_remove(stat->entries, GINT_TO_POINTER(pid));
+        entry = NULL;
+    }
+    
+    if (!entry) {
+        entry = g_new0(ProcEntry, 1);
+        entry->pid = pid;
+        entry->statm_fd = PROC_FD_NONE;
+        if (!proc_entry_read(stat, entry)) {
+            g_free(entry);
+            return;
+        }
+        g_hash_table_insert(stat->entries, GINT_TO_POINTER(pid), entry);
+    }
+    
+    entry->generation = stat->generation;
+    stat->n_procs++;
+    proc_heap_offer(stat, entry, n_top);
+}
+
+static gboolean
+proc_entry_unseen (gpointer key, gpointer value, gpointer data)
+{
+    ProcStat *stat = data;
+    ProcEntry *entry = value;
+    
+    if (entry->generation == stat->generation)
+        return FALSE;
+    
+    proc_entry_release(stat, entry);
+    
+    return TRUE;
+}
+
+/* The PSS line of smaps_rollup, 0 when it cannot be read */
+static gulong
+proc_read_pss (ProcStat *stat, gint pid)
+{
+    gchar buffer[PROC_ROLLUP_BUFFER_SIZE];
+    const gchar *line;
+    
+    if (proc_read_file(stat, pid, "smaps_rollup", buffer, sizeof(buffer)) <= 0)
+        return 0;
+    
+    line = strstr(buffer, "\nPss:");
+    
+    return line ? strtoul(line + strlen("\nPss:"), NULL, 10) : 0;
+}
+
+gint
+proc_stat_scan (ProcStat *stat, ProcUsage *top, gint n_top)
+{
+    glong n;
+    
+    n_top = CLAMP(n_top, 0, PROC_TOP_MAX);
+    stat->generation++;
+    stat->n_procs = 0;
+    stat->n_heap = 0;
+    
+    if (lseek(stat->proc_fd, 0, SEEK_SET) < 0)
+        return -1;
+    
+    while ((n = syscall(SYS_getdents64, stat->proc_fd, stat->dirents, PROC_DIRENT_BUFFER_SIZE)) > 0) {
+        for (glong pos = 0; pos < n; ) {
+            struct proc_dirent64 *dirent = (struct proc_dirent64 *) (stat->dirents + pos);
+            const gchar *name = dirent->d_name;
+            gint pid = 0;
+            
+            pos += dirent->d_reclen;
+            if (dirent->d_type != DT_DIR && dirent->d_type != DT_UNKNOWN)
+                continue;
+            
+            while (g_ascii_isdigit(*name))
+                pid = pid * 10 + (*name++ - '0');
+            if (*name == '\0' && pid > 0)
+                proc_stat_visit(stat, pid, n_top);
+        }
+    }
+    if (n < 0)
+        return -1;
+    
+    /* processes that exited since the last scan */
+    g_hash_table_foreach_remove(stat->entries, proc_entry_unseen, stat);
+    
+    /* the heap pops smallest first, fill from the back */
+    for (gint i = stat->n_heap - 1; i >= 0; i--) {
+        ProcEntry *entry = stat->heap[0];
+        ProcUsage *usage = &top[i];
+        
+        stat->heap[0] = stat->heap[i];
+        proc_heap_sift_down(stat->heap, i, 0);
+        
+        if (entry->name[0] == '\0'
+            && proc_read_file(stat, entry->pid, "comm", entry->name, sizeof(entry->name)) > 0)
+            g_strchomp(entry->name);
+        
+        usage->pid = entry->pid;
+        g_strlcpy(usage->name, entry->name, sizeof(usage->name));
+        usage->rss_kb = entry->rss_kb;
+        usage->pss_kb = proc_read_pss(stat, entry->pid);
+    }
+    
+    return stat->n_heap;
+}
+
+guint
+proc_stat_get_n_procs (ProcStat *stat)
+{
+    return stat->n_procs;
+}
@@ -0,0 +1,60 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_PROCS_H__
+#define __SAMPLE_PROCS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define PROC_NAME_SIZE 16
+#define PROC_TOP_MAX   8
+
+typedef struct {
+    gint     pid;
+    gchar    name[PROC_NAME_SIZE];
+    gulong   rss_kb;
+    gulong   pss_kb;        /* 0 when not readable */
+} ProcUsage;
+
+/* Resident memory of all processes, to list the biggest ones. The process
+ * directory is read with getdents64, and a statm descriptor stays open
+ * per process across scans, up to a limit, so a rescan costs one pread
+ * per process. Kernel threads are skipped after the first scan. Only the
+ * listed processes have their PSS read. The files are read through the
+ * sample source, from the live system or a copy under its root; there is
+ * no scanner while a trace is recorded or replayed, as a trace holds no
+ * directory listings. */
+typedef struct _ProcStat ProcStat;
+
+ProcStat  *proc_stat_new         (const gchar *path);
+
+void       proc_stat_free        (ProcStat    *stat);
+
+/* Fills @top with up to @n_top processes, biggest first; -1 on failure */
+gint       proc_stat_scan        (ProcStat    *stat,
+                                  ProcUsage   *top,
+                                  gint         n_top);
+
+guint      proc_stat_get_n_procs (ProcStat    *stat);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_PROCS_H__ */
@@ -0,0 +1,943 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sample-providers.h"
+#ifdef ENABLE_BATTERY
+#include "sample-battery.h"
+#endif
+#include "sample-cache.h"
+#include "sample-clock.h"
+#include "sample-cpu.h"
+#include "sample-history.h"
+#include "sample-icons.h"
+#include "sample-net.h"
+#include "sample-procs.h"
+#ifdef ENABLE_EXCHANGE
+#include "sample-planner.h"
+#include "sample-rates.h"
+#endif
+#include "sample-scheduler.h"
+#include "sample-source.h"
+#include "sample-trace.h"
+#ifdef ENABLE_WEATHER
+#include "sample-weather.h"
+#endif
+
+#ifdef ENABLE_WEATHER
+/* Weather is interpolated every tick from an hourly forecast that is
+ * refetched once it ages out, or sooner after a failed fetch. A forecast
+ * older than WEATHER_CACHE_TTL is still used but shown as out of date. */
+#define WEATHER_FORECAST_TTL    (6 * 3600)
+#define WEATHER_CACHE_TTL       (12 * 3600)
+#define WEATHER_RETRY_INTERVAL  (5 * 60)
+#define WEATHER_TICK_INTERVAL   60
+
+/* What the weather cache holds per location list */
+typedef struct {
+    gint            n_forecasts;
+    WeatherForecast forecasts[WEATHER_MAX_LOCATIONS];
+} WeatherCacheValue;
+#endif /* ENABLE_WEATHER */
+
+#ifdef ENABLE_EXCHANGE
+#define EXCHANGE_UPDATE_INTERVAL (30 * 60)
+#define EXCHANGE_CACHE_TTL       (3 * 3600)
+#define EXCHANGE_RETRY_INTERVAL  (5 * 60)
+#define EXCHANGE_USAGE_INTERVAL  (6 * 3600)
+#endif
+
+/* /proc/meminfo is about 1.5K, only its head is parsed */
+#define MEMINFO_BUFFER_SIZE 4096
+
+#ifdef ENABLE_BATTERY
+/* the first of BAT0 to BAT3 there is, without allocating */
+#define BATTERY_SYSFS_PATH "/sys/class/power_supply/BAT%d"
+#define BATTERY_MAX_PROBED 4
+#endif
+
+/* cores are averaged into at most this many bars of the CPU graph */
+#define CPU_GRAPH_MAX_BARS 16
+
+/* an interface name with every byte escaped as an entity */
+#define NET_NAME_ESCAPED_SIZE (NET_NAME_SIZE * 6)
+
+/* Thread functions */
+static gpointer date_thread_func (gpointer data);
+static gpointer memory_thread_func (gpointer data);
+#ifdef ENABLE_WEATHER
+static gpointer weather_thread_func (gpointer data);
+#endif
+#ifdef ENABLE_EXCHANGE
+static gpointer exchange_thread_func (gpointer data);
+#endif
+#ifdef ENABLE_BATTERY
+static gpointer battery_thread_func (gpointer data);
+#endif
+static gpointer cpu_thread_func (gpointer data);
+static gpointer net_thread_func (gpointer data);
+
+/* Worker of each block, indexed by BlockId. The remote ones keep clicks
+ * from spending the API quota and serve from a cache; only the clock has
+ * to stay on the minute when running on battery. Blocks compiled out
+ * have no worker. */
+static const SampleProvider providers[BLOCK_COUNT] = {
+#ifdef ENABLE_WEATHER
+    [BLOCK_WEATHER]       = { "weather_thread",  weather_thread_func,  5 * 60,  TRUE,  FALSE,
+                              sizeof(WeatherCacheValue), WEATHER_FORECAST_TTL, WEATHER_CACHE_TTL },
+#endif
+#ifdef ENABLE_EXCHANGE
+    [BLOCK_EXCHANGE_RATE] = { "exchange_thread", exchange_thread_func, 10 * 60, TRUE,  FALSE,
+                              sizeof(ExchangeSample), EXCHANGE_UPDATE_INTERVAL, EXCHANGE_CACHE_TTL },
+#endif
+    [BLOCK_NETWORK]       = { "net_thread",      net_thread_func,      1,       FALSE, FALSE },
+#ifdef ENABLE_BATTERY
+    [BLOCK_BATTERY]       = { "battery_thread",  battery_thread_func,  1,       FALSE, FALSE },
+#endif
+    [BLOCK_CPU]           = { "cpu_thread",      cpu_thread_func,      1,       FALSE, FALSE },
+    [BLOCK_MEMORY]        = { "memory_thread",   memory_thread_func,   1,       FALSE, FALSE },
+    [BLOCK_DATE]          = { "date_thread",     date_thread_func,     1,       FALSE, TRUE },
+};
+
+/* Utility functions */
+static gboolean get_memory_info (gint *fd, MemorySample *memory);
+
+const SampleProvider *
+sample_provider_get (BlockId block_id)
+{
+    g_return_val_if_fail(block_id < BLOCK_COUNT, NULL);
+    
+    return &providers[block_id];
+}
+
+/* Whether the block was compiled in */
+gboolean
+sample_provider_available (BlockId block_id)
+{
+    return sample_provider_get(block_id)->func != NULL;
+}
+
+/* Whether @url names this machine, e.g. a mock server */
+static gboolean
+url_is_loopback (const gchar *url)
+{
+    gchar *host = NULL;
+    gboolean loopback;
+    
+    if (!url || !g_uri_split(url, G_URI_FLAGS_NONE, NULL, NULL, &host, NULL, NULL, NULL, NULL, NULL))
+        return FALSE;
+    
+    loopback = host && (g_ascii_strcasecmp(host, "localhost") == 0 || strcmp(host, "::1") == 0
+                        || (g_hostname_is_ip_address(host) && g_str_has_prefix(host, "127.")));
+    g_free(host);
+    
+    return loopback;
+}
+
+/* Whether every request of a remote block goes to this machine: a
+ * forecast URL or rate sources that are all "name=URL" entries, see
+ * sample-rates.h */
+static gboolean
+remote_provider_loopback (const SampleConfig *config, BlockId block_id)
+{
+    gboolean loopback = FALSE;
+    gchar **entries;
+    
+    switch (block_id) {
+        case BLOCK_WEATHER:
+            return url_is_loopback(config->weather_url);
+        case BLOCK_EXCHANGE_RATE:
+            if (!config->exchange_sources)
+                return FALSE;
+            
+            entries = g_strsplit(config->exchange_sources, ";", -1);
+            for (gchar **entry = entries; *entry; entry++) {
+                gchar *url = strchr(g_strstrip(*entry), '=');
+                
+                if (**entry == '\0')
+                    continue;
+                loopback = url && url_is_loopback(g_strstrip(url + 1));
+                if (!loopback)
+                    break;
+            }
+            g_strfreev(entries);
+            
+            return loopback;
+        default:
+            return FALSE;
+    }
+}
+
+/* Whether a block's worker has anything to do with these settings */
+gboolean
+sample_provider_wanted (const SampleConfig *config, BlockId block_id)
+{
+    if (!block_enabled(config, block_id) || !sample_provider_available(block_id))
+        return FALSE;
+    
+    /* sped up or simulated time would turn the remote intervals into a
+     * flood of requests to the real services; only local ones may see it */
+    if (sample_provider_get(block_id)->remote
+        && (sample_clock_get_scale() != 1.0 || sample_clock_is_virtual())
+        && !remote_provider_loopback(config, block_id))
+        return FALSE;
+    
+    switch (block_id) {
+        case BLOCK_WEATHER:
+            return config->weather_location && *config->weather_location;
+        case BLOCK_EXCHANGE_RATE:
+            return (config->exchange_api_key && *config->exchange_api_key) ||
+                   (config->exchange_sources && *config->exchange_sources);
+        default:
+            return TRUE;
+    }
+}
+
+/* Read a small /proc or sysfs file through a descriptor kept open across
+ * ticks, so steady state reads neither allocate nor walk the path. The
+ * file is reopened after a failure. Trailing whitespace is dropped. */
+static gboolean
+read_cached_file (gint *fd, const gchar *path, gchar *buffer, gsize size)
+{
+    gssize n;
+    
+    if (*fd < 0) {
+        *fd = sample_source_open(path, O_RDONLY | O_CLOEXEC);
+        if (*fd < 0)
+            return FALSE;
+    }
+    
+    n = sample_source_pread(*fd, buffer, size - 1);
+    if (n <= 0) {
+        sample_source_close(*fd);
+        *fd = -1;
+        return FALSE;
+    }
+    
+    buffer[n] = '\0';
+    g_strchomp(buffer);
+    
+    return TRUE;
+}
+
+static void
+close_cached_file (gint *fd)
+{
+    if (*fd >= 0)
+        sample_source_close(*fd);
+    *fd = -1;
+}
+
+/* Format a byte rate compactly, e.g. 980B, 1.2M, 34K */
+static void
+format_rate (gdouble bytes_per_second, gchar *buffer, gsize size)
+{
+    static const gchar *units[] = { "B", "K", "M", "G" };
+    gint unit = 0;
+    
+    while (bytes_per_second >= 1000.0 && unit < 3) {
+        bytes_per_second /= 1024.0;
+        unit++;
+    }
+    
+    g_snprintf(buffer, size, unit > 0 && bytes_per_second < 10.0 ? "%.1f%s" : "%.0f%s",
+               bytes_per_second, units[unit]);
+}
+
+static const struct {
+    const gchar *key;
+    gsize        offset;
+} meminfo_fields[] = {
+    { "MemTotal:",     G_STRUCT_OFFSET(MemorySample, total_kb) },
+    { "MemFree:",      G_STRUCT_OFFSET(MemorySample, free_kb) },
+    { "MemAvailable:", G_STRUCT_OFFSET(MemorySample, available_kb) },
+    { "Cached:",       G_STRUCT_OFFSET(MemorySample, cached_kb) },
+    { "Buffers:",      G_STRUCT_OFFSET(MemorySample, buffers_kb) },
+    { "SReclaimable:", G_STRUCT_OFFSET(MemorySample, reclaimable_kb) },
+    { "Shmem:",        G_STRUCT_OFFSET(MemorySample, shmem_kb) },
+    { "SwapTotal:",    G_STRUCT_OFFSET(MemorySample, swap_total_kb) },
+    { "SwapFree:",     G_STRUCT_OFFSET(MemorySample, swap_free_kb) },
+};
+
+/* Get memory information, @fd caches /proc/meminfo */
+static gboolean
+get_memory_info (gint *fd, MemorySample *memory)
+{
+    gchar buffer[MEMINFO_BUFFER_SIZE];
+    const gchar *line = buffer;
+    
+    memset(memory, 0, sizeof(*memory));
+    
+    if (!read_cached_file(fd, "/proc/meminfo", buffer, sizeof(buffer)))
+        return FALSE;
+    
+    /* the fields we want all come early, a cut off tail does not matter */
+    while (line) {
+        for (guint i = 0; i < G_N_ELEMENTS(meminfo_fields); i++) {
+            if (g_str_has_prefix(line, meminfo_fields[i].key)) {
+                G_STRUCT_MEMBER(gulong, memory, meminfo_fields[i].offset) =
+                    g_ascii_strtoull(line + strlen(meminfo_fields[i].key), NULL, 10);
+                break;
+            }
+        }
+        
+        line = strchr(line, '\n');
+        if (line)
+            line++;
+    }
+    
+    return memory->total_kb > 0;
+}
+
+/* Thread Functions */
+
+/* Date/Time thread */
+static gpointer
+date_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    gchar date_str[MAX_BLOCK_SIZE];
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        time_t now = sample_clock_time();
+        struct tm tm;
+        struct tm *timeinfo = localtime_r(&now, &tm);
+        
+        g_snprintf(date_str, sizeof(date_str),
+            ICON_CALENDAR_STR " <span color='#10bbbb'>%s %s %d %s %02d:%02d</span>",
+            (gchar*[]){"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"}[timeinfo->tm_wday],
+            (gchar*[]){"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"}[timeinfo->tm_mon],
+            timeinfo->tm_mday,
+            (timeinfo->tm_hour >= 8 && timeinfo->tm_hour < 21) ? ICON_DAY_STR : ICON_NIGHT_STR,
+            timeinfo->tm_hour,
+            timeinfo->tm_min
+        );
+        
+        BlockSample raw = { .date.time = now };
+        block_store_update(thread->store, BLOCK_DATE, date_str, &raw);
+        
+        /* Sleep until next minute */
+        int sleep_time = 60 - timeinfo->tm_sec;
+        status_thread_sleep(thread, &config, sleep_time);
+    }
+    
+    sample_config_unref(config);
+    
+    return NULL;
+}
+
+/* Memory thread */
+static gpointer
+memory_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    gint meminfo_fd = -1;
+    gchar memory_text[MAX_BLOCK_SIZE];
+    ProcStat *procs = NULL;
+    guint n_scans = 0;
+    gint64 scan_usec = 0;
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        BlockSample raw;
+        gboolean details = status_thread_wants_details(thread);
+        
+        /* the process list is scanned only while it is shown */
+        if (details && !procs) {
+            procs = proc_stat_new("/proc");
+            n_scans = 0;
+            scan_usec = 0;
+        } else if (!details && procs) {
+            g_debug("Process list: %u scans of %u processes, %.1f ms each",
+                    n_scans, proc_stat_get_n_procs(procs),
+                    n_scans > 0 ? scan_usec / 1000.0 / n_scans : 0.0);
+            proc_stat_free(procs);
+            procs = NULL;
+        }
+        
+        if (get_memory_info(&meminfo_fd, &raw.memory)) {
+            raw.memory.n_top = 0;
+            if (procs) {
+                gint64 start = g_get_monotonic_time();
+                
+                SAMPLE_TRACE(procs__scan__start);
+                raw.memory.n_top = MAX(proc_stat_scan(procs, raw.memory.top, PROC_TOP_MAX), 0);
+                SAMPLE_TRACE2(procs__scan__done, proc_stat_get_n_procs(procs), raw.memory.n_top);
+                scan_usec += g_get_monotonic_time() - start;
+                n_scans++;
+            }
+            
+            gulong mem_cached_all = raw.memory.cached_kb + raw.memory.reclaimable_kb;
+            gulong mem_used = raw.memory.total_kb - raw.memory.free_kb - mem_cached_all;
+            gdouble mem_used_gb = mem_used / 1024.0 / 1024.0;
+            
+            g_snprintf(memory_text, sizeof(memory_text),
+                       "<span color='#186da5'>" ICON_MEMORY_STR " %.1fGB</span>", mem_used_gb);
+            block_store_update(thread->store, BLOCK_MEMORY, memory_text, &raw);
+            sample_history_add(thread->store->history, SAMPLE_HISTORY_MEMORY,
+                               sample_clock_get_real() / G_USEC_PER_SEC, mem_used_gb);
+        }
+        
+        /* Update every 5 seconds, the process list every 3 */
+        status_thread_sleep(thread, &config, procs ? 3 : 5);
+    }
+    
+    proc_stat_free(procs);
+    close_cached_file(&meminfo_fd);
+    sample_config_unref(config);
+    
+    return NULL;
+}
+
+#ifdef ENABLE_WEATHER
+static void
+temperature_style (gdouble temperature, const gchar **icon, const gchar **color)
+{
+    if (temperature < 0) {
+        *icon = ICON_TEMP_FREEZING_STR; *color = "#1e90ff";
+    } else if (temperature < 10) {
+        *icon = ICON_TEMP_COLD_STR; *color = "#00bfff";
+    } else if (temperature < 18) {
+        *icon = ICON_TEMP_COOL_STR; *color = "#32cd32";
+    } else if (temperature < 22) {
+        *icon = ICON_TEMP_MILD_STR; *color = "#ffd700";
+    } else if (temperature < 30) {
+        *icon = ICON_TEMP_WARM_STR; *color = "#ffa500";
+    } else {
+        *icon = ICON_TEMP_HOT_STR; *color = "#ff4500";
+    }
+}
+
+/* Render e.g. "Home 12° | Office 9°", or the classic block for one unnamed location */
+static gchar *
+format_weather (const WeatherSample *weather)
+{
+    GString *text = g_string_new(NULL);
+    
+    for (gint i = 0; i < weather->n_readings; i++) {
+        const WeatherReading *reading = &weather->readings[i];
+        const gchar *icon, *color;
+        
+        temperature_style(reading->temperature, &icon, &color);
+        if (i > 0)
+            g_string_append(text, " | ");
+        
+        if (reading->name[0] == '\0') {
+            g_string_append_printf(text, "<span color='%s'>%s %.1f°C</span>",
+                                   color, icon, reading->temperature);
+        } else {
+            gchar *name = g_markup_escape_text(reading->name, -1);
+            g_string_append_printf(text, "<span color='%s'>%s %.0f°</span>",
+                                   color, name, reading->temperature);
+            g_free(name);
+        }
+    }
+    
+    return g_string_free(text, FALSE);
+}
+
+/* Weather thread: the forecast is fetched rarely and the block is
+ * interpolated from it every tick */
+static gpointer
+weather_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    WeatherCacheValue cached;
+    gchar *fetched_spec = NULL;
+    gchar *last_text = NULL;
+    gboolean last_outdated = FALSE;
+    gboolean refresh = FALSE;
+    gint64 retry_at = 0;
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        gint64 now = sample_clock_get_real() / G_USEC_PER_SEC;
+        gint64 fetched_at = 0;
+        SampleCacheState state;
+        BlockSample raw = { .weather.n_readings = 0 };
+        
+        /* locations changed: fetch right away unless they are cached */
+        if (g_strcmp0(fetched_spec, config->weather_location) != 0) {
+            g_free(fetched_spec);
+            fetched_spec = g_strdup(config->weather_location);
+            retry_at = 0;
+        }
+        
+        state = fetched_spec ? sample_cache_get(thread->cache, fetched_spec, &cached, &fetched_at) : SAMPLE_CACHE_MISS;
+        if (fetched_spec && (state != SAMPLE_CACHE_FRESH || refresh) && now >= retry_at) {
+            WeatherLocation locations[WEATHER_MAX_LOCATIONS];
+            gint n_locations = weather_locations_parse(fetched_spec, locations, WEATHER_MAX_LOCATIONS);
+            WeatherCacheValue fetched;
+            
+            status_thread_fetch_begin(thread);
+            fetched.n_forecasts = 0;
+            if (n_locations > 0)
+                fetched.n_forecasts = weather_forecasts_fetch(config->weather_url, locations, n_locations,
+                                                              fetched.forecasts, thread->cancellable);
+            status_thread_fetch_end(thread);
+            
+            if (fetched.n_forecasts > 0) {
+                sample_cache_put(thread->cache, fetched_spec, &fetched);
+                cached = fetched;
+                fetched_at = sample_clock_get_real();
+                state = SAMPLE_CACHE_FRESH;
+            }
+            /* successful or not, the next try waits unless asked for */
+            retry_at = now + WEATHER_RETRY_INTERVAL;
+        }
+        refresh = FALSE;
+        
+        if (state != SAMPLE_CACHE_MISS) {
+            for (gint i = 0; i < cached.n_forecasts; i++) {
+                if (weather_forecast_interpolate(&cached.forecasts[i], now, &raw.weather.readings[raw.weather.n_readings]))
+                    raw.weather.n_readings++;
+            }
+        }
+        raw.weather.fetched_at = fetched_at / G_USEC_PER_SEC;
+        
+        if (raw.weather.n_readings > 0) {
+            gchar *weather_text = format_weather(&raw.weather);
+            gboolean outdated = state == SAMPLE_CACHE_EXPIRED;
+            
+            if (!outdated)
+                sample_history_add(thread->store->history, SAMPLE_HISTORY_TEMPERATURE,
+                                   now, raw.weather.readings[0].temperature);
+            
+            /* most ticks do not change the rounded value */
+            if (g_strcmp0(weather_text, last_text) != 0 || outdated != last_outdated) {
+                block_store_update_cached(thread->store, BLOCK_WEATHER, weather_text, &raw,
+                                          fetched_at, outdated);
+                g_free(last_text);
+                last_text = weather_text;
+                last_outdated = outdated;
+            } else {
+                g_free(weather_text);
+            }
+        } else if (state != SAMPLE_CACHE_MISS && now >= retry_at) {
+            /* ran past the end of the forecast, at most once per retry
+             * interval while fetches keep failing */
+            refresh = TRUE;
+            continue;
+        }
+        
+        /* a requested refresh refetches the forecast */
+        if (status_thread_sleep(thread, &config, WEATHER_TICK_INTERVAL)) {
+            refresh = TRUE;
+            retry_at = 0;
+        }
+    }
+    
+    g_free(fetched_spec);
+    g_free(last_text);
+    sample_config_unref(config);
+    
+    return NULL;
+}
+#endif /* ENABLE_WEATHER */
+
+#ifdef ENABLE_EXCHANGE
+static void
+format_exchange (const ExchangeSample *exchange, gchar *buffer, gsize size)
+{
+    gsize len = 0;
+    
+    buffer[0] = '\0';
+    if (exchange->has_try)
+        len = g_snprintf(buffer, size,
+            "<span color='#07d7e8'>TRY</span> <span color='#10bbbb'>%.2f</span>", exchange->try_rate);
+    if (exchange->has_rub && len < size)
+        g_snprintf(buffer + len, size - len,
+            "%s<span color='#07d7e8'>RUB</span> <span color='#10bbbb'>%.2f</span>",
+            exchange->has_try ? " " : "", exchange->rub_rate);
+}
+
+/* Exchange rate thread */
+static gpointer
+exchange_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    RateSources *sources = NULL;
+    SamplePlanner *planner = NULL;
+    gchar *fetched_key = NULL;
+    gint planned_budget = -1;
+    gboolean refresh = FALSE;
+    gint64 retry_at = 0, usage_at = 0;
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        gint64 now = sample_clock_get_real() / G_USEC_PER_SEC;
+        gint64 fetched_at = 0, next_fetch, next_check;
+        SampleCacheState state = SAMPLE_CACHE_MISS;
+        SamplePlannerUsage usage;
+        ExchangeSample exchange;
+        gchar *key;
+        
+        /* new sources or a new key are used right away instead of after
+         * the interval; the statistics start over with them */
+        key = g_strdup_printf("%s\n%s", config->exchange_sources ? config->exchange_sources : "",
+                              config->exchange_api_key ? config->exchange_api_key : "");
+        if (g_strcmp0(fetched_key, key) != 0) {
+            g_free(fetched_key);
+            fetched_key = key;
+            rate_sources_free(sources);
+            sources = rate_sources_new(config->exchange_sources, config->exchange_api_key);
+            retry_at = 0;
+            usage_at = 0;
+        } else {
+            g_free(key);
+        }
+        
+        /* a new budget plans from the usage again */
+        if (planned_budget != config->exchange_budget) {
+            sample_planner_free(planner);
+            planner = sample_planner_new(config->exchange_budget, EXCHANGE_UPDATE_INTERVAL, now);
+            planned_budget = config->exchange_budget;
+            usage_at = 0;
+        }
+        if (rate_sources_get_n(sources) > 0 && now >= usage_at) {
+            status_thread_fetch_begin(thread);
+            if (rate_sources_fetch_usage(sources, &usage, thread->cancellable))
+                sample_planner_set_usage(planner, now, &usage);
+            status_thread_fetch_end(thread);
+            usage_at = now + EXCHANGE_USAGE_INTERVAL;
+        }
+        
+        if (rate_sources_get_n(sources) > 0)
+            state = sample_cache_get(thread->cache, fetched_key, &exchange, &fetched_at);
+        fetched_at /= G_USEC_PER_SEC;
+        next_fetch = state == SAMPLE_CACHE_MISS ? now : sample_planner_next(planner, now, fetched_at);
+        
+        if (refresh && sample_planner_may_refresh(planner, now, fetched_at))
+            next_fetch = now;
+        
+        if (rate_sources_get_n(sources) > 0 && now >= next_fetch && now >= retry_at
+            && sample_planner_may_fetch(planner, now)) {
+            ExchangeSample fetched;
+            gboolean fetched_ok;
+            
+            status_thread_fetch_begin(thread);
+            fetched_ok = rate_sources_fetch(sources, &fetched, thread->cancellable);
+            status_thread_fetch_end(thread);
+            
+            if (fetched_ok) {
+                gint64 rated_at = fetched.timestamp > 0 ? fetched.timestamp : now;
+                
+                if (fetched.has_try)
+                    sample_history_add(thread->store->history, SAMPLE_HISTORY_TRY, rated_at, fetched.try_rate);
+                if (fetched.has_rub)
+                    sample_history_add(thread->store->history, SAMPLE_HISTORY_RUB, rated_at, fetched.rub_rate);
+                sample_cache_put(thread->cache, fetched_key, &fetched);
+                sample_planner_count(planner, now);
+                exchange = fetched;
+                fetched_at = now;
+                state = SAMPLE_CACHE_FRESH;
+                next_fetch = sample_planner_next(planner, now, now);
+                g_debug("Exchange rates: %d requests left, next fetch in %" G_GINT64_FORMAT " minutes",
+                        sample_planner_get_remaining(planner, now), (next_fetch - now) / 60);
+            } else {
+                retry_at = now + EXCHANGE_RETRY_INTERVAL;
+            }
+        }
+        refresh = FALSE;
+        
+        /* out of date once a planned fetch is missed and the markets
+         * have been open for a while since, not over the weekend or
+         * while the budget says wait */
+        if (state != SAMPLE_CACHE_MISS) {
+            gchar exchange_text[MAX_BLOCK_SIZE];
+            BlockSample raw = { .exchange = exchange };
+            
+            format_exchange(&exchange, exchange_text, sizeof(exchange_text));
+            block_store_update_cached(thread->store, BLOCK_EXCHANGE_RATE, exchange_text, &raw,
+                                      fetched_at * G_USEC_PER_SEC,
+                                      now >= next_fetch
+                                      && sample_planner_open_seconds(fetched_at, now) >= EXCHANGE_CACHE_TTL);
+        }
+        
+        /* sleep until the planned fetch or the next retry, or until
+         * asked to refresh; at most an interval to catch up with going
+         * out of date */
+        if (rate_sources_get_n(sources) == 0)
+            next_check = now + EXCHANGE_UPDATE_INTERVAL;
+        else if (now >= next_fetch)
+            next_check = MAX(retry_at, now + EXCHANGE_RETRY_INTERVAL);
+        else
+            next_check = next_fetch;
+        
+        if (status_thread_sleep(thread, &config, CLAMP(next_check - now, 1, EXCHANGE_UPDATE_INTERVAL))) {
+            refresh = TRUE;
+            retry_at = 0;
+        }
+    }
+    
+    sample_planner_free(planner);
+    rate_sources_free(sources);
+    g_free(fetched_key);
+    sample_config_unref(config);
+    
+    return NULL;
+}
+#endif /* ENABLE_EXCHANGE */
+
+#ifdef ENABLE_BATTERY
+static BatteryStat *
+battery_stat_find (void)
+{
+    gchar path[64];
+    
+    for (gint i = 0; i < BATTERY_MAX_PROBED; i++) {
+        BatteryStat *stat;
+        
+        g_snprintf(path, sizeof(path), BATTERY_SYSFS_PATH, i);
+        if ((stat = battery_stat_new(path)))
+            return stat;
+    }
+    
+    return NULL;
+}
+
+/* Battery thread */
+static gpointer
+battery_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    BatteryStat *stat = NULL;
+    gchar battery_text[MAX_BLOCK_SIZE];
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        /* a battery may be plugged in or out any time */
+        if (!stat)
+            stat = battery_stat_find();
+        if (stat && !battery_stat_sample(stat)) {
+            battery_stat_free(stat);
+            stat = NULL;
+        }
+        
+        if (stat) {
+            int capacity = battery_stat_get_capacity(stat);
+            const gchar *icon, *color;
+            
+            if (capacity < 10) {
+                icon = ICON_BATTERY_EMPTY_STR; color = "#ff0000";
+            } else if (capacity < 25) {
+                icon = ICON_BATTERY_CAUTION_STR; color = "#eb9634";
+            } else if (capacity < 50) {
+                icon = ICON_BATTERY_LOW_STR; color = "#ebd334";
+            } else if (capacity < 75) {
+                icon = ICON_BATTERY_GOOD_STR; color = "#c6eb34";
+            } else {
+                icon = ICON_BATTERY_FULL_STR; color = "#00ff00";
+            }
+            
+            const gchar *charging_icon = "";
+            if (battery_stat_is_charging(stat)) {
+                charging_icon = " " ICON_CHARGING_STR;
+            }
+            
+            g_snprintf(battery_text, sizeof(battery_text),
+                "<span color='%s'>%s %d%%</span>%s",
+                color, icon, capacity, charging_icon
+            );
+            
+            BlockSample raw;
+            raw.battery.capacity = capacity;
+            g_strlcpy(raw.battery.status, battery_stat_get_status(stat), sizeof(raw.battery.status));
+            raw.battery.charging = battery_stat_is_charging(stat);
+            raw.battery.power = battery_stat_get_power(stat);
+            raw.battery.seconds_left = battery_stat_get_seconds_left(stat);
+            raw.battery.full = battery_stat_get_full(stat);
+            raw.battery.full_design = battery_stat_get_full_design(stat);
+            
+            block_store_update(thread->store, BLOCK_BATTERY, battery_text, &raw);
+        }
+        
+        /* Update every 10 seconds */
+        status_thread_sleep(thread, &config, 10);
+    }
+    
+    battery_stat_free(stat);
+    sample_config_unref(config);
+    
+    return NULL;
+}
+#endif /* ENABLE_BATTERY */
+
+/* CPU thread */
+static gpointer
+cpu_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    static const gchar *bars[] = { "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+    CpuStat *stat = cpu_stat_new("/proc/stat");
+    gchar cpu_text[MAX_BLOCK_SIZE];
+    
+    if (!stat) {
+        g_warning("Unable to open /proc/stat");
+        return NULL;
+    }
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        /* the first sample only primes the counters */
+        if (cpu_stat_sample(stat)) {
+            const gfloat *cores = cpu_stat_get_cores(stat);
+            gint n_cores = cpu_stat_get_n_cores(stat);
+            gfloat total = cpu_stat_get_total(stat);
+            BlockSample raw = { .cpu = { .total = total, .n_cores = n_cores, .busiest = -1.0f } };
+            
+            for (gint i = 0; i < n_cores; i++) {
+                if (cores[i] > 0.9f)
+                    raw.cpu.n_busy_cores++;
+                if (cores[i] > raw.cpu.busiest) {
+                    raw.cpu.busiest = cores[i];
+                    raw.cpu.busiest_core = i;
+                }
+            }
+            
+            g_snprintf(cpu_text, sizeof(cpu_text), "<span color='%s'>" ICON_CPU_STR " %.0f%%</span>",
+                       total >= 0.9f ? "#ff4500" : "#e0a030", total * 100.0f);
+            
+            if (config->show_cpu_graph && n_cores > 1) {
+                /* average neighbouring cores so big machines still fit */
+                gint per_bar = (n_cores + CPU_GRAPH_MAX_BARS - 1) / CPU_GRAPH_MAX_BARS;
+                
+                g_strlcat(cpu_text, " <span color='#e0a030'>", sizeof(cpu_text));
+                for (gint first = 0; first < n_cores; first += per_bar) {
+                    gint last = MIN(first + per_bar, n_cores);
+                    gfloat sum = 0.0f;
+                    
+                    for (gint i = first; i < last; i++)
+                        sum += cores[i];
+                    g_strlcat(cpu_text, bars[CLAMP((gint)(sum / (last - first) * 8.0f), 0, 7)], sizeof(cpu_text));
+                }
+                g_strlcat(cpu_text, "</span>", sizeof(cpu_text));
+            }
+            
+            block_store_update(thread->store, BLOCK_CPU, cpu_text, &raw);
+        }
+        
+        /* Update every 2 seconds */
+        status_thread_sleep(thread, &config, 2);
+    }
+    
+    cpu_stat_free(stat);
+    sample_config_unref(config);
+    
+    return NULL;
+}
+
+/* Network thread */
+static gpointer
+net_thread_func (gpointer data)
+{
+    StatusThread *thread = data;
+    SampleConfig *config = NULL;
+    NetStat *stat = NULL;
+    gchar *exclude = NULL;
+    gchar net_text[MAX_BLOCK_SIZE];
+    
+    while (thread->running) {
+        status_thread_sync_config(thread, &config);
+        
+        /* other patterns need a fresh link dump */
+        if (!stat || g_strcmp0(exclude, config->network_exclude) != 0) {
+            net_stat_free(stat);
+            g_free(exclude);
+            exclude = g_strdup(config->network_exclude);
+            stat = net_stat_new(exclude);
+            
+            if (!stat) {
+                g_warning("Unable to open rtnetlink socket");
+                break;
+            }
+        }
+        
+        if (net_stat_sample(stat)) {
+            static const gchar closing[] = "</span>";
+            BlockSample raw = { .net.n_interfaces = 0 };
+            gsize empty_len = g_strlcpy(net_text, "<span color='#10bbbb'>" ICON_NETWORK_STR, sizeof(net_text));
+            gsize len = empty_len;
+            guint n = net_stat_get_n_interfaces(stat);
+            
+            for (guint i = 0; i < n; i++) {
+                const NetInterface *iface = net_stat_get_interface(stat, i);
+                gchar rx[16], tx[16], name[NET_NAME_ESCAPED_SIZE];
+                gint piece_len;
+                
+                if (raw.net.n_interfaces < NET_SAMPLE_MAX_INTERFACES)
+                    raw.net.interfaces[raw.net.n_interfaces++] = *iface;
+                if (!iface->up)
+                    continue;
+                
+                format_rate(iface->rx_rate, rx, sizeof(rx));
+                format_rate(iface->tx_rate, tx, sizeof(tx));
+                block_markup_escape(iface->name, strlen(iface->name), name, sizeof(name));
+                
+                /* interfaces that do not fit before the closing tag are left out */
+                piece_len = g_snprintf(net_text + len, sizeof(net_text) - len, " %s ↓%s ↑%s", name, rx, tx);
+                if (len + piece_len + sizeof(closing) > sizeof(net_text)) {
+                    net_text[len] = '\0';
+                    break;
+                }
+                len += piece_len;
+            }
+            
+            if (len == empty_len)
+                g_strlcat(net_text, " offline", sizeof(net_text));
+            g_strlcat(net_text, closing, sizeof(net_text));
+            
+            block_store_update(thread->store, BLOCK_NETWORK, net_text, &raw);
+        }
+        
+        /* Update every 2 seconds */
+        status_thread_sleep(thread, &config, 2);
+    }
+    
+    net_stat_free(stat);
+    g_free(exclude);
+    sample_config_unref(config);
+    
+    return NULL;
+}
@@ -0,0 +1,53 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_PROVIDERS_H__
+#define __SAMPLE_PROVIDERS_H__
+
+#include <glib.h>
+
+#include "sample-blocks.h"
+#include "sample-config.h"
+
+G_BEGIN_DECLS
+
+/* The worker filling a block; its thread function gets the StatusThread */
+typedef struct {
+    const gchar *name;
+    GThreadFunc  func;
+    gint         min_refresh;   /* seconds between requested refreshes */
+    gboolean     remote;        /* fetches over the network */
+    gboolean     critical;      /* keeps its cadence on battery */
+
+    /* the cache in front of a remote provider, none when cache_size is 0 */
+    gsize        cache_size;    /* of a value */
+    gint         soft_ttl;      /* seconds until fetched again */
+    gint         ttl;           /* seconds until shown as out of date */
+} SampleProvider;
+
+const SampleProvider *sample_provider_get       (BlockId block_id);
+
+gboolean              sample_provider_available (BlockId block_id);
+
+gboolean              sample_provider_wanted    (const SampleConfig *config,
+                                                 BlockId             block_id);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_PROVIDERS_H__ */
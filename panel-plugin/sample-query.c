@@ -0,0 +1,279 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Reads the blocks a running panel plugin or xfce4-sample-status exports,
+ * for scripts, conky or a tmux status line. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sample-blocks.h"
+#include "sample-export.h"
+#include "sample-icons.h"
+
+static gchar    *opt_file = NULL;
+static gboolean  opt_markup = FALSE;
+static gboolean  opt_raw = FALSE;
+
+static GOptionEntry entries[] = {
+    { "file", 'f', 0, G_OPTION_ARG_FILENAME, &opt_file,
+      "Export to read, the newest under $XDG_RUNTIME_DIR by default", "FILE" },
+    { "markup", 'm', 0, G_OPTION_ARG_NONE, &opt_markup,
+      "Print the Pango markup instead of plain text", NULL },
+    { "raw", 'r', 0, G_OPTION_ARG_NONE, &opt_raw,
+      "Print the numbers behind the blocks as name.key=value lines", NULL },
+    { NULL }
+};
+
+/* The most recently written export of any instance */
+static gchar *
+find_export (void)
+{
+    gchar *probe = sample_export_default_path("probe");
+    gchar *dirname = g_path_get_dirname(probe);
+    GDir *dir = g_dir_open(dirname, 0, NULL);
+    const gchar *name;
+    gchar *newest = NULL;
+    gint64 newest_time = 0;
+    
+    while (dir && (name = g_dir_read_name(dir))) {
+        gchar *path;
+        GStatBuf st;
+        
+        if (!g_str_has_suffix(name, ".blocks"))
+            continue;
+        path = g_build_filename(dirname, name, NULL);
+        if (g_stat(path, &st) == 0 && (!newest || st.st_mtime > newest_time)) {
+            g_free(newest);
+            newest = path;
+            newest_time = st.st_mtime;
+        } else {
+            g_free(path);
+        }
+    }
+    
+    if (dir)
+        g_dir_close(dir);
+    g_free(dirname);
+    g_free(probe);
+    
+    return newest;
+}
+
+/* Icons become their emoji, no one else knows our placeholders */
+static void
+append_icons_replaced (GString *text, const gchar *markup)
+{
+    for (const gchar *p = markup; *p; p = g_utf8_next_char(p)) {
+        gunichar c = g_utf8_get_char(p);
+        IconId icon = sample_icon_from_char(c);
+        
+        if (icon != ICON_NONE)
+            g_string_append(text, sample_icon_get_emoji(icon));
+        else
+            g_string_append_unichar(text, c);
+    }
+}
+
+static void
+strip_markup_text (GMarkupParseContext *context, const gchar *text, gsize text_len,
+                   gpointer user_data, GError **error)
+{
+    g_string_append_len(user_data, text, text_len);
+}
+
+static gchar *
+block_text (const SampleExportBlock *block)
+{
+    static const GMarkupParser parser = { NULL, NULL, strip_markup_text, NULL, NULL };
+    GString *markup = g_string_new(NULL);
+    GString *plain;
+    GMarkupParseContext *context;
+    
+    append_icons_replaced(markup, block->text);
+    if (opt_markup)
+        return g_string_free(markup, FALSE);
+    
+    /* the store only keeps valid markup */
+    plain = g_string_new(NULL);
+    context = g_markup_parse_context_new(&parser, 0, plain, NULL);
+    g_markup_parse_context_parse(context, "<markup>", -1, NULL);
+    g_markup_parse_context_parse(context, markup->str, markup->len, NULL);
+    g_markup_parse_context_parse(context, "</markup>", -1, NULL);
+    g_markup_parse_context_end_parse(context, NULL);
+    g_markup_parse_context_free(context);
+    g_string_free(markup, TRUE);
+    
+    return g_string_free(plain, FALSE);
+}
+
+static void
+print_raw (BlockId block_id, const SampleExportBlock *block)
+{
+    const BlockSample *raw = &block->raw;
+    const gchar *name = block->name;
+    
+    printf("%s.updated=%" G_GINT64_FORMAT "\n", name, block->updated / G_USEC_PER_SEC);
+    if (block->fetched_at > 0)
+        printf("%s.fetched_at=%" G_GINT64_FORMAT "\n%s.outdated=%d\n",
+               name, block->fetched_at / G_USEC_PER_SEC, name, block->outdated != 0);
+    
+    switch (block_id) {
+        case BLOCK_WEATHER:
+            for (gint i = 0; i < CLAMP(raw->weather.n_readings, 0, WEATHER_MAX_LOCATIONS); i++) {
+                const WeatherReading *reading = &raw->weather.readings[i];
+                
+                printf("%s.%d.name=%s\n%s.%d.temperature=%.1f\n%s.%d.windspeed=%.1f\n"
+                       "%s.%d.winddirection=%.0f\n%s.%d.weathercode=%d\n%s.%d.is_day=%d\n",
+                       name, i, reading->name, name, i, reading->temperature,
+                       name, i, reading->windspeed, name, i, reading->winddirection,
+                       name, i, reading->weathercode, name, i, reading->is_day != 0);
+            }
+            break;
+        case BLOCK_EXCHANGE_RATE:
+            if (raw->exchange.has_try)
+                printf("%s.try=%.4f\n", name, raw->exchange.try_rate);
+            if (raw->exchange.has_rub)
+                printf("%s.rub=%.4f\n", name, raw->exchange.rub_rate);
+            printf("%s.timestamp=%" G_GINT64_FORMAT "\n%s.source=%.*s\n", name, raw->exchange.timestamp,
+                   name, (gint) sizeof(raw->exchange.source), raw->exchange.source);
+            break;
+        case BLOCK_NETWORK:
+            for (gint i = 0; i < CLAMP(raw->net.n_interfaces, 0, NET_SAMPLE_MAX_INTERFACES); i++) {
+                const NetInterface *iface = &raw->net.interfaces[i];
+                
+                printf("%s.%.*s.up=%d\n%s.%.*s.rx_rate=%.0f\n%s.%.*s.tx_rate=%.0f\n",
+                       name, (gint) sizeof(iface->name), iface->name, iface->up != 0,
+                       name, (gint) sizeof(iface->name), iface->name, iface->rx_rate,
+                       name, (gint) sizeof(iface->name), iface->name, iface->tx_rate);
+            }
+            break;
+        case BLOCK_BATTERY:
+            printf("%s.capacity=%d\n%s.status=%.*s\n%s.charging=%d\n%s.power=%.2f\n"
+                   "%s.seconds_left=%" G_GINT64_FORMAT "\n%s.full=%" G_GINT64_FORMAT "\n"
+                   "%s.full_design=%" G_GINT64_FORMAT "\n",
+                   name, raw->battery.capacity, name, (gint) sizeof(raw->battery.status), raw->battery.status,
+                   name, raw->battery.charging != 0, name, raw->battery.power,
+                   name, raw->battery.seconds_left, name, raw->battery.full,
+                   name, raw->battery.full_design);
+            break;
+        case BLOCK_CPU:
+            printf("%s.total=%.1f\n%s.cores=%d\n%s.busy_cores=%d\n",
+                   name, raw->cpu.total, name, raw->cpu.n_cores, name, raw->cpu.n_busy_cores);
+            break;
+        case BLOCK_MEMORY:
+            printf("%s.total_kb=%lu\n%s.available_kb=%lu\n%s.free_kb=%lu\n%s.cached_kb=%lu\n"
+                   "%s.swap_total_kb=%lu\n%s.swap_free_kb=%lu\n",
+                   name, raw->memory.total_kb, name, raw->memory.available_kb,
+                   name, raw->memory.free_kb, name, raw->memory.cached_kb,
+                   name, raw->memory.swap_total_kb, name, raw->memory.swap_free_kb);
+            break;
+        case BLOCK_DATE:
+            printf("%s.time=%" G_GINT64_FORMAT "\n", name, (gint64) raw->date.time);
+            break;
+        default:
+            break;
+    }
+}
+
+static gboolean
+print_block (SampleExportReader *reader, BlockId block_id, gboolean named)
+{
+    SampleExportBlock block;
+    gchar *text;
+    
+    if (!sample_export_reader_read(reader, block_id, &block) || block.len == 0)
+        return FALSE;
+    
+    if (opt_raw) {
+        print_raw(block_id, &block);
+        return TRUE;
+    }
+    
+    text = block_text(&block);
+    if (named)
+        printf("%s\t%s\n", block.name, text);
+    else
+        printf("%s\n", text);
+    g_free(text);
+    
+    return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+    SampleExportReader *reader;
+    gboolean printed = FALSE;
+    
+    context = g_option_context_new("[BLOCK...] - print the blocks of a running status bar");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+    
+    if (!opt_file && !(opt_file = find_export())) {
+        g_printerr("No status bar is running\n");
+        return EXIT_FAILURE;
+    }
+    
+    reader = sample_export_reader_open(opt_file, &error);
+    if (!reader) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    
+    if (argc < 2) {
+        for (gint i = 0; i < BLOCK_COUNT; i++)
+            printed |= print_block(reader, i, TRUE);
+    }
+    for (gint arg = 1; arg < argc; arg++) {
+        BlockId id;
+        
+        for (id = 0; id < BLOCK_COUNT; id++)
+            if (g_strcmp0(argv[arg], block_get_name(id)) == 0)
+                break;
+        
+        if (id == BLOCK_COUNT) {
+            g_printerr("Unknown block \"%s\"\n", argv[arg]);
+            sample_export_reader_close(reader);
+            return EXIT_FAILURE;
+        }
+        printed |= print_block(reader, id, argc > 2);
+    }
+    
+    sample_export_reader_close(reader);
+    
+    return printed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,551 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <curl/curl.h>
+#include <json-glib/json-glib.h>
+#include <stdlib.h>
+
+#include "sample-clock.h"
+#include "sample-rates.h"
+#include "sample-trace.h"
+
+#define RATE_SOURCES_MAX      6
+#define RATE_TIMEOUT          (10 * G_USEC_PER_SEC)
+
+/* The hedge fires after the p95 latency of the source asked last, or
+ * after RATE_DEFAULT_HEDGE until it has RATE_MIN_SAMPLES answers */
+#define RATE_LATENCY_SAMPLES  32
+#define RATE_MIN_SAMPLES      5
+#define RATE_DEFAULT_HEDGE    (2 * G_USEC_PER_SEC)
+#define RATE_MIN_HEDGE        (200 * 1000)
+#define RATE_MAX_HEDGE        (5 * G_USEC_PER_SEC)
+#define RATE_ERROR_WEIGHT     0.2
+
+/* Where the rates are in an answer */
+typedef struct {
+    const gchar *name;
+    const gchar *url;
+    const gchar *rates_member;      /* object of rates by currency code */
+    const gchar *timestamp_member;  /* unix time, NULL for none */
+    gboolean     lowercase_codes;
+} RateSourceInfo;
+
+static const RateSourceInfo builtin_sources[] = {
+    { "openexchangerates", "https://openexchangerates.org/api/latest.json?app_id={key}",
+      "rates", "timestamp", FALSE },
+    { "open-er-api",       "https://open.er-api.com/v6/latest/USD",
+      "rates", "time_last_update_unix", FALSE },
+    { "currency-api",      "https://cdn.jsdelivr.net/npm/@fawazahmed0/currency-api@latest/v1/currencies/usd.json",
+      "usd", NULL, TRUE },
+};
+
+/* the answer format of "name=URL" sources */
+static const RateSourceInfo custom_source = {
+    NULL, NULL, "rates", "timestamp", FALSE
+};
+
+typedef struct {
+    gchar                *name;
+    gchar                *url;
+    const RateSourceInfo *info;
+
+    /* answer times in µs, a ring */
+    gint64                latency[RATE_LATENCY_SAMPLES];
+    guint                 n_latency;
+    guint                 next_latency;
+    gdouble               error_rate;       /* moving average of failures */
+} RateSource;
+
+typedef struct {
+    RateSource *source;
+    CURL       *curl;
+    GString    *body;
+    gint64      started;
+} RateRequest;
+
+struct _RateSources
+{
+    RateSource  sources[RATE_SOURCES_MAX];
+    gint        n_sources;
+    gint        primary;
+    CURLM      *multi;
+};
+
+static const RateSourceInfo *
+rate_source_info_find (const gchar *name)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(builtin_sources); i++) {
+        if (strcmp(builtin_sources[i].name, name) == 0)
+            return &builtin_sources[i];
+    }
+    
+    return NULL;
+}
+
+RateSources *
+rate_sources_new (const gchar *spec, const gchar *api_key)
+{
+    RateSources *sources = g_new0(RateSources, 1);
+    gchar **entries = g_strsplit(spec && *spec ? spec : RATE_DEFAULT_SOURCES, ";", -1);
+    gboolean has_key = api_key && *api_key;
+    
+    for (gchar **entry = entries; *entry && sources->n_sources < RATE_SOURCES_MAX; entry++) {
+        RateSource *source = &sources->sources[sources->n_sources];
+        gchar *name = g_strstrip(*entry);
+        gchar *url = strchr(name, '=');
+        const RateSourceInfo *info;
+        gchar **parts;
+        
+        if (*name == '\0')
+            continue;
+        
+        if (url) {
+            *url++ = '\0';
+            info = &custom_source;
+        } else if ((info = rate_source_info_find(name))) {
+            url = (gchar *) info->url;
+        } else {
+            g_warning("Ignoring unknown exchange rate source: %s", name);
+            continue;
+        }
+        
+        if (strstr(url, "{key}") && !has_key)
+            continue;
+        
+        parts = g_strsplit(url, "{key}", -1);
+        source->url = g_strjoinv(has_key ? api_key : "", parts);
+        g_strfreev(parts);
+        source->name = g_strdup(g_strstrip(name));
+        source->info = info;
+        sources->n_sources++;
+    }
+    g_strfreev(entries);
+    
+    sources->multi = curl_multi_init();
+    
+    return sources;
+}
+
+void
+rate_sources_free (RateSources *sources)
+{
+    if (!sources)
+        return;
+    
+    for (gint i = 0; i < sources->n_sources; i++) {
+        g_free(sources->sources[i].name);
+        g_free(sources->sources[i].url);
+    }
+    curl_multi_cleanup(sources->multi);
+    g_free(sources);
+}
+
+guint
+rate_sources_get_n (RateSources *sources)
+{
+    return sources->n_sources;
+}
+
+static gint
+compare_latency (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+    
+    return x < y ? -1 : x > y;
+}
+
+static gint64
+rate_source_p95 (const RateSource *source)
+{
+    gint64 sorted[RATE_LATENCY_SAMPLES];
+    guint i;
+    
+    if (source->n_latency < RATE_MIN_SAMPLES)
+        return RATE_DEFAULT_HEDGE;
+    
+    memcpy(sorted, source->latency, source->n_latency * sizeof(gint64));
+    qsort(sorted, source->n_latency, sizeof(gint64), compare_latency);
+    i = (source->n_latency * 95 + 99) / 100 - 1;
+    
+    return CLAMP(sorted[i], RATE_MIN_HEDGE, RATE_MAX_HEDGE);
+}
+
+static void
+rate_source_add_latency (RateSource *source, gint64 latency)
+{
+    source->latency[source->next_latency] = latency;
+    source->next_latency = (source->next_latency + 1) % RATE_LATENCY_SAMPLES;
+    source->n_latency = MIN(source->n_latency + 1, RATE_LATENCY_SAMPLES);
+}
+
+static void
+rate_source_add_result (RateSource *source, gboolean ok)
+{
+    source->error_rate += RATE_ERROR_WEIGHT * ((ok ? 0.0 : 1.0) - source->error_rate);
+}
+
+/* Expected time to a valid answer, lower is better */
+static gdouble
+rate_source_cost (const RateSource *source)
+{
+    return rate_source_p95(source) / (1.0 - MIN(source->error_rate, 0.9));
+}
+
+/* The primary first, then the rest in the configured order */
+static void
+rate_sources_order (RateSources *sources, gint *order)
+{
+    gint n = 0;
+    
+    order[n++] = sources->primary;
+    for (gint i = 0; i < sources->n_sources; i++) {
+        if (i != sources->primary)
+            order[n++] = i;
+    }
+}
+
+static void
+rate_sources_pick_primary (RateSources *sources)
+{
+    gint best = 0;
+    
+    for (gint i = 1; i < sources->n_sources; i++) {
+        if (rate_source_cost(&sources->sources[i]) < rate_source_cost(&sources->sources[best]))
+            best = i;
+    }
+    
+    if (best != sources->primary) {
+        const RateSource *source = &sources->sources[best];
+        
+        g_debug("Exchange rates: %s is the primary source now (p95 %.0f ms, %.0f%% errors)",
+                source->name, rate_source_p95(source) / 1000.0, source->error_rate * 100.0);
+        sources->primary = best;
+    }
+}
+
+static size_t
+rate_request_write (void *contents, size_t size, size_t nmemb, void *data)
+{
+    g_string_append_len(data, contents, size * nmemb);
+    
+    return size * nmemb;
+}
+
+/* non-zero aborts a transfer of curl_easy_perform() */
+static int
+rate_request_progress (void *data, curl_off_t dltotal, curl_off_t dlnow,
+                       curl_off_t ultotal, curl_off_t ulnow)
+{
+    return g_cancellable_is_cancelled(data);
+}
+
+/* curl_multi_poll() returns right away once the fetch is cancelled */
+static void
+rate_sources_cancelled (GCancellable *cancellable, gpointer data)
+{
+    curl_multi_wakeup(data);
+}
+
+static gboolean
+rate_request_start (RateSources *sources, RateRequest *request, RateSource *source)
+{
+    request->source = source;
+    request->body = g_string_new(NULL);
+    request->started = g_get_monotonic_time();
+    request->curl = curl_easy_init();
+    if (!request->curl)
+        return FALSE;
+    
+    curl_easy_setopt(request->curl, CURLOPT_URL, source->url);
+    curl_easy_setopt(request->curl, CURLOPT_WRITEFUNCTION, rate_request_write);
+    curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, request->body);
+    curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
+    curl_easy_setopt(request->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(request->curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(request->curl, CURLOPT_TIMEOUT_MS, (long) (RATE_TIMEOUT / 1000));
+    
+    SAMPLE_TRACE1(fetch__start, BLOCK_EXCHANGE_RATE);
+    
+    return curl_multi_add_handle(sources->multi, request->curl) == CURLM_OK;
+}
+
+static void
+rate_request_finish (RateSources *sources, RateRequest *request)
+{
+    if (request->curl) {
+        curl_multi_remove_handle(sources->multi, request->curl);
+        curl_easy_cleanup(request->curl);
+        request->curl = NULL;
+    }
+    g_string_free(request->body, TRUE);
+    request->body = NULL;
+}
+
+static gboolean
+rate_read_member (JsonObject *rates, const gchar *code, gboolean lowercase, gdouble *rate)
+{
+    gchar *key = lowercase ? g_ascii_strdown(code, -1) : g_strdup(code);
+    JsonNode *node = json_object_get_member(rates, key);
+    
+    g_free(key);
+    if (!node || !JSON_NODE_HOLDS_VALUE(node))
+        return FALSE;
+    
+    *rate = json_node_get_double(node);
+    
+    return *rate > 0.0;
+}
+
+/* Maps an answer onto @exchange; FALSE when it has none of the rates */
+static gboolean
+rate_parse (const RateSource *source, const GString *body, ExchangeSample *exchange)
+{
+    JsonParser *parser = json_parser_new();
+    gboolean parsed;
+    
+    memset(exchange, 0, sizeof(*exchange));
+    
+    SAMPLE_TRACE2(parse__start, BLOCK_EXCHANGE_RATE, body->len);
+    parsed = json_parser_load_from_data(parser, body->str, body->len, NULL);
+    SAMPLE_TRACE2(parse__done, BLOCK_EXCHANGE_RATE, parsed);
+    
+    if (parsed && JSON_NODE_HOLDS_OBJECT(json_parser_get_root(parser))) {
+        JsonObject *root = json_node_get_object(json_parser_get_root(parser));
+        JsonNode *rates = json_object_get_member(root, source->info->rates_member);
+        JsonNode *timestamp = source->info->timestamp_member
+                              ? json_object_get_member(root, source->info->timestamp_member) : NULL;
+        
+        if (rates && JSON_NODE_HOLDS_OBJECT(rates)) {
+            JsonObject *object = json_node_get_object(rates);
+            
+            exchange->has_try = rate_read_member(object, "TRY", source->info->lowercase_codes, &exchange->try_rate);
+            exchange->has_rub = rate_read_member(object, "RUB", source->info->lowercase_codes, &exchange->rub_rate);
+        }
+        if (timestamp && JSON_NODE_HOLDS_VALUE(timestamp))
+            exchange->timestamp = (gint64) json_node_get_double(timestamp);
+        else
+            exchange->timestamp = sample_clock_time();
+        g_strlcpy(exchange->source, source->name, sizeof(exchange->source));
+    }
+    g_object_unref(parser);
+    
+    return exchange->has_try || exchange->has_rub;
+}
+
+gboolean
+rate_sources_fetch (RateSources *sources, ExchangeSample *exchange, GCancellable *cancellable)
+{
+    RateRequest requests[RATE_SOURCES_MAX];
+    gint order[RATE_SOURCES_MAX];
+    gint n_started = 0, n_running = 0;
+    gint64 now = g_get_monotonic_time();
+    gint64 deadline = now + RATE_TIMEOUT;
+    gint64 next_hedge = now;
+    gboolean answered = FALSE, cancelled;
+    gulong cancelled_id = 0;
+    
+    if (sources->n_sources == 0)
+        return FALSE;
+    
+    rate_sources_order(sources, order);
+    if (cancellable)
+        cancelled_id = g_cancellable_connect(cancellable, G_CALLBACK(rate_sources_cancelled), sources->multi, NULL);
+    
+    while (!answered && now < deadline && !g_cancellable_is_cancelled(cancellable)) {
+        CURLMsg *message;
+        gint still_running, queued;
+        gint64 wake;
+        
+        /* hedge, or fail over right away */
+        if (n_started < sources->n_sources && (n_running == 0 || now >= next_hedge)) {
+            RateRequest *request = &requests[n_started++];
+            
+            if (rate_request_start(sources, request, &sources->sources[order[n_started - 1]])) {
+                next_hedge = now + rate_source_p95(request->source);
+                n_running++;
+            } else {
+                rate_source_add_result(request->source, FALSE);
+                rate_request_finish(sources, request);
+            }
+            continue;
+        }
+        if (n_running == 0)
+            break;
+        
+        curl_multi_perform(sources->multi, &still_running);
+        while (!answered && (message = curl_multi_info_read(sources->multi, &queued))) {
+            RateRequest *request = NULL;
+            gboolean ok;
+            
+            if (message->msg != CURLMSG_DONE)
+                continue;
+            
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, (gchar **) &request);
+            SAMPLE_TRACE3(fetch__done, BLOCK_EXCHANGE_RATE, request->body->len, message->data.result);
+            ok = message->data.result == CURLE_OK && rate_parse(request->source, request->body, exchange);
+            rate_source_add_result(request->source, ok);
+            if (ok)
+                rate_source_add_latency(request->source, g_get_monotonic_time() - request->started);
+            rate_request_finish(sources, request);
+            n_running--;
+            
+            answered = ok;
+            if (!ok)
+                next_hedge = now;
+        }
+        
+        now = g_get_monotonic_time();
+        if (answered || n_running == 0)
+            continue;
+        
+        wake = n_started < sources->n_sources ? MIN(next_hedge, deadline) : deadline;
+        curl_multi_poll(sources->multi, NULL, 0, (gint) CLAMP((wake - now) / 1000, 0, G_MAXINT), NULL);
+        now = g_get_monotonic_time();
+    }
+    
+    g_cancellable_disconnect(cancellable, cancelled_id);
+    cancelled = !answered && g_cancellable_is_cancelled(cancellable);
+    
+    /* requests that lost the race would have taken at least this long,
+     * which says something only when that is already past their p95;
+     * the ones still running without any answer count as failures; a
+     * cancelled fetch says nothing about its sources */
+    for (gint i = 0; i < n_started; i++) {
+        if (requests[i].body) {
+            gint64 at_least = g_get_monotonic_time() - requests[i].started;
+            
+            if (!cancelled && at_least > rate_source_p95(requests[i].source))
+                rate_source_add_latency(requests[i].source, at_least);
+            if (!answered && !cancelled)
+                rate_source_add_result(requests[i].source, FALSE);
+            rate_request_finish(sources, &requests[i]);
+        }
+    }
+    
+    rate_sources_pick_primary(sources);
+    
+    return answered;
+}
+
+static gint
+rate_read_int (JsonObject *object, const gchar *member)
+{
+    JsonNode *node = object ? json_object_get_member(object, member) : NULL;
+    
+    if (!node || !JSON_NODE_HOLDS_VALUE(node))
+        return -1;
+    if (json_node_get_value_type(node) == G_TYPE_STRING)
+        return (gint) g_ascii_strtoll(json_node_get_string(node), NULL, 10);
+    
+    return (gint) json_node_get_int(node);
+}
+
+static JsonObject *
+rate_read_object (JsonObject *object, const gchar *member)
+{
+    JsonNode *node = object ? json_object_get_member(object, member) : NULL;
+    
+    return node && JSON_NODE_HOLDS_OBJECT(node) ? json_node_get_object(node) : NULL;
+}
+
+/* The usage answer looks like
+ * {"data": {"plan": {"update_frequency": "3600s"},
+ *           "usage": {"requests": 10, "requests_quota": 1000,
+ *                     "requests_remaining": 990, "days_remaining": 20}}} */
+static gboolean
+rate_parse_usage (const GString *body, SamplePlannerUsage *usage)
+{
+    JsonParser *parser = json_parser_new();
+    gboolean parsed = FALSE;
+    
+    if (json_parser_load_from_data(parser, body->str, body->len, NULL)
+        && JSON_NODE_HOLDS_OBJECT(json_parser_get_root(parser))) {
+        JsonObject *data = rate_read_object(json_node_get_object(json_parser_get_root(parser)), "data");
+        JsonObject *counts = rate_read_object(data, "usage");
+        
+        usage->used = rate_read_int(counts, "requests");
+        usage->quota = rate_read_int(counts, "requests_quota");
+        usage->remaining = rate_read_int(counts, "requests_remaining");
+        usage->days_remaining = rate_read_int(counts, "days_remaining");
+        usage->update_interval = rate_read_int(rate_read_object(data, "plan"), "update_frequency");
+        parsed = counts != NULL;
+    }
+    g_object_unref(parser);
+    
+    return parsed;
+}
+
+gboolean
+rate_sources_fetch_usage (RateSources *sources, SamplePlannerUsage *usage, GCancellable *cancellable)
+{
+    const RateSource *source = NULL;
+    GString *body;
+    gchar **parts;
+    gchar *url;
+    CURL *curl;
+    CURLcode res = CURLE_FAILED_INIT;
+    gboolean parsed;
+    
+    for (gint i = 0; i < sources->n_sources && !source; i++) {
+        const RateSourceInfo *info = sources->sources[i].info;
+        
+        if ((info == rate_source_info_find("openexchangerates") || info == &custom_source)
+            && strstr(sources->sources[i].url, "/latest.json"))
+            source = &sources->sources[i];
+    }
+    if (!source)
+        return FALSE;
+    
+    parts = g_strsplit(source->url, "/latest.json", 2);
+    url = g_strjoinv("/usage.json", parts);
+    g_strfreev(parts);
+    body = g_string_new(NULL);
+    
+    curl = curl_easy_init();
+    if (curl) {
+        curl_easy_setopt(curl, CURLOPT_URL, url);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rate_request_write);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long) (RATE_TIMEOUT / 1000));
+        if (cancellable) {
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, rate_request_progress);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancellable);
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        }
+        res = curl_easy_perform(curl);
+        curl_easy_cleanup(curl);
+    }
+    g_free(url);
+    
+    parsed = res == CURLE_OK && rate_parse_usage(body, usage);
+    if (res != CURLE_OK && res != CURLE_ABORTED_BY_CALLBACK)
+        g_debug("Exchange rates: no usage from %s: %s", source->name, curl_easy_strerror(res));
+    g_string_free(body, TRUE);
+    
+    return parsed;
+}
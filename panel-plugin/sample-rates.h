@@ -0,0 +1,64 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_RATES_H__
+#define __SAMPLE_RATES_H__
+
+#include <gio/gio.h>
+
+#include "sample-blocks.h"
+#include "sample-planner.h"
+
+G_BEGIN_DECLS
+
+/* Used when the settings name no sources */
+#define RATE_DEFAULT_SOURCES "openexchangerates;open-er-api;currency-api"
+
+/* Exchange rate sources in order of preference, from a ';' separated
+ * list of built-in source names and "name=URL" entries. A URL entry
+ * answers like openexchangerates.org, e.g. a local mock server; "{key}"
+ * in a URL is replaced by the API key, sources that need one are skipped
+ * without it. A fetch asks the primary source first. When the primary
+ * has not answered by its p95 latency, or fails, the next source is asked
+ * too, and the first valid answer wins. Latency and error statistics of
+ * every source pick the primary. A fetch returns early, with nothing,
+ * once its @cancellable, which may be NULL, is cancelled. */
+typedef struct _RateSources RateSources;
+
+RateSources *rate_sources_new         (const gchar        *spec,
+                                       const gchar        *api_key);
+
+void         rate_sources_free        (RateSources        *sources);
+
+guint        rate_sources_get_n       (RateSources        *sources);
+
+gboolean     rate_sources_fetch       (RateSources        *sources,
+                                       ExchangeSample     *exchange,
+                                       GCancellable       *cancellable);
+
+/* Usage of the key from the usage.json next to the latest.json of the
+ * first openexchangerates.org style source; FALSE when there is none or
+ * it did not answer. Asking does not count against the quota. */
+gboolean     rate_sources_fetch_usage (RateSources        *sources,
+                                       SamplePlannerUsage *usage,
+                                       GCancellable       *cancellable);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_RATES_H__ */
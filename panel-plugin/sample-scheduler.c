@@ -0,0 +1,659 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gio/gio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "sample-scheduler.h"
+#include "sample-clock.h"
+#include "sample-power.h"
+#include "sample-providers.h"
+
+/* On battery, workers that are not critical sleep this many times longer
+ * and wake on a shared grid of the wall clock, so their wakeups batch up
+ * with each other and with the clock's minute */
+#define BATTERY_STRETCH     3
+#define BATTERY_GRID        (10 * G_USEC_PER_SEC)
+#define BATTERY_TIMER_SLACK (500 * 1000 * 1000)    /* ns */
+
+#define REPORT_INTERVAL     (60 * 60)              /* s */
+
+/* details are gathered this long after the front end last showed them */
+#define DETAILS_LEASE       (10 * G_USEC_PER_SEC)
+
+struct _SampleScheduler
+{
+    BlockStore   *store;
+    StatusThread  threads[BLOCK_COUNT];
+
+    /* power source, read by the workers before every sleep */
+    SamplePower     *power;
+    gint             on_battery;
+    guint            report_source;
+
+    /* refresh triggers besides the front end's clicks */
+    GNetworkMonitor *network_monitor;
+    gulong           network_changed_id;
+    GDBusConnection *system_bus;
+    guint            sleep_subscription;
+    GCancellable    *cancellable;
+
+    /* the current snapshot and the ones replaced while workers may still
+     * be picking them up */
+    SampleConfig *config;
+    gint          config_serial;
+    GSList       *retired_configs;
+    guint         reclaim_source;
+};
+
+/* Pick up the latest published settings; TRUE when they were replaced.
+ * The serial is read before the pointer and recorded only once the new
+ * snapshot is referenced, so a recorded serial promises the scheduler
+ * that this worker will not touch older snapshots anymore. */
+gboolean
+status_thread_sync_config (StatusThread  *thread,
+                           SampleConfig **config)
+{
+    SampleScheduler *scheduler = thread->scheduler;
+    gint serial = g_atomic_int_get(&scheduler->config_serial);
+    
+    if (*config && serial == thread->config_serial)
+        return FALSE;
+    
+    sample_config_unref(*config);
+    *config = sample_config_ref(g_atomic_pointer_get(&scheduler->config));
+    g_atomic_int_set(&thread->config_serial, serial);
+    
+    return TRUE;
+}
+
+/* Timer slack lets the kernel fire our timers together with others, it is
+ * per thread so every worker sets its own */
+static void
+status_thread_set_slack (StatusThread *thread, gboolean on_battery)
+{
+    if (thread->slack_raised == on_battery)
+        return;
+    
+#ifdef __linux__
+    /* 0 restores the default slack of the thread */
+    prctl(PR_SET_TIMERSLACK, on_battery ? BATTERY_TIMER_SLACK : 0, 0, 0, 0);
+#endif
+    thread->slack_raised = on_battery;
+}
+
+/* When to wake up after sleeping @seconds, under the power policy */
+static gint64
+status_thread_deadline (StatusThread *thread, gboolean on_battery, gint seconds)
+{
+    gint64 now = sample_clock_get_monotonic();
+    gint64 real, target;
+    
+    if (!on_battery || sample_provider_get(thread->block_id)->critical)
+        return now + seconds * G_USEC_PER_SEC;
+    
+    real = sample_clock_get_real();
+    target = real + (gint64) seconds * BATTERY_STRETCH * G_USEC_PER_SEC;
+    target = (target + BATTERY_GRID - 1) / BATTERY_GRID * BATTERY_GRID;
+    
+    return now + (target - real);
+}
+
+/* Charge the CPU time used since the last sleep to the current source */
+static void
+status_thread_account (StatusThread *thread, gboolean on_battery)
+{
+    struct timespec ts;
+    gint64 cpu;
+    
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return;
+    
+    cpu = (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+    thread->cpu_usec[on_battery] += cpu - thread->cpu_mark;
+    thread->cpu_mark = cpu;
+}
+
+/* Sleep, waking early when the thread is stopped, its settings were
+ * replaced or a refresh was requested. A refresh arriving sooner than the
+ * provider's minimum interval is held back until the interval is over.
+ * On battery the sleep is stretched and aligned, see BATTERY_STRETCH.
+ * Returns TRUE when woken for a refresh. */
+gboolean
+status_thread_sleep (StatusThread  *thread,
+                     SampleConfig **config,
+                     gint           seconds)
+{
+    SampleScheduler *scheduler = thread->scheduler;
+    gboolean on_battery = g_atomic_int_get(&scheduler->on_battery);
+    gint64 end = status_thread_deadline(thread, on_battery, seconds);
+    gboolean refresh = FALSE;
+    
+    status_thread_set_slack(thread, on_battery);
+    
+    g_mutex_lock(&thread->lock);
+    status_thread_account(thread, on_battery);
+    while (thread->running
+           && g_atomic_int_get(&scheduler->config_serial) == thread->config_serial) {
+        gint64 now = sample_clock_get_monotonic();
+        gint64 deadline = end;
+        
+        if (thread->refresh_pending) {
+            if (now >= thread->refresh_not_before) {
+                thread->refresh_pending = FALSE;
+                thread->refresh_not_before = now + sample_provider_get(thread->block_id)->min_refresh * G_USEC_PER_SEC;
+                refresh = TRUE;
+                break;
+            }
+            deadline = MIN(deadline, thread->refresh_not_before);
+        }
+        
+        if (now >= end)
+            break;
+        
+        sample_clock_wait_until(&thread->wake, &thread->lock, deadline);
+        thread->wakeups[on_battery]++;
+    }
+    g_mutex_unlock(&thread->lock);
+    
+    status_thread_sync_config(thread, config);
+    
+    return refresh;
+}
+
+/* Mark a fetch in flight. Requests made until it ends are answered by it
+ * instead of starting another one, and requests made before it are
+ * answered too. */
+void
+status_thread_fetch_begin (StatusThread *thread)
+{
+    const SampleProvider *provider = sample_provider_get(thread->block_id);
+    
+    g_mutex_lock(&thread->lock);
+    thread->fetching = TRUE;
+    thread->refresh_pending = FALSE;
+    thread->refresh_not_before = sample_clock_get_monotonic() + provider->min_refresh * G_USEC_PER_SEC;
+    thread->fetches++;
+    g_mutex_unlock(&thread->lock);
+}
+
+void
+status_thread_fetch_end (StatusThread *thread)
+{
+    g_mutex_lock(&thread->lock);
+    thread->fetching = FALSE;
+    g_mutex_unlock(&thread->lock);
+}
+
+/* Whether the costly extras of a block are on screen, e.g. the process
+ * list of the memory tooltip */
+gboolean
+status_thread_wants_details (StatusThread *thread)
+{
+    gboolean wanted;
+    
+    g_mutex_lock(&thread->lock);
+    wanted = thread->details_until > sample_clock_get_monotonic();
+    g_mutex_unlock(&thread->lock);
+    
+    return wanted;
+}
+
+static void
+status_thread_wake (StatusThread *thread)
+{
+    g_mutex_lock(&thread->lock);
+    g_cond_signal(&thread->wake);
+    g_mutex_unlock(&thread->lock);
+}
+
+/* Runs a provider; once it returns it reads no snapshot anymore */
+static gpointer
+status_thread_run (gpointer data)
+{
+    StatusThread *thread = data;
+    gpointer result = sample_provider_get(thread->block_id)->func(thread);
+    
+    g_atomic_int_set(&thread->config_serial, G_MAXINT);
+    sample_clock_release();
+    
+    return result;
+}
+
+static void
+start_thread (SampleScheduler *scheduler, BlockId block_id)
+{
+    StatusThread *thread = &scheduler->threads[block_id];
+    
+    thread->block_id = block_id;
+    thread->store = scheduler->store;
+    thread->scheduler = scheduler;
+    thread->config_serial = scheduler->config_serial;
+    thread->running = TRUE;
+    thread->fetching = FALSE;
+    thread->refresh_pending = FALSE;
+    thread->refresh_not_before = 0;
+    thread->details_until = 0;
+    thread->cpu_mark = 0;
+    thread->slack_raised = FALSE;
+    thread->cancellable = g_cancellable_new();
+    thread->thread = g_thread_new(sample_provider_get(block_id)->name, status_thread_run, thread);
+}
+
+/* Tell a worker to stop; a fetch in flight is aborted rather than waited
+ * for, so joining it does not hold up the GUI thread */
+static void
+signal_thread (StatusThread *thread)
+{
+    g_mutex_lock(&thread->lock);
+    thread->running = FALSE;
+    g_cond_signal(&thread->wake);
+    g_mutex_unlock(&thread->lock);
+    if (thread->cancellable)
+        g_cancellable_cancel(thread->cancellable);
+}
+
+static void
+stop_thread (SampleScheduler *scheduler, BlockId block_id)
+{
+    StatusThread *thread = &scheduler->threads[block_id];
+    
+    if (!thread->thread)
+        return;
+    
+    signal_thread(thread);
+    g_thread_join(thread->thread);
+    thread->thread = NULL;
+    g_clear_object(&thread->cancellable);
+}
+
+static void
+sample_scheduler_refresh_remote (SampleScheduler *scheduler)
+{
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        if (sample_provider_get(i)->remote || i == BLOCK_NETWORK)
+            sample_scheduler_refresh(scheduler, i);
+    }
+}
+
+static void
+sample_scheduler_network_changed (GNetworkMonitor *monitor,
+                                  gboolean         available,
+                                  gpointer         data)
+{
+    if (available)
+        sample_scheduler_refresh_remote(data);
+}
+
+/* logind announces the end of a suspend with PrepareForSleep(false) */
+static void
+sample_scheduler_prepare_for_sleep (GDBusConnection *connection,
+                                    const gchar     *sender_name,
+                                    const gchar     *object_path,
+                                    const gchar     *interface_name,
+                                    const gchar     *signal_name,
+                                    GVariant        *parameters,
+                                    gpointer         data)
+{
+    gboolean sleeping = TRUE;
+    
+    if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(b)")))
+        g_variant_get(parameters, "(b)", &sleeping);
+    
+    if (!sleeping) {
+        for (int i = 0; i < BLOCK_COUNT; i++)
+            sample_scheduler_refresh(data, i);
+    }
+}
+
+static void
+sample_scheduler_got_system_bus (GObject      *source,
+                                 GAsyncResult *result,
+                                 gpointer      data)
+{
+    GError *error = NULL;
+    GDBusConnection *bus = g_bus_get_finish(result, &error);
+    SampleScheduler *scheduler;
+    
+    /* without a system bus resumes are only noticed by the timers */
+    if (!bus) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_debug("No system bus, not watching for resume: %s", error->message);
+        g_error_free(error);
+        return;
+    }
+    
+    scheduler = data;
+    scheduler->system_bus = bus;
+    scheduler->sleep_subscription =
+        g_dbus_connection_signal_subscribe(bus, "org.freedesktop.login1",
+                                           "org.freedesktop.login1.Manager", "PrepareForSleep",
+                                           "/org/freedesktop/login1", NULL,
+                                           G_DBUS_SIGNAL_FLAGS_NONE,
+                                           sample_scheduler_prepare_for_sleep, scheduler, NULL);
+}
+
+static void
+sample_scheduler_power_changed (gboolean on_battery,
+                                gpointer data)
+{
+    SampleScheduler *scheduler = data;
+    
+    /* workers switch policy at their next sleep */
+    g_atomic_int_set(&scheduler->on_battery, on_battery);
+}
+
+/* Open descriptors, threads and resident size of the process, so that a
+ * long or sped up run shows whether any of them grows */
+static void
+sample_scheduler_report_process (void)
+{
+    GDir *fds = g_dir_open("/proc/self/fd", 0, NULL);
+    gchar *status = NULL;
+    const gchar *line;
+    guint n_fds = 0;
+    glong threads = 0, rss_kib = 0;
+    
+    if (fds) {
+        while (g_dir_read_name(fds))
+            n_fds++;
+        g_dir_close(fds);
+    }
+    
+    if (g_file_get_contents("/proc/self/status", &status, NULL, NULL)) {
+        if ((line = strstr(status, "\nThreads:")))
+            threads = strtol(line + strlen("\nThreads:"), NULL, 10);
+        if ((line = strstr(status, "\nVmRSS:")))
+            rss_kib = strtol(line + strlen("\nVmRSS:"), NULL, 10);
+        g_free(status);
+    }
+    
+    g_debug("Process: %u open descriptors, %ld threads, %ld KiB resident",
+            n_fds, threads, rss_kib);
+}
+
+/* Sums and resets the counters of all workers. CPU time is charged when
+ * a worker goes to sleep, so a running one has its current tick left out. */
+void
+sample_scheduler_take_stats (SampleScheduler      *scheduler,
+                             SampleSchedulerStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        StatusThread *thread = &scheduler->threads[i];
+        
+        g_mutex_lock(&thread->lock);
+        for (int mode = 0; mode < 2; mode++) {
+            stats->wakeups[mode] += thread->wakeups[mode];
+            stats->cpu_usec[mode] += thread->cpu_usec[mode];
+            thread->wakeups[mode] = 0;
+            thread->cpu_usec[mode] = 0;
+        }
+        stats->fetches += thread->fetches;
+        thread->fetches = 0;
+        g_mutex_unlock(&thread->lock);
+    }
+}
+
+/* Hourly cost of the workers, to compare the two power policies. The hour
+ * is on the sample clock, a sped up run reports more often. */
+static gboolean
+sample_scheduler_report (gpointer data)
+{
+    SampleScheduler *scheduler = data;
+    SampleSchedulerStats stats;
+    
+    sample_scheduler_take_stats(scheduler, &stats);
+    g_debug("Worker wakeups in the last hour: %u on AC, %u on battery; "
+            "CPU time: %.3f s on AC, %.3f s on battery",
+            stats.wakeups[FALSE], stats.wakeups[TRUE],
+            stats.cpu_usec[FALSE] / (gdouble) G_USEC_PER_SEC,
+            stats.cpu_usec[TRUE] / (gdouble) G_USEC_PER_SEC);
+    g_debug("Remote fetches in the last hour: %u", stats.fetches);
+    
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        SampleCacheStats cache_stats;
+        
+        if (!scheduler->threads[i].cache)
+            continue;
+        sample_cache_take_stats(scheduler->threads[i].cache, &cache_stats);
+        g_debug("%s cache in the last hour: %u hits, %u misses, %u revalidations",
+                block_get_name(i), cache_stats.hits, cache_stats.misses, cache_stats.revalidations);
+    }
+    sample_scheduler_report_process();
+    
+    return G_SOURCE_CONTINUE;
+}
+
+/* Takes ownership of @config and starts the workers it enables */
+SampleScheduler *
+sample_scheduler_new (BlockStore   *store,
+                      SampleConfig *config)
+{
+    SampleScheduler *scheduler = g_slice_new0(SampleScheduler);
+    
+    scheduler->store = store;
+    scheduler->config = config;
+    scheduler->config_serial = config->serial;
+    
+    /* before the workers, they read it at their first sleep */
+    scheduler->power = sample_power_new(sample_scheduler_power_changed, scheduler);
+    scheduler->on_battery = sample_power_on_battery(scheduler->power);
+    scheduler->report_source = g_timeout_add(MAX(1, (guint) (REPORT_INTERVAL * 1000 / sample_clock_get_scale())),
+                                             sample_scheduler_report, scheduler);
+    
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        const SampleProvider *provider = sample_provider_get(i);
+        
+        g_mutex_init(&scheduler->threads[i].lock);
+        g_cond_init(&scheduler->threads[i].wake);
+        /* kept across restarts of the worker and changes of its settings */
+        if (provider->cache_size > 0)
+            scheduler->threads[i].cache = sample_cache_new(provider->cache_size, provider->soft_ttl, provider->ttl);
+        if (sample_provider_wanted(config, i))
+            start_thread(scheduler, i);
+    }
+    
+    /* fresh data once the network is back or after a resume */
+    scheduler->network_monitor = g_object_ref(g_network_monitor_get_default());
+    scheduler->network_changed_id =
+        g_signal_connect(scheduler->network_monitor, "network-changed",
+                         G_CALLBACK(sample_scheduler_network_changed), scheduler);
+    scheduler->cancellable = g_cancellable_new();
+    g_bus_get(G_BUS_TYPE_SYSTEM, scheduler->cancellable, sample_scheduler_got_system_bus, scheduler);
+    
+    return scheduler;
+}
+
+void
+sample_scheduler_free (SampleScheduler *scheduler)
+{
+    /* no more refresh triggers or power changes */
+    sample_power_free(scheduler->power);
+    g_source_remove(scheduler->report_source);
+    g_signal_handler_disconnect(scheduler->network_monitor, scheduler->network_changed_id);
+    g_object_unref(scheduler->network_monitor);
+    g_cancellable_cancel(scheduler->cancellable);
+    g_object_unref(scheduler->cancellable);
+    if (scheduler->system_bus) {
+        g_dbus_connection_signal_unsubscribe(scheduler->system_bus, scheduler->sleep_subscription);
+        g_object_unref(scheduler->system_bus);
+    }
+    
+    /* Stop all threads first so they wind down together */
+    for (int i = 0; i < BLOCK_COUNT; i++)
+        signal_thread(&scheduler->threads[i]);
+    
+    /* Wait for threads to finish */
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        stop_thread(scheduler, i);
+        g_mutex_clear(&scheduler->threads[i].lock);
+        g_cond_clear(&scheduler->threads[i].wake);
+        sample_cache_free(scheduler->threads[i].cache);
+    }
+    
+    /* no worker holds a snapshot anymore */
+    if (scheduler->reclaim_source != 0)
+        g_source_remove(scheduler->reclaim_source);
+    g_slist_free_full(scheduler->retired_configs, (GDestroyNotify) sample_config_unref);
+    sample_config_unref(scheduler->config);
+    
+    g_slice_free(SampleScheduler, scheduler);
+}
+
+/* Drop the replaced snapshots every running worker has moved past */
+static gboolean
+sample_scheduler_reclaim (gpointer data)
+{
+    SampleScheduler *scheduler = data;
+    gint oldest = scheduler->config_serial;
+    GSList *l = scheduler->retired_configs;
+    
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        if (scheduler->threads[i].thread)
+            oldest = MIN(oldest, g_atomic_int_get(&scheduler->threads[i].config_serial));
+    }
+    
+    while (l) {
+        GSList *next = l->next;
+        SampleConfig *config = l->data;
+        
+        if (config->serial < oldest) {
+            scheduler->retired_configs = g_slist_delete_link(scheduler->retired_configs, l);
+            sample_config_unref(config);
+        }
+        l = next;
+    }
+    
+    if (scheduler->retired_configs)
+        return G_SOURCE_CONTINUE;
+    
+    scheduler->reclaim_source = 0;
+    return G_SOURCE_REMOVE;
+}
+
+/* Publish new settings, taking ownership of @config. Only providers whose
+ * settings changed are started or stopped; running workers pick up the
+ * snapshot at their next step and rekey themselves from it. */
+void
+sample_scheduler_apply (SampleScheduler *scheduler,
+                        SampleConfig    *config)
+{
+    SampleConfig *old = scheduler->config;
+    
+    config->serial = old->serial + 1;
+    g_atomic_pointer_set(&scheduler->config, config);
+    g_atomic_int_set(&scheduler->config_serial, config->serial);
+    scheduler->retired_configs = g_slist_prepend(scheduler->retired_configs, old);
+    
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        gboolean running = scheduler->threads[i].thread != NULL;
+        gboolean wanted = sample_provider_wanted(config, i);
+        
+        if (running && !wanted) {
+            stop_thread(scheduler, i);
+            block_store_reset(scheduler->store, i);
+        } else if (!running && wanted) {
+            start_thread(scheduler, i);
+        } else if (running) {
+            /* pick up the snapshot now rather than at the next tick */
+            status_thread_wake(&scheduler->threads[i]);
+        }
+    }
+    
+    if (sample_scheduler_reclaim(scheduler) && scheduler->reclaim_source == 0)
+        scheduler->reclaim_source = g_timeout_add_seconds(1, sample_scheduler_reclaim, scheduler);
+}
+
+/* The current snapshot, only for the thread driving the scheduler */
+const SampleConfig *
+sample_scheduler_get_config (SampleScheduler *scheduler)
+{
+    return scheduler->config;
+}
+
+/* Ask a block's worker for fresh data now. Requests while it fetches are
+ * answered by that fetch, and the provider's minimum interval holds back
+ * the ones right after it, so any number of clicks costs one fetch. */
+void
+sample_scheduler_refresh (SampleScheduler *scheduler,
+                          BlockId          block_id)
+{
+    StatusThread *thread;
+    
+    g_return_if_fail(block_id < BLOCK_COUNT);
+    
+    thread = &scheduler->threads[block_id];
+    if (!thread->thread)
+        return;
+    
+    g_mutex_lock(&thread->lock);
+    if (!thread->fetching && !thread->refresh_pending) {
+        thread->refresh_pending = TRUE;
+        g_cond_signal(&thread->wake);
+    }
+    g_mutex_unlock(&thread->lock);
+}
+
+/* The front end shows a block's details; call it again while they stay
+ * on screen. The first call asks for them right away. */
+void
+sample_scheduler_show_details (SampleScheduler *scheduler,
+                               BlockId          block_id)
+{
+    StatusThread *thread;
+    gint64 now = sample_clock_get_monotonic();
+    gboolean shown;
+    
+    g_return_if_fail(block_id < BLOCK_COUNT);
+    
+    thread = &scheduler->threads[block_id];
+    if (!thread->thread)
+        return;
+    
+    g_mutex_lock(&thread->lock);
+    shown = thread->details_until > now;
+    thread->details_until = now + DETAILS_LEASE;
+    g_mutex_unlock(&thread->lock);
+    
+    if (!shown)
+        sample_scheduler_refresh(scheduler, block_id);
+}
+
+gboolean
+sample_scheduler_showing_details (SampleScheduler *scheduler,
+                                  BlockId          block_id)
+{
+    g_return_val_if_fail(block_id < BLOCK_COUNT, FALSE);
+    
+    return scheduler->threads[block_id].thread
+           && status_thread_wants_details(&scheduler->threads[block_id]);
+}
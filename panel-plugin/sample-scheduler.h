@@ -0,0 +1,110 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_SCHEDULER_H__
+#define __SAMPLE_SCHEDULER_H__
+
+#include <gio/gio.h>
+
+#include "sample-blocks.h"
+#include "sample-cache.h"
+#include "sample-config.h"
+
+G_BEGIN_DECLS
+
+/* Runs one worker thread per enabled block and publishes settings
+ * snapshots to them. Owned and driven by a single thread with a main
+ * loop, the GUI thread in the panel. */
+typedef struct _SampleScheduler SampleScheduler;
+
+/* Status bar update thread data */
+typedef struct {
+    GThread         *thread;
+    gboolean         running;
+    gint             config_serial;    /* serial of the last settings snapshot picked up */
+    BlockId          block_id;
+    BlockStore      *store;
+    SampleScheduler *scheduler;
+    SampleCache     *cache;            /* remote providers only, outlives the thread */
+    GCancellable    *cancellable;      /* cancelled to cut a fetch short on stop */
+
+    /* wakes the worker early; guards the fields below and running */
+    GMutex           lock;
+    GCond            wake;
+    gboolean         fetching;           /* a fetch is in flight */
+    gboolean         refresh_pending;    /* someone asked for fresh data */
+    gint64           refresh_not_before; /* monotonic, from min_refresh */
+    gint64           details_until;      /* monotonic, the front end shows the details */
+
+    /* wakeups and CPU time since the stats were taken, by power source */
+    guint            wakeups[2];
+    gint64           cpu_usec[2];
+    guint            fetches;            /* since the stats were taken */
+
+    /* only touched by the worker itself */
+    gint64           cpu_mark;
+    gboolean         slack_raised;
+} StatusThread;
+
+/* Cost of the workers since the stats were last taken */
+typedef struct {
+    guint  wakeups[2];     /* by power source, [TRUE] on battery */
+    gint64 cpu_usec[2];
+    guint  fetches;
+} SampleSchedulerStats;
+
+SampleScheduler    *sample_scheduler_new        (BlockStore   *store,
+                                                 SampleConfig *config);
+
+void                sample_scheduler_free       (SampleScheduler *scheduler);
+
+void                sample_scheduler_apply      (SampleScheduler *scheduler,
+                                                 SampleConfig    *config);
+
+const SampleConfig *sample_scheduler_get_config (SampleScheduler *scheduler);
+
+void                sample_scheduler_refresh    (SampleScheduler *scheduler,
+                                                 BlockId          block_id);
+
+void                sample_scheduler_take_stats (SampleScheduler      *scheduler,
+                                                 SampleSchedulerStats *stats);
+
+void                sample_scheduler_show_details    (SampleScheduler *scheduler,
+                                                      BlockId          block_id);
+
+gboolean            sample_scheduler_showing_details (SampleScheduler *scheduler,
+                                                      BlockId          block_id);
+
+/* for the workers */
+gboolean            status_thread_sync_config   (StatusThread  *thread,
+                                                 SampleConfig **config);
+
+gboolean            status_thread_sleep         (StatusThread  *thread,
+                                                 SampleConfig **config,
+                                                 gint           seconds);
+
+void                status_thread_fetch_begin   (StatusThread  *thread);
+
+void                status_thread_fetch_end     (StatusThread  *thread);
+
+gboolean            status_thread_wants_details (StatusThread  *thread);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_SCHEDULER_H__ */
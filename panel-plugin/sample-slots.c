@@ -0,0 +1,60 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "sample-slots.h"
+
+void
+sample_slot_size_reset (SampleSlotSize *size, gint template_width, gint height)
+{
+    size->template_width = template_width;
+    size->width = 0;
+    size->height = height;
+    size->narrow_since = 0;
+}
+
+gboolean
+sample_slot_size_update (SampleSlotSize *size, gint width, gint height, gint64 now)
+{
+    width = MAX(width, size->template_width);
+    
+    if (width > size->width || height > size->height) {
+        size->width = MAX(width, size->width);
+        size->height = MAX(height, size->height);
+        size->narrow_since = 0;
+        return TRUE;
+    }
+    
+    if (width + SAMPLE_SLOT_SHRINK_SLACK > size->width) {
+        size->narrow_since = 0;
+        return FALSE;
+    }
+    
+    if (size->narrow_since == 0)
+        size->narrow_since = now;
+    if (now - size->narrow_since < SAMPLE_SLOT_SHRINK_DELAY)
+        return FALSE;
+    
+    size->width = width;
+    size->narrow_since = 0;
+    return TRUE;
+}
@@ -0,0 +1,55 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_SLOTS_H__
+#define __SAMPLE_SLOTS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Slots shrink only once their content has been this many pixels narrower
+ * than the reserved width for a while */
+#define SAMPLE_SLOT_SHRINK_SLACK 8
+#define SAMPLE_SLOT_SHRINK_DELAY (5 * 60 * G_USEC_PER_SEC)
+
+/* Size reserved in the panel for a block. It grows right away and shrinks
+ * only after the content stayed clearly narrower for a while, so text
+ * that jitters by a digit is redrawn in place instead of relayouting the
+ * whole panel. */
+typedef struct {
+    gint   template_width;  /* worst case width for the current font */
+    gint   width, height;   /* reserved size */
+    gint64 narrow_since;    /* content well below the reserved width since */
+} SampleSlotSize;
+
+void      sample_slot_size_reset  (SampleSlotSize *size,
+                                   gint            template_width,
+                                   gint            height);
+
+/* Takes the size of new content at monotonic time @now, µs. Returns TRUE
+ * when the reserved size changed and the panel needs a relayout. */
+gboolean  sample_slot_size_update (SampleSlotSize *size,
+                                   gint            width,
+                                   gint            height,
+                                   gint64          now);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_SLOTS_H__ */
@@ -0,0 +1,497 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "sample-source.h"
+#include "sample-clock.h"
+
+/* A trace is the magic and version, then records of two kinds, all
+ * numbers little endian:
+ *   'p' id:u16 length:u16 path            names the next path id
+ *   's' id:u16 time:i64 length:u32 bytes  contents read at time µs
+ * Path ids count up from 0. A read is recorded only when its contents
+ * changed, so a recording grows with what happened on the machine and
+ * not with the refresh rate. */
+#define TRACE_MAGIC       "XSSTRACE"
+#define TRACE_MAGIC_LEN   8
+#define TRACE_VERSION     1
+#define TRACE_PATH        'p'
+#define TRACE_SNAPSHOT    's'
+#define TRACE_MAX_PATHS   G_MAXUINT16
+
+typedef enum {
+    SOURCE_LIVE,
+    SOURCE_RECORD,
+    SOURCE_REPLAY
+} SourceMode;
+
+typedef struct {
+    gint64 time;      /* µs since the start of the trace */
+    gsize  offset;    /* of the contents in the trace */
+    gsize  len;
+} TraceSnapshot;
+
+typedef struct {
+    gchar      *path;
+    gint        trace_id;     /* -1 until named in the recording */
+    GByteArray *last;         /* recording: contents written last */
+    GArray     *snapshots;    /* replay: TraceSnapshot by time */
+} SourcePath;
+
+static SourceMode  source_mode = SOURCE_LIVE;
+static gchar      *source_root;
+
+/* guards everything below, the workers read concurrently */
+static GMutex      source_lock;
+static GPtrArray  *source_paths;      /* SourcePath */
+static GHashTable *source_path_index; /* path -> index + 1 */
+static GHashTable *source_fds;        /* fd -> index + 1 */
+static gint64      trace_start;       /* sample clock */
+static FILE       *trace_out;
+static gint        trace_n_paths;
+static gchar      *trace_in;
+static gsize       trace_in_len;
+
+static void
+source_path_free (gpointer data)
+{
+    SourcePath *source_path = data;
+    
+    g_free(source_path->path);
+    if (source_path->last)
+        g_byte_array_unref(source_path->last);
+    if (source_path->snapshots)
+        g_array_unref(source_path->snapshots);
+    g_free(source_path);
+}
+
+static void
+source_init (SourceMode mode)
+{
+    source_paths = g_ptr_array_new_with_free_func(source_path_free);
+    source_path_index = g_hash_table_new(g_str_hash, g_str_equal);
+    source_fds = g_hash_table_new(NULL, NULL);
+    trace_start = sample_clock_get_monotonic();
+    source_mode = mode;
+}
+
+/* Called with the lock held */
+static SourcePath *
+source_path_get (const gchar *path, gboolean create)
+{
+    guint index = GPOINTER_TO_UINT(g_hash_table_lookup(source_path_index, path));
+    SourcePath *source_path;
+    
+    if (index > 0)
+        return g_ptr_array_index(source_paths, index - 1);
+    if (!create)
+        return NULL;
+    
+    source_path = g_new0(SourcePath, 1);
+    source_path->path = g_strdup(path);
+    source_path->trace_id = -1;
+    g_ptr_array_add(source_paths, source_path);
+    g_hash_table_insert(source_path_index, source_path->path, GUINT_TO_POINTER(source_paths->len));
+    
+    return source_path;
+}
+
+/* Called with the lock held */
+static SourcePath *
+source_fd_get (gint fd)
+{
+    guint index = GPOINTER_TO_UINT(g_hash_table_lookup(source_fds, GINT_TO_POINTER(fd)));
+    
+    return index > 0 ? g_ptr_array_index(source_paths, index - 1) : NULL;
+}
+
+static void
+source_track (gint fd, const gchar *path)
+{
+    SourcePath *source_path;
+    
+    g_mutex_lock(&source_lock);
+    source_path = source_path_get(path, TRUE);
+    g_hash_table_insert(source_fds, GINT_TO_POINTER(fd),
+                        g_hash_table_lookup(source_path_index, source_path->path));
+    g_mutex_unlock(&source_lock);
+}
+
+void
+sample_source_set_root (const gchar *root)
+{
+    g_free(source_root);
+    source_root = g_strdup(root);
+}
+
+gboolean
+sample_source_record (const gchar *trace, GError **error)
+{
+    guint32 version = GUINT32_TO_LE(TRACE_VERSION);
+    
+    g_return_val_if_fail(source_mode == SOURCE_LIVE, FALSE);
+    
+    trace_out = fopen(trace, "wbe");
+    if (!trace_out) {
+        gint saved_errno = errno;
+        
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Unable to create %s: %s", trace, g_strerror(saved_errno));
+        return FALSE;
+    }
+    
+    fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_LEN, trace_out);
+    fwrite(&version, sizeof(version), 1, trace_out);
+    source_init(SOURCE_RECORD);
+    
+    return TRUE;
+}
+
+/* Checks the whole trace up front so that reads cannot fail later */
+gboolean
+sample_source_replay (const gchar *trace, GError **error)
+{
+    gchar *data;
+    gsize len, pos;
+    guint32 version;
+    gint n_paths = 0;
+    
+    g_return_val_if_fail(source_mode == SOURCE_LIVE, FALSE);
+    
+    if (!g_file_get_contents(trace, &data, &len, error))
+        return FALSE;
+    
+    if (len < TRACE_MAGIC_LEN + sizeof(version) || memcmp(data, TRACE_MAGIC, TRACE_MAGIC_LEN) != 0)
+        goto invalid;
+    memcpy(&version, data + TRACE_MAGIC_LEN, sizeof(version));
+    if (GUINT32_FROM_LE(version) != TRACE_VERSION)
+        goto invalid;
+    
+    source_init(SOURCE_REPLAY);
+    trace_in = data;
+    trace_in_len = len;
+    
+    for (pos = TRACE_MAGIC_LEN + sizeof(version); pos < len; ) {
+        gchar kind = data[pos++];
+        guint16 id;
+        
+        if (len - pos < sizeof(id))
+            goto invalid;
+        memcpy(&id, data + pos, sizeof(id));
+        id = GUINT16_FROM_LE(id);
+        pos += sizeof(id);
+        
+        if (kind == TRACE_PATH) {
+            guint16 path_len;
+            gchar *path;
+            
+            if (id != n_paths || len - pos < sizeof(path_len))
+                goto invalid;
+            memcpy(&path_len, data + pos, sizeof(path_len));
+            path_len = GUINT16_FROM_LE(path_len);
+            pos += sizeof(path_len);
+            if (len - pos < path_len)
+                goto invalid;
+            
+            /* a path named twice would break the id to index mapping */
+            path = g_strndup(data + pos, path_len);
+            if (source_path_get(path, FALSE)) {
+                g_free(path);
+                goto invalid;
+            }
+            source_path_get(path, TRUE)->snapshots = g_array_new(FALSE, FALSE, sizeof(TraceSnapshot));
+            g_free(path);
+            pos += path_len;
+            n_paths++;
+        } else if (kind == TRACE_SNAPSHOT) {
+            SourcePath *source_path;
+            TraceSnapshot snapshot;
+            gint64 time;
+            guint32 snapshot_len;
+            
+            if (id >= n_paths || len - pos < sizeof(time) + sizeof(snapshot_len))
+                goto invalid;
+            memcpy(&time, data + pos, sizeof(time));
+            memcpy(&snapshot_len, data + pos + sizeof(time), sizeof(snapshot_len));
+            pos += sizeof(time) + sizeof(snapshot_len);
+            snapshot.time = GINT64_FROM_LE(time);
+            snapshot.len = GUINT32_FROM_LE(snapshot_len);
+            snapshot.offset = pos;
+            if (len - pos < snapshot.len)
+                goto invalid;
+            
+            /* paths are named in order, the id is the index */
+            source_path = g_ptr_array_index(source_paths, id);
+            if (source_path->snapshots->len > 0
+                && g_array_index(source_path->snapshots, TraceSnapshot,
+                                 source_path->snapshots->len - 1).time > snapshot.time)
+                goto invalid;
+            g_array_append_val(source_path->snapshots, snapshot);
+            pos += snapshot.len;
+        } else {
+            goto invalid;
+        }
+    }
+    
+    return TRUE;
+    
+invalid:
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s is not a valid sample trace", trace);
+    if (source_mode == SOURCE_REPLAY) {
+        g_ptr_array_unref(source_paths);
+        g_hash_table_unref(source_path_index);
+        g_hash_table_unref(source_fds);
+        trace_in = NULL;
+        source_mode = SOURCE_LIVE;
+    }
+    g_free(data);
+    
+    return FALSE;
+}
+
+gboolean
+sample_source_is_live (void)
+{
+    return !source_root && source_mode != SOURCE_REPLAY;
+}
+
+gboolean
+sample_source_is_traced (void)
+{
+    return source_mode != SOURCE_LIVE;
+}
+
+void
+sample_source_finish (void)
+{
+    g_mutex_lock(&source_lock);
+    if (trace_out) {
+        if (fclose(trace_out) != 0)
+            g_warning("Unable to write the trace: %s", g_strerror(errno));
+        trace_out = NULL;
+        /* reads go on unrecorded */
+        source_mode = SOURCE_LIVE;
+    }
+    g_mutex_unlock(&source_lock);
+}
+
+/* A stand in descriptor for a path of the trace: files are the recorded
+ * ones, directories the ones containing them */
+static gint
+source_replay_open (const gchar *path)
+{
+    gboolean known;
+    gint fd;
+    
+    g_mutex_lock(&source_lock);
+    known = source_path_get(path, FALSE) != NULL;
+    for (guint i = 0; !known && i < source_paths->len; i++) {
+        const gchar *other = ((SourcePath *) g_ptr_array_index(source_paths, i))->path;
+        
+        known = g_str_has_prefix(other, path) && other[strlen(path)] == '/';
+    }
+    g_mutex_unlock(&source_lock);
+    
+    if (!known) {
+        errno = ENOENT;
+        return -1;
+    }
+    
+    fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+        source_track(fd, path);
+    
+    return fd;
+}
+
+gint
+sample_source_open (const gchar *path, gint flags)
+{
+    gchar *rooted = NULL;
+    gint fd;
+    
+    if (source_mode == SOURCE_REPLAY)
+        return source_replay_open(path);
+    
+    if (source_root)
+        rooted = g_build_filename(source_root, path, NULL);
+    fd = open(rooted ? rooted : path, flags);
+    g_free(rooted);
+    
+    if (fd >= 0 && source_mode == SOURCE_RECORD)
+        source_track(fd, path);
+    
+    return fd;
+}
+
+gint
+sample_source_openat (gint dir_fd, const gchar *name, gint flags)
+{
+    SourcePath *dir;
+    gchar *path;
+    gint fd;
+    
+    if (source_mode == SOURCE_LIVE)
+        return openat(dir_fd, name, flags);
+    
+    g_mutex_lock(&source_lock);
+    dir = source_fd_get(dir_fd);
+    path = dir ? g_build_filename(dir->path, name, NULL) : NULL;
+    g_mutex_unlock(&source_lock);
+    
+    if (!path) {
+        errno = EBADF;
+        return -1;
+    }
+    
+    if (source_mode == SOURCE_REPLAY) {
+        fd = source_replay_open(path);
+    } else {
+        fd = openat(dir_fd, name, flags);
+        if (fd >= 0)
+            source_track(fd, path);
+    }
+    g_free(path);
+    
+    return fd;
+}
+
+/* Called with the lock held */
+static void
+source_record_write (SourcePath *source_path, const gchar *buffer, gsize len)
+{
+    guint16 id, path_len;
+    gint64 time;
+    guint32 snapshot_len;
+    
+    if (source_path->trace_id < 0) {
+        if (trace_n_paths >= TRACE_MAX_PATHS)
+            return;
+        source_path->trace_id = trace_n_paths++;
+        id = GUINT16_TO_LE(source_path->trace_id);
+        path_len = GUINT16_TO_LE(strlen(source_path->path));
+        fputc(TRACE_PATH, trace_out);
+        fwrite(&id, sizeof(id), 1, trace_out);
+        fwrite(&path_len, sizeof(path_len), 1, trace_out);
+        fwrite(source_path->path, 1, strlen(source_path->path), trace_out);
+        source_path->last = g_byte_array_new();
+    }
+    
+    id = GUINT16_TO_LE(source_path->trace_id);
+    time = GINT64_TO_LE(sample_clock_get_monotonic() - trace_start);
+    snapshot_len = GUINT32_TO_LE(len);
+    fputc(TRACE_SNAPSHOT, trace_out);
+    fwrite(&id, sizeof(id), 1, trace_out);
+    fwrite(&time, sizeof(time), 1, trace_out);
+    fwrite(&snapshot_len, sizeof(snapshot_len), 1, trace_out);
+    fwrite(buffer, 1, len, trace_out);
+    
+    g_byte_array_set_size(source_path->last, 0);
+    g_byte_array_append(source_path->last, (const guint8 *) buffer, len);
+}
+
+static void
+source_record_read (gint fd, const gchar *buffer, gsize len)
+{
+    SourcePath *source_path;
+    
+    g_mutex_lock(&source_lock);
+    source_path = source_fd_get(fd);
+    if (trace_out && source_path
+        && !(source_path->last && source_path->last->len == len
+             && memcmp(source_path->last->data, buffer, len) == 0))
+        source_record_write(source_path, buffer, len);
+    g_mutex_unlock(&source_lock);
+}
+
+/* The last contents recorded at or before the current trace time, the
+ * first ones before that */
+static gssize
+source_replay_read (gint fd, gchar *buffer, gsize size)
+{
+    gint64 now = sample_clock_get_monotonic() - trace_start;
+    const TraceSnapshot *snapshot;
+    SourcePath *source_path;
+    guint lo = 0, hi;
+    gsize n;
+    
+    g_mutex_lock(&source_lock);
+    source_path = source_fd_get(fd);
+    if (!source_path || !source_path->snapshots || source_path->snapshots->len == 0) {
+        g_mutex_unlock(&source_lock);
+        errno = source_path ? EISDIR : EBADF;
+        return -1;
+    }
+    
+    hi = source_path->snapshots->len;
+    while (hi - lo > 1) {
+        guint mid = lo + (hi - lo) / 2;
+        
+        if (g_array_index(source_path->snapshots, TraceSnapshot, mid).time <= now)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    snapshot = &g_array_index(source_path->snapshots, TraceSnapshot, lo);
+    n = MIN(snapshot->len, size);
+    memcpy(buffer, trace_in + snapshot->offset, n);
+    g_mutex_unlock(&source_lock);
+    
+    return n;
+}
+
+gssize
+sample_source_pread (gint fd, gchar *buffer, gsize size)
+{
+    gssize n;
+    
+    if (source_mode == SOURCE_REPLAY)
+        return source_replay_read(fd, buffer, size);
+    
+    do {
+        n = pread(fd, buffer, size, 0);
+    } while (n < 0 && errno == EINTR);
+    
+    if (n >= 0 && source_mode == SOURCE_RECORD)
+        source_record_read(fd, buffer, n);
+    
+    return n;
+}
+
+void
+sample_source_close (gint fd)
+{
+    if (source_mode != SOURCE_LIVE) {
+        g_mutex_lock(&source_lock);
+        g_hash_table_remove(source_fds, GINT_TO_POINTER(fd));
+        g_mutex_unlock(&source_lock);
+    }
+    close(fd);
+}
@@ -0,0 +1,67 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_SOURCE_H__
+#define __SAMPLE_SOURCE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Where the local providers read /proc and sysfs from. Normally the live
+ * files; they can be taken from a copy under another root, recorded into
+ * a trace as they are read, or replayed from such a trace instead of the
+ * system. Replay follows the sample clock, so a sped up clock replays
+ * faster. Configure once, before any worker runs. */
+void      sample_source_set_root  (const gchar  *root);
+
+gboolean  sample_source_record    (const gchar  *trace,
+                                   GError      **error);
+
+gboolean  sample_source_replay    (const gchar  *trace,
+                                   GError      **error);
+
+/* Whether the reads go to the live system, FALSE under another root or
+ * while replaying */
+gboolean  sample_source_is_live   (void);
+
+/* Whether the reads are recorded into a trace or replayed from one */
+gboolean  sample_source_is_traced (void);
+
+/* Writes out the rest of a recording */
+void      sample_source_finish    (void);
+
+/* Like open(), openat(), pread() at offset 0 and close() for the files
+ * of @path, a path on the live system */
+gint      sample_source_open      (const gchar  *path,
+                                   gint          flags);
+
+gint      sample_source_openat    (gint          dir_fd,
+                                   const gchar  *name,
+                                   gint          flags);
+
+gssize    sample_source_pread     (gint          fd,
+                                   gchar        *buffer,
+                                   gsize         size);
+
+void      sample_source_close     (gint          fd);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_SOURCE_H__ */
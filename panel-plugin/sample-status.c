@@ -0,0 +1,575 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Headless front end: runs the same providers as the panel plugin and
+ * streams the blocks to stdout, for i3bar/swaybar or a dwm status line. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_LIBCURL
+#include <curl/curl.h>
+#endif
+#include <json-glib/json-glib.h>
+#include <glib-unix.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sample-blocks.h"
+#include "sample-bus.h"
+#include "sample-clock.h"
+#include "sample-commands.h"
+#include "sample-config.h"
+#include "sample-export.h"
+#include "sample-history.h"
+#include "sample-icons.h"
+#include "sample-net.h"
+#include "sample-providers.h"
+#include "sample-scheduler.h"
+#include "sample-source.h"
+
+#define DWM_SEPARATOR " | "
+
+/* The built-in blocks, the command blocks, then the custom ones from
+ * the session bus */
+#define SLOT_COMMANDS BLOCK_COUNT
+#define SLOT_BUS      (SLOT_COMMANDS + SAMPLE_COMMANDS_MAX)
+#define SLOT_COUNT    (SLOT_BUS + SAMPLE_BUS_MAX_BLOCKS)
+
+typedef enum {
+    FORMAT_I3BAR,
+    FORMAT_DWM
+} OutputFormat;
+
+typedef struct {
+    BlockStore       store;
+    SampleScheduler *scheduler;
+    GMainLoop       *loop;
+    GSource         *redraw;               /* prints after block changes */
+    SampleBus       *bus;                  /* NULL without --bus */
+    SampleCommands  *commands;             /* NULL without --commands */
+    OutputFormat     format;
+    guint            printed[SLOT_COUNT];  /* serials of the last line, 0 if not shown */
+} StatusBar;
+
+static gchar    *opt_format = NULL;
+static gchar    *opt_weather = NULL;
+static gchar    *opt_weather_url = NULL;
+static gchar    *opt_exchange_key = NULL;
+static gchar    *opt_exchange_sources = NULL;
+static gint      opt_exchange_budget = 1000;
+static gchar    *opt_exclude = NULL;
+static gchar    *opt_commands = NULL;
+static gchar    *opt_blocks = NULL;
+static gboolean  opt_cpu_graph = FALSE;
+static gint      opt_interval = 60;
+static gdouble   opt_time_scale = 1.0;
+static gchar    *opt_root = NULL;
+static gchar    *opt_record = NULL;
+static gchar    *opt_replay = NULL;
+static gchar    *opt_export = NULL;
+static gchar    *opt_history = NULL;
+static gboolean  opt_bus = FALSE;
+
+static GOptionEntry entries[] = {
+    { "format", 'f', 0, G_OPTION_ARG_STRING, &opt_format,
+      "Output format, i3bar (also swaybar) or dwm", "FORMAT" },
+#ifdef ENABLE_WEATHER
+    { "weather", 'w', 0, G_OPTION_ARG_STRING, &opt_weather,
+      "Weather locations, defaults to $MY_LOCATION", "LOCATIONS" },
+    { "weather-url", 0, 0, G_OPTION_ARG_STRING, &opt_weather_url,
+      "Open-Meteo style forecast service to ask instead", "URL" },
+#endif
+#ifdef ENABLE_EXCHANGE
+    { "exchange-key", 'k', 0, G_OPTION_ARG_STRING, &opt_exchange_key,
+      "openexchangerates.org key, defaults to $OPENEXCHANGERATES_API_KEY", "KEY" },
+    { "exchange-sources", 0, 0, G_OPTION_ARG_STRING, &opt_exchange_sources,
+      "Exchange rate sources, ';' separated names or name=URL entries", "SOURCES" },
+    { "exchange-budget", 0, 0, G_OPTION_ARG_INT, &opt_exchange_budget,
+      "Exchange rate requests per month, 0 for no limit", "REQUESTS" },
+#endif
+    { "exclude", 'x', 0, G_OPTION_ARG_STRING, &opt_exclude,
+      "Network interfaces to hide", "PATTERNS" },
+    { "commands", 'c', 0, G_OPTION_ARG_FILENAME, &opt_commands,
+      "Also show the command blocks set up in this file", "FILE" },
+    { "blocks", 'b', 0, G_OPTION_ARG_STRING, &opt_blocks,
+      "Comma separated blocks to show, all by default", "NAMES" },
+    { "cpu-graph", 'g', 0, G_OPTION_ARG_NONE, &opt_cpu_graph,
+      "Show per core bars in the CPU block", NULL },
+    { "interval", 'i', 0, G_OPTION_ARG_INT, &opt_interval,
+      "Update interval of the slower blocks in seconds", "SECONDS" },
+    { "time-scale", 0, 0, G_OPTION_ARG_DOUBLE, &opt_time_scale,
+      "Run the clock this many times faster, for soak runs; remote blocks are off then unless local", "FACTOR" },
+    { "root", 0, 0, G_OPTION_ARG_FILENAME, &opt_root,
+      "Read /proc and /sys below this directory", "DIR" },
+    { "record", 0, 0, G_OPTION_ARG_FILENAME, &opt_record,
+      "Record what the local blocks read into a trace", "FILE" },
+    { "replay", 0, 0, G_OPTION_ARG_FILENAME, &opt_replay,
+      "Read the local blocks from a recorded trace instead of the system", "FILE" },
+    { "export", 0, 0, G_OPTION_ARG_FILENAME, &opt_export,
+      "Also publish the blocks in a shared memory file for xfce4-sample-query", "FILE" },
+    { "history", 0, 0, G_OPTION_ARG_FILENAME, &opt_history,
+      "Record the rates, temperature and memory use in this directory", "DIR" },
+    { "bus", 0, 0, G_OPTION_ARG_NONE, &opt_bus,
+      "Show custom blocks pushed over the session bus as " SAMPLE_BUS_NAME, NULL },
+    { NULL }
+};
+
+static gboolean
+set_blocks (SampleConfig *config, const gchar *list, GError **error)
+{
+    gchar **names = g_strsplit(list, ",", -1);
+    gboolean found = TRUE;
+    
+    config->show_weather = FALSE;
+    config->show_exchange = FALSE;
+    config->show_network = FALSE;
+    config->show_battery = FALSE;
+    config->show_memory = FALSE;
+    config->show_cpu = FALSE;
+    config->show_date = FALSE;
+    
+    for (gint i = 0; names[i] && found; i++) {
+        const gchar *name = g_strstrip(names[i]);
+        BlockId id;
+        
+        if (*name == '\0')
+            continue;
+        
+        for (id = 0; id < BLOCK_COUNT; id++)
+            if (g_strcmp0(name, block_get_name(id)) == 0)
+                break;
+        
+        if (id < BLOCK_COUNT && !sample_provider_available(id)) {
+            g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                        "Block \"%s\" is not built in", name);
+            found = FALSE;
+            break;
+        }
+        
+        switch (id) {
+            case BLOCK_WEATHER:       config->show_weather = TRUE; break;
+            case BLOCK_EXCHANGE_RATE: config->show_exchange = TRUE; break;
+            case BLOCK_NETWORK:       config->show_network = TRUE; break;
+            case BLOCK_BATTERY:       config->show_battery = TRUE; break;
+            case BLOCK_CPU:           config->show_cpu = TRUE; break;
+            case BLOCK_MEMORY:        config->show_memory = TRUE; break;
+            case BLOCK_DATE:          config->show_date = TRUE; break;
+            default:
+                g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                            "Unknown block \"%s\"", name);
+                found = FALSE;
+                break;
+        }
+    }
+    g_strfreev(names);
+    
+    return found;
+}
+
+static SampleConfig *
+status_bar_read_config (GError **error)
+{
+    SampleConfig *config = sample_config_new();
+    
+    config->weather_location = g_strdup(opt_weather ? opt_weather : g_getenv("MY_LOCATION"));
+    config->weather_url = g_strdup(opt_weather_url);
+    config->exchange_api_key = g_strdup(opt_exchange_key ? opt_exchange_key
+                                                         : g_getenv("OPENEXCHANGERATES_API_KEY"));
+    config->exchange_sources = g_strdup(opt_exchange_sources);
+    config->network_exclude = g_strdup(opt_exclude ? opt_exclude : NET_DEFAULT_EXCLUDE);
+    config->commands_file = g_strdup(opt_commands);
+    config->exchange_budget = MAX(opt_exchange_budget, 0);
+    config->update_interval = MAX(opt_interval, 1);
+    config->show_weather = TRUE;
+    config->show_exchange = TRUE;
+    config->show_network = TRUE;
+    config->show_battery = TRUE;
+    config->show_memory = TRUE;
+    config->show_cpu = TRUE;
+    config->show_cpu_graph = opt_cpu_graph;
+    config->show_date = TRUE;
+    
+    if (opt_blocks && !set_blocks(config, opt_blocks, error)) {
+        sample_config_unref(config);
+        return NULL;
+    }
+    
+    return config;
+}
+
+/* Icons become their emoji, no one else knows our placeholders */
+static gchar *
+replace_icons (const gchar *markup)
+{
+    GString *text = g_string_sized_new(strlen(markup));
+    
+    for (const gchar *p = markup; *p; p = g_utf8_next_char(p)) {
+        gunichar c = g_utf8_get_char(p);
+        IconId icon = sample_icon_from_char(c);
+        
+        if (icon != ICON_NONE)
+            g_string_append(text, sample_icon_get_emoji(icon));
+        else
+            g_string_append_unichar(text, c);
+    }
+    
+    return g_string_free(text, FALSE);
+}
+
+static void
+strip_markup_text (GMarkupParseContext *context, const gchar *text, gsize text_len,
+                   gpointer user_data, GError **error)
+{
+    g_string_append_len(user_data, text, text_len);
+}
+
+/* dwm shows the root window name as is */
+static void
+append_plain_text (GString *line, const gchar *markup)
+{
+    static const GMarkupParser parser = { NULL, NULL, strip_markup_text, NULL, NULL };
+    GMarkupParseContext *context = g_markup_parse_context_new(&parser, 0, line, NULL);
+    
+    /* the store only keeps valid markup */
+    g_markup_parse_context_parse(context, "<markup>", -1, NULL);
+    g_markup_parse_context_parse(context, markup, -1, NULL);
+    g_markup_parse_context_parse(context, "</markup>", -1, NULL);
+    g_markup_parse_context_end_parse(context, NULL);
+    g_markup_parse_context_free(context);
+}
+
+static void
+print_i3bar (const gchar **names, gchar **texts)
+{
+    JsonBuilder *builder = json_builder_new();
+    JsonGenerator *generator = json_generator_new();
+    JsonNode *root;
+    gchar *line;
+    
+    json_builder_begin_array(builder);
+    for (gint i = 0; i < SLOT_COUNT; i++) {
+        if (!texts[i])
+            continue;
+        
+        json_builder_begin_object(builder);
+        json_builder_set_member_name(builder, "name");
+        json_builder_add_string_value(builder, names[i]);
+        json_builder_set_member_name(builder, "full_text");
+        json_builder_add_string_value(builder, texts[i]);
+        json_builder_set_member_name(builder, "markup");
+        json_builder_add_string_value(builder, "pango");
+        json_builder_end_object(builder);
+    }
+    json_builder_end_array(builder);
+    
+    root = json_builder_get_root(builder);
+    json_generator_set_root(generator, root);
+    line = json_generator_to_data(generator, NULL);
+    
+    /* the body is an endless array of status lines */
+    printf("%s,\n", line);
+    
+    g_free(line);
+    json_node_unref(root);
+    g_object_unref(generator);
+    g_object_unref(builder);
+}
+
+static void
+print_dwm (gchar **texts)
+{
+    GString *line = g_string_new(NULL);
+    
+    for (gint i = 0; i < SLOT_COUNT; i++) {
+        if (!texts[i])
+            continue;
+        
+        if (line->len > 0)
+            g_string_append(line, DWM_SEPARATOR);
+        append_plain_text(line, texts[i]);
+    }
+    
+    printf("%s\n", line->str);
+    g_string_free(line, TRUE);
+}
+
+static gboolean
+status_bar_print (gpointer data)
+{
+    StatusBar *bar = data;
+    const SampleConfig *config = sample_scheduler_get_config(bar->scheduler);
+    const gchar *names[SLOT_COUNT] = { NULL };
+    gchar *texts[SLOT_COUNT] = { NULL };
+    gboolean changed = FALSE;
+    
+    pthread_mutex_lock(&bar->store.mutex);
+    for (gint i = 0; i < BLOCK_COUNT; i++) {
+        BlockData *block = &bar->store.blocks[i];
+        gboolean shown = block_enabled(config, i) && block->len > 0;
+        guint serial = shown ? block->serial : 0;
+        
+        /* a block that went away is a change too */
+        if (bar->printed[i] != serial) {
+            bar->printed[i] = serial;
+            changed = TRUE;
+        }
+        if (!shown)
+            continue;
+        
+        names[i] = block_get_name(i);
+        texts[i] = replace_icons(block->data);
+    }
+    pthread_mutex_unlock(&bar->store.mutex);
+    
+    for (gint i = SLOT_COMMANDS; i < SLOT_BUS && bar->commands; i++) {
+        gchar text[MAX_BLOCK_SIZE];
+        guint serial = 0;
+        
+        if (!sample_commands_read(bar->commands, i - SLOT_COMMANDS, &serial, text))
+            serial = 0;
+        if (bar->printed[i] != serial) {
+            bar->printed[i] = serial;
+            changed = TRUE;
+        }
+        if (serial != 0) {
+            names[i] = sample_commands_get_name(bar->commands, i - SLOT_COMMANDS);
+            texts[i] = replace_icons(text);
+        }
+    }
+    
+    for (gint i = SLOT_BUS; i < SLOT_COUNT && bar->bus; i++) {
+        const SampleBusBlock *block = sample_bus_get_block(bar->bus, i - SLOT_BUS);
+        guint serial = block ? block->serial : 0;
+        
+        if (bar->printed[i] != serial) {
+            bar->printed[i] = serial;
+            changed = TRUE;
+        }
+        if (block) {
+            names[i] = block->name;
+            texts[i] = replace_icons(block->text);
+        }
+    }
+    
+    if (changed) {
+        if (bar->format == FORMAT_I3BAR)
+            print_i3bar(names, texts);
+        else
+            print_dwm(texts);
+        fflush(stdout);
+    }
+    
+    for (gint i = 0; i < SLOT_COUNT; i++)
+        g_free(texts[i]);
+    
+    return G_SOURCE_CONTINUE;
+}
+
+/* i3bar sends one click object per line of an endless array */
+static void
+status_bar_handle_click (StatusBar *bar, const gchar *line)
+{
+    JsonParser *parser;
+    
+    while (*line == '[' || *line == ',' || g_ascii_isspace(*line))
+        line++;
+    if (*line == '\0')
+        return;
+    
+    parser = json_parser_new();
+    if (json_parser_load_from_data(parser, line, -1, NULL)
+        && JSON_NODE_HOLDS_OBJECT(json_parser_get_root(parser))) {
+        JsonObject *click = json_node_get_object(json_parser_get_root(parser));
+        JsonNode *node = json_object_get_member(click, "name");
+        const gchar *name = node && JSON_NODE_HOLDS_VALUE(node) ? json_node_get_string(node) : NULL;
+        
+        for (gint i = 0; i < BLOCK_COUNT; i++) {
+            if (g_strcmp0(name, block_get_name(i)) == 0)
+                sample_scheduler_refresh(bar->scheduler, i);
+        }
+        for (gint i = 0; i < SAMPLE_COMMANDS_MAX; i++) {
+            if (g_strcmp0(name, sample_commands_get_name(bar->commands, i)) == 0)
+                sample_commands_refresh(bar->commands, i);
+        }
+    }
+    g_object_unref(parser);
+}
+
+static gboolean
+status_bar_read_clicks (GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+    gchar *line = NULL;
+    GIOStatus status = g_io_channel_read_line(channel, &line, NULL, NULL, NULL);
+    
+    if (status == G_IO_STATUS_NORMAL)
+        status_bar_handle_click(data, line);
+    g_free(line);
+    
+    /* the bar closed its end, keep printing */
+    return status != G_IO_STATUS_EOF && status != G_IO_STATUS_ERROR;
+}
+
+static gboolean
+status_bar_quit (gpointer data)
+{
+    StatusBar *bar = data;
+    
+    g_main_loop_quit(bar->loop);
+    
+    return G_SOURCE_REMOVE;
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+    SampleConfig *config;
+    SampleExport *export = NULL;
+    SampleHistory *history = NULL;
+    StatusBar bar = { 0 };
+    
+    context = g_option_context_new("- status blocks for i3bar, swaybar and dwm");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+    
+    if (opt_format == NULL || g_strcmp0(opt_format, "i3bar") == 0
+        || g_strcmp0(opt_format, "swaybar") == 0) {
+        bar.format = FORMAT_I3BAR;
+    } else if (g_strcmp0(opt_format, "dwm") == 0) {
+        bar.format = FORMAT_DWM;
+    } else {
+        g_printerr("Unknown format \"%s\"\n", opt_format);
+        return EXIT_FAILURE;
+    }
+    
+    if (opt_time_scale <= 0.0) {
+        g_printerr("The time scale must be positive\n");
+        return EXIT_FAILURE;
+    }
+    /* before any worker reads the clock */
+    if (opt_time_scale != 1.0)
+        sample_clock_set_scale(opt_time_scale);
+    
+    if (opt_record && opt_replay) {
+        g_printerr("--record and --replay cannot be combined\n");
+        return EXIT_FAILURE;
+    }
+    if (opt_root)
+        sample_source_set_root(opt_root);
+    if ((opt_record && !sample_source_record(opt_record, &error))
+        || (opt_replay && !sample_source_replay(opt_replay, &error))) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    
+    config = status_bar_read_config(&error);
+    if (!config) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    
+    if (opt_export && !(export = sample_export_new(opt_export, &error))) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        sample_config_unref(config);
+        return EXIT_FAILURE;
+    }
+    if (opt_history && !(history = sample_history_new(opt_history, &error))) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        sample_export_free(export);
+        sample_config_unref(config);
+        return EXIT_FAILURE;
+    }
+    
+#ifdef HAVE_LIBCURL
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+#endif
+    
+    if (bar.format == FORMAT_I3BAR) {
+        printf("{\"version\":1,\"click_events\":true}\n[\n");
+        fflush(stdout);
+    }
+    
+    bar.loop = g_main_loop_new(NULL, FALSE);
+    g_unix_signal_add(SIGINT, status_bar_quit, &bar);
+    g_unix_signal_add(SIGTERM, status_bar_quit, &bar);
+    
+    /* updates that come together print once */
+    bar.redraw = block_notify_source_new();
+    g_source_set_callback(bar.redraw, status_bar_print, &bar, NULL);
+    g_source_attach(bar.redraw, NULL);
+    block_store_init(&bar.store, block_notify_source_wake, bar.redraw);
+    block_store_set_export(&bar.store, export);
+    block_store_set_history(&bar.store, history);
+    bar.scheduler = sample_scheduler_new(&bar.store, config);
+    if (opt_commands
+        && !(bar.commands = sample_commands_new(opt_commands, block_notify_source_wake, bar.redraw, &error))) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        sample_scheduler_free(bar.scheduler);
+        sample_export_free(export);
+        sample_history_free(history);
+        return EXIT_FAILURE;
+    }
+    if (opt_bus)
+        bar.bus = sample_bus_new(SAMPLE_BUS_NAME, NULL, block_notify_source_wake, bar.redraw);
+    
+    /* clicking a block refreshes it */
+    if (bar.format == FORMAT_I3BAR) {
+        GIOChannel *input = g_io_channel_unix_new(STDIN_FILENO);
+        
+        g_io_add_watch(input, G_IO_IN | G_IO_HUP | G_IO_ERR, status_bar_read_clicks, &bar);
+        g_io_channel_unref(input);
+    }
+    
+    g_main_loop_run(bar.loop);
+    
+    sample_bus_free(bar.bus);
+    sample_commands_free(bar.commands);
+    sample_scheduler_free(bar.scheduler);
+    sample_export_free(export);
+    sample_history_free(history);
+    sample_source_finish();
+    block_store_clear(&bar.store);
+    g_source_destroy(bar.redraw);
+    g_source_unref(bar.redraw);
+    g_main_loop_unref(bar.loop);
+#ifdef HAVE_LIBCURL
+    curl_global_cleanup();
+#endif
+    
+    return EXIT_SUCCESS;
+}
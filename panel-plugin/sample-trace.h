@@ -0,0 +1,57 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_TRACE_H__
+#define __SAMPLE_TRACE_H__
+
+#include <glib.h>
+
+/* Static probes for lining the plugin up against the rest of the desktop
+ * in a profiler, e.g. "bpftrace -l 'usdt:*:xfce4_sample:*'". Built with
+ * -Dtracing=enabled; otherwise they expand to nothing, arguments
+ * included. Block arguments are a BlockId, or -1 for all blocks.
+ *
+ *   fetch-start (block)             fetch-done (block, bytes, curl code)
+ *   parse-start (block, bytes)      parse-done (block, ok)
+ *   block-update (block, bytes)
+ *   store-lock (block)              store-unlock (block)
+ *   display-start ()                display-done (blocks changed)
+ *   markup-start (block, bytes)     markup-done (block)
+ *   procs-scan-start ()             procs-scan-done (processes, listed)
+ */
+
+#ifdef ENABLE_TRACING
+
+#include <sys/sdt.h>
+
+#define SAMPLE_TRACE(probe)                   DTRACE_PROBE (xfce4_sample, probe)
+#define SAMPLE_TRACE1(probe, a)               DTRACE_PROBE1 (xfce4_sample, probe, a)
+#define SAMPLE_TRACE2(probe, a, b)            DTRACE_PROBE2 (xfce4_sample, probe, a, b)
+#define SAMPLE_TRACE3(probe, a, b, c)         DTRACE_PROBE3 (xfce4_sample, probe, a, b, c)
+
+#else
+
+#define SAMPLE_TRACE(probe)                   G_STMT_START { } G_STMT_END
+#define SAMPLE_TRACE1(probe, a)               G_STMT_START { } G_STMT_END
+#define SAMPLE_TRACE2(probe, a, b)            G_STMT_START { } G_STMT_END
+#define SAMPLE_TRACE3(probe, a, b, c)         G_STMT_START { } G_STMT_END
+
+#endif /* !ENABLE_TRACING */
+
+#endif /* !__SAMPLE_TRACE_H__ */
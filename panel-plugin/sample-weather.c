@@ -0,0 +1,291 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <curl/curl.h>
+#include <json-glib/json-glib.h>
+
+#include "sample-trace.h"
+#include "sample-weather.h"
+
+#define WEATHER_TIMEOUT 10L
+
+static gboolean
+is_coordinate (const gchar *text)
+{
+    gchar *end;
+    
+    if (*text == '\0')
+        return FALSE;
+    g_ascii_strtod(text, &end);
+    return *end == '\0';
+}
+
+gint
+weather_locations_parse (const gchar *spec, WeatherLocation *locations, gint max_locations)
+{
+    gchar **entries;
+    gint n_locations = 0;
+    
+    if (!spec) return 0;
+    
+    entries = g_strsplit(spec, ";", -1);
+    for (gchar **entry = entries; *entry && n_locations < max_locations; entry++) {
+        WeatherLocation *location = &locations[n_locations];
+        gchar *coordinates = strchr(*entry, '=');
+        gchar **parts;
+        
+        if (coordinates) {
+            *coordinates++ = '\0';
+            g_strlcpy(location->name, g_strstrip(*entry), sizeof(location->name));
+        } else {
+            coordinates = *entry;
+            location->name[0] = '\0';
+        }
+        
+        parts = g_strsplit(coordinates, ",", 2);
+        if (parts[0] && parts[1] && is_coordinate(g_strstrip(parts[0])) && is_coordinate(g_strstrip(parts[1]))) {
+            g_strlcpy(location->latitude, parts[0], sizeof(location->latitude));
+            g_strlcpy(location->longitude, parts[1], sizeof(location->longitude));
+            n_locations++;
+        } else if (g_strstrip(*entry)[0] != '\0') {
+            g_warning("Ignoring invalid weather location: %s", *entry);
+        }
+        g_strfreev(parts);
+    }
+    g_strfreev(entries);
+    
+    return n_locations;
+}
+
+/* curl hands the body over in pieces of at most CURL_MAX_WRITE_SIZE */
+static size_t
+weather_request_write (void *contents, size_t size, size_t nmemb, void *data)
+{
+    g_string_append_len(data, contents, size * nmemb);
+    
+    return size * nmemb;
+}
+
+/* libcurl calls this about once a second while it waits, non-zero
+ * aborts the transfer */
+static int
+weather_request_progress (void *data, curl_off_t dltotal, curl_off_t dlnow,
+                          curl_off_t ultotal, curl_off_t ulnow)
+{
+    return g_cancellable_is_cancelled(data);
+}
+
+/* Get weather data from the service, all locations in one request */
+static GString *
+weather_request (const gchar *url, const WeatherLocation *locations, gint n_locations,
+                 GCancellable *cancellable)
+{
+    CURL *curl;
+    CURLcode res = CURLE_FAILED_INIT;
+    GString *body = g_string_new(NULL);
+    GString *request = g_string_new(url ? url : WEATHER_DEFAULT_URL);
+    
+    /* Open-Meteo takes comma separated coordinate lists */
+    g_string_append_c(request, strchr(request->str, '?') ? '&' : '?');
+    g_string_append(request, "latitude=");
+    for (gint i = 0; i < n_locations; i++)
+        g_string_append_printf(request, "%s%s", i > 0 ? "," : "", locations[i].latitude);
+    g_string_append(request, "&longitude=");
+    for (gint i = 0; i < n_locations; i++)
+        g_string_append_printf(request, "%s%s", i > 0 ? "," : "", locations[i].longitude);
+    g_string_append_printf(request, "&hourly=temperature_2m,weather_code,wind_speed_10m,wind_direction_10m,is_day"
+                           "&past_hours=1&forecast_hours=%d&timeformat=unixtime", WEATHER_FORECAST_HOURS);
+    
+    curl = curl_easy_init();
+    if (curl) {
+        curl_easy_setopt(curl, CURLOPT_URL, request->str);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, weather_request_write);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, WEATHER_TIMEOUT);
+        if (cancellable) {
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, weather_request_progress);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancellable);
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        }
+        
+        SAMPLE_TRACE1(fetch__start, BLOCK_WEATHER);
+        res = curl_easy_perform(curl);
+        SAMPLE_TRACE3(fetch__done, BLOCK_WEATHER, body->len, res);
+        curl_easy_cleanup(curl);
+    }
+    g_string_free(request, TRUE);
+    
+    if (res != CURLE_OK) {
+        if (res != CURLE_ABORTED_BY_CALLBACK)
+            g_debug("Weather request failed: %s", curl_easy_strerror(res));
+        g_string_free(body, TRUE);
+        return NULL;
+    }
+    
+    return body;
+}
+
+static JsonArray *
+json_get_array (JsonObject *object, const gchar *member)
+{
+    if (!json_object_has_member(object, member))
+        return NULL;
+    return json_object_get_array_member(object, member);
+}
+
+/* Copy the hourly arrays of one location into a compact forecast */
+static gboolean
+parse_hourly_forecast (JsonObject *object, WeatherForecast *forecast)
+{
+    JsonObject *hourly;
+    JsonArray *time, *temperature, *weathercode, *windspeed, *winddirection, *is_day;
+    guint n;
+    
+    if (!json_object_has_member(object, "hourly"))
+        return FALSE;
+    hourly = json_object_get_object_member(object, "hourly");
+    
+    time = json_get_array(hourly, "time");
+    temperature = json_get_array(hourly, "temperature_2m");
+    weathercode = json_get_array(hourly, "weather_code");
+    windspeed = json_get_array(hourly, "wind_speed_10m");
+    winddirection = json_get_array(hourly, "wind_direction_10m");
+    is_day = json_get_array(hourly, "is_day");
+    if (!time || !temperature || !weathercode || !windspeed || !winddirection || !is_day)
+        return FALSE;
+    
+    n = MIN(json_array_get_length(time), WEATHER_FORECAST_HOURS);
+    n = MIN(n, json_array_get_length(temperature));
+    n = MIN(n, json_array_get_length(weathercode));
+    n = MIN(n, json_array_get_length(windspeed));
+    n = MIN(n, json_array_get_length(winddirection));
+    n = MIN(n, json_array_get_length(is_day));
+    if (n < 2)
+        return FALSE;
+    
+    forecast->start = json_array_get_int_element(time, 0);
+    forecast->n_hours = 0;
+    for (guint i = 0; i < n; i++) {
+        /* the arrays are expected on a strict hourly grid */
+        if (json_array_get_int_element(time, i) != forecast->start + (gint64)i * 3600)
+            break;
+        forecast->temperature[i] = json_array_get_double_element(temperature, i);
+        forecast->windspeed[i] = json_array_get_double_element(windspeed, i);
+        forecast->winddirection[i] = (guint16)json_array_get_int_element(winddirection, i);
+        forecast->weathercode[i] = (guint8)json_array_get_int_element(weathercode, i);
+        forecast->is_day[i] = json_array_get_int_element(is_day, i) != 0;
+        forecast->n_hours++;
+    }
+    
+    return forecast->n_hours >= 2;
+}
+
+/* Parse a response, an object for one location and an array in request
+ * order for several */
+static gint
+parse_weather_forecasts (JsonNode *root, const WeatherLocation *locations, gint n_locations,
+                         WeatherForecast *forecasts)
+{
+    JsonArray *array = JSON_NODE_HOLDS_ARRAY(root) ? json_node_get_array(root) : NULL;
+    gint n = array ? (gint)json_array_get_length(array) : 1;
+    gint n_forecasts = 0;
+    
+    for (gint i = 0; i < MIN(n, n_locations); i++) {
+        JsonNode *node = array ? json_array_get_element(array, i) : root;
+        WeatherForecast *forecast = &forecasts[n_forecasts];
+        
+        if (!JSON_NODE_HOLDS_OBJECT(node) || !parse_hourly_forecast(json_node_get_object(node), forecast))
+            return 0;
+        g_strlcpy(forecast->name, locations[i].name, sizeof(forecast->name));
+        n_forecasts++;
+    }
+    
+    return n_forecasts;
+}
+
+gint
+weather_forecasts_fetch (const gchar *url, const WeatherLocation *locations, gint n_locations,
+                         WeatherForecast *forecasts, GCancellable *cancellable)
+{
+    WeatherForecast parsed[WEATHER_MAX_LOCATIONS];
+    JsonParser *parser;
+    GError *error = NULL;
+    GString *body;
+    gint n_forecasts = 0;
+    
+    n_locations = MIN(n_locations, WEATHER_MAX_LOCATIONS);
+    if (n_locations <= 0)
+        return 0;
+    
+    body = weather_request(url, locations, n_locations, cancellable);
+    if (!body)
+        return 0;
+    
+    parser = json_parser_new();
+    SAMPLE_TRACE2(parse__start, BLOCK_WEATHER, body->len);
+    if (json_parser_load_from_data(parser, body->str, body->len, &error))
+        n_forecasts = parse_weather_forecasts(json_parser_get_root(parser), locations, n_locations, parsed);
+    SAMPLE_TRACE2(parse__done, BLOCK_WEATHER, n_forecasts > 0);
+    if (n_forecasts > 0)
+        memcpy(forecasts, parsed, n_forecasts * sizeof(WeatherForecast));
+    
+    if (error) {
+        g_debug("Could not parse the weather response: %s", error->message);
+        g_error_free(error);
+    }
+    g_object_unref(parser);
+    g_string_free(body, TRUE);
+    
+    return n_forecasts;
+}
+
+/* Linear interpolation between the surrounding hours, the discrete
+ * values are taken from the nearest hour */
+gboolean
+weather_forecast_interpolate (const WeatherForecast *forecast, gint64 now, WeatherReading *reading)
+{
+    gdouble position = (now - forecast->start) / 3600.0;
+    gint hour = (gint)position;
+    gdouble fraction = position - hour;
+    gint nearest;
+    
+    if (position < 0.0 || hour + 1 >= forecast->n_hours)
+        return FALSE;
+    nearest = fraction < 0.5 ? hour : hour + 1;
+    
+    g_strlcpy(reading->name, forecast->name, sizeof(reading->name));
+    reading->temperature = forecast->temperature[hour]
+                           + fraction * (forecast->temperature[hour + 1] - forecast->temperature[hour]);
+    reading->windspeed = forecast->windspeed[hour]
+                         + fraction * (forecast->windspeed[hour + 1] - forecast->windspeed[hour]);
+    reading->winddirection = forecast->winddirection[nearest];
+    reading->weathercode = forecast->weathercode[nearest];
+    reading->is_day = forecast->is_day[nearest];
+    
+    return TRUE;
+}
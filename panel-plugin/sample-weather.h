@@ -0,0 +1,77 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SAMPLE_WEATHER_H__
+#define __SAMPLE_WEATHER_H__
+
+#include <gio/gio.h>
+
+#include "sample-blocks.h"
+
+G_BEGIN_DECLS
+
+/* Used when the settings name no forecast service */
+#define WEATHER_DEFAULT_URL     "https://api.open-meteo.com/v1/forecast"
+
+#define WEATHER_FORECAST_HOURS  48
+
+/* A weather location parsed from the settings, coordinates kept as given */
+typedef struct {
+    gchar name[32];
+    gchar latitude[16];
+    gchar longitude[16];
+} WeatherLocation;
+
+/* Hourly forecast of one location, starting at a full hour */
+typedef struct {
+    gchar   name[32];
+    gint64  start;
+    gint    n_hours;
+    gfloat  temperature[WEATHER_FORECAST_HOURS];
+    gfloat  windspeed[WEATHER_FORECAST_HOURS];
+    guint16 winddirection[WEATHER_FORECAST_HOURS];
+    guint8  weathercode[WEATHER_FORECAST_HOURS];
+    guint8  is_day[WEATHER_FORECAST_HOURS];
+} WeatherForecast;
+
+/* Parse "[name=]latitude,longitude" entries separated by ';', returns
+ * how many were valid */
+gint     weather_locations_parse      (const gchar           *spec,
+                                       WeatherLocation       *locations,
+                                       gint                   max_locations);
+
+/* Fetch the hourly forecasts of all locations in one request to @url, an
+ * Open-Meteo style forecast endpoint or NULL for WEATHER_DEFAULT_URL.
+ * Returns how many forecasts were filled; @forecasts is only written
+ * when the whole response parsed. Cancelling @cancellable, which may be
+ * NULL, from another thread aborts the request within about a second. */
+gint     weather_forecasts_fetch      (const gchar           *url,
+                                       const WeatherLocation *locations,
+                                       gint                   n_locations,
+                                       WeatherForecast       *forecasts,
+                                       GCancellable          *cancellable);
+
+/* The reading at @now, FALSE once @now is outside the forecast */
+gboolean weather_forecast_interpolate (const WeatherForecast *forecast,
+                                       gint64                 now,
+                                       WeatherReading        *reading);
+
+G_END_DECLS
+
+#endif /* !__SAMPLE_WEATHER_H__ */
@@ -28,149 +28,644 @@
 #include <libxfce4util/libxfce4util.h>
 #include <libxfce4panel/libxfce4panel.h>
 #include <pango/pango.h>
+#ifdef HAVE_LIBCURL
 #include <curl/curl.h>
-#include <libudev.h>
-#include <json-glib/json-glib.h>
-#include <poll.h>
-#include <sys/eventfd.h>
-#include <unistd.h>
-#include <stdio.h>
+#endif
 #include <stdlib.h>
 #include <time.h>
-#include <errno.h>
 
 #include "sample.h"
+#include "sample-atlas.h"
+#include "sample-clock.h"
+#include "sample-history.h"
+#include "sample-icons.h"
 #include "sample-dialogs.h"
+#include "sample-trace.h"
 
 /* default settings */
 #define DEFAULT_WEATHER_LOCATION NULL
+#define DEFAULT_WEATHER_URL NULL
 #define DEFAULT_EXCHANGE_API_KEY NULL
+#define DEFAULT_EXCHANGE_SOURCES NULL
+#define DEFAULT_EXCHANGE_BUDGET 1000
 #define DEFAULT_UPDATE_INTERVAL 60
 #define DEFAULT_SHOW_WEATHER TRUE
 #define DEFAULT_SHOW_EXCHANGE TRUE
+#define DEFAULT_SHOW_NETWORK TRUE
+#define DEFAULT_NETWORK_EXCLUDE NET_DEFAULT_EXCLUDE
+#define DEFAULT_COMMANDS_FILE NULL
 #define DEFAULT_SHOW_BATTERY TRUE
 #define DEFAULT_SHOW_MEMORY TRUE
+#define DEFAULT_SHOW_CPU TRUE
+#define DEFAULT_SHOW_CPU_GRAPH FALSE
 #define DEFAULT_SHOW_DATE TRUE
 
+/* separator between the blocks in the label */
+#define BLOCK_SEPARATOR " | "
+
+/* opacity of blocks showing data their provider could not refresh */
+#define OUTDATED_ALPHA 0.5
+
+/* Widest content a block usually has; digits are tabular, so any digit
+ * will do. Slots start out this wide. */
+static const gchar *slot_templates[BLOCK_COUNT] = {
+    [BLOCK_WEATHER]       = ICON_TEMP_MILD_STR " -88.8°C",
+    [BLOCK_EXCHANGE_RATE] = "TRY 88.88 RUB 888.88",
+    [BLOCK_NETWORK]       = ICON_NETWORK_STR " eth0 ↓888K ↑888K",
+    [BLOCK_BATTERY]       = ICON_BATTERY_FULL_STR " 100% " ICON_CHARGING_STR,
+    [BLOCK_CPU]           = ICON_CPU_STR " 100%",
+    [BLOCK_MEMORY]        = ICON_MEMORY_STR " 88.8GB",
+    [BLOCK_DATE]          = ICON_CALENDAR_STR " Wed May 28 " ICON_DAY_STR " 88:88",
+};
+
 /* prototypes */
 static void sample_construct (XfcePanelPlugin *plugin);
 static gboolean update_display (SamplePlugin *sample);
-static void update_block (SamplePlugin *sample, BlockId block_id, const char *text);
-
-/* Thread functions */
-static gpointer date_thread_func (gpointer data);
-static gpointer memory_thread_func (gpointer data);
-static gpointer weather_thread_func (gpointer data);
-static gpointer exchange_thread_func (gpointer data);
-static gpointer battery_thread_func (gpointer data);
-
-/* Utility functions */
-static size_t write_response_callback (void *contents, size_t size, size_t nmemb, void *userp);
-static gchar* get_weather_data (const gchar *location);
-static gchar* get_exchange_data (const gchar *api_key);
-static void get_battery_info (gchar **capacity, gchar **status);
-static void get_memory_info (gchar **memory_text);
+static gboolean sample_query_tooltip (GtkWidget *widget, gint x, gint y, gboolean keyboard_mode,
+                                      GtkTooltip *tooltip, SamplePlugin *sample);
 
 /* register the plugin */
 XFCE_PANEL_PLUGIN_REGISTER (sample_construct);
 
-/* Update a specific block with new data */
+/* Relayouts of the panel caused by the slots, logged once an hour next to
+ * the count without the slot hysteresis, one for every change of size */
 static void
-update_block (SamplePlugin *sample, BlockId block_id, const char *text)
+count_resize (SamplePlugin *sample, gboolean resized, gboolean size_changed)
 {
-    if (!sample || block_id >= BLOCK_COUNT || !text)
-        return;
-    
-    pthread_mutex_lock(&sample->mutex);
+    gint64 now = g_get_monotonic_time();
     
-    /* Validate markup before storing it */
-    gchar *validated_text = NULL;
-    if (pango_parse_markup(text, -1, 0, NULL, NULL, NULL, NULL)) {
-        validated_text = g_strdup(text);
-    } else {
-        /* If markup is invalid, escape the text */
-        validated_text = g_markup_escape_text(text, -1);
-        g_warning("Invalid markup in block %d: %s", block_id, text);
+    sample->n_resizes += resized;
+    sample->n_size_changes += size_changed;
+    if (now - sample->resizes_since >= G_GINT64_CONSTANT(3600) * G_USEC_PER_SEC) {
+        g_debug("%u panel relayouts in the last hour, %u without the slot hysteresis",
+                sample->n_resizes, sample->n_size_changes);
+        sample->n_resizes = 0;
+        sample->n_size_changes = 0;
+        sample->resizes_since = now;
     }
+}
+
+/* A content size change is a local redraw unless the reserved size moves */
+static void
+update_slot_size (SamplePlugin *sample, BlockSlot *slot)
+{
+    gint width, height;
+    gboolean resized, size_changed;
     
-    int len = strlen(validated_text);
-    if (len >= MAX_BLOCK_SIZE) {
-        len = MAX_BLOCK_SIZE - 1;
-    }
-    
-    sample->blocks[block_id].len = len;
-    memcpy(sample->blocks[block_id].data, validated_text, len);
-    sample->blocks[block_id].data[len] = '\0';
-    
-    g_free(validated_text);
-    pthread_mutex_unlock(&sample->mutex);
+    pango_layout_get_pixel_size(slot->layout, &width, &height);
+    size_changed = width != slot->width || height != slot->height;
+    resized = sample_slot_size_update(&slot->size, width, height, g_get_monotonic_time());
+    if (resized)
+        gtk_widget_set_size_request(slot->area, slot->size.width, slot->size.height);
+    else
+        gtk_widget_queue_draw(slot->area);
     
-    /* Schedule GUI update */
-    g_idle_add((GSourceFunc)update_display, sample);
+    if (resized || size_changed)
+        count_resize(sample, resized, size_changed);
+    slot->width = width;
+    slot->height = height;
+}
+
+/* Template widths depend on the font and icon size only; custom blocks
+ * have none and start out as wide as their first text */
+static void
+measure_slot_templates (SamplePlugin *sample)
+{
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        BlockSlot *slot = &sample->slots[i];
+        PangoLayout *layout = pango_layout_new(pango_layout_get_context(slot->layout));
+        gint width, height;
+        
+        sample_atlas_set_markup(sample->atlas, layout, i < BLOCK_COUNT ? slot_templates[i] : "");
+        pango_layout_get_pixel_size(layout, &width, &height);
+        sample_slot_size_reset(&slot->size, width, height);
+        g_object_unref(layout);
+    }
 }
 
 /* Update the display with current block data */
 static gboolean
 update_display (SamplePlugin *sample)
 {
-    if (!sample || !sample->label)
-        return FALSE;
+    gchar    markup[SLOT_COUNT][MAX_BLOCK_SIZE];
+    gboolean visible[SLOT_COUNT];
+    gboolean changed[SLOT_COUNT];
+    gboolean outdated[SLOT_COUNT];
+    gboolean any_shown = FALSE;
+    gint     n_changed = 0;
+    const SampleConfig *config;
     
-    pthread_mutex_lock(&sample->mutex);
+    if (!sample || !sample->label || !sample->scheduler)
+        return FALSE;
     
-    GString *display_text = g_string_new("");
+    config = sample_scheduler_get_config(sample->scheduler);
+    SAMPLE_TRACE(display__start);
     
-    /* Combine all enabled blocks */
+    /* copy out only what changed, the layouts are built outside the lock */
+    pthread_mutex_lock(&sample->store.mutex);
+    SAMPLE_TRACE1(store__lock, -1);
     for (int i = 0; i < BLOCK_COUNT; i++) {
-        gboolean show_block = FALSE;
+        BlockData *block = &sample->store.blocks[i];
         
-        switch (i) {
-            case BLOCK_WEATHER:
-                show_block = sample->show_weather;
-                break;
-            case BLOCK_EXCHANGE_RATE:
-                show_block = sample->show_exchange;
-                break;
-            case BLOCK_BATTERY:
-                show_block = sample->show_battery;
-                break;
-            case BLOCK_MEMORY:
-                show_block = sample->show_memory;
-                break;
-            case BLOCK_DATE:
-                show_block = sample->show_date;
-                break;
+        visible[i] = block_enabled(config, i) && block->len > 0;
+        changed[i] = visible[i] && sample->slots[i].serial != block->serial;
+        if (changed[i]) {
+            memcpy(markup[i], block->data, block->len + 1);
+            outdated[i] = block->outdated;
+            sample->slots[i].serial = block->serial;
         }
+    }
+    SAMPLE_TRACE1(store__unlock, -1);
+    pthread_mutex_unlock(&sample->store.mutex);
+    
+    for (int i = SLOT_COMMANDS; i < SLOT_BUS; i++) {
+        guint serial = sample->slots[i].serial;
         
-        if (show_block && sample->blocks[i].len > 0) {
-            if (display_text->len > 0) {
-                g_string_append(display_text, " | ");
-            }
-            g_string_append(display_text, sample->blocks[i].data);
-        }
+        visible[i] = sample_commands_read(sample->commands, i - SLOT_COMMANDS, &serial, markup[i]);
+        changed[i] = visible[i] && sample->slots[i].serial != serial;
+        outdated[i] = FALSE;
+        sample->slots[i].serial = serial;
     }
     
-    pthread_mutex_unlock(&sample->mutex);
+    /* custom blocks only change on this thread */
+    for (int i = SLOT_BUS; i < SLOT_COUNT; i++) {
+        const SampleBusBlock *block = sample_bus_get_block(sample->bus, i - SLOT_BUS);
+        
+        visible[i] = block != NULL;
+        changed[i] = visible[i] && sample->slots[i].serial != block->serial;
+        if (changed[i]) {
+            g_strlcpy(markup[i], block->text, sizeof(markup[i]));
+            outdated[i] = FALSE;
+            sample->slots[i].serial = block->serial;
+        }
+    }
     
-    /* Validate the complete markup before setting it */
-    if (display_text->len > 0) {
-        if (pango_parse_markup(display_text->str, -1, 0, NULL, NULL, NULL, NULL)) {
-            /* Update label with markup support for colors */
-            gtk_label_set_markup(GTK_LABEL(sample->label), display_text->str);
-        } else {
-            /* If markup is invalid, show as plain text */
-            g_warning("Invalid final markup: %s", display_text->str);
-            gtk_label_set_text(GTK_LABEL(sample->label), "Status Error");
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        BlockSlot *slot = &sample->slots[i];
+        
+        /* many updates only change the raw sample behind the tooltip */
+        if (changed[i] && strcmp(slot->markup, markup[i]) != 0) {
+            SAMPLE_TRACE2(markup__start, i, strlen(markup[i]));
+            if (sample_atlas_set_markup(sample->atlas, slot->layout, markup[i]))
+                update_slot_size(sample, slot);
+            else
+                g_warning("Invalid markup in block %d: %s", i, markup[i]);
+            SAMPLE_TRACE1(markup__done, i);
+            g_strlcpy(slot->markup, markup[i], sizeof(slot->markup));
+            n_changed++;
+        }
+        
+        if (changed[i] && slot->outdated != outdated[i]) {
+            slot->outdated = outdated[i];
+            gtk_widget_queue_draw(slot->area);
         }
-    } else {
-        gtk_label_set_text(GTK_LABEL(sample->label), "Loading...");
+        
+        /* an open tooltip only follows new details when asked again */
+        if (changed[i] && i == BLOCK_MEMORY
+            && sample_scheduler_showing_details(sample->scheduler, i))
+            gtk_widget_trigger_tooltip_query(slot->area);
+        
+        if (gtk_widget_get_visible(slot->area) != visible[i])
+            count_resize(sample, TRUE, TRUE);
+        gtk_widget_set_visible(slot->separator, visible[i] && any_shown);
+        gtk_widget_set_visible(slot->area, visible[i]);
+        any_shown |= visible[i];
+    }
+    
+    gtk_widget_set_visible(sample->label, !any_shown);
+    SAMPLE_TRACE1(display__done, n_changed);
+    
+    return FALSE; /* the redraw source stays armed regardless */
+}
+
+static gboolean
+slot_draw (GtkWidget    *widget,
+           cairo_t      *cr,
+           SamplePlugin *sample)
+{
+    BlockId      block_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(widget), "block-id"));
+    PangoLayout *layout = sample->slots[block_id].layout;
+    gint         width, height;
+    
+    pango_layout_get_pixel_size(layout, &width, &height);
+    
+    /* data a remote provider could not refresh in time is dimmed */
+    if (sample->slots[block_id].outdated)
+        cairo_push_group(cr);
+    gtk_render_layout(gtk_widget_get_style_context(widget), cr,
+                      0, (gtk_widget_get_allocated_height(widget) - height) / 2, layout);
+    if (sample->slots[block_id].outdated) {
+        cairo_pop_group_to_source(cr);
+        cairo_paint_with_alpha(cr, OUTDATED_ALPHA);
     }
     
-    g_string_free(display_text, TRUE);
+    return FALSE;
+}
+
+/* Rebuild the icon atlas if the icon size, scale, font or theme changed,
+ * and with it every layout that holds icon shapes of the old size */
+static void
+sample_refresh_icons (SamplePlugin *sample)
+{
+    if (!sample_atlas_update(sample->atlas, sample->slots[0].area))
+        return;
     
-    return FALSE; /* Don't repeat this idle callback */
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        pango_layout_context_changed(sample->slots[i].layout);
+        sample->slots[i].serial = G_MAXUINT;
+        sample->slots[i].markup[0] = '\0';
+    }
+    measure_slot_templates(sample);
+    
+    update_display(sample);
+}
+
+static void
+sample_icon_theme_changed (GtkIconTheme *theme,
+                           SamplePlugin *sample)
+{
+    sample_atlas_invalidate(sample->atlas);
+    sample_refresh_icons(sample);
+}
+
+
+
+/* Tooltips */
+
+static const gchar *
+weather_code_description (gint code)
+{
+    /* WMO weather interpretation codes as used by Open-Meteo */
+    switch (code) {
+        case 0:  return _("Clear sky");
+        case 1:  return _("Mainly clear");
+        case 2:  return _("Partly cloudy");
+        case 3:  return _("Overcast");
+        case 45: return _("Fog");
+        case 48: return _("Depositing rime fog");
+        case 51: return _("Light drizzle");
+        case 53: return _("Drizzle");
+        case 55: return _("Dense drizzle");
+        case 56:
+        case 57: return _("Freezing drizzle");
+        case 61: return _("Slight rain");
+        case 63: return _("Rain");
+        case 65: return _("Heavy rain");
+        case 66:
+        case 67: return _("Freezing rain");
+        case 71: return _("Slight snow");
+        case 73: return _("Snow");
+        case 75: return _("Heavy snow");
+        case 77: return _("Snow grains");
+        case 80: return _("Slight rain showers");
+        case 81: return _("Rain showers");
+        case 82: return _("Violent rain showers");
+        case 85: return _("Slight snow showers");
+        case 86: return _("Heavy snow showers");
+        case 95: return _("Thunderstorm");
+        case 96:
+        case 99: return _("Thunderstorm with hail");
+        default: return _("Unknown conditions");
+    }
+}
+
+static const gchar *
+wind_direction_name (gdouble degrees)
+{
+    static const gchar *names[] = { "N", "NE", "E", "SE", "S", "SW", "W", "NW" };
+
+    return names[((gint)((degrees + 22.5) / 45.0) % 8 + 8) % 8];
 }
 
+static void
+append_tooltip_size (GString *text, const gchar *name, gulong kb)
+{
+    gchar *size = g_format_size_full((guint64)kb * 1024, G_FORMAT_SIZE_IEC_UNITS);
+
+    g_string_append_printf(text, "%s%s: %s", text->len > 0 ? "\n" : "", name, size);
+    g_free(size);
+}
+
+/* Lowest and highest value of a series over the last @days, if recorded */
+static void
+append_tooltip_range (GString *text, SampleHistory *history, const gchar *series,
+                      const gchar *name, gint days, const gchar *format)
+{
+    gint64 now = sample_clock_get_real() / G_USEC_PER_SEC;
+    SampleHistoryPoint summary;
+    gchar *range;
+
+    if (!sample_history_summary(history, series, now - days * 86400, now + 1, &summary))
+        return;
+
+    range = g_strdup_printf(format, summary.min, summary.max);
+    g_string_append_printf(text, "\n<small>%s%s</small>", name, range);
+    g_free(range);
+}
+
+/* Build the detailed text for a block from its raw values */
+static gchar *
+build_block_tooltip (BlockId block_id, const BlockSample *raw, SampleHistory *history)
+{
+    GString   *text = g_string_new(NULL);
+    GDateTime *dt;
+    gchar     *formatted;
+
+    switch (block_id) {
+        case BLOCK_DATE:
+            dt = g_date_time_new_from_unix_local(raw->date.time);
+            if (dt) {
+                formatted = g_date_time_format(dt, _("<b>%A, %-d %B %Y</b>\nWeek %V, day %j of the year"));
+                g_string_append(text, formatted);
+                g_free(formatted);
+                g_date_time_unref(dt);
+            }
+            break;
+
+        case BLOCK_MEMORY: {
+            const MemorySample *memory = &raw->memory;
+            gulong cached_all = memory->cached_kb + memory->reclaimable_kb;
+            gulong used = memory->total_kb - memory->free_kb - cached_all;
+
+            append_tooltip_size(text, _("<b>Used</b>"), used);
+            append_tooltip_size(text, _("Total"), memory->total_kb);
+            append_tooltip_size(text, _("Available"), memory->available_kb);
+            append_tooltip_size(text, _("Free"), memory->free_kb);
+            append_tooltip_size(text, _("Buffers"), memory->buffers_kb);
+            append_tooltip_size(text, _("Cached"), memory->cached_kb);
+            append_tooltip_size(text, _("Reclaimable"), memory->reclaimable_kb);
+            append_tooltip_size(text, _("Shared"), memory->shmem_kb);
+            if (memory->swap_total_kb > 0) {
+                append_tooltip_size(text, _("Swap used"), memory->swap_total_kb - memory->swap_free_kb);
+                append_tooltip_size(text, _("Swap total"), memory->swap_total_kb);
+            }
+
+            if (memory->n_top > 0)
+                g_string_append(text, _("\n\n<b>Largest processes</b>"));
+            for (gint i = 0; i < memory->n_top; i++) {
+                const ProcUsage *usage = &memory->top[i];
+                gchar *name = g_markup_escape_text(usage->name, -1);
+                gchar *rss = g_format_size_full((guint64)usage->rss_kb * 1024, G_FORMAT_SIZE_IEC_UNITS);
+
+                g_string_append_printf(text, "\n%s  %s", name, rss);
+                if (usage->pss_kb > 0) {
+                    gchar *pss = g_format_size_full((guint64)usage->pss_kb * 1024, G_FORMAT_SIZE_IEC_UNITS);
+
+                    g_string_append_printf(text, _(" (PSS %s)"), pss);
+                    g_free(pss);
+                }
+                g_free(rss);
+                g_free(name);
+            }
+            break;
+        }
+
+        case BLOCK_WEATHER:
+            for (gint i = 0; i < raw->weather.n_readings; i++) {
+                const WeatherReading *reading = &raw->weather.readings[i];
+
+                if (i > 0)
+                    g_string_append(text, "\n\n");
+                if (reading->name[0] != '\0') {
+                    gchar *name = g_markup_escape_text(reading->name, -1);
+                    g_string_append_printf(text, "<b>%s</b>  ", name);
+                    g_free(name);
+                }
+                g_string_append_printf(text, "<b>%.1f°C</b>  %s\n", reading->temperature,
+                                       weather_code_description(reading->weathercode));
+                g_string_append_printf(text, _("Wind: %.1f km/h %s\n"), reading->windspeed,
+                                       wind_direction_name(reading->winddirection));
+                g_string_append(text, reading->is_day ? _("Daytime") : _("Night"));
+            }
+            if (raw->weather.n_readings > 0)
+                append_tooltip_range(text, history, SAMPLE_HISTORY_TEMPERATURE,
+                                     _("Last 24 hours: "), 1, "%.1f – %.1f°C");
+
+            dt = raw->weather.fetched_at > 0 ? g_date_time_new_from_unix_local(raw->weather.fetched_at) : NULL;
+            if (dt) {
+                formatted = g_date_time_format(dt, _("Interpolated from the forecast of %H:%M"));
+                g_string_append_printf(text, "\n\n<small>%s</small>", formatted);
+                g_free(formatted);
+                g_date_time_unref(dt);
+            }
+            break;
+
+        case BLOCK_EXCHANGE_RATE: {
+            const ExchangeSample *exchange = &raw->exchange;
+
+            if (exchange->has_try)
+                g_string_append_printf(text, "<b>USD/TRY</b> %.4f", exchange->try_rate);
+            if (exchange->has_rub)
+                g_string_append_printf(text, "%s<b>USD/RUB</b> %.4f",
+                                       text->len > 0 ? "\n" : "", exchange->rub_rate);
+            if (exchange->has_try)
+                append_tooltip_range(text, history, SAMPLE_HISTORY_TRY,
+                                     _("USD/TRY last 30 days: "), 30, "%.2f – %.2f");
+            if (exchange->has_rub)
+                append_tooltip_range(text, history, SAMPLE_HISTORY_RUB,
+                                     _("USD/RUB last 30 days: "), 30, "%.2f – %.2f");
+
+            dt = exchange->timestamp > 0 ? g_date_time_new_from_unix_local(exchange->timestamp) : NULL;
+            if (dt) {
+                formatted = g_date_time_format(dt, _("Updated %H:%M, %-d %b"));
+                g_string_append_printf(text, "\n%s", formatted);
+                g_free(formatted);
+                g_date_time_unref(dt);
+            }
+            if (exchange->source[0]) {
+                gchar *source = g_markup_escape_text(exchange->source, -1);
+
+                g_string_append_printf(text, _("\n<small>From %s</small>"), source);
+                g_free(source);
+            }
+            break;
+        }
+
+        case BLOCK_BATTERY: {
+            const BatterySample *battery = &raw->battery;
+            gchar *status = g_markup_escape_text(battery->status, -1);
+
+            g_string_append_printf(text, "<b>%d%%</b>  %s", battery->capacity, status);
+            g_free(status);
+
+            if (battery->power > 0.0)
+                g_string_append_printf(text, battery->charging ? _("\nCharging at %.1f W")
+                                                               : _("\nDrawing %.1f W"),
+                                       battery->power);
+            if (battery->seconds_left > 0) {
+                gint64 minutes = battery->seconds_left / 60;
+
+                g_string_append_printf(text, battery->charging ? _("\nFull in %d:%02d")
+                                                               : _("\nEmpty in %d:%02d"),
+                                       (gint) (minutes / 60), (gint) (minutes % 60));
+            }
+
+            if (battery->full > 0 && battery->full_design > 0)
+                g_string_append_printf(text, _("\nHealth: %.0f%%"),
+                                       100.0 * battery->full / battery->full_design);
+            break;
+        }
+
+        case BLOCK_CPU: {
+            const CpuSample *cpu = &raw->cpu;
+
+            g_string_append_printf(text, _("<b>CPU %.0f%%</b>\n%d cores, %d above 90%%"),
+                                   cpu->total * 100.0f, cpu->n_cores, cpu->n_busy_cores);
+            if (cpu->n_cores > 1)
+                g_string_append_printf(text, _("\nBusiest: cpu%d at %.0f%%"),
+                                       cpu->busiest_core, cpu->busiest * 100.0f);
+            break;
+        }
+
+        case BLOCK_NETWORK:
+            for (gint i = 0; i < raw->net.n_interfaces; i++) {
+                const NetInterface *iface = &raw->net.interfaces[i];
+                gchar *name = g_markup_escape_text(iface->name, -1);
+                gchar *rx_rate = g_format_size((guint64)iface->rx_rate);
+                gchar *tx_rate = g_format_size((guint64)iface->tx_rate);
+                gchar *rx_total = g_format_size(iface->rx_bytes);
+                gchar *tx_total = g_format_size(iface->tx_bytes);
+
+                if (text->len > 0)
+                    g_string_append_c(text, '\n');
+                if (iface->up)
+                    g_string_append_printf(text, _("<b>%s</b>  ↓ %s/s  ↑ %s/s\nReceived %s, sent %s"),
+                                           name, rx_rate, tx_rate, rx_total, tx_total);
+                else
+                    g_string_append_printf(text, _("<b>%s</b>  down"), name);
+
+                g_free(name);
+                g_free(rx_rate);
+                g_free(tx_rate);
+                g_free(rx_total);
+                g_free(tx_total);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (text->len == 0) {
+        g_string_free(text, TRUE);
+        return NULL;
+    }
+
+    return g_string_free(text, FALSE);
+}
+
+/* Tooltips are only built here, on hover, and cached until the block's sample changes */
+static gboolean
+sample_query_tooltip (GtkWidget    *widget,
+                      gint          x,
+                      gint          y,
+                      gboolean      keyboard_mode,
+                      GtkTooltip   *tooltip,
+                      SamplePlugin *sample)
+{
+    BlockTooltip *cache;
+    BlockSample   raw;
+    guint         serial = 0;
+    gboolean      stale;
+    gboolean      outdated = FALSE;
+    gint64        fetched_at = 0;
+    gint          block_id;
+
+    if (keyboard_mode)
+        return FALSE;
+
+    block_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(widget), "block-id"));
+
+    /* keeps the process list coming while the tooltip is up */
+    if (block_id == BLOCK_MEMORY)
+        sample_scheduler_show_details(sample->scheduler, block_id);
+
+    cache = &sample->tooltips[block_id];
+
+    pthread_mutex_lock(&sample->store.mutex);
+    stale = cache->text == NULL || cache->serial != sample->store.blocks[block_id].serial;
+    if (stale) {
+        serial = sample->store.blocks[block_id].serial;
+        raw = sample->store.blocks[block_id].raw;
+        outdated = sample->store.blocks[block_id].outdated;
+        fetched_at = sample->store.blocks[block_id].fetched_at;
+    }
+    pthread_mutex_unlock(&sample->store.mutex);
+
+    if (stale) {
+        g_free(cache->text);
+        cache->text = build_block_tooltip(block_id, &raw, sample->store.history);
+        cache->serial = serial;
+    }
+
+    /* say why the block is dimmed */
+    if (stale && outdated && cache->text) {
+        GDateTime *dt = g_date_time_new_from_unix_local(fetched_at / G_USEC_PER_SEC);
+        gchar     *formatted = dt ? g_date_time_format(dt, _("Out of date, fetched %H:%M, %-d %b")) : NULL;
+
+        if (formatted) {
+            gchar *text = g_strdup_printf("%s\n\n<small>%s</small>", cache->text, formatted);
+
+            g_free(cache->text);
+            cache->text = text;
+        }
+        g_free(formatted);
+        if (dt)
+            g_date_time_unref(dt);
+    }
+
+    if (cache->text == NULL)
+        return FALSE;
+
+    gtk_tooltip_set_markup(tooltip, cache->text);
+
+    return TRUE;
+}
+
+/* A left click on a block refreshes it, the scheduler merges repeated
+ * clicks into one fetch */
+static gboolean
+sample_button_released (GtkWidget      *widget,
+                        GdkEventButton *event,
+                        SamplePlugin   *sample)
+{
+    if (event->button != 1)
+        return FALSE;
+
+    for (gint i = 0; i < BLOCK_COUNT; i++) {
+        GtkWidget *area = sample->slots[i].area;
+        GtkAllocation allocation;
+        gint x, y;
+
+        if (!gtk_widget_get_visible(area)
+            || !gtk_widget_translate_coordinates(widget, area, event->x, event->y, &x, &y))
+            continue;
+
+        gtk_widget_get_allocation(area, &allocation);
+        if (x >= 0 && x < allocation.width && y >= 0 && y < allocation.height) {
+            sample_scheduler_refresh(sample->scheduler, i);
+            return TRUE;
+        }
+    }
+
+    for (gint i = SLOT_COMMANDS; i < SLOT_BUS; i++) {
+        GtkWidget *area = sample->slots[i].area;
+        GtkAllocation allocation;
+        gint x, y;
+
+        if (!gtk_widget_get_visible(area)
+            || !gtk_widget_translate_coordinates(widget, area, event->x, event->y, &x, &y))
+            continue;
+
+        gtk_widget_get_allocation(area, &allocation);
+        if (x >= 0 && x < allocation.width && y >= 0 && y < allocation.height) {
+            sample_commands_refresh(sample->commands, i - SLOT_COMMANDS);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
 
 
 /* Plugin Core Functions */
@@ -179,8 +674,9 @@ void
 sample_save (XfcePanelPlugin *plugin,
              SamplePlugin    *sample)
 {
-    XfceRc *rc;
-    gchar  *file;
+    XfceRc             *rc;
+    gchar              *file;
+    const SampleConfig *config;
 
     /* get the config file location */
     file = xfce_panel_plugin_save_location (plugin, TRUE);
@@ -198,30 +694,52 @@ sample_save (XfcePanelPlugin *plugin,
     if (G_LIKELY (rc != NULL))
     {
         /* save the settings */
-        if (sample->weather_location)
-            xfce_rc_write_entry (rc, "weather_location", sample->weather_location);
+        config = sample_scheduler_get_config (sample->scheduler);
+        
+        if (config->weather_location)
+            xfce_rc_write_entry (rc, "weather_location", config->weather_location);
+        
+        if (config->weather_url)
+            xfce_rc_write_entry (rc, "weather_url", config->weather_url);
+        
+        if (config->exchange_api_key)
+            xfce_rc_write_entry (rc, "exchange_api_key", config->exchange_api_key);
+        
+        if (config->exchange_sources)
+            xfce_rc_write_entry (rc, "exchange_sources", config->exchange_sources);
+        
+        if (config->network_exclude)
+            xfce_rc_write_entry (rc, "network_exclude", config->network_exclude);
         
-        if (sample->exchange_api_key)
-            xfce_rc_write_entry (rc, "exchange_api_key", sample->exchange_api_key);
+        if (config->commands_file)
+            xfce_rc_write_entry (rc, "commands_file", config->commands_file);
         
-        xfce_rc_write_int_entry  (rc, "update_interval", sample->update_interval);
-        xfce_rc_write_bool_entry (rc, "show_weather", sample->show_weather);
-        xfce_rc_write_bool_entry (rc, "show_exchange", sample->show_exchange);
-        xfce_rc_write_bool_entry (rc, "show_battery", sample->show_battery);
-        xfce_rc_write_bool_entry (rc, "show_memory", sample->show_memory);
-        xfce_rc_write_bool_entry (rc, "show_date", sample->show_date);
+        xfce_rc_write_int_entry  (rc, "update_interval", config->update_interval);
+        xfce_rc_write_int_entry  (rc, "exchange_budget", config->exchange_budget);
+        xfce_rc_write_bool_entry (rc, "show_weather", config->show_weather);
+        xfce_rc_write_bool_entry (rc, "show_exchange", config->show_exchange);
+        xfce_rc_write_bool_entry (rc, "show_network", config->show_network);
+        xfce_rc_write_bool_entry (rc, "show_battery", config->show_battery);
+        xfce_rc_write_bool_entry (rc, "show_memory", config->show_memory);
+        xfce_rc_write_bool_entry (rc, "show_cpu", config->show_cpu);
+        xfce_rc_write_bool_entry (rc, "show_cpu_graph", config->show_cpu_graph);
+        xfce_rc_write_bool_entry (rc, "show_date", config->show_date);
 
         /* close the rc file */
         xfce_rc_close (rc);
     }
 }
 
-static void
+static SampleConfig *
 sample_read (SamplePlugin *sample)
 {
-    XfceRc      *rc;
-    gchar       *file;
-    const gchar *value;
+    XfceRc       *rc;
+    gchar        *file;
+    const gchar  *value;
+    SampleConfig *config;
+
+    /* the first snapshot, not yet published */
+    config = sample_config_new ();
 
     /* get the plugin config file location */
     file = xfce_panel_plugin_save_location (sample->plugin, TRUE);
@@ -238,110 +756,169 @@ sample_read (SamplePlugin *sample)
         {
             /* read the settings */
             value = xfce_rc_read_entry (rc, "weather_location", DEFAULT_WEATHER_LOCATION);
-            sample->weather_location = g_strdup (value);
+            config->weather_location = g_strdup (value);
+
+            value = xfce_rc_read_entry (rc, "weather_url", DEFAULT_WEATHER_URL);
+            config->weather_url = g_strdup (value);
 
             value = xfce_rc_read_entry (rc, "exchange_api_key", DEFAULT_EXCHANGE_API_KEY);
-            sample->exchange_api_key = g_strdup (value);
+            config->exchange_api_key = g_strdup (value);
+
+            value = xfce_rc_read_entry (rc, "exchange_sources", DEFAULT_EXCHANGE_SOURCES);
+            config->exchange_sources = g_strdup (value);
+
+            value = xfce_rc_read_entry (rc, "network_exclude", DEFAULT_NETWORK_EXCLUDE);
+            config->network_exclude = g_strdup (value);
 
-            sample->update_interval = xfce_rc_read_int_entry (rc, "update_interval", DEFAULT_UPDATE_INTERVAL);
-            sample->show_weather = xfce_rc_read_bool_entry (rc, "show_weather", DEFAULT_SHOW_WEATHER);
-            sample->show_exchange = xfce_rc_read_bool_entry (rc, "show_exchange", DEFAULT_SHOW_EXCHANGE);
-            sample->show_battery = xfce_rc_read_bool_entry (rc, "show_battery", DEFAULT_SHOW_BATTERY);
-            sample->show_memory = xfce_rc_read_bool_entry (rc, "show_memory", DEFAULT_SHOW_MEMORY);
-            sample->show_date = xfce_rc_read_bool_entry (rc, "show_date", DEFAULT_SHOW_DATE);
+            value = xfce_rc_read_entry (rc, "commands_file", DEFAULT_COMMANDS_FILE);
+            config->commands_file = g_strdup (value);
+
+            config->update_interval = xfce_rc_read_int_entry (rc, "update_interval", DEFAULT_UPDATE_INTERVAL);
+            config->exchange_budget = MAX (xfce_rc_read_int_entry (rc, "exchange_budget", DEFAULT_EXCHANGE_BUDGET), 0);
+            config->show_weather = xfce_rc_read_bool_entry (rc, "show_weather", DEFAULT_SHOW_WEATHER);
+            config->show_exchange = xfce_rc_read_bool_entry (rc, "show_exchange", DEFAULT_SHOW_EXCHANGE);
+            config->show_network = xfce_rc_read_bool_entry (rc, "show_network", DEFAULT_SHOW_NETWORK);
+            config->show_battery = xfce_rc_read_bool_entry (rc, "show_battery", DEFAULT_SHOW_BATTERY);
+            config->show_memory = xfce_rc_read_bool_entry (rc, "show_memory", DEFAULT_SHOW_MEMORY);
+            config->show_cpu = xfce_rc_read_bool_entry (rc, "show_cpu", DEFAULT_SHOW_CPU);
+            config->show_cpu_graph = xfce_rc_read_bool_entry (rc, "show_cpu_graph", DEFAULT_SHOW_CPU_GRAPH);
+            config->show_date = xfce_rc_read_bool_entry (rc, "show_date", DEFAULT_SHOW_DATE);
 
             /* cleanup */
             xfce_rc_close (rc);
 
             /* leave the function, everything went well */
-            return;
+            return config;
         }
     }
 
     /* something went wrong, apply default values */
     DBG ("Applying default settings");
 
-    sample->weather_location = g_strdup (DEFAULT_WEATHER_LOCATION);
-    sample->exchange_api_key = g_strdup (DEFAULT_EXCHANGE_API_KEY);
-    sample->update_interval = DEFAULT_UPDATE_INTERVAL;
-    sample->show_weather = DEFAULT_SHOW_WEATHER;
-    sample->show_exchange = DEFAULT_SHOW_EXCHANGE;
-    sample->show_battery = DEFAULT_SHOW_BATTERY;
-    sample->show_memory = DEFAULT_SHOW_MEMORY;
-    sample->show_date = DEFAULT_SHOW_DATE;
+    config->weather_location = g_strdup (DEFAULT_WEATHER_LOCATION);
+    config->weather_url = g_strdup (DEFAULT_WEATHER_URL);
+    config->exchange_api_key = g_strdup (DEFAULT_EXCHANGE_API_KEY);
+    config->exchange_sources = g_strdup (DEFAULT_EXCHANGE_SOURCES);
+    config->network_exclude = g_strdup (DEFAULT_NETWORK_EXCLUDE);
+    config->commands_file = g_strdup (DEFAULT_COMMANDS_FILE);
+    config->update_interval = DEFAULT_UPDATE_INTERVAL;
+    config->exchange_budget = DEFAULT_EXCHANGE_BUDGET;
+    config->show_weather = DEFAULT_SHOW_WEATHER;
+    config->show_exchange = DEFAULT_SHOW_EXCHANGE;
+    config->show_network = DEFAULT_SHOW_NETWORK;
+    config->show_battery = DEFAULT_SHOW_BATTERY;
+    config->show_memory = DEFAULT_SHOW_MEMORY;
+    config->show_cpu = DEFAULT_SHOW_CPU;
+    config->show_cpu_graph = DEFAULT_SHOW_CPU_GRAPH;
+    config->show_date = DEFAULT_SHOW_DATE;
+
+    return config;
 }
 
+/* (Re)start the command blocks of the current settings, the file is
+ * only read here */
 static void
-start_threads (SamplePlugin *sample)
+sample_commands_start (SamplePlugin *sample)
 {
-    /* Initialize all blocks */
-    for (int i = 0; i < BLOCK_COUNT; i++) {
-        sample->blocks[i].len = 0;
-        sample->blocks[i].data[0] = '\0';
-    }
-    
-    /* Start threads */
-    if (sample->show_date) {
-        sample->date_thread.running = TRUE;
-        sample->date_thread.thread = g_thread_new("date_thread", date_thread_func, sample);
-    }
-    
-    if (sample->show_memory) {
-        sample->memory_thread.running = TRUE;
-        sample->memory_thread.thread = g_thread_new("memory_thread", memory_thread_func, sample);
-    }
-    
-    if (sample->show_weather && sample->weather_location) {
-        sample->weather_thread.running = TRUE;
-        sample->weather_thread.thread = g_thread_new("weather_thread", weather_thread_func, sample);
-    }
-    
-    if (sample->show_exchange && sample->exchange_api_key) {
-        sample->exchange_thread.running = TRUE;
-        sample->exchange_thread.thread = g_thread_new("exchange_thread", exchange_thread_func, sample);
+    const SampleConfig *config = sample_scheduler_get_config (sample->scheduler);
+    GError             *error = NULL;
+
+    sample_commands_free (sample->commands);
+    sample->commands = NULL;
+
+    /* the new blocks count their serials from the start again */
+    for (gint i = SLOT_COMMANDS; i < SLOT_BUS; i++)
+    {
+        sample->slots[i].serial = G_MAXUINT;
+        sample->slots[i].markup[0] = '\0';
     }
-    
-    if (sample->show_battery) {
-        sample->battery_thread.running = TRUE;
-        sample->battery_thread.thread = g_thread_new("battery_thread", battery_thread_func, sample);
+
+    if (config->commands_file == NULL || *config->commands_file == '\0')
+        return;
+
+    sample->commands = sample_commands_new (config->commands_file, block_notify_source_wake,
+                                            sample->redraw, &error);
+    if (sample->commands == NULL)
+    {
+        g_warning ("Command blocks are not run: %s", error->message);
+        g_error_free (error);
     }
 }
 
+/* Publish new settings from the dialog, taking ownership of @config */
+void
+sample_apply_config (SamplePlugin *sample,
+                     SampleConfig *config)
+{
+    gboolean commands_changed;
+
+    commands_changed = g_strcmp0 (config->commands_file,
+                                  sample_scheduler_get_config (sample->scheduler)->commands_file) != 0;
+    sample_scheduler_apply (sample->scheduler, config);
+
+    /* saving the dialog also picks up edits of the file */
+    if (commands_changed || sample->commands != NULL)
+        sample_commands_start (sample);
+
+    /* shown blocks may have changed */
+    update_display (sample);
+}
+
+/* Custom blocks are checked against Pango once, when they arrive */
+static gboolean
+sample_custom_markup_valid (const gchar  *markup,
+                            GError      **error)
+{
+    return pango_parse_markup (markup, -1, 0, NULL, NULL, NULL, error);
+}
+
+/* Publish the blocks for scripts and status lines, one file per plugin
+ * instance; the panel works the same without it */
 static void
-stop_threads (SamplePlugin *sample)
+sample_export_start (SamplePlugin *sample)
 {
-    /* Stop all threads */
-    sample->date_thread.running = FALSE;
-    sample->memory_thread.running = FALSE;
-    sample->weather_thread.running = FALSE;
-    sample->exchange_thread.running = FALSE;
-    sample->battery_thread.running = FALSE;
-    
-    /* Wait for threads to finish */
-    if (sample->date_thread.thread) {
-        g_thread_join(sample->date_thread.thread);
-        sample->date_thread.thread = NULL;
-    }
-    
-    if (sample->memory_thread.thread) {
-        g_thread_join(sample->memory_thread.thread);
-        sample->memory_thread.thread = NULL;
-    }
-    
-    if (sample->weather_thread.thread) {
-        g_thread_join(sample->weather_thread.thread);
-        sample->weather_thread.thread = NULL;
-    }
-    
-    if (sample->exchange_thread.thread) {
-        g_thread_join(sample->exchange_thread.thread);
-        sample->exchange_thread.thread = NULL;
+    GError *error = NULL;
+    gchar  *name, *path;
+
+    name = g_strdup_printf ("plugin-%d", xfce_panel_plugin_get_unique_id (sample->plugin));
+    path = sample_export_default_path (name);
+    sample->export = sample_export_new (path, &error);
+    if (sample->export)
+        block_store_set_export (&sample->store, sample->export);
+    else
+    {
+        g_warning ("Blocks are not exported: %s", error->message);
+        g_error_free (error);
     }
-    
-    if (sample->battery_thread.thread) {
-        g_thread_join(sample->battery_thread.thread);
-        sample->battery_thread.thread = NULL;
+    g_free (path);
+    g_free (name);
+}
+
+/* Record the rates, temperature and memory use next to the settings,
+ * in sample-<id>.history/ beside sample-<id>.rc */
+static void
+sample_history_start (SamplePlugin *sample)
+{
+    GError *error = NULL;
+    gchar  *file, *dir;
+
+    file = xfce_panel_plugin_save_location (sample->plugin, TRUE);
+    if (G_UNLIKELY (file == NULL))
+        return;
+
+    if (g_str_has_suffix (file, ".rc"))
+        file[strlen (file) - strlen (".rc")] = '\0';
+    dir = g_strconcat (file, ".history", NULL);
+    sample->history = sample_history_new (dir, &error);
+    if (sample->history)
+        block_store_set_history (&sample->store, sample->history);
+    else
+    {
+        g_warning ("No history is kept: %s", error->message);
+        g_error_free (error);
     }
+    g_free (dir);
+    g_free (file);
 }
 
 static SamplePlugin *
@@ -356,11 +933,13 @@ sample_new (XfcePanelPlugin *plugin)
     /* pointer to plugin */
     sample->plugin = plugin;
 
-    /* read the user settings */
-    sample_read (sample);
-
-    /* Initialize mutex */
-    pthread_mutex_init(&sample->mutex, NULL);
+    /* Initialize the block store, workers wake the redraw source */
+    sample->redraw = block_notify_source_new ();
+    g_source_set_callback (sample->redraw, (GSourceFunc) update_display, sample, NULL);
+    g_source_attach (sample->redraw, NULL);
+    block_store_init (&sample->store, block_notify_source_wake, sample->redraw);
+    sample_export_start (sample);
+    sample_history_start (sample);
 
     /* get the current orientation */
     orientation = xfce_panel_plugin_get_orientation (plugin);
@@ -368,18 +947,62 @@ sample_new (XfcePanelPlugin *plugin)
     /* create some panel widgets */
     sample->ebox = gtk_event_box_new ();
     gtk_widget_show (sample->ebox);
+    g_signal_connect (G_OBJECT (sample->ebox), "button-release-event",
+                      G_CALLBACK (sample_button_released), sample);
 
     sample->hvbox = gtk_box_new (orientation, 2);
     gtk_widget_show (sample->hvbox);
     gtk_container_add (GTK_CONTAINER (sample->ebox), sample->hvbox);
 
-    /* Create main label */
+    /* Placeholder label, shown until the first block has data */
     sample->label = gtk_label_new (_("Loading..."));
     gtk_widget_show (sample->label);
     gtk_box_pack_start (GTK_BOX (sample->hvbox), sample->label, FALSE, FALSE, 0);
 
-    /* Start update threads */
-    start_threads(sample);
+    /* One drawing area per block, each with its own cached layout */
+    sample->atlas = sample_atlas_new ();
+    sample->resizes_since = g_get_monotonic_time ();
+    for (gint i = 0; i < SLOT_COUNT; i++)
+    {
+        BlockSlot *slot = &sample->slots[i];
+
+        slot->separator = gtk_label_new (BLOCK_SEPARATOR);
+        gtk_box_pack_start (GTK_BOX (sample->hvbox), slot->separator, FALSE, FALSE, 0);
+
+        slot->area = gtk_drawing_area_new ();
+        g_object_set_data (G_OBJECT (slot->area), "block-id", GINT_TO_POINTER (i));
+        g_signal_connect (G_OBJECT (slot->area), "draw",
+                          G_CALLBACK (slot_draw), sample);
+        if (i < BLOCK_COUNT)
+        {
+            gtk_widget_set_has_tooltip (slot->area, TRUE);
+            g_signal_connect (G_OBJECT (slot->area), "query-tooltip",
+                              G_CALLBACK (sample_query_tooltip), sample);
+        }
+        gtk_box_pack_start (GTK_BOX (sample->hvbox), slot->area, FALSE, FALSE, 0);
+
+        sample_atlas_attach (sample->atlas, gtk_widget_get_pango_context (slot->area));
+        slot->layout = gtk_widget_create_pango_layout (slot->area, NULL);
+    }
+
+    /* Rebuild the icons on font, scale and theme changes, the slots all
+     * share the first one's style */
+    g_signal_connect_swapped (G_OBJECT (sample->slots[0].area), "style-updated",
+                              G_CALLBACK (sample_refresh_icons), sample);
+    g_signal_connect_swapped (G_OBJECT (sample->slots[0].area), "notify::scale-factor",
+                              G_CALLBACK (sample_refresh_icons), sample);
+    sample->icon_theme_changed_id =
+        g_signal_connect (G_OBJECT (gtk_icon_theme_get_default ()), "changed",
+                          G_CALLBACK (sample_icon_theme_changed), sample);
+    sample_refresh_icons (sample);
+
+    /* read the user settings and start the update threads */
+    sample->scheduler = sample_scheduler_new (&sample->store, sample_read (sample));
+    sample_commands_start (sample);
+
+    /* take custom blocks from other programs, they redraw like the rest */
+    sample->bus = sample_bus_new (SAMPLE_BUS_NAME, sample_custom_markup_valid,
+                                  block_notify_source_wake, sample->redraw);
 
     return sample;
 }
@@ -390,8 +1013,14 @@ sample_free (XfcePanelPlugin *plugin,
 {
     GtkWidget *dialog;
 
-    /* Stop threads first */
-    stop_threads(sample);
+    /* Stop threads first, they release the settings with them */
+    sample_bus_free (sample->bus);
+    sample_commands_free (sample->commands);
+    sample_scheduler_free (sample->scheduler);
+    block_store_set_export (&sample->store, NULL);
+    sample_export_free (sample->export);
+    block_store_set_history (&sample->store, NULL);
+    sample_history_free (sample->history);
 
     /* check if the dialog is still open. if so, destroy it */
     dialog = g_object_get_data (G_OBJECT (plugin), "dialog");
@@ -399,16 +1028,19 @@ sample_free (XfcePanelPlugin *plugin,
         gtk_widget_destroy (dialog);
 
     /* destroy the panel widgets */
+    g_signal_handler_disconnect (gtk_icon_theme_get_default (), sample->icon_theme_changed_id);
     gtk_widget_destroy (sample->hvbox);
+    for (gint i = 0; i < SLOT_COUNT; i++)
+        g_object_unref (sample->slots[i].layout);
+    sample_atlas_free (sample->atlas);
 
-    /* cleanup the settings */
-    if (G_LIKELY (sample->weather_location != NULL))
-        g_free (sample->weather_location);
-    if (G_LIKELY (sample->exchange_api_key != NULL))
-        g_free (sample->exchange_api_key);
+    for (gint i = 0; i < BLOCK_COUNT; i++)
+        g_free (sample->tooltips[i].text);
 
     /* Destroy mutex */
-    pthread_mutex_destroy(&sample->mutex);
+    block_store_clear (&sample->store);
+    g_source_destroy (sample->redraw);
+    g_source_unref (sample->redraw);
 
     /* free the plugin structure */
     g_slice_free (SamplePlugin, sample);
@@ -439,6 +1071,9 @@ sample_size_changed (XfcePanelPlugin *plugin,
     else
         gtk_widget_set_size_request (GTK_WIDGET (plugin), size, -1);
 
+    /* the panel font may come with the new size */
+    sample_refresh_icons (sample);
+
     /* we handled the orientation */
     return TRUE;
 }
@@ -453,8 +1088,10 @@ sample_construct (XfcePanelPlugin *plugin)
     /* setup translation domain */
     xfce_textdomain(GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR, "UTF-8");
 
+#ifdef HAVE_LIBCURL
     /* Initialize CURL globally */
     curl_global_init(CURL_GLOBAL_DEFAULT);
+#endif
 
     /* create the plugin */
     sample = sample_new (plugin);
@@ -489,410 +1126,3 @@ sample_construct (XfcePanelPlugin *plugin)
                       G_CALLBACK (sample_about), NULL);
 }
 
-/* Utility Functions */
-
-/* CURL write callback */
-static size_t
-write_response_callback (void *contents, size_t size, size_t nmemb, void *userp)
-{
-    size_t total_size = size * nmemb;
-    gchar **output = (gchar**)userp;
-    gchar *temp = g_realloc(*output, total_size + 1);
-    if (temp) {
-        *output = temp;
-        memcpy(*output, contents, total_size);
-        (*output)[total_size] = '\0';
-    }
-    return total_size;
-}
-
-/* Get weather data from API */
-static gchar*
-get_weather_data (const gchar *location)
-{
-    if (!location) return NULL;
-    
-    CURL *curl;
-    CURLcode res;
-    gchar *response = NULL;
-    gchar *url;
-    gchar **parts;
-    
-    /* Parse latitude,longitude */
-    parts = g_strsplit(location, ",", 2);
-    if (!parts || !parts[0] || !parts[1]) {
-        g_strfreev(parts);
-        return NULL;
-    }
-    
-    url = g_strdup_printf("https://api.open-meteo.com/v1/forecast?latitude=%s&longitude=%s&current_weather=true",
-                          g_strstrip(parts[0]), g_strstrip(parts[1]));
-    g_strfreev(parts);
-    
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_response_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-        
-        res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-        
-        if (res != CURLE_OK) {
-            g_free(response);
-            response = NULL;
-        }
-    }
-    
-    g_free(url);
-    return response;
-}
-
-/* Get exchange rate data from API */
-static gchar*
-get_exchange_data (const gchar *api_key)
-{
-    if (!api_key) return NULL;
-    
-    CURL *curl;
-    CURLcode res;
-    gchar *response = NULL;
-    gchar *url;
-    
-    url = g_strdup_printf("https://openexchangerates.org/api/latest.json?app_id=%s", api_key);
-    
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_response_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-        
-        res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-        
-        if (res != CURLE_OK) {
-            g_free(response);
-            response = NULL;
-        }
-    }
-    
-    g_free(url);
-    return response;
-}
-
-/* Get battery information */
-static void
-get_battery_info (gchar **capacity, gchar **status)
-{
-    FILE *fp;
-    gchar buffer[64];
-    
-    *capacity = NULL;
-    *status = NULL;
-    
-    /* Get capacity */
-    fp = fopen("/sys/class/power_supply/BAT0/capacity", "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            g_strchomp(buffer);
-            *capacity = g_strdup(buffer);
-        }
-        fclose(fp);
-    }
-    
-    /* Get status */
-    fp = fopen("/sys/class/power_supply/BAT0/status", "r");
-    if (fp) {
-        if (fgets(buffer, sizeof(buffer), fp)) {
-            g_strchomp(buffer);
-            *status = g_strdup(buffer);
-        }
-        fclose(fp);
-    }
-}
-
-/* Get memory information */
-static void
-get_memory_info (gchar **memory_text)
-{
-    FILE *fp;
-    gchar line[256];
-    gulong mem_total = 0, mem_free = 0, cached = 0, buffers = 0, mem_reclaimable = 0;
-    
-    *memory_text = NULL;
-    
-    fp = fopen("/proc/meminfo", "r");
-    if (!fp) return;
-    
-    while (fgets(line, sizeof(line), fp)) {
-        if (sscanf(line, "MemTotal: %lu kB", &mem_total) == 1) continue;
-        if (sscanf(line, "MemFree: %lu kB", &mem_free) == 1) continue;
-        if (sscanf(line, "Cached: %lu kB", &cached) == 1) continue;
-        if (sscanf(line, "Buffers: %lu kB", &buffers) == 1) continue;
-        if (sscanf(line, "SReclaimable: %lu kB", &mem_reclaimable) == 1) continue;
-    }
-    
-    fclose(fp);
-    
-    if (mem_total > 0) {
-        gulong mem_cached_all = cached + mem_reclaimable;
-        gulong mem_used = mem_total - mem_free - mem_cached_all;
-        gdouble mem_used_gb = mem_used / 1024.0 / 1024.0;
-        
-        *memory_text = g_strdup_printf("<span color='#186da5'>🗄️ %.1fGB</span>", mem_used_gb);
-    }
-}
-
-/* Thread Functions */
-
-/* Date/Time thread */
-static gpointer
-date_thread_func (gpointer data)
-{
-    SamplePlugin *sample = (SamplePlugin *)data;
-    
-    while (sample->date_thread.running) {
-        time_t now = time(NULL);
-        struct tm *timeinfo = localtime(&now);
-        
-        gchar *date_str = g_strdup_printf(
-            "<span color='#07d7e8'>📅</span> <span color='#10bbbb'>%s %s %d %s %02d:%02d</span>",
-            (gchar*[]){"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"}[timeinfo->tm_wday],
-            (gchar*[]){"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"}[timeinfo->tm_mon],
-            timeinfo->tm_mday,
-            (timeinfo->tm_hour >= 8 && timeinfo->tm_hour < 21) ? "<span color='#edd238'>☀️</span>" : "<span color='#ecede8'>🌙</span>",
-            timeinfo->tm_hour,
-            timeinfo->tm_min
-        );
-        
-        update_block(sample, BLOCK_DATE, date_str);
-        g_free(date_str);
-        
-        /* Sleep until next minute */
-        int sleep_time = 60 - timeinfo->tm_sec;
-        for (int i = 0; i < sleep_time && sample->date_thread.running; i++) {
-            g_usleep(1000000); /* 1 second */
-        }
-    }
-    
-    return NULL;
-}
-
-/* Memory thread */
-static gpointer
-memory_thread_func (gpointer data)
-{
-    SamplePlugin *sample = (SamplePlugin *)data;
-    
-    while (sample->memory_thread.running) {
-        gchar *memory_text;
-        get_memory_info(&memory_text);
-        
-        if (memory_text) {
-            update_block(sample, BLOCK_MEMORY, memory_text);
-            g_free(memory_text);
-        }
-        
-        /* Update every 5 seconds */
-        for (int i = 0; i < 5 && sample->memory_thread.running; i++) {
-            g_usleep(1000000);
-        }
-    }
-    
-    return NULL;
-}
-
-/* Weather thread */
-static gpointer
-weather_thread_func (gpointer data)
-{
-    SamplePlugin *sample = (SamplePlugin *)data;
-    
-    while (sample->weather_thread.running) {
-        if (sample->weather_location) {
-            gchar *weather_json = get_weather_data(sample->weather_location);
-            
-            if (weather_json) {
-                JsonParser *parser = json_parser_new();
-                GError *error = NULL;
-                
-                if (json_parser_load_from_data(parser, weather_json, -1, &error)) {
-                    JsonNode *root = json_parser_get_root(parser);
-                    JsonObject *root_obj = json_node_get_object(root);
-                    JsonObject *current_weather = json_object_get_object_member(root_obj, "current_weather");
-                    
-                    if (current_weather) {
-                        gdouble temperature = json_object_get_double_member(current_weather, "temperature");
-                        
-                        const gchar *icon;
-                        const gchar *color;
-                        if (temperature < 0) {
-                            icon = "❄️"; color = "#1e90ff";
-                        } else if (temperature < 10) {
-                            icon = "🥶"; color = "#00bfff";
-                        } else if (temperature < 18) {
-                            icon = "🌿"; color = "#32cd32";
-                        } else if (temperature < 22) {
-                            icon = "😊"; color = "#ffd700";
-                        } else if (temperature < 30) {
-                            icon = "🌡️"; color = "#ffa500";
-                        } else {
-                            icon = "🔥"; color = "#ff4500";
-                        }
-                        
-                        gchar *weather_text = g_strdup_printf(
-                            "<span color='%s'>%s %.1f°C</span>", 
-                            color, icon, temperature
-                        );
-                        
-                        update_block(sample, BLOCK_WEATHER, weather_text);
-                        g_free(weather_text);
-                    }
-                }
-                
-                if (error) {
-                    g_error_free(error);
-                }
-                g_object_unref(parser);
-                g_free(weather_json);
-            }
-        }
-        
-        /* Update every 30 minutes */
-        for (int i = 0; i < 1800 && sample->weather_thread.running; i++) {
-            g_usleep(1000000);
-        }
-    }
-    
-    return NULL;
-}
-
-/* Exchange rate thread */
-static gpointer
-exchange_thread_func (gpointer data)
-{
-    SamplePlugin *sample = (SamplePlugin *)data;
-    
-    while (sample->exchange_thread.running) {
-        if (sample->exchange_api_key) {
-            gchar *exchange_json = get_exchange_data(sample->exchange_api_key);
-            
-            if (exchange_json) {
-                JsonParser *parser = json_parser_new();
-                GError *error = NULL;
-                
-                if (json_parser_load_from_data(parser, exchange_json, -1, &error)) {
-                    JsonNode *root = json_parser_get_root(parser);
-                    JsonObject *root_obj = json_node_get_object(root);
-                    JsonObject *rates = json_object_get_object_member(root_obj, "rates");
-                    
-                    if (rates) {
-                        GString *exchange_text = g_string_new("");
-                        gboolean has_try = FALSE, has_rub = FALSE;
-                        gdouble try_rate = 0.0, rub_rate = 0.0;
-                        
-                        /* Get TRY and RUB rates */
-                        if (json_object_has_member(rates, "TRY")) {
-                            try_rate = json_object_get_double_member(rates, "TRY");
-                            has_try = TRUE;
-                        }
-                        
-                        if (json_object_has_member(rates, "RUB")) {
-                            rub_rate = json_object_get_double_member(rates, "RUB");
-                            has_rub = TRUE;
-                        }
-                        
-                        /* Build the exchange text carefully */
-                        if (has_try) {
-                            g_string_append_printf(exchange_text, 
-                                "<span color='#07d7e8'>TRY</span> <span color='#10bbbb'>%.2f</span>", 
-                                try_rate);
-                        }
-                        
-                        if (has_rub) {
-                            if (has_try) {
-                                g_string_append(exchange_text, " ");
-                            }
-                            g_string_append_printf(exchange_text, 
-                                "<span color='#07d7e8'>RUB</span> <span color='#10bbbb'>%.2f</span>", 
-                                rub_rate);
-                        }
-                        
-                        if (exchange_text->len > 0) {
-                            update_block(sample, BLOCK_EXCHANGE_RATE, exchange_text->str);
-                        }
-                        
-                        g_string_free(exchange_text, TRUE);
-                    }
-                }
-                
-                if (error) {
-                    g_error_free(error);
-                }
-                g_object_unref(parser);
-                g_free(exchange_json);
-            }
-        }
-        
-        /* Update every 30 minutes */
-        for (int i = 0; i < 1800 && sample->exchange_thread.running; i++) {
-            g_usleep(1000000);
-        }
-    }
-    
-    return NULL;
-}
-
-/* Battery thread */
-static gpointer
-battery_thread_func (gpointer data)
-{
-    SamplePlugin *sample = (SamplePlugin *)data;
-    
-    while (sample->battery_thread.running) {
-        gchar *capacity_str, *status_str;
-        get_battery_info(&capacity_str, &status_str);
-        
-        if (capacity_str) {
-            int capacity = atoi(capacity_str);
-            const gchar *icon, *color;
-            
-            if (capacity < 10) {
-                icon = "🔋"; color = "#ff0000";
-            } else if (capacity < 25) {
-                icon = "🔋"; color = "#eb9634";
-            } else if (capacity < 50) {
-                icon = "🔋"; color = "#ebd334";
-            } else if (capacity < 75) {
-                icon = "🔋"; color = "#c6eb34";
-            } else {
-                icon = "🔋"; color = "#00ff00";
-            }
-            
-            gchar *charging_icon = "";
-            if (status_str && g_strcmp0(status_str, "Charging") == 0) {
-                charging_icon = " <span color='#cccccc'>⚡</span>";
-            }
-            
-            gchar *battery_text = g_strdup_printf(
-                "<span color='%s'>%s %d%%</span>%s",
-                color, icon, capacity, charging_icon
-            );
-            
-            update_block(sample, BLOCK_BATTERY, battery_text);
-            g_free(battery_text);
-        }
-        
-        g_free(capacity_str);
-        g_free(status_str);
-        
-        /* Update every 10 seconds */
-        for (int i = 0; i < 10 && sample->battery_thread.running; i++) {
-            g_usleep(1000000);
-        }
-    }
-    
-    return NULL;
-}
@@ -22,36 +22,40 @@
 
 #include <gtk/gtk.h>
 #include <libxfce4panel/libxfce4panel.h>
-#include <pthread.h>
-#include <time.h>
 
-G_BEGIN_DECLS
+#include "sample-atlas.h"
+#include "sample-blocks.h"
+#include "sample-bus.h"
+#include "sample-commands.h"
+#include "sample-export.h"
+#include "sample-scheduler.h"
+#include "sample-slots.h"
 
-#define MAX_BLOCK_SIZE 256
+G_BEGIN_DECLS
 
-/* Block identifiers for different status components */
-typedef enum {
-    BLOCK_WEATHER = 0,
-    BLOCK_EXCHANGE_RATE,
-    BLOCK_BATTERY,
-    BLOCK_MEMORY,
-    BLOCK_DATE,
-    BLOCK_COUNT
-} BlockId;
+/* The built-in blocks, the command blocks, then the custom ones from
+ * the session bus */
+#define SLOT_COMMANDS BLOCK_COUNT
+#define SLOT_BUS      (SLOT_COMMANDS + SAMPLE_COMMANDS_MAX)
+#define SLOT_COUNT    (SLOT_BUS + SAMPLE_BUS_MAX_BLOCKS)
 
-/* Structure to hold individual block data */
+/* Tooltip text of a block, built lazily and only owned by the GUI thread */
 typedef struct {
-    int  len;
-    char data[MAX_BLOCK_SIZE];
-} BlockData;
+    gchar       *text;
+    guint        serial;    /* BlockData serial the text was built from */
+} BlockTooltip;
 
-/* Status bar update thread data */
+/* Panel widgets of one block, only touched by the GUI thread */
 typedef struct {
-    GThread     *thread;
-    gboolean     running;
-    gint         update_interval;
-    gpointer     user_data;
-} StatusThread;
+    GtkWidget   *separator;  /* in front of the block, hidden for the first one shown */
+    GtkWidget   *area;
+    PangoLayout *layout;     /* block markup with the icons as atlas shapes */
+    guint        serial;     /* BlockData serial the layout was built from */
+    gchar        markup[MAX_BLOCK_SIZE];  /* text of the layout */
+    SampleSlotSize size;            /* reserved in the panel */
+    gint         width, height;     /* of the text last laid out */
+    gboolean     outdated;          /* drawn dimmed */
+} BlockSlot;
 
 /* plugin structure */
 typedef struct
@@ -61,28 +65,25 @@ typedef struct
     /* panel widgets */
     GtkWidget       *ebox;
     GtkWidget       *hvbox;
-    GtkWidget       *label;
-
-    /* Status bar data */
-    BlockData       blocks[BLOCK_COUNT];
-    pthread_mutex_t mutex;
-    
-    /* Update threads */
-    StatusThread    date_thread;
-    StatusThread    memory_thread;
-    StatusThread    weather_thread;
-    StatusThread    exchange_thread;
-    StatusThread    battery_thread;
-    
-    /* Settings */
-    gchar           *weather_location;    /* latitude,longitude */
-    gchar           *exchange_api_key;    /* OpenExchangeRates API key */
-    gint             update_interval;     /* Base update interval in seconds */
-    gboolean         show_weather;
-    gboolean         show_exchange;
-    gboolean         show_battery;
-    gboolean         show_memory;
-    gboolean         show_date;
+    GtkWidget       *label;               /* shown while no block has data */
+    BlockSlot        slots[SLOT_COUNT];
+    SampleAtlas     *atlas;
+    gulong           icon_theme_changed_id;
+    guint            n_resizes;           /* panel relayouts caused by the slots */
+    guint            n_size_changes;      /* those a relayout on every size change would make */
+    gint64           resizes_since;
+
+    /* Status bar data and the workers filling it */
+    BlockStore       store;
+    SampleScheduler *scheduler;
+    GSource         *redraw;              /* dispatches update_display after block changes */
+    SampleExport    *export;              /* the blocks for other programs, NULL if unavailable */
+    SampleHistory   *history;             /* past values behind the blocks, NULL if unavailable */
+    SampleBus       *bus;                 /* custom blocks pushed by other programs */
+    SampleCommands  *commands;            /* command blocks, NULL without a commands file */
+
+    /* Tooltips */
+    BlockTooltip    tooltips[BLOCK_COUNT];
 }
 SamplePlugin;
 
@@ -92,6 +93,10 @@ void
 sample_save (XfcePanelPlugin *plugin,
              SamplePlugin    *sample);
 
+void
+sample_apply_config (SamplePlugin *sample,
+                     SampleConfig *config);
+
 G_END_DECLS
 
 #endif /* !__SAMPLE_H__ */
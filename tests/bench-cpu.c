@@ -0,0 +1,66 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "sample-cpu.h"
+#include "sample-source.h"
+
+/* samples per run, about a day of one second ticks */
+#define BENCH_CPU_SAMPLES 100000
+
+/* One sampler over the recorded /proc/stat of a 256 core machine */
+static void
+bench_cpu_sample (gconstpointer user_data)
+{
+    CpuStat *stat;
+    gdouble  elapsed;
+    
+    sample_source_set_root(user_data);
+    stat = cpu_stat_new("/proc/stat");
+    g_assert_nonnull(stat);
+    cpu_stat_sample(stat);
+    g_assert_cmpint(cpu_stat_get_n_cores(stat), ==, 256);
+    
+    g_test_timer_start();
+    for (gint i = 0; i < BENCH_CPU_SAMPLES; i++)
+        cpu_stat_sample(stat);
+    elapsed = g_test_timer_elapsed();
+    
+    g_test_minimized_result(elapsed * G_USEC_PER_SEC / BENCH_CPU_SAMPLES,
+                            "%.2f µs per sample of 256 cores",
+                            elapsed * G_USEC_PER_SEC / BENCH_CPU_SAMPLES);
+    
+    cpu_stat_free(stat);
+    sample_source_set_root(NULL);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add_data_func("/cpu/sample-256", FIXTURE_DIR "/stat-256", bench_cpu_sample);
+    
+    return g_test_run();
+}
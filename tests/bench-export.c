@@ -0,0 +1,144 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sample-export.h"
+
+/* seconds of reading per run */
+#define BENCH_EXPORT_SECONDS 2.0
+
+/* reads between clock reads, keeps the clock out of the numbers */
+#define BENCH_EXPORT_BATCH   1024
+
+typedef struct {
+    gchar        *dir;
+    gchar        *path;
+    SampleExport *export;
+    gint          stop;
+    guint64       writes;
+} ExportFixture;
+
+static void
+export_fixture_set_up (ExportFixture *fixture,
+                       gconstpointer  user_data)
+{
+    BlockData first = { 0 };
+    
+    fixture->dir = g_dir_make_tmp("sample-export-XXXXXX", NULL);
+    g_assert_nonnull(fixture->dir);
+    fixture->path = g_build_filename(fixture->dir, "benchmark.blocks", NULL);
+    fixture->export = sample_export_new(fixture->path, NULL);
+    g_assert_nonnull(fixture->export);
+    
+    first.len = g_snprintf(first.data, sizeof(first.data), "0");
+    sample_export_write(fixture->export, BLOCK_MEMORY, &first);
+}
+
+static void
+export_fixture_tear_down (ExportFixture *fixture,
+                          gconstpointer  user_data)
+{
+    sample_export_free(fixture->export);
+    g_rmdir(fixture->dir);
+    g_free(fixture->path);
+    g_free(fixture->dir);
+}
+
+/* Rewrites the memory block as fast as it can, its text and its number
+ * always agree */
+static gpointer
+export_writer (gpointer data)
+{
+    ExportFixture *fixture = data;
+    BlockData block = { 0 };
+    
+    while (!g_atomic_int_get(&fixture->stop)) {
+        block.serial++;
+        block.raw.memory.available_kb = block.serial;
+        block.len = g_snprintf(block.data, sizeof(block.data), "%u", block.serial);
+        sample_export_write(fixture->export, BLOCK_MEMORY, &block);
+        fixture->writes++;
+    }
+    
+    return NULL;
+}
+
+/* Reads of one block with the writer idle, or with it rewriting that
+ * very block, which makes readers retry or even give up, but never see
+ * a torn copy */
+static void
+bench_export_read (ExportFixture *fixture,
+                   gconstpointer  user_data)
+{
+    gboolean concurrent = GPOINTER_TO_INT(user_data);
+    SampleExportReader *reader = sample_export_reader_open(fixture->path, NULL);
+    SampleExportBlock block;
+    GThread *thread = NULL;
+    guint64 reads = 0, given_up = 0, torn = 0;
+    gdouble elapsed;
+    
+    g_assert_nonnull(reader);
+    if (concurrent)
+        thread = g_thread_new("export-writer", export_writer, fixture);
+    
+    g_test_timer_start();
+    do {
+        for (gint i = 0; i < BENCH_EXPORT_BATCH; i++) {
+            if (!sample_export_reader_read(reader, BLOCK_MEMORY, &block))
+                given_up++;
+            else if (block.raw.memory.available_kb != strtoul(block.text, NULL, 10))
+                torn++;
+        }
+        reads += BENCH_EXPORT_BATCH;
+        elapsed = g_test_timer_elapsed();
+    } while (elapsed < BENCH_EXPORT_SECONDS);
+    
+    if (thread) {
+        g_atomic_int_set(&fixture->stop, 1);
+        g_thread_join(thread);
+    }
+    
+    g_test_message("%.0f reads/s, %.0f writes/s, %.2f%% retried, %" G_GUINT64_FORMAT " given up",
+                   reads / elapsed, fixture->writes / elapsed,
+                   100.0 * sample_export_reader_get_retries(reader) / reads, given_up);
+    g_test_minimized_result(elapsed * 1e9 / reads, "%.1f ns per read", elapsed * 1e9 / reads);
+    g_assert_cmpuint(torn, ==, 0);
+    
+    sample_export_reader_close(reader);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add("/export/idle-writer", ExportFixture, GINT_TO_POINTER(FALSE),
+               export_fixture_set_up, bench_export_read, export_fixture_tear_down);
+    g_test_add("/export/concurrent-writer", ExportFixture, GINT_TO_POINTER(TRUE),
+               export_fixture_set_up, bench_export_read, export_fixture_tear_down);
+    
+    return g_test_run();
+}
@@ -0,0 +1,211 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sample-procs.h"
+#include "sample-source.h"
+
+/* processes in the tree, the recorded table is repeated up to this */
+#define BENCH_PROCS_TARGET 5000
+
+/* rescans per run, about 10 minutes of an open tooltip */
+#define BENCH_PROCS_SCANS  200
+
+/* above any real pid, so repeated rows never collide */
+#define BENCH_PROCS_STRIDE (1 << 22)
+
+typedef struct {
+    gint   pid;
+    gchar  statm[128];
+    gulong pss_kb;
+    gchar  comm[PROC_NAME_SIZE];
+} ProcRow;
+
+typedef struct {
+    gchar  *root;
+    GArray *rows;       /* ProcRow, as recorded */
+    guint   n_copies;
+} ProcsFixture;
+
+static GArray *
+read_table (const gchar *path)
+{
+    GArray *rows = g_array_new(FALSE, TRUE, sizeof(ProcRow));
+    gchar *contents = NULL;
+    gchar **lines;
+    
+    g_assert_true(g_file_get_contents(path, &contents, NULL, NULL));
+    lines = g_strsplit(contents, "\n", -1);
+    for (gint i = 0; lines[i]; i++) {
+        guint statm[7];
+        ProcRow row = { 0 };
+        gint end = 0;
+        
+        if (lines[i][0] == '#' || lines[i][0] == '\0')
+            continue;
+        g_assert_cmpint(sscanf(lines[i], "%d %u %u %u %u %u %u %u %lu %n", &row.pid,
+                               &statm[0], &statm[1], &statm[2], &statm[3], &statm[4],
+                               &statm[5], &statm[6], &row.pss_kb, &end), ==, 9);
+        g_snprintf(row.statm, sizeof(row.statm), "%u %u %u %u %u %u %u\n",
+                   statm[0], statm[1], statm[2], statm[3], statm[4], statm[5], statm[6]);
+        g_strlcpy(row.comm, lines[i] + end, sizeof(row.comm));
+        g_array_append_val(rows, row);
+    }
+    g_strfreev(lines);
+    g_free(contents);
+    
+    return rows;
+}
+
+/* The files of one process under the root, or their removal */
+static void
+procs_fixture_process (ProcsFixture *fixture, const ProcRow *row, gint pid, gboolean create)
+{
+    gchar *dir = g_strdup_printf("%s/proc/%d", fixture->root, pid);
+    gchar *statm = g_build_filename(dir, "statm", NULL);
+    gchar *comm = g_build_filename(dir, "comm", NULL);
+    gchar *rollup = g_build_filename(dir, "smaps_rollup", NULL);
+    
+    if (create) {
+        gchar *text;
+        
+        g_assert_cmpint(g_mkdir_with_parents(dir, 0700), ==, 0);
+        g_assert_true(g_file_set_contents(statm, row->statm, -1, NULL));
+        text = g_strdup_printf("%s\n", row->comm);
+        g_assert_true(g_file_set_contents(comm, text, -1, NULL));
+        g_free(text);
+        
+        /* like a kernel thread or a process of another user otherwise */
+        if (row->pss_kb > 0) {
+            text = g_strdup_printf("00400000-7fffffffffff ---p 00000000 00:00 0 [rollup]\n"
+                                   "Rss: 0 kB\nPss: %lu kB\n", row->pss_kb);
+            g_assert_true(g_file_set_contents(rollup, text, -1, NULL));
+            g_free(text);
+        }
+    } else {
+        g_unlink(rollup);
+        g_unlink(comm);
+        g_unlink(statm);
+        g_rmdir(dir);
+    }
+    
+    g_free(rollup);
+    g_free(comm);
+    g_free(statm);
+    g_free(dir);
+}
+
+static void
+procs_fixture_set_up (ProcsFixture  *fixture,
+                      gconstpointer  user_data)
+{
+    fixture->root = g_dir_make_tmp("sample-procs-XXXXXX", NULL);
+    g_assert_nonnull(fixture->root);
+    fixture->rows = read_table(user_data);
+    g_assert_cmpuint(fixture->rows->len, >, 0);
+    fixture->n_copies = (BENCH_PROCS_TARGET + fixture->rows->len - 1) / fixture->rows->len;
+    
+    for (guint copy = 0; copy < fixture->n_copies; copy++) {
+        for (guint i = 0; i < fixture->rows->len; i++) {
+            const ProcRow *row = &g_array_index(fixture->rows, ProcRow, i);
+            
+            procs_fixture_process(fixture, row, row->pid + copy * BENCH_PROCS_STRIDE, TRUE);
+        }
+    }
+    
+    sample_source_set_root(fixture->root);
+}
+
+static void
+procs_fixture_tear_down (ProcsFixture  *fixture,
+                         gconstpointer  user_data)
+{
+    gchar *proc = g_build_filename(fixture->root, "proc", NULL);
+    
+    sample_source_set_root(NULL);
+    for (guint copy = 0; copy < fixture->n_copies; copy++) {
+        for (guint i = 0; i < fixture->rows->len; i++) {
+            const ProcRow *row = &g_array_index(fixture->rows, ProcRow, i);
+            
+            procs_fixture_process(fixture, row, row->pid + copy * BENCH_PROCS_STRIDE, FALSE);
+        }
+    }
+    g_rmdir(proc);
+    g_rmdir(fixture->root);
+    g_free(proc);
+    g_array_unref(fixture->rows);
+    g_free(fixture->root);
+}
+
+/* The first scan opens every statm, later ones re-read the kept
+ * descriptors and skip the kernel threads. The tree is on a regular file
+ * system, where reads cost less than generating /proc contents, so the
+ * numbers are a floor for a machine with this many processes. */
+static void
+bench_procs_scan (ProcsFixture  *fixture,
+                  gconstpointer  user_data)
+{
+    guint n_procs = fixture->rows->len * fixture->n_copies;
+    ProcUsage top[PROC_TOP_MAX];
+    ProcStat *stat;
+    gdouble first, elapsed;
+    gint n_top;
+    
+    stat = proc_stat_new("/proc");
+    g_assert_nonnull(stat);
+    
+    g_test_timer_start();
+    n_top = proc_stat_scan(stat, top, PROC_TOP_MAX);
+    first = g_test_timer_elapsed();
+    g_assert_cmpint(n_top, ==, PROC_TOP_MAX);
+    g_assert_cmpuint(proc_stat_get_n_procs(stat), ==, n_procs);
+    for (gint i = 1; i < n_top; i++)
+        g_assert_cmpuint(top[i - 1].rss_kb, >=, top[i].rss_kb);
+    
+    g_test_timer_start();
+    for (gint i = 0; i < BENCH_PROCS_SCANS; i++)
+        g_assert_cmpint(proc_stat_scan(stat, top, PROC_TOP_MAX), ==, PROC_TOP_MAX);
+    elapsed = g_test_timer_elapsed();
+    g_assert_cmpuint(proc_stat_get_n_procs(stat), ==, n_procs);
+    
+    g_test_message("first scan of %u processes: %.2f ms", n_procs, first * 1000.0);
+    g_test_minimized_result(elapsed * 1000.0 / BENCH_PROCS_SCANS,
+                            "%.2f ms per rescan of %u processes",
+                            elapsed * 1000.0 / BENCH_PROCS_SCANS, n_procs);
+    
+    proc_stat_free(stat);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add("/procs/scan", ProcsFixture, FIXTURE_DIR "/procs/table",
+               procs_fixture_set_up, bench_procs_scan, procs_fixture_tear_down);
+    
+    return g_test_run();
+}
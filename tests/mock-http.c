@@ -0,0 +1,335 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gio/gio.h>
+
+#include "mock-http.h"
+
+typedef struct {
+    guint   status;
+    GBytes *body;
+    gint64  delay;
+    guint   requests;
+    gchar  *query;
+} MockRoute;
+
+struct _MockHttp {
+    GThread        *thread;
+    GMainContext   *context;
+    GMainLoop      *loop;
+    guint16         port;
+    
+    GMutex          lock;
+    GCond           cond;
+    gboolean        ready;
+    guint           active;     /* connections being answered */
+    GHashTable     *routes;     /* path -> MockRoute */
+    gsize           chunk_size;
+    gint64          chunk_delay;
+};
+
+static void
+mock_route_free (gpointer data)
+{
+    MockRoute *route = data;
+    
+    g_bytes_unref(route->body);
+    g_free(route->query);
+    g_free(route);
+}
+
+static void
+mock_http_write (GOutputStream *output, const gchar *data, gsize length)
+{
+    g_output_stream_write_all(output, data, length, NULL, NULL, NULL);
+    g_output_stream_flush(output, NULL, NULL);
+}
+
+/* Runs in a thread of the service's pool, one per connection */
+static gboolean
+mock_http_run (GThreadedSocketService *service,
+               GSocketConnection      *connection,
+               GObject                *source_object,
+               gpointer                user_data)
+{
+    MockHttp *mock = user_data;
+    GInputStream *input = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+    GOutputStream *output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    GDataInputStream *lines = g_data_input_stream_new(input);
+    gchar *request, *header, *path = NULL, *query;
+    guint status = 404;
+    GBytes *body = NULL;
+    gint64 delay = 0;
+    gsize chunk_size;
+    gint64 chunk_delay;
+    gchar *head;
+    
+    g_filter_input_stream_set_close_base_stream(G_FILTER_INPUT_STREAM(lines), FALSE);
+    
+    /* "GET /path?query HTTP/1.1", then headers up to an empty line */
+    request = g_data_input_stream_read_line(lines, NULL, NULL, NULL);
+    if (request) {
+        gchar **parts = g_strsplit(g_strchomp(request), " ", 3);
+        
+        if (parts[0] && parts[1])
+            path = g_strdup(parts[1]);
+        g_strfreev(parts);
+    }
+    while ((header = g_data_input_stream_read_line(lines, NULL, NULL, NULL))) {
+        gboolean end = *g_strchomp(header) == '\0';
+        
+        g_free(header);
+        if (end)
+            break;
+    }
+    
+    query = path ? strchr(path, '?') : NULL;
+    if (query)
+        *query++ = '\0';
+    
+    g_mutex_lock(&mock->lock);
+    if (path) {
+        MockRoute *route = g_hash_table_lookup(mock->routes, path);
+        
+        if (route) {
+            status = route->status;
+            body = g_bytes_ref(route->body);
+            delay = route->delay;
+            route->requests++;
+            g_free(route->query);
+            route->query = g_strdup(query ? query : "");
+        }
+    }
+    chunk_size = mock->chunk_size;
+    chunk_delay = mock->chunk_delay;
+    g_mutex_unlock(&mock->lock);
+    
+    if (delay > 0)
+        g_usleep(delay);
+    
+    head = g_strdup_printf("HTTP/1.1 %u %s\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+                           "Connection: close\r\n"
+                           "\r\n",
+                           status, status == 200 ? "OK" : "Error",
+                           body ? g_bytes_get_size(body) : 0);
+    mock_http_write(output, head, strlen(head));
+    g_free(head);
+    
+    if (body) {
+        gsize length;
+        const gchar *data = g_bytes_get_data(body, &length);
+        
+        for (gsize offset = 0; offset < length; offset += chunk_size) {
+            if (offset > 0 && chunk_delay > 0)
+                g_usleep(chunk_delay);
+            mock_http_write(output, data + offset, MIN(chunk_size, length - offset));
+        }
+        g_bytes_unref(body);
+    }
+    
+    g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+    g_object_unref(lines);
+    g_free(request);
+    g_free(path);
+    
+    g_mutex_lock(&mock->lock);
+    mock->active--;
+    g_cond_broadcast(&mock->cond);
+    g_mutex_unlock(&mock->lock);
+    
+    return TRUE;
+}
+
+/* Counted on the listening thread, before the pool picks it up */
+static gboolean
+mock_http_incoming (GSocketService    *service,
+                    GSocketConnection *connection,
+                    GObject           *source_object,
+                    gpointer           user_data)
+{
+    MockHttp *mock = user_data;
+    
+    g_mutex_lock(&mock->lock);
+    mock->active++;
+    g_mutex_unlock(&mock->lock);
+    
+    return FALSE;
+}
+
+static gpointer
+mock_http_thread (gpointer data)
+{
+    MockHttp *mock = data;
+    GSocketService *service;
+    GSocketAddress *address;
+    GSocketAddress *effective = NULL;
+    GError *error = NULL;
+    
+    /* the service accepts from the context that is current when it starts */
+    g_main_context_push_thread_default(mock->context);
+    
+    service = g_threaded_socket_service_new(8);
+    address = g_inet_socket_address_new_from_string("127.0.0.1", 0);
+    g_socket_listener_add_address(G_SOCKET_LISTENER(service), address, G_SOCKET_TYPE_STREAM,
+                                  G_SOCKET_PROTOCOL_TCP, NULL, &effective, &error);
+    g_assert_no_error(error);
+    g_object_unref(address);
+    
+    g_signal_connect(service, "incoming", G_CALLBACK(mock_http_incoming), mock);
+    g_signal_connect(service, "run", G_CALLBACK(mock_http_run), mock);
+    g_socket_service_start(service);
+    
+    g_mutex_lock(&mock->lock);
+    mock->port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(effective));
+    mock->ready = TRUE;
+    g_cond_broadcast(&mock->cond);
+    g_mutex_unlock(&mock->lock);
+    g_object_unref(effective);
+    
+    g_main_loop_run(mock->loop);
+    
+    g_socket_service_stop(service);
+    g_socket_listener_close(G_SOCKET_LISTENER(service));
+    g_object_unref(service);
+    
+    g_main_context_pop_thread_default(mock->context);
+    
+    return NULL;
+}
+
+MockHttp *
+mock_http_new (void)
+{
+    MockHttp *mock = g_new0(MockHttp, 1);
+    
+    g_mutex_init(&mock->lock);
+    g_cond_init(&mock->cond);
+    mock->routes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, mock_route_free);
+    mock->chunk_size = 1024;
+    mock->context = g_main_context_new();
+    mock->loop = g_main_loop_new(mock->context, FALSE);
+    mock->thread = g_thread_new("mock-http", mock_http_thread, mock);
+    
+    g_mutex_lock(&mock->lock);
+    while (!mock->ready)
+        g_cond_wait(&mock->cond, &mock->lock);
+    g_mutex_unlock(&mock->lock);
+    
+    return mock;
+}
+
+static gboolean
+mock_http_quit (gpointer data)
+{
+    g_main_loop_quit(data);
+    
+    return G_SOURCE_REMOVE;
+}
+
+void
+mock_http_free (MockHttp *mock)
+{
+    g_main_context_invoke(mock->context, mock_http_quit, mock->loop);
+    g_thread_join(mock->thread);
+    
+    /* answers still being written hold on to the routes */
+    g_mutex_lock(&mock->lock);
+    while (mock->active > 0)
+        g_cond_wait(&mock->cond, &mock->lock);
+    g_mutex_unlock(&mock->lock);
+    
+    g_main_loop_unref(mock->loop);
+    g_main_context_unref(mock->context);
+    g_hash_table_destroy(mock->routes);
+    g_cond_clear(&mock->cond);
+    g_mutex_clear(&mock->lock);
+    g_free(mock);
+}
+
+gchar *
+mock_http_get_url (MockHttp *mock, const gchar *path)
+{
+    return g_strdup_printf("http://127.0.0.1:%u%s", mock->port, path);
+}
+
+void
+mock_http_route (MockHttp    *mock,
+                 const gchar *path,
+                 guint        status,
+                 const gchar *body,
+                 gint64       delay)
+{
+    MockRoute *route = g_new0(MockRoute, 1);
+    
+    route->status = status;
+    route->body = g_bytes_new(body ? body : "", body ? strlen(body) : 0);
+    route->delay = delay;
+    
+    g_mutex_lock(&mock->lock);
+    g_hash_table_replace(mock->routes, g_strdup(path), route);
+    g_mutex_unlock(&mock->lock);
+}
+
+void
+mock_http_set_chunking (MockHttp *mock, gsize chunk_size, gint64 chunk_delay)
+{
+    g_return_if_fail(chunk_size > 0);
+    
+    g_mutex_lock(&mock->lock);
+    mock->chunk_size = chunk_size;
+    mock->chunk_delay = chunk_delay;
+    g_mutex_unlock(&mock->lock);
+}
+
+guint
+mock_http_get_requests (MockHttp *mock, const gchar *path)
+{
+    MockRoute *route;
+    guint requests;
+    
+    g_mutex_lock(&mock->lock);
+    route = g_hash_table_lookup(mock->routes, path);
+    requests = route ? route->requests : 0;
+    g_mutex_unlock(&mock->lock);
+    
+    return requests;
+}
+
+gchar *
+mock_http_get_query (MockHttp *mock, const gchar *path)
+{
+    MockRoute *route;
+    gchar *query;
+    
+    g_mutex_lock(&mock->lock);
+    route = g_hash_table_lookup(mock->routes, path);
+    query = route ? g_strdup(route->query) : NULL;
+    g_mutex_unlock(&mock->lock);
+    
+    return query;
+}
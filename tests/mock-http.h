@@ -0,0 +1,64 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __MOCK_HTTP_H__
+#define __MOCK_HTTP_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A loopback HTTP/1.1 server for the remote providers, answering from
+ * its own thread so the providers can block on it. Each path has a
+ * canned answer; the body is written in small pieces to exercise the
+ * reassembly on the client side. */
+typedef struct _MockHttp MockHttp;
+
+MockHttp *mock_http_new          (void);
+
+void      mock_http_free         (MockHttp    *mock);
+
+/* "http://127.0.0.1:port/path", free with g_free() */
+gchar    *mock_http_get_url      (MockHttp    *mock,
+                                  const gchar *path);
+
+/* Answer requests for @path with @status and @body after @delay
+ * microseconds. Unknown paths get a 404. */
+void      mock_http_route        (MockHttp    *mock,
+                                  const gchar *path,
+                                  guint        status,
+                                  const gchar *body,
+                                  gint64       delay);
+
+/* Write bodies @chunk_size bytes at a time, @chunk_delay microseconds
+ * apart; 1024 bytes and no delay by default */
+void      mock_http_set_chunking (MockHttp    *mock,
+                                  gsize        chunk_size,
+                                  gint64       chunk_delay);
+
+guint     mock_http_get_requests (MockHttp    *mock,
+                                  const gchar *path);
+
+/* Query string of the last request for @path, NULL before the first */
+gchar    *mock_http_get_query    (MockHttp    *mock,
+                                  const gchar *path);
+
+G_END_DECLS
+
+#endif /* !__MOCK_HTTP_H__ */
@@ -0,0 +1,272 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Allocations made by the provider workers once they have settled.
+ * malloc and friends are interposed for the whole test and counted per
+ * thread name, the workers being named after their provider. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <glib.h>
+
+#include "sample-blocks.h"
+#include "sample-clock.h"
+#include "sample-providers.h"
+#include "sample-scheduler.h"
+#include "sample-source.h"
+
+#define HOUR        (G_GINT64_CONSTANT(3600) * G_USEC_PER_SEC)
+
+/* Monday 2 March 2026, 00:00:00 UTC */
+#define ALLOC_START (G_GINT64_CONSTANT(1772409600) * G_USEC_PER_SEC)
+
+/* thread names are at most 15 bytes on Linux */
+#define THREAD_NAME_SIZE 16
+#define ALLOC_MAX_COUNTERS 8
+
+/* updates of the same broken text counted after the first one */
+#define MARKUP_REPEATS 1000
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *mem, size_t size);
+extern void *__libc_memalign (size_t alignment, size_t size);
+
+typedef struct {
+    gchar name[THREAD_NAME_SIZE];
+    gint  count;
+} AllocCounter;
+
+static AllocCounter counters[ALLOC_MAX_COUNTERS];
+static gint n_counters;
+static gint counting;
+
+/* Called on every allocation, it must not allocate itself */
+static void
+alloc_count (void)
+{
+    gchar name[THREAD_NAME_SIZE] = { 0 };
+    
+    if (!g_atomic_int_get(&counting) || prctl(PR_GET_NAME, name, 0, 0, 0) != 0)
+        return;
+    
+    for (gint i = 0; i < n_counters; i++) {
+        if (strcmp(counters[i].name, name) == 0) {
+            g_atomic_int_inc(&counters[i].count);
+            break;
+        }
+    }
+}
+
+void *
+malloc (size_t size)
+{
+    alloc_count();
+    return __libc_malloc(size);
+}
+
+void *
+calloc (size_t n_members, size_t size)
+{
+    alloc_count();
+    return __libc_calloc(n_members, size);
+}
+
+void *
+realloc (void *mem, size_t size)
+{
+    alloc_count();
+    return __libc_realloc(mem, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+    alloc_count();
+    return __libc_memalign(alignment, size);
+}
+
+void *
+aligned_alloc (size_t alignment, size_t size)
+{
+    alloc_count();
+    return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign (void **mem, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    
+    alloc_count();
+    *mem = __libc_memalign(alignment, size);
+    
+    return *mem ? 0 : ENOMEM;
+}
+
+/* Starts counting the allocations of the threads named so far */
+static void
+alloc_count_start (void)
+{
+    for (gint i = 0; i < n_counters; i++)
+        counters[i].count = 0;
+    g_atomic_int_set(&counting, TRUE);
+}
+
+static void
+alloc_count_stop (void)
+{
+    g_atomic_int_set(&counting, FALSE);
+}
+
+/* Index of the counter for @name, added if it is new */
+static gint
+alloc_counter (const gchar *name)
+{
+    for (gint i = 0; i < n_counters; i++) {
+        if (strcmp(counters[i].name, name) == 0)
+            return i;
+    }
+    
+    g_assert_cmpint(n_counters, <, ALLOC_MAX_COUNTERS);
+    g_strlcpy(counters[n_counters].name, name, THREAD_NAME_SIZE);
+    
+    return n_counters++;
+}
+
+static guint
+block_serial (BlockStore *store, BlockId block_id)
+{
+    guint serial;
+    
+    pthread_mutex_lock(&store->mutex);
+    serial = store->blocks[block_id].serial;
+    pthread_mutex_unlock(&store->mutex);
+    
+    return serial;
+}
+
+/* An hour of ticks of each local provider over the laptop fixture, after
+ * an hour for buffers, time zone data and thread locals to settle */
+static void
+test_alloc_providers (void)
+{
+    static const BlockId blocks[] = { BLOCK_DATE, BLOCK_MEMORY, BLOCK_CPU, BLOCK_BATTERY };
+    SampleConfig *config = sample_config_new();
+    SampleScheduler *scheduler;
+    BlockStore store;
+    guint before[G_N_ELEMENTS(blocks)];
+    gint counter[G_N_ELEMENTS(blocks)];
+    guint n_workers = 0;
+    
+    config->show_date = TRUE;
+    config->show_memory = TRUE;
+    config->show_cpu = TRUE;
+    config->show_battery = TRUE;
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++) {
+        counter[i] = alloc_counter(sample_provider_get(blocks[i])->name);
+        if (sample_provider_wanted(config, blocks[i]))
+            n_workers++;
+    }
+    
+    block_store_init(&store, NULL, NULL);
+    scheduler = sample_scheduler_new(&store, config);
+    sample_clock_settle(n_workers);
+    sample_clock_advance(HOUR);
+    
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++)
+        before[i] = block_serial(&store, blocks[i]);
+    
+    alloc_count_start();
+    sample_clock_advance(HOUR);
+    alloc_count_stop();
+    
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++) {
+        guint ticks = block_serial(&store, blocks[i]) - before[i];
+        
+        if (!sample_provider_available(blocks[i]))
+            continue;
+        g_test_message("%s: %u ticks, %d allocations", block_get_name(blocks[i]),
+                       ticks, counters[counter[i]].count);
+        g_assert_cmpuint(ticks, >, 0);
+        g_assert_cmpint(counters[counter[i]].count, ==, 0);
+    }
+    
+    sample_scheduler_free(scheduler);
+    block_store_clear(&store);
+}
+
+/* A provider producing broken markup warns once, then stores the escaped
+ * text on every tick without allocating */
+static void
+test_alloc_invalid_markup (void)
+{
+    static const gchar broken[] = "<span color='#10bbbb'>eth0 \xff ↓1K";
+    gchar name[THREAD_NAME_SIZE] = { 0 };
+    BlockStore store;
+    gint counter;
+    
+    g_assert_cmpint(prctl(PR_GET_NAME, name, 0, 0, 0), ==, 0);
+    counter = alloc_counter(name);
+    block_store_init(&store, NULL, NULL);
+    
+    g_test_expect_message("xfce4-sample-plugin", G_LOG_LEVEL_WARNING, "Invalid markup in block*");
+    block_store_update(&store, BLOCK_NETWORK, broken, NULL);
+    g_test_assert_expected_messages();
+    g_assert_true(g_str_has_prefix(store.blocks[BLOCK_NETWORK].data, "&lt;span color=&apos;#10bbbb&apos;&gt;eth0 \xef\xbf\xbd"));
+    
+    /* a further warning would abort the test */
+    alloc_count_start();
+    for (gint i = 0; i < MARKUP_REPEATS; i++)
+        block_store_update(&store, BLOCK_NETWORK, broken, NULL);
+    alloc_count_stop();
+    g_assert_cmpint(counters[counter].count, ==, 0);
+    
+    /* a different broken text is worth another warning */
+    g_test_expect_message("xfce4-sample-plugin", G_LOG_LEVEL_WARNING, "Invalid markup in block*");
+    block_store_update(&store, BLOCK_NETWORK, "<b>eth1", NULL);
+    g_test_assert_expected_messages();
+    
+    block_store_clear(&store);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    /* before any worker runs; also keeps the power source on AC */
+    sample_source_set_root(FIXTURE_DIR "/laptop");
+    sample_clock_set_virtual(ALLOC_START);
+    
+    g_test_add_func("/alloc/providers", test_alloc_providers);
+    g_test_add_func("/alloc/invalid-markup", test_alloc_invalid_markup);
+    
+    return g_test_run();
+}
@@ -0,0 +1,147 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+
+#include "sample-blocks.h"
+
+/* Stores @text in a fresh store and checks what a front end would get */
+static gchar *
+store_text (const gchar *text)
+{
+    BlockStore store;
+    gchar *stored;
+    
+    block_store_init(&store, NULL, NULL);
+    block_store_update(&store, BLOCK_NETWORK, text, NULL);
+    stored = g_strndup(store.blocks[BLOCK_NETWORK].data, store.blocks[BLOCK_NETWORK].len);
+    g_assert_cmpint(strlen(stored), ==, store.blocks[BLOCK_NETWORK].len);
+    g_assert_cmpint(store.blocks[BLOCK_NETWORK].len, <, MAX_BLOCK_SIZE);
+    g_assert_true(g_utf8_validate(stored, -1, NULL));
+    g_assert_true(block_markup_valid(stored, strlen(stored)));
+    block_store_clear(&store);
+    
+    return stored;
+}
+
+static void
+test_blocks_fits (void)
+{
+    gchar *stored = store_text("<b>eth0</b> ↓12K ↑3K");
+    
+    g_assert_cmpstr(stored, ==, "<b>eth0</b> ↓12K ↑3K");
+    g_free(stored);
+}
+
+static void
+test_blocks_long_ascii (void)
+{
+    gchar *text = g_strnfill(400, 'x');
+    gchar *stored = store_text(text);
+    
+    g_assert_cmpint(strlen(stored), ==, MAX_BLOCK_SIZE - 1);
+    g_free(stored);
+    g_free(text);
+}
+
+/* A three byte character across the limit is left out whole */
+static void
+test_blocks_long_utf8 (void)
+{
+    GString *text = g_string_new(NULL);
+    gchar *stored;
+    
+    g_string_append(text, "ab");
+    while (text->len < 2 * MAX_BLOCK_SIZE)
+        g_string_append(text, "↓");
+    stored = store_text(text->str);
+    
+    g_assert_cmpint(strlen(stored), ==, 2 + (MAX_BLOCK_SIZE - 3) / 3 * 3);
+    g_free(stored);
+    g_string_free(text, TRUE);
+}
+
+/* Cut in the middle of a tag, the rest of the markup is kept */
+static void
+test_blocks_long_tag (void)
+{
+    GString *text = g_string_new(NULL);
+    gchar *stored;
+    
+    while (text->len < MAX_BLOCK_SIZE - 8)
+        g_string_append_c(text, 'x');
+    g_string_append(text, "<span foreground='red'>y</span>");
+    stored = store_text(text->str);
+    
+    g_assert_cmpint(strlen(stored), ==, MAX_BLOCK_SIZE - 8);
+    g_assert_null(strchr(stored, '<'));
+    g_free(stored);
+    g_string_free(text, TRUE);
+}
+
+/* Cut in an entity of text that had to be escaped */
+static void
+test_blocks_long_entity (void)
+{
+    GString *text = g_string_new("<b>");
+    gchar *stored;
+    
+    while (text->len < MAX_BLOCK_SIZE)
+        g_string_append(text, "a&");
+    stored = store_text(text->str);
+    
+    g_assert_true(g_str_has_prefix(stored, "&lt;b&gt;a&amp;"));
+    g_assert_true(g_str_has_suffix(stored, ";") || g_str_has_suffix(stored, "a"));
+    g_free(stored);
+    g_string_free(text, TRUE);
+}
+
+static void
+test_blocks_invalid_utf8 (void)
+{
+    gchar *stored = store_text("eth0 \xff\xfe ↓1K");
+    
+    g_assert_true(g_str_has_prefix(stored, "eth0 "));
+    g_assert_true(g_str_has_suffix(stored, " ↓1K"));
+    g_free(stored);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    /* the store warns about the invalid markup these tests feed it */
+    g_log_set_always_fatal(G_LOG_FATAL_MASK | G_LOG_LEVEL_CRITICAL);
+    
+    g_test_add_func("/blocks/fits", test_blocks_fits);
+    g_test_add_func("/blocks/long-ascii", test_blocks_long_ascii);
+    g_test_add_func("/blocks/long-utf8", test_blocks_long_utf8);
+    g_test_add_func("/blocks/long-tag", test_blocks_long_tag);
+    g_test_add_func("/blocks/long-entity", test_blocks_long_entity);
+    g_test_add_func("/blocks/invalid-utf8", test_blocks_invalid_utf8);
+    
+    return g_test_run();
+}
@@ -0,0 +1,468 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gio/gio.h>
+
+#include "sample-bus.h"
+
+/* Private to sample-bus.c */
+#define BUS_CLIENT_RATE  2.0
+#define BUS_CLIENT_BURST 5.0
+#define BUS_TOTAL_RATE   10.0
+#define BUS_TOTAL_BURST  10.0
+
+/* how long the senders below keep at it */
+#define BUS_FLOOD_TIME   G_USEC_PER_SEC
+
+typedef struct {
+    GTestDBus       *dbus;
+    GDBusConnection *client;    /* a sender of its own, apart from the bus */
+    SampleBus       *bus;
+    guint            changes;   /* applied changes, from the notify */
+} BusFixture;
+
+static void
+count_change (gpointer user_data)
+{
+    BusFixture *fixture = user_data;
+    
+    fixture->changes++;
+}
+
+/* Stands in for the Pango check of the panel */
+static gboolean
+reject_blink (const gchar *markup, GError **error)
+{
+    if (!strstr(markup, "<blink"))
+        return TRUE;
+    
+    g_set_error_literal(error, G_MARKUP_ERROR, G_MARKUP_ERROR_UNKNOWN_ELEMENT, "Unknown tag 'blink'");
+    
+    return FALSE;
+}
+
+static void
+name_appeared (GDBusConnection *connection,
+               const gchar     *name,
+               const gchar     *name_owner,
+               gpointer         user_data)
+{
+    *(gboolean *) user_data = TRUE;
+}
+
+static void
+call_done (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+    *(GAsyncResult **) user_data = g_object_ref(result);
+}
+
+/* The bus answers from this thread's main context, so a blocking call
+ * would never get its reply */
+static GVariant *
+bus_call_on (GDBusConnection  *connection,
+             const gchar      *method,
+             GVariant         *parameters,
+             GError          **error)
+{
+    GAsyncResult *result = NULL;
+    GVariant *reply;
+    
+    g_dbus_connection_call(connection, SAMPLE_BUS_NAME, SAMPLE_BUS_PATH, SAMPLE_BUS_INTERFACE,
+                           method, parameters, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+                           call_done, &result);
+    while (!result)
+        g_main_context_iteration(NULL, TRUE);
+    reply = g_dbus_connection_call_finish(connection, result, error);
+    g_object_unref(result);
+    
+    return reply;
+}
+
+static GVariant *
+bus_call (BusFixture   *fixture,
+          const gchar  *method,
+          GVariant     *parameters,
+          GError      **error)
+{
+    return bus_call_on(fixture->client, method, parameters, error);
+}
+
+static gboolean
+bus_set_on (GDBusConnection *connection, const gchar *name, const gchar *markup, GError **error)
+{
+    GVariant *reply = bus_call_on(connection, "Set", g_variant_new("(ss)", name, markup), error);
+    
+    if (reply)
+        g_variant_unref(reply);
+    
+    return reply != NULL;
+}
+
+static gboolean
+bus_set (BusFixture *fixture, const gchar *name, const gchar *markup, GError **error)
+{
+    return bus_set_on(fixture->client, name, markup, error);
+}
+
+static gboolean
+bus_remove (BusFixture *fixture, const gchar *name, GError **error)
+{
+    GVariant *reply = bus_call(fixture, "Remove", g_variant_new("(s)", name), error);
+    
+    if (reply)
+        g_variant_unref(reply);
+    
+    return reply != NULL;
+}
+
+/* The names List returns, joined by commas */
+static gchar *
+bus_list (BusFixture *fixture)
+{
+    GVariant *reply = bus_call(fixture, "List", NULL, NULL);
+    const gchar **names;
+    gchar *joined;
+    
+    g_assert_nonnull(reply);
+    g_variant_get(reply, "(^a&s)", &names);
+    joined = g_strjoinv(",", (gchar **) names);
+    g_free(names);
+    g_variant_unref(reply);
+    
+    return joined;
+}
+
+/* Changes beyond a sender's budget are applied later */
+static void
+wait_for_changes (BusFixture *fixture, guint changes)
+{
+    while (fixture->changes < changes)
+        g_main_context_iteration(NULL, TRUE);
+}
+
+/* Another sender, as a second client or one run of gdbus call would be */
+static GDBusConnection *
+bus_connect (BusFixture *fixture)
+{
+    GError *error = NULL;
+    GDBusConnection *connection =
+        g_dbus_connection_new_for_address_sync(g_test_dbus_get_bus_address(fixture->dbus),
+                                               G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+                                               | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                               NULL, NULL, &error);
+    
+    g_assert_no_error(error);
+    
+    return connection;
+}
+
+static void
+bus_disconnect (GDBusConnection *connection)
+{
+    g_dbus_connection_close_sync(connection, NULL, NULL);
+    g_object_unref(connection);
+}
+
+static gboolean
+all_slots_shown (BusFixture *fixture)
+{
+    for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+        if (!sample_bus_get_block(fixture->bus, i))
+            return FALSE;
+    }
+    
+    return TRUE;
+}
+
+static const SampleBusBlock *
+find_block (BusFixture *fixture, const gchar *name)
+{
+    for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+        const SampleBusBlock *block = sample_bus_get_block(fixture->bus, i);
+        
+        if (block && strcmp(block->name, name) == 0)
+            return block;
+    }
+    
+    return NULL;
+}
+
+/* Waits until block @name shows @text, which may take the budget of its
+ * sender to refill; returns the seconds since @start */
+static gdouble
+wait_for_text (BusFixture *fixture, const gchar *name, const gchar *text, gint64 start)
+{
+    const SampleBusBlock *block;
+    
+    while (!(block = find_block(fixture, name)) || strcmp(block->text, text) != 0)
+        g_main_context_iteration(NULL, TRUE);
+    
+    return (g_get_monotonic_time() - start) / (gdouble) G_USEC_PER_SEC;
+}
+
+static void
+bus_fixture_set_up (BusFixture    *fixture,
+                    gconstpointer  user_data)
+{
+    gboolean appeared = FALSE;
+    guint watch_id;
+    
+    /* a private dbus-daemon, $DBUS_SESSION_BUS_ADDRESS points to it */
+    fixture->dbus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(fixture->dbus);
+    
+    fixture->bus = sample_bus_new(SAMPLE_BUS_NAME, reject_blink, count_change, fixture);
+    fixture->client = bus_connect(fixture);
+    
+    /* the object is registered before the name is taken */
+    watch_id = g_bus_watch_name_on_connection(fixture->client, SAMPLE_BUS_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                              name_appeared, NULL, &appeared, NULL);
+    while (!appeared)
+        g_main_context_iteration(NULL, TRUE);
+    g_bus_unwatch_name(watch_id);
+}
+
+static void
+bus_fixture_tear_down (BusFixture    *fixture,
+                       gconstpointer  user_data)
+{
+    sample_bus_free(fixture->bus);
+    bus_disconnect(fixture->client);
+    
+    /* let the session connection go before the daemon does */
+    while (g_main_context_iteration(NULL, FALSE));
+    g_test_dbus_down(fixture->dbus);
+    g_object_unref(fixture->dbus);
+}
+
+static void
+test_bus_add_update_remove (BusFixture    *fixture,
+                            gconstpointer  user_data)
+{
+    GError *error = NULL;
+    gchar *names;
+    
+    g_assert_true(bus_set(fixture, "deploy", "<b>green</b>", &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(fixture->changes, ==, 1);
+    g_assert_cmpstr(find_block(fixture, "deploy")->text, ==, "<b>green</b>");
+    names = bus_list(fixture);
+    g_assert_cmpstr(names, ==, "deploy");
+    g_free(names);
+    
+    /* repeating what is shown is not a change */
+    g_assert_true(bus_set(fixture, "deploy", "<b>green</b>", NULL));
+    g_assert_cmpuint(fixture->changes, ==, 1);
+    
+    g_assert_true(bus_set(fixture, "deploy", "<span color='red'>red</span>", NULL));
+    g_assert_cmpuint(fixture->changes, ==, 2);
+    g_assert_cmpstr(find_block(fixture, "deploy")->text, ==, "<span color='red'>red</span>");
+    
+    g_assert_true(bus_remove(fixture, "deploy", NULL));
+    g_assert_cmpuint(fixture->changes, ==, 3);
+    g_assert_null(find_block(fixture, "deploy"));
+    names = bus_list(fixture);
+    g_assert_cmpstr(names, ==, "");
+    g_free(names);
+    
+    g_assert_false(bus_remove(fixture, "deploy", &error));
+    g_assert_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+    g_clear_error(&error);
+}
+
+/* More blocks than a sender may change at once, so the last ones arrive
+ * as the budget refills */
+static void
+test_bus_max_blocks (BusFixture    *fixture,
+                     gconstpointer  user_data)
+{
+    GError *error = NULL;
+    gchar name[SAMPLE_BUS_NAME_MAX];
+    gchar **names;
+    gchar *list;
+    
+    for (gint i = 0; i < SAMPLE_BUS_MAX_BLOCKS; i++) {
+        g_snprintf(name, sizeof(name), "block-%d", i);
+        g_assert_true(bus_set(fixture, name, "x", &error));
+        g_assert_no_error(error);
+    }
+    
+    g_snprintf(name, sizeof(name), "block-%d", SAMPLE_BUS_MAX_BLOCKS);
+    g_assert_false(bus_set(fixture, name, "x", &error));
+    g_assert_error(error, G_DBUS_ERROR, G_DBUS_ERROR_LIMITS_EXCEEDED);
+    g_clear_error(&error);
+    
+    list = bus_list(fixture);
+    names = g_strsplit(list, ",", -1);
+    g_assert_cmpuint(g_strv_length(names), ==, SAMPLE_BUS_MAX_BLOCKS);
+    g_strfreev(names);
+    g_free(list);
+    
+    /* the ones past the burst are applied together, with one redraw */
+    while (!all_slots_shown(fixture))
+        g_main_context_iteration(NULL, TRUE);
+    g_test_message("%u redraws for %d blocks", fixture->changes, SAMPLE_BUS_MAX_BLOCKS);
+    g_assert_cmpuint(fixture->changes, <, SAMPLE_BUS_MAX_BLOCKS);
+    
+    /* a removed block makes room once it is applied */
+    g_assert_true(bus_remove(fixture, "block-0", NULL));
+    g_assert_false(bus_remove(fixture, "block-0", &error));
+    g_assert_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+    g_clear_error(&error);
+    wait_for_changes(fixture, fixture->changes + 1);
+    g_snprintf(name, sizeof(name), "block-%d", SAMPLE_BUS_MAX_BLOCKS);
+    g_assert_true(bus_set(fixture, name, "x", &error));
+    g_assert_no_error(error);
+}
+
+/* A sender setting its block as fast as it can for a second gets its
+ * burst and then its rate, and the block ends up with what it sent last */
+static void
+test_bus_burst (BusFixture    *fixture,
+                gconstpointer  user_data)
+{
+    gint64 start = g_get_monotonic_time();
+    gchar text[32] = "";
+    guint n_sets = 0;
+    gdouble elapsed;
+    
+    while (g_get_monotonic_time() - start < BUS_FLOOD_TIME) {
+        g_snprintf(text, sizeof(text), "step %u", n_sets++);
+        g_assert_true(bus_set(fixture, "progress", text, NULL));
+    }
+    elapsed = wait_for_text(fixture, "progress", text, start);
+    
+    g_test_message("%u sets, %u redraws in %.2f s", n_sets, fixture->changes, elapsed);
+    g_assert_cmpuint(n_sets, >, BUS_CLIENT_BURST + BUS_CLIENT_RATE * elapsed);
+    g_assert_cmpfloat(fixture->changes, <=, BUS_CLIENT_BURST + BUS_CLIENT_RATE * elapsed);
+}
+
+/* One client keeps its block going while the other sets its own from a
+ * new connection every time, as a loop around gdbus call does. Each of
+ * those is a new sender with a whole budget, only the budget of all
+ * senders together holds them back, and the first client still gets its
+ * last change through. */
+static void
+test_bus_two_clients (BusFixture    *fixture,
+                      gconstpointer  user_data)
+{
+    gint64 start = g_get_monotonic_time();
+    gchar steady[32] = "", looped[32] = "";
+    guint n_sets = 0;
+    gdouble elapsed;
+    
+    while (g_get_monotonic_time() - start < BUS_FLOOD_TIME) {
+        GDBusConnection *connection = bus_connect(fixture);
+        
+        g_snprintf(steady, sizeof(steady), "steady %u", n_sets);
+        g_snprintf(looped, sizeof(looped), "looped %u", n_sets++);
+        g_assert_true(bus_set(fixture, "steady", steady, NULL));
+        g_assert_true(bus_set_on(connection, "looped", looped, NULL));
+        bus_disconnect(connection);
+    }
+    wait_for_text(fixture, "steady", steady, start);
+    elapsed = wait_for_text(fixture, "looped", looped, start);
+    
+    g_test_message("%u sets from each, %u redraws in %.2f s", n_sets, fixture->changes, elapsed);
+    g_assert_cmpuint(n_sets, >, BUS_TOTAL_BURST + BUS_TOTAL_RATE * elapsed);
+    g_assert_cmpfloat(fixture->changes, <=, BUS_TOTAL_BURST + BUS_TOTAL_RATE * elapsed);
+}
+
+static void
+test_bus_invalid_markup (BusFixture    *fixture,
+                         gconstpointer  user_data)
+{
+    static const gchar *markups[] = {
+        "",
+        "<b>unclosed",
+        "<b>crossed<i></b></i>",
+        "a & b",
+        "<span color='red>quote</span>",
+        "<blink>front end</blink>",
+    };
+    static const gchar *block_names[] = { "", "Upper", "with space", "much-too-long-name", "cpu" };
+    gchar *names, *long_markup = g_strnfill(MAX_BLOCK_SIZE, 'x');
+    GError *error = NULL;
+    
+    for (guint i = 0; i < G_N_ELEMENTS(markups); i++) {
+        g_assert_false(bus_set(fixture, "bad", markups[i], &error));
+        g_assert_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+        g_test_message("\"%s\": %s", markups[i], error->message);
+        g_clear_error(&error);
+    }
+    
+    g_assert_false(bus_set(fixture, "bad", long_markup, &error));
+    g_assert_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+    g_clear_error(&error);
+    g_free(long_markup);
+    
+    for (guint i = 0; i < G_N_ELEMENTS(block_names); i++) {
+        g_assert_false(bus_set(fixture, block_names[i], "x", &error));
+        g_assert_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+        g_clear_error(&error);
+    }
+    
+    /* nothing was taken, not even a slot */
+    names = bus_list(fixture);
+    g_assert_cmpstr(names, ==, "");
+    g_free(names);
+    g_assert_cmpuint(fixture->changes, ==, 0);
+}
+
+static void
+test_bus_no_daemon (void)
+{
+    g_test_skip("dbus-daemon is not installed");
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    gchar *daemon;
+    
+    g_test_init(&argc, &argv, NULL);
+    
+    /* GTestDBus spawns its own */
+    daemon = g_find_program_in_path("dbus-daemon");
+    if (!daemon) {
+        g_test_add_func("/bus/no-daemon", test_bus_no_daemon);
+        return g_test_run();
+    }
+    g_free(daemon);
+    
+    g_test_add("/bus/add-update-remove", BusFixture, NULL,
+               bus_fixture_set_up, test_bus_add_update_remove, bus_fixture_tear_down);
+    g_test_add("/bus/max-blocks", BusFixture, NULL,
+               bus_fixture_set_up, test_bus_max_blocks, bus_fixture_tear_down);
+    g_test_add("/bus/burst", BusFixture, NULL,
+               bus_fixture_set_up, test_bus_burst, bus_fixture_tear_down);
+    g_test_add("/bus/two-clients", BusFixture, NULL,
+               bus_fixture_set_up, test_bus_two_clients, bus_fixture_tear_down);
+    g_test_add("/bus/invalid-markup", BusFixture, NULL,
+               bus_fixture_set_up, test_bus_invalid_markup, bus_fixture_tear_down);
+    
+    return g_test_run();
+}
@@ -0,0 +1,260 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <stdlib.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sample-commands.h"
+
+/* Private to sample-commands.c */
+#define COMMANDS_MAX_RUNNING  4
+#define COMMANDS_RESTART_DELAY 10
+
+typedef struct {
+    gchar          *dir;
+    SampleCommands *commands;
+    gint            changes;   /* atomic, from the notify */
+} CommandsFixture;
+
+static void
+count_change (gpointer user_data)
+{
+    CommandsFixture *fixture = user_data;
+    
+    g_atomic_int_inc(&fixture->changes);
+}
+
+/* Runs the commands of @contents, @DIR@ in it being the scratch directory */
+static void
+commands_start (CommandsFixture *fixture, const gchar *contents)
+{
+    gchar **parts = g_strsplit(contents, "@DIR@", -1);
+    gchar *expanded = g_strjoinv(fixture->dir, parts);
+    gchar *path = g_build_filename(fixture->dir, "commands.conf", NULL);
+    GError *error = NULL;
+    
+    g_assert_true(g_file_set_contents(path, expanded, -1, NULL));
+    fixture->commands = sample_commands_new(path, count_change, fixture, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(fixture->commands);
+    
+    g_free(path);
+    g_free(expanded);
+    g_strfreev(parts);
+}
+
+/* Waits up to @timeout s for block @index to show @expected, or anything
+ * if that is NULL; @text gets what it shows */
+static gboolean
+wait_for_block (CommandsFixture *fixture, gint index, const gchar *expected,
+                gdouble timeout, gchar *text)
+{
+    gint64 deadline = g_get_monotonic_time() + (gint64) (timeout * G_USEC_PER_SEC);
+    guint serial = 0;
+    
+    do {
+        if (sample_commands_read(fixture->commands, index, &serial, text)
+            && (!expected || strcmp(text, expected) == 0))
+            return TRUE;
+        g_usleep(10000);
+    } while (g_get_monotonic_time() < deadline);
+    
+    return FALSE;
+}
+
+/* Gone, or a zombie nobody reaped yet */
+static gboolean
+process_alive (gint pid)
+{
+    gchar *path = g_strdup_printf("/proc/%d/stat", pid);
+    gchar *stat = NULL;
+    gboolean alive = FALSE;
+    
+    if (g_file_get_contents(path, &stat, NULL, NULL)) {
+        const gchar *state = strrchr(stat, ')');
+        
+        alive = state && state[1] == ' ' && state[2] != 'Z' && state[2] != 'X';
+    }
+    g_free(stat);
+    g_free(path);
+    
+    return alive;
+}
+
+static void
+commands_fixture_set_up (CommandsFixture *fixture,
+                         gconstpointer    user_data)
+{
+    fixture->dir = g_dir_make_tmp("sample-commands-XXXXXX", NULL);
+    g_assert_nonnull(fixture->dir);
+}
+
+static void
+commands_fixture_tear_down (CommandsFixture *fixture,
+                            gconstpointer    user_data)
+{
+    const gchar *name;
+    GDir *dir;
+    
+    sample_commands_free(fixture->commands);
+    
+    dir = g_dir_open(fixture->dir, 0, NULL);
+    while ((name = g_dir_read_name(dir))) {
+        gchar *path = g_build_filename(fixture->dir, name, NULL);
+        
+        g_unlink(path);
+        g_free(path);
+    }
+    g_dir_close(dir);
+    g_rmdir(fixture->dir);
+    g_free(fixture->dir);
+}
+
+/* A command past its timeout goes down with what it started in the
+ * background, and the block keeps the line it printed */
+static void
+test_commands_timeout (CommandsFixture *fixture,
+                       gconstpointer    user_data)
+{
+    gchar text[MAX_BLOCK_SIZE];
+    gchar *path = g_build_filename(fixture->dir, "child", NULL);
+    gchar *pid = NULL;
+    gint64 start = g_get_monotonic_time();
+    
+    commands_start(fixture,
+                   "[stuck]\n"
+                   "command=echo started; sleep 30 & echo $! > @DIR@/child; wait\n"
+                   "timeout=1\n");
+    
+    g_assert_true(wait_for_block(fixture, 0, "started", 5.0, text));
+    g_assert_cmpint(g_get_monotonic_time() - start, >=, G_USEC_PER_SEC);
+    g_assert_true(g_file_get_contents(path, &pid, NULL, NULL));
+    
+    /* the shell is killed first, its child must not be left behind */
+    for (gint i = 0; i < 200 && process_alive(atoi(pid)); i++)
+        g_usleep(10000);
+    g_assert_false(process_alive(atoi(pid)));
+    
+    g_free(pid);
+    g_free(path);
+}
+
+/* However many are due, only a few interval commands run at a time, so
+ * six of one second each take two rounds */
+static void
+test_commands_max_running (CommandsFixture *fixture,
+                           gconstpointer    user_data)
+{
+    GString *contents = g_string_new(NULL);
+    gchar text[MAX_BLOCK_SIZE];
+    gint64 start = g_get_monotonic_time();
+    gint peak = 0;
+    
+    for (gint i = 0; i < COMMANDS_MAX_RUNNING + 2; i++)
+        g_string_append_printf(contents,
+                               "[block%d]\n"
+                               "command=touch @DIR@/running.$BLOCK_NAME; ls @DIR@ | grep -c running; "
+                               "sleep 1; rm @DIR@/running.$BLOCK_NAME\n", i);
+    commands_start(fixture, contents->str);
+    
+    for (gint i = 0; i < COMMANDS_MAX_RUNNING + 2; i++) {
+        gint running;
+        
+        g_assert_true(wait_for_block(fixture, i, NULL, 10.0, text));
+        running = atoi(text);
+        g_test_message("%s started with %d running", sample_commands_get_name(fixture->commands, i), running);
+        g_assert_cmpint(running, >=, 1);
+        g_assert_cmpint(running, <=, COMMANDS_MAX_RUNNING);
+        peak = MAX(peak, running);
+    }
+    g_assert_cmpint(peak, >, 1);
+    g_assert_cmpint(g_get_monotonic_time() - start, >=, 2 * G_USEC_PER_SEC);
+    
+    g_string_free(contents, TRUE);
+}
+
+/* A persistent command that exits is started again after the delay */
+static void
+test_commands_persist_restart (CommandsFixture *fixture,
+                               gconstpointer    user_data)
+{
+    gchar text[MAX_BLOCK_SIZE];
+    gint64 first;
+    
+    commands_start(fixture,
+                   "[daemon]\n"
+                   "command=echo run >> @DIR@/runs; echo \"run $(grep -c run @DIR@/runs)\"\n"
+                   "interval=persist\n");
+    
+    g_assert_true(wait_for_block(fixture, 0, "run 1", 5.0, text));
+    first = g_get_monotonic_time();
+    g_assert_true(wait_for_block(fixture, 0, "run 2", COMMANDS_RESTART_DELAY + 5.0, text));
+    g_assert_cmpint(g_get_monotonic_time() - first, >=, (COMMANDS_RESTART_DELAY - 1) * G_USEC_PER_SEC);
+}
+
+/* A command that is slow to finish its line holds up nobody: the lines
+ * of a persistent one show as they come */
+static void
+test_commands_multiplex (CommandsFixture *fixture,
+                         gconstpointer    user_data)
+{
+    gchar text[MAX_BLOCK_SIZE];
+    gint64 start = g_get_monotonic_time();
+    guint serial = 0;
+    
+    commands_start(fixture,
+                   "[slow]\n"
+                   "command=printf partial; sleep 4; echo\n"
+                   "[fast]\n"
+                   "command=for i in 1 2 3 4 5; do echo line $i; sleep 0.2; done; sleep 30\n"
+                   "interval=persist\n");
+    
+    g_assert_true(wait_for_block(fixture, 1, "line 1", 2.0, text));
+    g_assert_true(wait_for_block(fixture, 1, "line 5", 3.0, text));
+    g_assert_cmpint(g_get_monotonic_time() - start, <, 3 * G_USEC_PER_SEC);
+    g_assert_false(sample_commands_read(fixture->commands, 0, &serial, text));
+    
+    g_assert_true(wait_for_block(fixture, 0, "partial", 8.0, text));
+    g_assert_cmpint(g_atomic_int_get(&fixture->changes), >=, 6);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add("/commands/timeout", CommandsFixture, NULL,
+               commands_fixture_set_up, test_commands_timeout, commands_fixture_tear_down);
+    g_test_add("/commands/max-running", CommandsFixture, NULL,
+               commands_fixture_set_up, test_commands_max_running, commands_fixture_tear_down);
+    g_test_add("/commands/persist-restart", CommandsFixture, NULL,
+               commands_fixture_set_up, test_commands_persist_restart, commands_fixture_tear_down);
+    g_test_add("/commands/multiplex", CommandsFixture, NULL,
+               commands_fixture_set_up, test_commands_multiplex, commands_fixture_tear_down);
+    
+    return g_test_run();
+}
@@ -0,0 +1,218 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sample-cpu.h"
+#include "sample-source.h"
+
+typedef struct {
+    gchar *root;
+    gchar *stat_path;
+} CpuFixture;
+
+/* Rewritten in place, the sampler keeps the file open */
+static void
+write_stat (CpuFixture  *fixture,
+            const gchar *contents)
+{
+    FILE *file = fopen(fixture->stat_path, "w");
+    
+    g_assert_nonnull(file);
+    g_assert_cmpint(fputs(contents, file), >=, 0);
+    g_assert_cmpint(fclose(file), ==, 0);
+}
+
+static void
+cpu_fixture_set_up (CpuFixture    *fixture,
+                    gconstpointer  user_data)
+{
+    gchar *proc;
+    
+    fixture->root = g_dir_make_tmp("sample-cpu-XXXXXX", NULL);
+    g_assert_nonnull(fixture->root);
+    proc = g_build_filename(fixture->root, "proc", NULL);
+    g_assert_cmpint(g_mkdir(proc, 0700), ==, 0);
+    fixture->stat_path = g_build_filename(proc, "stat", NULL);
+    g_free(proc);
+    
+    sample_source_set_root(fixture->root);
+}
+
+static void
+cpu_fixture_tear_down (CpuFixture    *fixture,
+                       gconstpointer  user_data)
+{
+    gchar *proc = g_path_get_dirname(fixture->stat_path);
+    
+    sample_source_set_root(NULL);
+    g_unlink(fixture->stat_path);
+    g_rmdir(proc);
+    g_rmdir(fixture->root);
+    g_free(proc);
+    g_free(fixture->stat_path);
+    g_free(fixture->root);
+}
+
+static void
+test_cpu_usage (CpuFixture    *fixture,
+                gconstpointer  user_data)
+{
+    CpuStat *stat;
+    
+    write_stat(fixture,
+               "cpu  200 0 100 700 0 0 0 0 0 0\n"
+               "cpu0 100 0 50 350 0 0 0 0 0 0\n"
+               "cpu1 100 0 50 350 0 0 0 0 0 0\n"
+               "intr 0\n");
+    stat = cpu_stat_new("/proc/stat");
+    g_assert_nonnull(stat);
+    g_assert_false(cpu_stat_sample(stat));
+    g_assert_cmpint(cpu_stat_get_n_cores(stat), ==, 2);
+    
+    /* cpu0 fully busy, cpu1 idle */
+    write_stat(fixture,
+               "cpu  300 0 100 800 0 0 0 0 0 0\n"
+               "cpu0 200 0 50 350 0 0 0 0 0 0\n"
+               "cpu1 100 0 50 450 0 0 0 0 0 0\n"
+               "intr 0\n");
+    g_assert_true(cpu_stat_sample(stat));
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_total(stat), 0.5, 1e-6);
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[0], 1.0, 1e-6);
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[1], 0.0, 1e-6);
+    
+    cpu_stat_free(stat);
+}
+
+/* A core plugged in between two samples has no previous sample; its
+ * first reading must not be the whole uptime against zero */
+static void
+test_cpu_hotplug (CpuFixture    *fixture,
+                  gconstpointer  user_data)
+{
+    CpuStat *stat;
+    
+    write_stat(fixture,
+               "cpu  100 0 0 100 0 0 0 0 0 0\n"
+               "cpu0 100 0 0 100 0 0 0 0 0 0\n");
+    stat = cpu_stat_new("/proc/stat");
+    g_assert_nonnull(stat);
+    cpu_stat_sample(stat);
+    
+    write_stat(fixture,
+               "cpu  5000000 0 0 200 0 0 0 0 0 0\n"
+               "cpu0 200 0 0 100 0 0 0 0 0 0\n"
+               "cpu1 4999800 0 0 100 0 0 0 0 0 0\n");
+    g_assert_true(cpu_stat_sample(stat));
+    g_assert_cmpint(cpu_stat_get_n_cores(stat), ==, 2);
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[0], 1.0, 1e-6);
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[1], 0.0, 1e-6);
+    
+    write_stat(fixture,
+               "cpu  5000200 0 0 300 0 0 0 0 0 0\n"
+               "cpu0 300 0 0 100 0 0 0 0 0 0\n"
+               "cpu1 4999900 0 0 200 0 0 0 0 0 0\n");
+    g_assert_true(cpu_stat_sample(stat));
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[1], 0.5, 1e-6);
+    
+    cpu_stat_free(stat);
+}
+
+/* An offline core drops out of the file and starts over when it is back */
+static void
+test_cpu_offline (CpuFixture    *fixture,
+                  gconstpointer  user_data)
+{
+    CpuStat *stat;
+    
+    write_stat(fixture,
+               "cpu  300 0 0 300 0 0 0 0 0 0\n"
+               "cpu0 100 0 0 100 0 0 0 0 0 0\n"
+               "cpu1 100 0 0 100 0 0 0 0 0 0\n"
+               "cpu2 100 0 0 100 0 0 0 0 0 0\n");
+    stat = cpu_stat_new("/proc/stat");
+    g_assert_nonnull(stat);
+    cpu_stat_sample(stat);
+    
+    write_stat(fixture,
+               "cpu  400 0 0 400 0 0 0 0 0 0\n"
+               "cpu0 150 0 0 150 0 0 0 0 0 0\n"
+               "cpu2 150 0 0 150 0 0 0 0 0 0\n");
+    g_assert_true(cpu_stat_sample(stat));
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[0], 0.5, 1e-6);
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[2], 0.5, 1e-6);
+    
+    write_stat(fixture,
+               "cpu  900 0 0 600 0 0 0 0 0 0\n"
+               "cpu0 200 0 0 200 0 0 0 0 0 0\n"
+               "cpu1 900 0 0 100 0 0 0 0 0 0\n"
+               "cpu2 200 0 0 200 0 0 0 0 0 0\n");
+    g_assert_true(cpu_stat_sample(stat));
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_cores(stat)[1], 0.0, 1e-6);
+    
+    cpu_stat_free(stat);
+}
+
+/* Deltas past 2^31 ticks, a long suspend on a large machine */
+static void
+test_cpu_large_delta (CpuFixture    *fixture,
+                      gconstpointer  user_data)
+{
+    CpuStat *stat;
+    
+    write_stat(fixture,
+               "cpu  1000 0 0 1000 0 0 0 0 0 0\n"
+               "cpu0 1000 0 0 1000 0 0 0 0 0 0\n");
+    stat = cpu_stat_new("/proc/stat");
+    g_assert_nonnull(stat);
+    cpu_stat_sample(stat);
+    
+    write_stat(fixture,
+               "cpu  3000001000 0 0 9000001000 0 0 0 0 0 0\n"
+               "cpu0 3000001000 0 0 9000001000 0 0 0 0 0 0\n");
+    g_assert_true(cpu_stat_sample(stat));
+    g_assert_cmpfloat_with_epsilon(cpu_stat_get_total(stat), 0.25, 1e-6);
+    
+    cpu_stat_free(stat);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add("/cpu/usage", CpuFixture, NULL,
+               cpu_fixture_set_up, test_cpu_usage, cpu_fixture_tear_down);
+    g_test_add("/cpu/hotplug", CpuFixture, NULL,
+               cpu_fixture_set_up, test_cpu_hotplug, cpu_fixture_tear_down);
+    g_test_add("/cpu/offline", CpuFixture, NULL,
+               cpu_fixture_set_up, test_cpu_offline, cpu_fixture_tear_down);
+    g_test_add("/cpu/large-delta", CpuFixture, NULL,
+               cpu_fixture_set_up, test_cpu_large_delta, cpu_fixture_tear_down);
+    
+    return g_test_run();
+}
@@ -0,0 +1,182 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sample-export.h"
+
+/* writes per run; every reader copies the block as often as it can */
+#define EXPORT_WRITES  200000
+#define EXPORT_READERS 4
+
+typedef struct {
+    gchar        *dir;
+    gchar        *path;
+    SampleExport *export;
+    gint          writing;
+} ExportFixture;
+
+typedef struct {
+    ExportFixture *fixture;
+    guint64        reads;
+    guint64        busy;       /* gave up while the writer held the block */
+    guint64        retries;
+} ExportReader;
+
+/* Every field of write @n is derived from @n, so a copy mixing two
+ * writes shows in at least one of them */
+static void
+fill_block (BlockData *block, guint n)
+{
+    memset(block, 0, sizeof(*block));
+    block->len = 1 + n % (MAX_BLOCK_SIZE - 1);
+    memset(block->data, 'a' + n % 26, block->len);
+    block->data[block->len] = '\0';
+    block->serial = n;
+    block->fetched_at = n;
+    block->outdated = n & 1;
+    block->raw.memory.total_kb = n;
+    block->raw.memory.swap_free_kb = ~(gulong) n;
+}
+
+static void
+check_block (const SampleExportBlock *block)
+{
+    guint n = block->serial;
+    
+    g_assert_cmpuint(block->len, ==, 1 + n % (MAX_BLOCK_SIZE - 1));
+    g_assert_cmpuint(strspn(block->text, (gchar[]) { 'a' + n % 26, '\0' }), ==, block->len);
+    g_assert_cmpint(block->fetched_at, ==, n);
+    g_assert_cmpuint(block->outdated, ==, n & 1);
+    g_assert_cmpuint(block->raw.memory.total_kb, ==, n);
+    g_assert_cmpuint(block->raw.memory.swap_free_kb, ==, ~(gulong) n);
+    g_assert_cmpstr(block->name, ==, block_get_name(BLOCK_MEMORY));
+}
+
+static void
+export_fixture_set_up (ExportFixture *fixture,
+                       gconstpointer  user_data)
+{
+    BlockData block;
+    
+    fixture->dir = g_dir_make_tmp("sample-export-XXXXXX", NULL);
+    g_assert_nonnull(fixture->dir);
+    fixture->path = g_build_filename(fixture->dir, "test.blocks", NULL);
+    fixture->export = sample_export_new(fixture->path, NULL);
+    g_assert_nonnull(fixture->export);
+    
+    /* readers fail on a block never written */
+    fill_block(&block, 0);
+    sample_export_write(fixture->export, BLOCK_MEMORY, &block);
+}
+
+static void
+export_fixture_tear_down (ExportFixture *fixture,
+                          gconstpointer  user_data)
+{
+    sample_export_free(fixture->export);
+    g_rmdir(fixture->dir);
+    g_free(fixture->path);
+    g_free(fixture->dir);
+}
+
+static gpointer
+reader_thread (gpointer data)
+{
+    ExportReader *reader = data;
+    SampleExportReader *export_reader = sample_export_reader_open(reader->fixture->path, NULL);
+    SampleExportBlock block;
+    guint last = 0;
+    
+    g_assert_nonnull(export_reader);
+    while (g_atomic_int_get(&reader->fixture->writing)) {
+        if (!sample_export_reader_read(export_reader, BLOCK_MEMORY, &block)) {
+            reader->busy++;
+            continue;
+        }
+        check_block(&block);
+        
+        /* a single writer, so a reader never goes back in time */
+        g_assert_cmpuint(block.serial, >=, last);
+        last = block.serial;
+        reader->reads++;
+    }
+    reader->retries = sample_export_reader_get_retries(export_reader);
+    sample_export_reader_close(export_reader);
+    
+    return NULL;
+}
+
+/* One writer rewriting a block as fast as it can, with the readers
+ * checking every copy they get */
+static void
+test_export_torn_reads (ExportFixture *fixture,
+                        gconstpointer  user_data)
+{
+    ExportReader readers[EXPORT_READERS] = { { 0 } };
+    GThread *threads[EXPORT_READERS];
+    guint64 reads = 0, retries = 0;
+    BlockData block;
+    
+    g_atomic_int_set(&fixture->writing, TRUE);
+    for (gint i = 0; i < EXPORT_READERS; i++) {
+        readers[i].fixture = fixture;
+        threads[i] = g_thread_new("reader", reader_thread, &readers[i]);
+    }
+    
+    for (guint n = 1; n <= EXPORT_WRITES; n++) {
+        fill_block(&block, n);
+        sample_export_write(fixture->export, BLOCK_MEMORY, &block);
+    }
+    g_atomic_int_set(&fixture->writing, FALSE);
+    
+    for (gint i = 0; i < EXPORT_READERS; i++) {
+        g_thread_join(threads[i]);
+        g_test_message("reader %d: %" G_GUINT64_FORMAT " copies, %" G_GUINT64_FORMAT
+                       " retries, %" G_GUINT64_FORMAT " given up",
+                       i, readers[i].reads, readers[i].retries, readers[i].busy);
+        reads += readers[i].reads;
+        retries += readers[i].retries;
+    }
+    g_assert_cmpuint(reads, >, 0);
+    
+    /* without retries the readers never overlapped a write, and the
+     * run did not test anything */
+    if (retries == 0)
+        g_test_incomplete("No read overlapped a write");
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add("/export/torn-reads", ExportFixture, NULL,
+               export_fixture_set_up, test_export_torn_reads, export_fixture_tear_down);
+    
+    return g_test_run();
+}
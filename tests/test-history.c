@@ -0,0 +1,258 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sample-clock.h"
+#include "sample-history.h"
+
+/* Midnight UTC; two values a minute for HISTORY_DAYS days from there */
+#define HISTORY_START  G_GINT64_CONSTANT(1700006400)
+#define HISTORY_DAYS   5
+#define HISTORY_STEP   30
+#define HISTORY_SERIES "test"
+
+typedef struct {
+    gchar         *dir;
+    SampleHistory *history;
+} HistoryFixture;
+
+typedef struct {
+    gfloat  min;
+    gfloat  max;
+    gdouble mean;
+    guint   count;
+} HistoryExpected;
+
+/* Scattered over 0 to 99.9 so that every bucket has its own min and max */
+static gdouble
+value_at (gint64 time)
+{
+    return (gdouble) ((time / HISTORY_STEP) * 7919 % 1000) / 10.0;
+}
+
+static void
+expect_range (gint64 from, gint64 to, HistoryExpected *expected)
+{
+    gdouble sum = 0.0;
+    
+    memset(expected, 0, sizeof(*expected));
+    for (gint64 time = from; time < to; time += HISTORY_STEP) {
+        gfloat value = value_at(time);
+        
+        expected->min = expected->count == 0 ? value : MIN(expected->min, value);
+        expected->max = expected->count == 0 ? value : MAX(expected->max, value);
+        sum += value;
+        expected->count++;
+    }
+    expected->mean = sum / expected->count;
+}
+
+static void
+check_point (const SampleHistoryPoint *point, gint64 bucket)
+{
+    HistoryExpected expected;
+    
+    expect_range(point->time, point->time + bucket, &expected);
+    g_assert_cmpint(point->time % bucket, ==, 0);
+    g_assert_cmpuint(point->count, ==, expected.count);
+    g_assert_cmpfloat(point->min, ==, expected.min);
+    g_assert_cmpfloat(point->max, ==, expected.max);
+    g_assert_cmpfloat_with_epsilon(point->mean, expected.mean, 0.01);
+}
+
+/* Points of a query are consecutive buckets from @from to before @to */
+static void
+check_query (HistoryFixture *fixture, gint64 from, gint64 to, gint max_points, gint64 bucket)
+{
+    SampleHistoryPoint *points = g_new(SampleHistoryPoint, max_points);
+    gint n = sample_history_query(fixture->history, HISTORY_SERIES, from, to, points, max_points);
+    
+    g_test_message("%" G_GINT64_FORMAT " to %" G_GINT64_FORMAT ": %d points of %" G_GINT64_FORMAT " s",
+                   from, to, n, bucket);
+    g_assert_cmpint(n, ==, (to - from) / bucket);
+    for (gint i = 0; i < n; i++) {
+        g_assert_cmpint(points[i].time, ==, from + i * bucket);
+        check_point(&points[i], bucket);
+    }
+    g_free(points);
+}
+
+static gsize
+file_n_points (HistoryFixture *fixture, const gchar *suffix)
+{
+    gchar *filename = g_strconcat(HISTORY_SERIES, ".", suffix, NULL);
+    gchar *path = g_build_filename(fixture->dir, filename, NULL);
+    GStatBuf st;
+    
+    g_assert_cmpint(g_stat(path, &st), ==, 0);
+    g_free(path);
+    g_free(filename);
+    
+    return (st.st_size - sizeof(SampleHistoryHeader)) / sizeof(SampleHistoryPoint);
+}
+
+/* Records the days as a provider would, the clock stepping along so that
+ * the history flushes and compacts as it goes, then opens the files anew */
+static void
+history_fixture_set_up (HistoryFixture *fixture,
+                        gconstpointer   user_data)
+{
+    gint64 end = HISTORY_START + HISTORY_DAYS * 86400;
+    
+    fixture->dir = g_dir_make_tmp("sample-history-XXXXXX", NULL);
+    g_assert_nonnull(fixture->dir);
+    fixture->history = sample_history_new(fixture->dir, NULL);
+    g_assert_nonnull(fixture->history);
+    
+    for (gint64 time = HISTORY_START; time < end; time += HISTORY_STEP) {
+        sample_history_add(fixture->history, HISTORY_SERIES, time, value_at(time));
+        sample_clock_advance(HISTORY_STEP * G_USEC_PER_SEC);
+    }
+    /* a bucket is closed by the first closed one after it from the level
+     * below, so these close the last minute, hour and day; they are past
+     * every range checked */
+    for (gint64 time = end; time <= end + 2 * 3600; time += 3600)
+        sample_history_add(fixture->history, HISTORY_SERIES, time, 0.0);
+    sample_history_free(fixture->history);
+    
+    fixture->history = sample_history_new(fixture->dir, NULL);
+    g_assert_nonnull(fixture->history);
+}
+
+static void
+history_fixture_tear_down (HistoryFixture *fixture,
+                           gconstpointer   user_data)
+{
+    const gchar *name;
+    GDir *dir;
+    
+    sample_history_free(fixture->history);
+    
+    dir = g_dir_open(fixture->dir, 0, NULL);
+    while ((name = g_dir_read_name(dir))) {
+        gchar *path = g_build_filename(fixture->dir, name, NULL);
+        
+        g_unlink(path);
+        g_free(path);
+    }
+    g_dir_close(dir);
+    g_rmdir(fixture->dir);
+    g_free(fixture->dir);
+}
+
+static void
+test_history_minutes (HistoryFixture *fixture,
+                      gconstpointer   user_data)
+{
+    gint64 end = HISTORY_START + HISTORY_DAYS * 86400;
+    
+    check_query(fixture, end - 2 * 3600, end, 120, 60);
+    check_query(fixture, end - 86400 - 600, end - 86400 + 600, 20, 60);
+}
+
+/* Past the two days of minutes, or more points than asked for */
+static void
+test_history_hours (HistoryFixture *fixture,
+                    gconstpointer   user_data)
+{
+    gint64 end = HISTORY_START + HISTORY_DAYS * 86400;
+    
+    check_query(fixture, HISTORY_START, HISTORY_START + 3 * 86400, 72, 3600);
+    check_query(fixture, end - 86400, end, 24, 3600);
+}
+
+static void
+test_history_days (HistoryFixture *fixture,
+                   gconstpointer   user_data)
+{
+    check_query(fixture, HISTORY_START, HISTORY_START + HISTORY_DAYS * 86400, HISTORY_DAYS, 86400);
+}
+
+static void
+test_history_summary (HistoryFixture *fixture,
+                      gconstpointer   user_data)
+{
+    gint64 ranges[][2] = {
+        { HISTORY_START, HISTORY_START + HISTORY_DAYS * 86400 },
+        { HISTORY_START + 86400 + 3600, HISTORY_START + 2 * 86400 },
+        { HISTORY_START + 4 * 86400 + 60, HISTORY_START + 4 * 86400 + 300 },
+    };
+    
+    for (guint i = 0; i < G_N_ELEMENTS(ranges); i++) {
+        SampleHistoryPoint summary;
+        HistoryExpected expected;
+        
+        expect_range(ranges[i][0], ranges[i][1], &expected);
+        g_assert_true(sample_history_summary(fixture->history, HISTORY_SERIES,
+                                             ranges[i][0], ranges[i][1], &summary));
+        g_assert_cmpuint(summary.count, ==, expected.count);
+        g_assert_cmpfloat(summary.min, ==, expected.min);
+        g_assert_cmpfloat(summary.max, ==, expected.max);
+        g_assert_cmpfloat_with_epsilon(summary.mean, expected.mean, 0.01);
+    }
+}
+
+/* The minutes were compacted to two days once they held four, the hours
+ * and days were not */
+static void
+test_history_compacted (HistoryFixture *fixture,
+                        gconstpointer   user_data)
+{
+    gchar *path = g_build_filename(fixture->dir, HISTORY_SERIES ".minute.new", NULL);
+    gsize minutes = file_n_points(fixture, "minute");
+    
+    g_test_message("%" G_GSIZE_FORMAT " points of minutes left", minutes);
+    g_assert_cmpuint(minutes, >=, 2 * 1440);
+    g_assert_cmpuint(minutes, <, 4 * 1440);
+    g_assert_cmpuint(file_n_points(fixture, "hour"), ==, HISTORY_DAYS * 24 + 1);
+    g_assert_cmpuint(file_n_points(fixture, "day"), ==, HISTORY_DAYS);
+    g_assert_false(g_file_test(path, G_FILE_TEST_EXISTS));
+    g_free(path);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    /* only flushes go by the clock */
+    sample_clock_set_virtual(HISTORY_START * G_USEC_PER_SEC);
+    
+    g_test_add("/history/minutes", HistoryFixture, NULL,
+               history_fixture_set_up, test_history_minutes, history_fixture_tear_down);
+    g_test_add("/history/hours", HistoryFixture, NULL,
+               history_fixture_set_up, test_history_hours, history_fixture_tear_down);
+    g_test_add("/history/days", HistoryFixture, NULL,
+               history_fixture_set_up, test_history_days, history_fixture_tear_down);
+    g_test_add("/history/summary", HistoryFixture, NULL,
+               history_fixture_set_up, test_history_summary, history_fixture_tear_down);
+    g_test_add("/history/compacted", HistoryFixture, NULL,
+               history_fixture_set_up, test_history_compacted, history_fixture_tear_down);
+    
+    return g_test_run();
+}
@@ -0,0 +1,250 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <time.h>
+
+#include <glib.h>
+
+#include "sample-planner.h"
+
+/* as the exchange worker has them */
+#define PLANNER_INTERVAL     (30 * 60)
+#define PLANNER_RETRY        (5 * 60)
+#define PLANNER_MONTHS       3
+
+/* Clicks come every 30 minutes to 4 hours, or never */
+#define PLANNER_CLICK_MIN    (30 * 60)
+#define PLANNER_CLICK_MAX    (4 * 3600)
+
+typedef struct {
+    guint fetches;
+    guint clicked;          /* fetched ahead of the plan */
+    guint closed;           /* while the markets were closed */
+    guint work;             /* in local working hours */
+} PlannerCount;
+
+static gint64
+unix_utc (gint year, gint month, gint day, gint hour)
+{
+    GDateTime *dt = g_date_time_new_utc(year, month, day, hour, 0, 0);
+    gint64 time = g_date_time_to_unix(dt);
+    
+    g_date_time_unref(dt);
+    
+    return time;
+}
+
+static gboolean
+work_hour (gint64 time)
+{
+    time_t local = time;
+    struct tm tm;
+    
+    localtime_r(&local, &tm);
+    
+    return tm.tm_wday >= 1 && tm.tm_wday <= 5
+           && tm.tm_hour >= SAMPLE_PLANNER_WORK_START && tm.tm_hour < SAMPLE_PLANNER_WORK_END;
+}
+
+/* Steps the clock from @start to @end the way the exchange worker sleeps:
+ * to the planned fetch, at most an interval at a time, or to a click.
+ * Every fetch succeeds. Fetches are counted into @counts, one per
+ * period of @period_ends. */
+static void
+run_planner (SamplePlanner *planner,
+             gint64         start,
+             const gint64  *period_ends,
+             gint           n_periods,
+             GRand         *clicks,
+             PlannerCount  *counts)
+{
+    gint64 now = start, fetched_at = 0, next_fetch, next_check, wake;
+    gint64 click = clicks ? start + g_rand_int_range(clicks, PLANNER_CLICK_MIN, PLANNER_CLICK_MAX) : G_MAXINT64;
+    gboolean refresh = FALSE;
+    gint period = 0;
+    
+    memset(counts, 0, n_periods * sizeof(*counts));
+    while (now < period_ends[n_periods - 1]) {
+        next_fetch = fetched_at == 0 ? now : sample_planner_next(planner, now, fetched_at);
+        if (refresh && sample_planner_may_refresh(planner, now, fetched_at))
+            next_fetch = now;
+        
+        if (now >= next_fetch && sample_planner_may_fetch(planner, now)) {
+            while (now >= period_ends[period])
+                period++;
+            
+            sample_planner_count(planner, now);
+            counts[period].fetches++;
+            counts[period].clicked += refresh && fetched_at > 0;
+            /* nothing is cached at first, that fetch comes right away */
+            counts[period].closed += !sample_planner_market_open(now) && fetched_at > 0;
+            counts[period].work += work_hour(now);
+            fetched_at = now;
+            next_fetch = sample_planner_next(planner, now, now);
+        }
+        refresh = FALSE;
+        
+        next_check = now >= next_fetch ? now + PLANNER_RETRY : next_fetch;
+        wake = now + CLAMP(next_check - now, 1, PLANNER_INTERVAL);
+        if (click <= wake) {
+            wake = click;
+            refresh = TRUE;
+            click += g_rand_int_range(clicks, PLANNER_CLICK_MIN, PLANNER_CLICK_MAX);
+        }
+        now = wake;
+    }
+}
+
+/* Calendar months in a row from January, with clicks; none may go over
+ * the budget or fetch while the markets are closed */
+static void
+test_planner_months (gconstpointer user_data)
+{
+    guint budget = GPOINTER_TO_UINT(user_data);
+    gint64 start = unix_utc(2026, 1, 1, 0);
+    gint64 ends[PLANNER_MONTHS];
+    PlannerCount counts[PLANNER_MONTHS];
+    SamplePlanner *planner = sample_planner_new(budget, PLANNER_INTERVAL, start);
+    GRand *clicks = g_rand_new_with_seed(budget);
+    
+    for (gint i = 0; i < PLANNER_MONTHS; i++)
+        ends[i] = unix_utc(2026, i + 2, 1, 0);
+    run_planner(planner, start, ends, PLANNER_MONTHS, clicks, counts);
+    
+    for (gint i = 0; i < PLANNER_MONTHS; i++) {
+        g_test_message("month %d: %u requests of %u, %u on request, %u in working hours",
+                       i + 1, counts[i].fetches, budget, counts[i].clicked, counts[i].work);
+        g_assert_cmpuint(counts[i].fetches, <=, budget);
+        g_assert_cmpuint(counts[i].closed, ==, 0);
+        /* and the budget is not left unused either */
+        g_assert_cmpuint(counts[i].fetches, >=, budget * 9 / 10);
+    }
+    
+    g_rand_free(clicks);
+    sample_planner_free(planner);
+}
+
+/* Restarted in the middle of the month, the part already past counts as
+ * spent */
+static void
+test_planner_restart (void)
+{
+    gint64 start = unix_utc(2026, 3, 16, 12), end = unix_utc(2026, 4, 1, 0);
+    SamplePlanner *planner = sample_planner_new(1000, PLANNER_INTERVAL, start);
+    gint remaining = sample_planner_get_remaining(planner, start);
+    GRand *clicks = g_rand_new_with_seed(16);
+    PlannerCount count;
+    
+    g_assert_cmpint(remaining, >, 0);
+    g_assert_cmpint(remaining, <, 1000);
+    run_planner(planner, start, &end, 1, clicks, &count);
+    
+    g_test_message("%u requests of %d left", count.fetches, remaining);
+    g_assert_cmpuint(count.fetches, <=, (guint) remaining);
+    g_assert_cmpuint(count.closed, ==, 0);
+    
+    g_rand_free(clicks);
+    sample_planner_free(planner);
+}
+
+/* The service's usage data sets the period and what is left of it; its
+ * quota applies to the next period where it is below the budget */
+static void
+test_planner_usage (void)
+{
+    SamplePlannerUsage usage = { 750, 1000, 250, 9, 0 };
+    gint64 start = unix_utc(2026, 3, 10, 15);
+    gint64 ends[2] = { unix_utc(2026, 3, 20, 0), unix_utc(2026, 4, 20, 0) };
+    SamplePlanner *planner = sample_planner_new(800, PLANNER_INTERVAL, start);
+    GRand *clicks = g_rand_new_with_seed(9);
+    PlannerCount counts[2];
+    
+    sample_planner_set_usage(planner, start, &usage);
+    g_assert_cmpint(sample_planner_get_period_end(planner), ==, ends[0]);
+    /* 800 minus 750 used is less than the service has left */
+    g_assert_cmpint(sample_planner_get_remaining(planner, start), ==, 50);
+    
+    run_planner(planner, start, ends, 2, clicks, counts);
+    g_test_message("%u requests of 50 left, then %u of 800", counts[0].fetches, counts[1].fetches);
+    g_assert_cmpuint(counts[0].fetches, <=, 50);
+    g_assert_cmpuint(counts[1].fetches, <=, 800);
+    g_assert_cmpuint(counts[0].closed + counts[1].closed, ==, 0);
+    
+    g_rand_free(clicks);
+    sample_planner_free(planner);
+}
+
+/* Without clicks, an hour of work gets about SAMPLE_PLANNER_WORK_WEIGHT
+ * times the fetches of another hour of open market */
+static void
+test_planner_working_hours (void)
+{
+    gint64 start = unix_utc(2026, 3, 1, 0), end = unix_utc(2026, 4, 1, 0);
+    SamplePlanner *planner = sample_planner_new(300, PLANNER_INTERVAL, start);
+    gint64 work_seconds = 0, open_seconds = sample_planner_open_seconds(start, end);
+    gdouble work_rate, other_rate;
+    PlannerCount count;
+    
+    run_planner(planner, start, &end, 1, NULL, &count);
+    
+    for (gint64 t = start; t < end; t += 3600)
+        work_seconds += work_hour(t) && sample_planner_market_open(t) ? 3600 : 0;
+    work_rate = (gdouble) count.work / work_seconds;
+    other_rate = (gdouble) (count.fetches - count.work) / (open_seconds - work_seconds);
+    
+    g_test_message("%u requests, %.2f per working hour, %.2f per other hour",
+                   count.fetches, work_rate * 3600, other_rate * 3600);
+    g_assert_cmpuint(count.fetches, <=, 300);
+    g_assert_cmpfloat(work_rate, >, 2.0 * other_rate);
+    g_assert_cmpfloat(work_rate, <, 4.0 * other_rate);
+    
+    sample_planner_free(planner);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    static const guint budgets[] = { 1000, 300, 50 };
+    
+    g_test_init(&argc, &argv, NULL);
+    
+    /* working hours are local; a fixed zone keeps the plan the same
+     * everywhere */
+    g_setenv("TZ", "<+03>-3", TRUE);
+    tzset();
+    
+    for (guint i = 0; i < G_N_ELEMENTS(budgets); i++) {
+        gchar *path = g_strdup_printf("/planner/months/%u", budgets[i]);
+        
+        g_test_add_data_func(path, GUINT_TO_POINTER(budgets[i]), test_planner_months);
+        g_free(path);
+    }
+    g_test_add_func("/planner/restart", test_planner_restart);
+    g_test_add_func("/planner/usage", test_planner_usage);
+    g_test_add_func("/planner/working-hours", test_planner_working_hours);
+    
+    return g_test_run();
+}
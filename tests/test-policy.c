@@ -0,0 +1,185 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "sample-blocks.h"
+#include "sample-clock.h"
+#include "sample-providers.h"
+#include "sample-scheduler.h"
+#include "sample-source.h"
+
+#define HOUR         (G_GINT64_CONSTANT(3600) * G_USEC_PER_SEC)
+
+/* Monday 2 March 2026, 00:00:00 UTC */
+#define POLICY_START (G_GINT64_CONSTANT(1772409600) * G_USEC_PER_SEC)
+
+typedef struct {
+    guint                updates[BLOCK_COUNT];
+    SampleSchedulerStats stats;
+    BatterySample        battery;   /* the last one of the hour */
+} PolicyHour;
+
+static const BlockId blocks[] = { BLOCK_DATE, BLOCK_MEMORY, BLOCK_CPU, BLOCK_BATTERY };
+
+static guint
+block_serial (BlockStore *store, BlockId block_id)
+{
+    guint serial;
+    
+    pthread_mutex_lock(&store->mutex);
+    serial = store->blocks[block_id].serial;
+    pthread_mutex_unlock(&store->mutex);
+    
+    return serial;
+}
+
+/* The second hour of the local blocks over @fixture; the first one lets
+ * the stretched sleeps fall onto the battery grid */
+static void
+policy_run_hour (const gchar *fixture, PolicyHour *hour)
+{
+    SampleConfig *config = sample_config_new();
+    SampleScheduler *scheduler;
+    BlockStore store;
+    guint before[BLOCK_COUNT];
+    guint n_workers = 0;
+    
+    /* the power source is read from the tree when the scheduler starts */
+    sample_source_set_root(fixture);
+    
+    config->show_date = TRUE;
+    config->show_memory = TRUE;
+    config->show_cpu = TRUE;
+    config->show_battery = TRUE;
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++) {
+        if (sample_provider_wanted(config, blocks[i]))
+            n_workers++;
+    }
+    
+    block_store_init(&store, NULL, NULL);
+    scheduler = sample_scheduler_new(&store, config);
+    sample_clock_settle(n_workers);
+    sample_clock_advance(HOUR);
+    
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++)
+        before[blocks[i]] = block_serial(&store, blocks[i]);
+    sample_scheduler_take_stats(scheduler, &hour->stats);
+    
+    sample_clock_advance(HOUR);
+    
+    sample_scheduler_take_stats(scheduler, &hour->stats);
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++)
+        hour->updates[blocks[i]] = block_serial(&store, blocks[i]) - before[blocks[i]];
+    pthread_mutex_lock(&store.mutex);
+    hour->battery = store.blocks[BLOCK_BATTERY].raw.battery;
+    pthread_mutex_unlock(&store.mutex);
+    
+    sample_scheduler_free(scheduler);
+    block_store_clear(&store);
+}
+
+/* Checks the updates of @hour against the intervals of the providers and
+ * returns the wakeups they take */
+static guint
+policy_check_updates (const PolicyHour *hour, const guint *per_hour)
+{
+    guint expected = 0;
+    
+    for (guint i = 0; i < G_N_ELEMENTS(blocks); i++) {
+        if (!sample_provider_available(blocks[i]))
+            continue;
+        g_test_message("%s: %u updates", block_get_name(blocks[i]), hour->updates[blocks[i]]);
+        g_assert_cmpuint(hour->updates[blocks[i]], ==, per_hour[i]);
+        expected += per_hour[i];
+    }
+    
+    return expected;
+}
+
+static void
+policy_check_stats (const PolicyHour *hour, gboolean on_battery, guint expected)
+{
+    const SampleSchedulerStats *stats = &hour->stats;
+    
+    g_test_message("on %s: %u wakeups, %.3f ms CPU, %u fetches",
+                   on_battery ? "battery" : "AC", stats->wakeups[on_battery],
+                   stats->cpu_usec[on_battery] / 1000.0, stats->fetches);
+    
+    /* one wakeup per tick, and a condition variable may wake spuriously */
+    g_assert_cmpuint(stats->wakeups[on_battery], >=, expected);
+    g_assert_cmpuint(stats->wakeups[on_battery], <=, expected + expected / 50);
+    g_assert_cmpuint(stats->wakeups[!on_battery], ==, 0);
+    g_assert_cmpint(stats->cpu_usec[!on_battery], ==, 0);
+    
+    /* the local providers never go to the network */
+    g_assert_cmpuint(stats->fetches, ==, 0);
+}
+
+/* An hour on AC and one unplugged. On battery the workers that are not
+ * critical sleep BATTERY_STRETCH times longer, rounded up to the 10 s
+ * grid: memory 5 s to 20 s, CPU 2 s to 10 s, battery 10 s to 30 s. The
+ * clock is critical and keeps its minute. */
+static void
+test_policy_battery (void)
+{
+    static const guint on_ac[] = { 60, 3600 / 5, 3600 / 2, 3600 / 10 };
+    static const guint on_battery[] = { 60, 3600 / 20, 3600 / 10, 3600 / 30 };
+    PolicyHour ac, battery;
+    guint ac_wakeups, battery_wakeups;
+    
+    /* built without it, the machine is always on AC */
+    if (!sample_provider_available(BLOCK_BATTERY)) {
+        g_test_skip("Built without the battery block");
+        return;
+    }
+    
+    policy_run_hour(FIXTURE_DIR "/laptop", &ac);
+    ac_wakeups = policy_check_updates(&ac, on_ac);
+    policy_check_stats(&ac, FALSE, ac_wakeups);
+    
+    policy_run_hour(FIXTURE_DIR "/unplugged", &battery);
+    battery_wakeups = policy_check_updates(&battery, on_battery);
+    policy_check_stats(&battery, TRUE, battery_wakeups);
+    
+    /* the laptop has BAT0, the unplugged one BAT1; both are worn down */
+    g_assert_cmpint(ac.battery.full, ==, 49700000);
+    g_assert_cmpint(ac.battery.full_design, ==, 57000000);
+    g_assert_cmpint(battery.battery.full, ==, 49700000);
+    g_assert_cmpint(battery.battery.full_design, ==, 57000000);
+    
+    /* a quarter of the ticks does not get to cost more */
+    g_assert_cmpint(battery.stats.cpu_usec[TRUE], <, ac.stats.cpu_usec[FALSE]);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    sample_clock_set_virtual(POLICY_START);
+    
+    g_test_add_func("/policy/battery", test_policy_battery);
+    
+    return g_test_run();
+}
@@ -0,0 +1,201 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+
+#include "mock-http.h"
+#include "sample-rates.h"
+
+/* Private to sample-rates.c */
+#define RATE_MIN_SAMPLES   5
+#define RATE_DEFAULT_HEDGE (2 * G_USEC_PER_SEC)
+#define RATE_MIN_HEDGE     (200 * 1000)
+
+#define FAST_PATH    "/fast/latest.json"
+#define SLOW_PATH    "/slow/latest.json"
+#define STEADY_PATH  "/steady/latest.json"
+#define FAILING_PATH "/failing/latest.json"
+
+/* well past the hedge, well inside the timeout */
+#define SLOW_DELAY   (3 * G_USEC_PER_SEC)
+
+/* a primary that answers in a second, then a step slower each time */
+#define STEADY_DELAY (1 * G_USEC_PER_SEC)
+#define STEADY_STEP  (100 * 1000)
+
+#define RATES_BODY   "{\"base\":\"USD\",\"timestamp\":1760000400,\"rates\":{\"TRY\":41.82,\"RUB\":81.05}}"
+
+typedef struct {
+    MockHttp    *mock;
+    RateSources *sources;
+} RatesFixture;
+
+static void
+rates_fixture_set_up (RatesFixture *fixture, gconstpointer user_data)
+{
+    const gchar *const *names = user_data;
+    GString *spec = g_string_new(NULL);
+    
+    fixture->mock = mock_http_new();
+    mock_http_route(fixture->mock, FAST_PATH, 200, RATES_BODY, 0);
+    mock_http_route(fixture->mock, SLOW_PATH, 200, RATES_BODY, SLOW_DELAY);
+    mock_http_route(fixture->mock, FAILING_PATH, 500, "{\"error\":true,\"status\":500}", 0);
+    
+    for (gint i = 0; names[i]; i++) {
+        gchar *path = g_strdup_printf("/%s/latest.json", names[i]);
+        gchar *url = mock_http_get_url(fixture->mock, path);
+        
+        g_string_append_printf(spec, "%s%s=%s", i > 0 ? ";" : "", names[i], url);
+        g_free(url);
+        g_free(path);
+    }
+    fixture->sources = rate_sources_new(spec->str, NULL);
+    g_assert_cmpuint(rate_sources_get_n(fixture->sources), ==, g_strv_length((gchar **) names));
+    g_string_free(spec, TRUE);
+}
+
+static void
+rates_fixture_tear_down (RatesFixture *fixture, gconstpointer user_data)
+{
+    rate_sources_free(fixture->sources);
+    mock_http_free(fixture->mock);
+}
+
+/* One fetch; the source that answered and how long it took, in µs */
+static gint64
+rates_fetch (RatesFixture *fixture, const gchar *expected_source)
+{
+    ExchangeSample exchange;
+    gint64 start = g_get_monotonic_time();
+    
+    g_assert_true(rate_sources_fetch(fixture->sources, &exchange, NULL));
+    g_assert_cmpstr(exchange.source, ==, expected_source);
+    g_assert_true(exchange.has_try);
+    g_assert_cmpfloat_with_epsilon(exchange.try_rate, 41.82, 1e-9);
+    g_assert_cmpint(exchange.timestamp, ==, 1760000400);
+    
+    return g_get_monotonic_time() - start;
+}
+
+/* A failing primary is left for the next source at once, without
+ * waiting for the hedge, and loses its place */
+static void
+test_rates_failover (RatesFixture *fixture, gconstpointer user_data)
+{
+    g_assert_cmpint(rates_fetch(fixture, "fast"), <, RATE_DEFAULT_HEDGE / 2);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAILING_PATH), ==, 1);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAST_PATH), ==, 1);
+    
+    rates_fetch(fixture, "fast");
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAILING_PATH), ==, 1);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAST_PATH), ==, 2);
+}
+
+/* A primary that has not answered by the hedge delay gets company, and
+ * the first answer wins */
+static void
+test_rates_hedge (RatesFixture *fixture, gconstpointer user_data)
+{
+    gint64 elapsed = rates_fetch(fixture, "fast");
+    
+    g_assert_cmpint(elapsed, >=, RATE_DEFAULT_HEDGE);
+    g_assert_cmpint(elapsed, <, SLOW_DELAY);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, SLOW_PATH), ==, 1);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAST_PATH), ==, 1);
+}
+
+/* Once the hedge has answered often enough to have a p95, it takes over
+ * from the slow primary, whose lost races do not make it look fast */
+static void
+test_rates_primary (RatesFixture *fixture, gconstpointer user_data)
+{
+    for (gint i = 0; i < RATE_MIN_SAMPLES; i++)
+        g_assert_cmpint(rates_fetch(fixture, "fast"), >=, RATE_DEFAULT_HEDGE);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, SLOW_PATH), ==, RATE_MIN_SAMPLES);
+    
+    for (gint i = 0; i < RATE_MIN_SAMPLES; i++)
+        g_assert_cmpint(rates_fetch(fixture, "fast"), <, RATE_DEFAULT_HEDGE / 2);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, SLOW_PATH), ==, RATE_MIN_SAMPLES);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAST_PATH), ==, 2 * RATE_MIN_SAMPLES);
+}
+
+/* A hedge that loses the race was only out for a moment. That is no
+ * answer time, and must not make a source that takes seconds look like
+ * the quicker one. The primary slows down a step each fetch, so the
+ * hedge goes out shortly before every answer. */
+static void
+test_rates_lost_races (RatesFixture *fixture, gconstpointer user_data)
+{
+    mock_http_route(fixture->mock, STEADY_PATH, 200, RATES_BODY, STEADY_DELAY);
+    for (gint i = 0; i < RATE_MIN_SAMPLES; i++)
+        rates_fetch(fixture, "steady");
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, SLOW_PATH), ==, 0);
+    
+    for (gint i = 1; i <= RATE_MIN_SAMPLES; i++) {
+        mock_http_route(fixture->mock, STEADY_PATH, 200, RATES_BODY, STEADY_DELAY + i * STEADY_STEP);
+        rates_fetch(fixture, "steady");
+        g_assert_cmpuint(mock_http_get_requests(fixture->mock, SLOW_PATH), ==, i);
+    }
+    
+    /* still the primary: asked alone and answering at once */
+    mock_http_route(fixture->mock, STEADY_PATH, 200, RATES_BODY, 0);
+    g_assert_cmpint(rates_fetch(fixture, "steady"), <, RATE_MIN_HEDGE);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, SLOW_PATH), ==, RATE_MIN_SAMPLES);
+}
+
+/* Nothing when every source fails, and each of them was asked once */
+static void
+test_rates_all_failing (RatesFixture *fixture, gconstpointer user_data)
+{
+    ExchangeSample exchange;
+    
+    g_assert_false(rate_sources_fetch(fixture->sources, &exchange, NULL));
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FAILING_PATH), ==, 1);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    static const gchar *failing_fast[] = { "failing", "fast", NULL };
+    static const gchar *slow_fast[] = { "slow", "fast", NULL };
+    static const gchar *steady_slow[] = { "steady", "slow", NULL };
+    static const gchar *failing[] = { "failing", NULL };
+    
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add("/rates/failover", RatesFixture, failing_fast,
+               rates_fixture_set_up, test_rates_failover, rates_fixture_tear_down);
+    g_test_add("/rates/hedge", RatesFixture, slow_fast,
+               rates_fixture_set_up, test_rates_hedge, rates_fixture_tear_down);
+    g_test_add("/rates/primary", RatesFixture, slow_fast,
+               rates_fixture_set_up, test_rates_primary, rates_fixture_tear_down);
+    g_test_add("/rates/lost-races", RatesFixture, steady_slow,
+               rates_fixture_set_up, test_rates_lost_races, rates_fixture_tear_down);
+    g_test_add("/rates/all-failing", RatesFixture, failing,
+               rates_fixture_set_up, test_rates_all_failing, rates_fixture_tear_down);
+    
+    return g_test_run();
+}
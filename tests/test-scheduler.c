@@ -0,0 +1,318 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <stdlib.h>
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
+#include <glib.h>
+
+#include "mock-http.h"
+#include "sample-blocks.h"
+#include "sample-clock.h"
+#include "sample-providers.h"
+#include "sample-scheduler.h"
+#include "sample-source.h"
+
+/* Simulated days of the soak run, a month of exchange rate budget. The
+ * first week settles allocations, e.g. the latency statistics of the
+ * rate sources fill up. */
+#define SOAK_DAYS        30
+#define SOAK_SETTLE_DAYS 7
+#define DAY        (G_GINT64_CONSTANT(86400) * G_USEC_PER_SEC)
+
+/* Monday 2 March 2026, 00:00:00 UTC */
+#define SOAK_START (G_GINT64_CONSTANT(1772409600) * G_USEC_PER_SEC)
+
+/* exchange rate requests for the month */
+#define SOAK_EXCHANGE_BUDGET 300
+
+/* bytes allocated may still move with the length of strings such as
+ * the last query the loopback server keeps, and by the odd GSlice
+ * magazine for a new thread of its pool; a leak of one string per
+ * fetch is well past it by the end of the month */
+#define SOAK_HEAP_SLACK 4096
+
+/* Private to sample-providers.c */
+#define WEATHER_FORECAST_TTL     (6 * 3600)
+#define EXCHANGE_UPDATE_INTERVAL (30 * 60)
+#define EXCHANGE_USAGE_INTERVAL  (6 * 3600)
+
+/* Private to sample-weather.c */
+#define WEATHER_FORECAST_PATH "/v1/forecast"
+
+#define EXCHANGE_LATEST_PATH "/api/latest.json"
+#define EXCHANGE_USAGE_PATH  "/api/usage.json"
+
+typedef struct {
+    guint n_fds;
+    glong threads;
+    gsize heap;         /* bytes allocated, 0 where unknown */
+} ProcessStats;
+
+static void
+process_stats (ProcessStats *stats)
+{
+    GDir *fds = g_dir_open("/proc/self/fd", 0, NULL);
+    const gchar *tunables = g_getenv("GLIBC_TUNABLES");
+    gchar *status = NULL;
+    const gchar *line;
+    
+    memset(stats, 0, sizeof(*stats));
+    g_assert_nonnull(fds);
+    while (g_dir_read_name(fds))
+        stats->n_fds++;
+    g_dir_close(fds);
+    
+    g_assert_true(g_file_get_contents("/proc/self/status", &status, NULL, NULL));
+    if ((line = strstr(status, "\nThreads:")))
+        stats->threads = strtol(line + strlen("\nThreads:"), NULL, 10);
+    g_free(status);
+#ifdef HAVE_MALLINFO2
+    /* freed blocks in the per-thread caches still count as allocated,
+     * the test environment turns those off */
+    if (tunables && strstr(tunables, "glibc.malloc.tcache_count=0"))
+        stats->heap = mallinfo2().uordblks;
+#endif
+}
+
+static guint
+block_serial (BlockStore *store, BlockId block_id)
+{
+    guint serial;
+    
+    pthread_mutex_lock(&store->mutex);
+    serial = store->blocks[block_id].serial;
+    pthread_mutex_unlock(&store->mutex);
+    
+    return serial;
+}
+
+/* One location's hourly forecast from an hour before @start, as the
+ * service would answer at that time */
+static gchar *
+forecast_body (gint64 start)
+{
+    GString *body = g_string_new("{\"latitude\":52.52,\"longitude\":13.41,\"hourly\":{\"time\":[");
+    const gchar *arrays[] = { "temperature_2m", "weather_code", "wind_speed_10m", "wind_direction_10m", "is_day" };
+    
+    for (gint i = 0; i <= 48; i++)
+        g_string_append_printf(body, "%s%" G_GINT64_FORMAT, i ? "," : "", start - 3600 + i * 3600);
+    for (guint a = 0; a < G_N_ELEMENTS(arrays); a++) {
+        g_string_append_printf(body, "],\"%s\":[", arrays[a]);
+        for (gint i = 0; i <= 48; i++)
+            g_string_append_printf(body, "%s%d", i ? "," : "", a == 0 ? 5 + i % 24 / 3 : a == 4 ? i % 24 >= 6 : 3);
+    }
+    g_string_append(body, "]}}");
+    
+    return g_string_free(body, FALSE);
+}
+
+/* Simulated time reaches the remote blocks only when every request
+ * stays on this machine */
+static void
+test_scheduler_remote (void)
+{
+    SampleConfig *config = sample_config_new();
+    gboolean weather = sample_provider_available(BLOCK_WEATHER);
+    gboolean exchange = sample_provider_available(BLOCK_EXCHANGE_RATE);
+    
+    config->show_weather = TRUE;
+    config->show_exchange = TRUE;
+    config->weather_location = g_strdup("52.52,13.41");
+    config->exchange_sources = g_strdup("mock=http://127.0.0.1:8000/api/latest.json;openexchangerates");
+    g_assert_false(sample_provider_wanted(config, BLOCK_WEATHER));
+    g_assert_false(sample_provider_wanted(config, BLOCK_EXCHANGE_RATE));
+    
+    config->weather_url = g_strdup("http://localhost:8000/v1/forecast");
+    g_free(config->exchange_sources);
+    config->exchange_sources = g_strdup("mock=http://[::1]:8000/api/latest.json; second=http://127.0.0.2/");
+    g_assert_cmpint(sample_provider_wanted(config, BLOCK_WEATHER), ==, weather);
+    g_assert_cmpint(sample_provider_wanted(config, BLOCK_EXCHANGE_RATE), ==, exchange);
+    
+    g_free(config->weather_url);
+    config->weather_url = g_strdup("http://127.0.0.1.example.com/v1/forecast");
+    g_assert_false(sample_provider_wanted(config, BLOCK_WEATHER));
+    
+    sample_config_unref(config);
+}
+
+/* A month of the local blocks over the laptop fixture and of the
+ * network, with weather and exchange rates fetched from a loopback
+ * server */
+static void
+test_scheduler_soak (void)
+{
+    static const struct {
+        BlockId block_id;
+        guint   per_day;     /* updates, from the provider's interval */
+    } expected[] = {
+        { BLOCK_DATE,    24 * 60 },
+        { BLOCK_MEMORY,  86400 / 5 },
+        { BLOCK_CPU,     86400 / 2 },
+        { BLOCK_NETWORK, 86400 / 2 },
+        { BLOCK_BATTERY, 86400 / 10 },
+    };
+    SampleConfig *config = sample_config_new();
+    MockHttp *mock = mock_http_new();
+    gchar *url = mock_http_get_url(mock, EXCHANGE_LATEST_PATH);
+    gboolean weather, exchange;
+    SampleScheduler *scheduler = NULL;
+    ProcessStats settled = { 0 }, stats;
+    BlockStore store;
+    guint n_workers = 0, n_exchange = 0;
+    
+    config->show_date = TRUE;
+    config->show_memory = TRUE;
+    config->show_cpu = TRUE;
+    config->show_network = TRUE;
+    config->show_battery = TRUE;
+    config->show_weather = TRUE;
+    config->show_exchange = TRUE;
+    config->weather_location = g_strdup("52.52,13.41");
+    config->weather_url = mock_http_get_url(mock, WEATHER_FORECAST_PATH);
+    config->exchange_sources = g_strdup_printf("mock=%s", url);
+    config->exchange_budget = SOAK_EXCHANGE_BUDGET;
+    config->network_exclude = g_strdup("");
+    g_free(url);
+    
+    /* the usage of a key is unknown, the budget alone plans */
+    mock_http_route(mock, EXCHANGE_LATEST_PATH, 200, "{\"base\":\"USD\",\"rates\":{\"TRY\":43.51,\"RUB\":79.24}}", 0);
+    mock_http_route(mock, EXCHANGE_USAGE_PATH, 404, "{\"error\":true,\"status\":404}", 0);
+    
+    for (guint i = 0; i < G_N_ELEMENTS(expected); i++) {
+        if (sample_provider_wanted(config, expected[i].block_id))
+            n_workers++;
+    }
+    weather = sample_provider_wanted(config, BLOCK_WEATHER);
+    exchange = sample_provider_wanted(config, BLOCK_EXCHANGE_RATE);
+    n_workers += weather + exchange;
+    g_assert_cmpint(weather, ==, sample_provider_available(BLOCK_WEATHER));
+    g_assert_cmpint(exchange, ==, sample_provider_available(BLOCK_EXCHANGE_RATE));
+    
+    block_store_init(&store, NULL, NULL);
+    for (gint day = 0; day < SOAK_DAYS; day++) {
+        gint64 day_start = (SOAK_START + day * DAY) / G_USEC_PER_SEC;
+        guint before[G_N_ELEMENTS(expected)];
+        guint weather_before, exchange_before, usage_before;
+        gchar *body = forecast_body(day_start);
+        
+        /* the forecast moves on with the days */
+        mock_http_route(mock, WEATHER_FORECAST_PATH, 200, body, 0);
+        g_free(body);
+        if (day == 0) {
+            scheduler = sample_scheduler_new(&store, config);
+            sample_clock_settle(n_workers);
+        }
+        
+        for (guint i = 0; i < G_N_ELEMENTS(expected); i++)
+            before[i] = block_serial(&store, expected[i].block_id);
+        weather_before = mock_http_get_requests(mock, WEATHER_FORECAST_PATH);
+        exchange_before = mock_http_get_requests(mock, EXCHANGE_LATEST_PATH);
+        usage_before = mock_http_get_requests(mock, EXCHANGE_USAGE_PATH);
+        
+        sample_clock_advance(DAY);
+        
+        for (guint i = 0; i < G_N_ELEMENTS(expected); i++) {
+            BlockId block_id = expected[i].block_id;
+            guint updates = block_serial(&store, block_id) - before[i];
+            
+            if (!sample_provider_available(block_id))
+                continue;
+            g_test_message("day %d: %s updated %u times", day + 1, block_get_name(block_id), updates);
+            g_assert_cmpuint(updates, ==, expected[i].per_day);
+        }
+        
+        /* a forecast each time the last one ages out */
+        if (weather) {
+            guint fetches = mock_http_get_requests(mock, WEATHER_FORECAST_PATH) - weather_before;
+            
+            g_test_message("day %d: %u forecasts", day + 1, fetches);
+            g_assert_cmpuint(fetches, ==, 86400 / WEATHER_FORECAST_TTL);
+        }
+        
+        /* the usage every few hours, checked at least every update
+         * interval, and rates while the market is open: it is closed
+         * all Saturday and opens late on Sunday */
+        if (exchange) {
+            guint fetches = mock_http_get_requests(mock, EXCHANGE_LATEST_PATH) - exchange_before;
+            GDateTime *date = g_date_time_new_from_unix_utc(day_start);
+            guint usage = mock_http_get_requests(mock, EXCHANGE_USAGE_PATH) - usage_before;
+            
+            g_test_message("day %d: %u exchange rates", day + 1, fetches);
+            g_assert_cmpuint(usage, <=, 86400 / EXCHANGE_USAGE_INTERVAL);
+            g_assert_cmpuint(usage, >=, 86400 / (EXCHANGE_USAGE_INTERVAL + EXCHANGE_UPDATE_INTERVAL));
+            if (g_date_time_get_day_of_week(date) == 6)
+                g_assert_cmpuint(fetches, ==, 0);
+            else if (g_date_time_get_day_of_week(date) < 6)
+                g_assert_cmpuint(fetches, >, 0);
+            g_date_time_unref(date);
+            n_exchange += fetches;
+        }
+        
+        process_stats(&stats);
+        g_test_message("day %d: %u descriptors, %ld threads, %" G_GSIZE_FORMAT " bytes allocated",
+                       day + 1, stats.n_fds, stats.threads, stats.heap);
+        if (day < SOAK_SETTLE_DAYS) {
+            settled = stats;
+            continue;
+        }
+        g_assert_cmpuint(stats.n_fds, ==, settled.n_fds);
+        g_assert_cmpint(stats.threads, ==, settled.threads);
+        g_assert_cmpuint(stats.heap, <=, settled.heap + SOAK_HEAP_SLACK);
+    }
+    
+    /* the month's budget is spent, but not overspent */
+    if (exchange) {
+        g_test_message("%u exchange rates in %d days", n_exchange, SOAK_DAYS);
+        g_assert_cmpuint(n_exchange, <=, SOAK_EXCHANGE_BUDGET);
+        g_assert_cmpuint(n_exchange, >=, SOAK_EXCHANGE_BUDGET * 9 / 10);
+    }
+    
+    sample_scheduler_free(scheduler);
+    block_store_clear(&store);
+    mock_http_free(mock);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    /* before any worker runs; also keeps the power source on AC */
+    sample_source_set_root(FIXTURE_DIR "/laptop");
+    sample_clock_set_virtual(SOAK_START);
+    
+    /* the loopback server's connection threads are kept once started,
+     * so that the counts only move with the workers */
+    g_thread_pool_set_max_unused_threads(-1);
+    g_thread_pool_set_max_idle_time(0);
+    
+    g_test_add_func("/scheduler/remote", test_scheduler_remote);
+    g_test_add_func("/scheduler/soak", test_scheduler_soak);
+    
+    return g_test_run();
+}
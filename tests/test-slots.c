@@ -0,0 +1,152 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "sample-slots.h"
+
+/* an hour of one second ticks */
+#define TICKS 3600
+#define TICK  G_USEC_PER_SEC
+
+#define TEMPLATE_WIDTH 110
+#define HEIGHT         18
+
+/* Relayouts caused by @width over an hour of ticks, with and without
+ * the hysteresis */
+static guint
+count_relayouts (gint   (*width_at) (GRand *rand, gint tick),
+                 guint   *naive)
+{
+    GRand *rand = g_rand_new_with_seed(33);
+    SampleSlotSize size;
+    gint last_width = -1;
+    guint relayouts = 0;
+    
+    sample_slot_size_reset(&size, TEMPLATE_WIDTH, HEIGHT);
+    *naive = 0;
+    for (gint i = 0; i < TICKS; i++) {
+        gint width = width_at(rand, i);
+        
+        if (sample_slot_size_update(&size, width, HEIGHT, (gint64)(i + 1) * TICK))
+            relayouts++;
+        if (width != last_width)
+            (*naive)++;
+        last_width = width;
+    }
+    g_rand_free(rand);
+    
+    return relayouts;
+}
+
+/* Throughput that changes by a digit or two every second */
+static gint
+jitter_below_template (GRand *rand, gint tick)
+{
+    return g_rand_int_range(rand, TEMPLATE_WIDTH - 30, TEMPLATE_WIDTH + 1);
+}
+
+static gint
+jitter_above_template (GRand *rand, gint tick)
+{
+    return g_rand_int_range(rand, TEMPLATE_WIDTH, TEMPLATE_WIDTH + 24);
+}
+
+/* Bursts well past the template and back every few minutes */
+static gint
+bursts (GRand *rand, gint tick)
+{
+    return (tick / 120) % 2 ? TEMPLATE_WIDTH + 40 : g_rand_int_range(rand, 60, TEMPLATE_WIDTH);
+}
+
+static void
+test_slots_jitter_below_template (void)
+{
+    guint naive, relayouts = count_relayouts(jitter_below_template, &naive);
+    
+    g_test_message("below the template: %u relayouts, %u without hysteresis", relayouts, naive);
+    /* only the first size is ever reserved */
+    g_assert_cmpuint(relayouts, ==, 1);
+    g_assert_cmpuint(naive, >, TICKS / 2);
+}
+
+static void
+test_slots_jitter_above_template (void)
+{
+    guint naive, relayouts = count_relayouts(jitter_above_template, &naive);
+    
+    g_test_message("above the template: %u relayouts, %u without hysteresis", relayouts, naive);
+    /* grows a few times to the widest jitter, never shrinks back */
+    g_assert_cmpuint(relayouts, <=, 24);
+    g_assert_cmpuint(naive, >, TICKS / 2);
+}
+
+static void
+test_slots_bursts (void)
+{
+    guint naive, relayouts = count_relayouts(bursts, &naive);
+    
+    g_test_message("bursts: %u relayouts, %u without hysteresis", relayouts, naive);
+    /* two minute dips are shorter than the shrink delay */
+    g_assert_cmpuint(relayouts, ==, 2);
+}
+
+static void
+test_slots_shrink (void)
+{
+    SampleSlotSize size;
+    gint64 now = TICK;
+    
+    sample_slot_size_reset(&size, TEMPLATE_WIDTH, HEIGHT);
+    g_assert_true(sample_slot_size_update(&size, TEMPLATE_WIDTH + 50, HEIGHT, now));
+    g_assert_cmpint(size.width, ==, TEMPLATE_WIDTH + 50);
+    
+    /* within the slack the reserved width stays */
+    now += TICK;
+    g_assert_false(sample_slot_size_update(&size, TEMPLATE_WIDTH + 50 - SAMPLE_SLOT_SHRINK_SLACK + 1,
+                                           HEIGHT, now));
+    
+    /* clearly narrower, but not for long enough yet */
+    for (gint64 end = now + SAMPLE_SLOT_SHRINK_DELAY; now < end; now += TICK)
+        g_assert_false(sample_slot_size_update(&size, TEMPLATE_WIDTH + 10, HEIGHT, now));
+    g_assert_true(sample_slot_size_update(&size, TEMPLATE_WIDTH + 10, HEIGHT, now));
+    g_assert_cmpint(size.width, ==, TEMPLATE_WIDTH + 10);
+    
+    /* never below the template */
+    for (gint64 end = now + 2 * SAMPLE_SLOT_SHRINK_DELAY; now < end; now += TICK)
+        sample_slot_size_update(&size, 10, HEIGHT, now);
+    g_assert_cmpint(size.width, ==, TEMPLATE_WIDTH);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add_func("/slots/jitter-below-template", test_slots_jitter_below_template);
+    g_test_add_func("/slots/jitter-above-template", test_slots_jitter_above_template);
+    g_test_add_func("/slots/bursts", test_slots_bursts);
+    g_test_add_func("/slots/shrink", test_slots_shrink);
+    
+    return g_test_run();
+}
@@ -0,0 +1,235 @@
+/*  Status Bar Plugin for XFCE Panel
+ *
+ *  Copyright (C) 2025 
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+
+#include "mock-http.h"
+#include "sample-weather.h"
+
+/* Six named locations of 49 hours from here, see fixtures/weather */
+#define FORECAST_START  G_GINT64_CONSTANT(1760000400)
+#define FORECAST_PATH   "/v1/forecast"
+#define FORECAST_SPEC   "Berlin=52.52,13.41;Paris=48.85,2.35;London=51.51,-0.13;" \
+                        "New York=40.71,-74.01;Tokyo=35.69,139.69;Sydney=-33.87,151.21"
+
+typedef struct {
+    MockHttp *mock;
+    gchar    *url;
+} WeatherFixture;
+
+static gchar *
+read_fixture (const gchar *name)
+{
+    gchar *path = g_build_filename(FIXTURE_DIR, "weather", name, NULL);
+    gchar *contents = NULL;
+    
+    g_assert_true(g_file_get_contents(path, &contents, NULL, NULL));
+    g_free(path);
+    
+    return contents;
+}
+
+static void
+weather_fixture_set_up (WeatherFixture *fixture, gconstpointer user_data)
+{
+    fixture->mock = mock_http_new();
+    fixture->url = mock_http_get_url(fixture->mock, FORECAST_PATH);
+}
+
+static void
+weather_fixture_tear_down (WeatherFixture *fixture, gconstpointer user_data)
+{
+    mock_http_free(fixture->mock);
+    g_free(fixture->url);
+}
+
+static void
+test_weather_locations (void)
+{
+    WeatherLocation locations[WEATHER_MAX_LOCATIONS];
+    
+    g_assert_cmpint(weather_locations_parse(FORECAST_SPEC, locations, WEATHER_MAX_LOCATIONS), ==, 6);
+    g_assert_cmpstr(locations[3].name, ==, "New York");
+    g_assert_cmpstr(locations[3].latitude, ==, "40.71");
+    g_assert_cmpstr(locations[3].longitude, ==, "-74.01");
+    
+    /* unnamed, invalid and empty entries */
+    g_test_expect_message("xfce4-sample-plugin", G_LOG_LEVEL_WARNING, "Ignoring invalid weather location*");
+    g_assert_cmpint(weather_locations_parse(" 1.5 , 2.5 ;Nowhere=north,east;;", locations,
+                                            WEATHER_MAX_LOCATIONS), ==, 1);
+    g_test_assert_expected_messages();
+    g_assert_cmpstr(locations[0].name, ==, "");
+    g_assert_cmpstr(locations[0].latitude, ==, "1.5");
+    
+    /* no more than asked for */
+    g_assert_cmpint(weather_locations_parse(FORECAST_SPEC, locations, 2), ==, 2);
+    g_assert_cmpint(weather_locations_parse(NULL, locations, 2), ==, 0);
+}
+
+/* The answer for six locations comes in many writes, all of which have
+ * to end up in the parsed body */
+static void
+test_weather_chunked (WeatherFixture *fixture, gconstpointer user_data)
+{
+    WeatherLocation locations[WEATHER_MAX_LOCATIONS];
+    WeatherForecast forecasts[WEATHER_MAX_LOCATIONS];
+    gint n_locations = weather_locations_parse(FORECAST_SPEC, locations, WEATHER_MAX_LOCATIONS);
+    gchar *body = read_fixture("forecast.json");
+    gchar *query;
+    
+    g_assert_cmpuint(strlen(body), >, 8 * 512);
+    mock_http_route(fixture->mock, FORECAST_PATH, 200, body, 0);
+    mock_http_set_chunking(fixture->mock, 512, 2000);
+    
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, n_locations, forecasts, NULL), ==, 6);
+    g_assert_cmpuint(mock_http_get_requests(fixture->mock, FORECAST_PATH), ==, 1);
+    
+    query = mock_http_get_query(fixture->mock, FORECAST_PATH);
+    g_assert_nonnull(strstr(query, "latitude=52.52,48.85,51.51,40.71,35.69,-33.87&"));
+    g_assert_nonnull(strstr(query, "longitude=13.41,2.35,-0.13,-74.01,139.69,151.21&"));
+    g_free(query);
+    
+    for (gint i = 0; i < 6; i++) {
+        g_assert_cmpstr(forecasts[i].name, ==, locations[i].name);
+        g_assert_cmpint(forecasts[i].start, ==, FORECAST_START);
+        g_assert_cmpint(forecasts[i].n_hours, ==, WEATHER_FORECAST_HOURS);
+    }
+    
+    /* the first and the last location, at both ends */
+    g_assert_cmpfloat_with_epsilon(forecasts[0].temperature[0], 8.0, 1e-4);
+    g_assert_cmpfloat_with_epsilon(forecasts[0].temperature[47], 6.4, 1e-4);
+    g_assert_cmpuint(forecasts[0].winddirection[0], ==, 180);
+    g_assert_cmpfloat_with_epsilon(forecasts[5].temperature[0], 13.8, 1e-4);
+    g_assert_cmpfloat_with_epsilon(forecasts[5].temperature[47], 15.0, 1e-4);
+    g_assert_cmpuint(forecasts[5].winddirection[0], ==, 20);
+    g_assert_cmpuint(forecasts[5].weathercode[47], ==, 61);
+    
+    g_free(body);
+}
+
+/* A single location is answered with an object instead of an array */
+static void
+test_weather_single (WeatherFixture *fixture, gconstpointer user_data)
+{
+    WeatherLocation locations[1];
+    WeatherForecast forecast;
+    WeatherReading reading;
+    gchar *body = read_fixture("forecast-single.json");
+    
+    g_assert_cmpint(weather_locations_parse("52.52,13.41", locations, 1), ==, 1);
+    mock_http_route(fixture->mock, FORECAST_PATH, 200, body, 0);
+    
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, 1, &forecast, NULL), ==, 1);
+    g_assert_cmpstr(forecast.name, ==, "");
+    
+    /* halfway between 8.0 and 9.6, the direction of the nearer hour */
+    g_assert_true(weather_forecast_interpolate(&forecast, FORECAST_START + 1800, &reading));
+    g_assert_cmpfloat_with_epsilon(reading.temperature, 8.8, 1e-4);
+    g_assert_true(weather_forecast_interpolate(&forecast, FORECAST_START + 2700, &reading));
+    g_assert_cmpfloat(reading.winddirection, ==, 187);
+    g_assert_false(weather_forecast_interpolate(&forecast, FORECAST_START - 1, &reading));
+    g_assert_false(weather_forecast_interpolate(&forecast, FORECAST_START + 47 * 3600, &reading));
+    
+    g_free(body);
+}
+
+/* Cut off, failed and empty answers leave the previous forecasts alone */
+static void
+test_weather_failed (WeatherFixture *fixture, gconstpointer user_data)
+{
+    WeatherLocation locations[WEATHER_MAX_LOCATIONS];
+    WeatherForecast forecasts[WEATHER_MAX_LOCATIONS];
+    gint n_locations = weather_locations_parse(FORECAST_SPEC, locations, WEATHER_MAX_LOCATIONS);
+    gchar *body = read_fixture("forecast.json");
+    
+    mock_http_route(fixture->mock, FORECAST_PATH, 200, body, 0);
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, n_locations, forecasts, NULL), ==, 6);
+    
+    body[strlen(body) / 2] = '\0';
+    mock_http_route(fixture->mock, FORECAST_PATH, 200, body, 0);
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, n_locations, forecasts, NULL), ==, 0);
+    
+    mock_http_route(fixture->mock, FORECAST_PATH, 429, "{\"error\":true}", 0);
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, n_locations, forecasts, NULL), ==, 0);
+    
+    mock_http_route(fixture->mock, FORECAST_PATH, 200, "[]", 0);
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, n_locations, forecasts, NULL), ==, 0);
+    
+    g_assert_cmpint(forecasts[5].n_hours, ==, WEATHER_FORECAST_HOURS);
+    g_assert_cmpfloat_with_epsilon(forecasts[5].temperature[47], 15.0, 1e-4);
+    
+    g_free(body);
+}
+
+static gpointer
+cancel_later (gpointer data)
+{
+    g_usleep(200 * 1000);
+    g_cancellable_cancel(data);
+    
+    return NULL;
+}
+
+/* A stopped worker does not wait out a slow answer */
+static void
+test_weather_cancelled (WeatherFixture *fixture, gconstpointer user_data)
+{
+    WeatherLocation locations[WEATHER_MAX_LOCATIONS];
+    WeatherForecast forecasts[WEATHER_MAX_LOCATIONS];
+    gint n_locations = weather_locations_parse(FORECAST_SPEC, locations, WEATHER_MAX_LOCATIONS);
+    GCancellable *cancellable = g_cancellable_new();
+    gchar *body = read_fixture("forecast.json");
+    gint64 start = g_get_monotonic_time();
+    GThread *canceller;
+    
+    mock_http_route(fixture->mock, FORECAST_PATH, 200, body, 3 * G_USEC_PER_SEC);
+    canceller = g_thread_new("canceller", cancel_later, cancellable);
+    g_assert_cmpint(weather_forecasts_fetch(fixture->url, locations, n_locations, forecasts, cancellable), ==, 0);
+    g_test_message("aborted after %.2f s", (g_get_monotonic_time() - start) / (gdouble) G_USEC_PER_SEC);
+    g_assert_cmpint(g_get_monotonic_time() - start, <, 2 * G_USEC_PER_SEC);
+    
+    g_thread_join(canceller);
+    g_object_unref(cancellable);
+    g_free(body);
+}
+
+gint
+main (gint argc, gchar **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    
+    g_test_add_func("/weather/locations", test_weather_locations);
+    g_test_add("/weather/chunked", WeatherFixture, NULL,
+               weather_fixture_set_up, test_weather_chunked, weather_fixture_tear_down);
+    g_test_add("/weather/single", WeatherFixture, NULL,
+               weather_fixture_set_up, test_weather_single, weather_fixture_tear_down);
+    g_test_add("/weather/failed", WeatherFixture, NULL,
+               weather_fixture_set_up, test_weather_failed, weather_fixture_tear_down);
+    g_test_add("/weather/cancelled", WeatherFixture, NULL,
+               weather_fixture_set_up, test_weather_cancelled, weather_fixture_tear_down);
+    
+    return g_test_run();
+}